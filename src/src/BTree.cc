@@ -0,0 +1,763 @@
+#include "BTree.h"
+
+BTree::BTree() : m_pSortInfo(NULL), m_KeyOrder(), m_sFilePath(), m_sMetaSuffix(".meta.data"),
+				 m_bReadOnly(false), m_nRoot(-1), m_nHeight(0), m_nFirstLeaf(-1),
+				 m_nCurrPage(-1), m_nNextPage(-1), m_eAccess(RANDOM_ACCESS),
+				 m_bFileOrderScan(false), m_bQueryStarted(false), m_bQueryDone(false),
+				 m_pQueryOrderMaker(NULL), m_LowOrder(), m_HighOrder(), m_pStopOrder(NULL)
+{
+	m_pFile = new File();
+	m_pReadAhead = new ReadAhead(m_pFile);
+	m_pNodePage = new Page();
+	m_pOutPage = new Page();
+	m_pPage = new Page();
+}
+
+BTree::~BTree()
+{
+	// stop prefetching before the File goes away
+	delete m_pReadAhead;
+	m_pReadAhead = NULL;
+
+	delete m_pFile;
+	m_pFile = NULL;
+
+	delete m_pNodePage;
+	delete m_pOutPage;
+	delete m_pPage;
+	m_pNodePage = m_pOutPage = m_pPage = NULL;
+
+	delete m_pQueryOrderMaker;
+	m_pQueryOrderMaker = NULL;
+
+	if (m_pSortInfo)
+	{
+		delete m_pSortInfo->myOrder;
+		delete m_pSortInfo;
+		m_pSortInfo = NULL;
+	}
+}
+
+int BTree::Create(char *f_path, void *sortInfo, int pageSize, int compression)
+{
+	if (sortInfo == NULL)
+	{
+		cout << "\nBTree::Create --> sortInfo is NULL. ERROR!\n";
+		return RET_FAILURE;
+	}
+
+	// keep our own copy, the metadata is written again on Close
+	m_pSortInfo = new SortInfo();
+	m_pSortInfo->myOrder = new OrderMaker(*(((SortInfo*)sortInfo)->myOrder));
+	m_pSortInfo->runLength = ((SortInfo*)sortInfo)->runLength;
+
+	m_KeyOrder.numAtts = m_pSortInfo->myOrder->numAtts;
+	for (int i = 0; i < m_KeyOrder.numAtts; i++)
+	{
+		m_KeyOrder.whichAtts[i] = i;
+		m_KeyOrder.whichTypes[i] = m_pSortInfo->myOrder->whichTypes[i];
+	}
+
+	m_sFilePath = f_path;
+	m_pFile->Open(TRUNCATE, f_path, pageSize, compression);
+	m_bReadOnly = false;
+	m_nRoot = -1;
+	m_nHeight = 0;
+	m_nFirstLeaf = -1;
+	WriteMetaData();
+	MoveFirst();
+	return RET_SUCCESS;
+}
+
+int BTree::Open(char *fname, FileOpenMode mode)
+{
+	//read metadata here
+	ifstream meta_in;
+	meta_in.open((string(fname) + m_sMetaSuffix).c_str());
+	if (!meta_in)
+	{
+		cout << "BTree::Open: File " << fname << m_sMetaSuffix << " does not exist.\n";
+		return RET_FILE_NOT_FOUND;
+	}
+
+	string fileType;
+	string type;
+	if (!m_pSortInfo)
+	{
+		m_pSortInfo = new SortInfo();
+		m_pSortInfo->myOrder = new OrderMaker();
+	}
+	meta_in >> fileType;
+	meta_in >> m_pSortInfo->runLength;
+	meta_in >> m_pSortInfo->myOrder->numAtts;
+	for (int i = 0; i < m_pSortInfo->myOrder->numAtts; i++)
+	{
+		meta_in >> m_pSortInfo->myOrder->whichAtts[i];
+		meta_in >> type;
+		m_pSortInfo->myOrder->whichTypes[i] = TypeFromString(type);
+	}
+	meta_in >> m_nRoot;
+	meta_in >> m_nHeight;
+	meta_in >> m_nFirstLeaf;
+	meta_in.close();
+
+	m_KeyOrder.numAtts = m_pSortInfo->myOrder->numAtts;
+	for (int i = 0; i < m_KeyOrder.numAtts; i++)
+	{
+		m_KeyOrder.whichAtts[i] = i;
+		m_KeyOrder.whichTypes[i] = m_pSortInfo->myOrder->whichTypes[i];
+	}
+
+	m_sFilePath = fname;
+	m_bReadOnly = (mode == READ_ONLY);
+	m_pFile->Open(m_bReadOnly ? READ_ONLY : APPEND, fname);
+	MoveFirst();
+	return RET_SUCCESS;
+}
+
+// returns 1 if successfully closed the file, 0 otherwise
+int BTree::Close()
+{
+	// the root moves as the tree grows
+	if (!m_bReadOnly)
+		WriteMetaData();
+	m_pReadAhead->Stop();
+	m_pFile->Close();
+	return RET_SUCCESS;
+}
+
+/* Load function bulk loads the BTree instance from a text file. The records
+ * are sorted by a BigQ and the tree is rebuilt from them and from the records
+ * already in it, which is much cheaper than inserting them one by one.
+ */
+void BTree::Load (Schema &mySchema, char *loadMe)
+{
+	EventLogger *el = EventLogger::getEventLogger();
+
+	BulkLoader loader;
+	if (!loader.Open(loadMe, mySchema))
+	{
+		el->writeLog("Can't open file name :" + string(loadMe));
+		return;
+	}
+
+	Pipe inPipe(PIPE_SIZE), outPipe(PIPE_SIZE);
+	BigQ bq(inPipe, outPipe, *(m_pSortInfo->myOrder), m_pSortInfo->runLength,
+			m_pFile->GetPageSize(), m_pFile->GetCompression(), SORTED_RUNS, -1, "b+ tree load");
+
+	Page *pPage;
+	Record aRecord;
+	while ((pPage = loader.GetNextPage()) != NULL)
+	{
+		while (pPage->GetFirst(&aRecord))
+			inPipe.Insert(&aRecord);
+	}
+	loader.Close();
+	inPipe.ShutDown();
+
+	BulkLoad(outPipe);
+}
+
+// next record of the leaves of a tree, in key order; nNext is
+// the leaf to read once "leaf" is exhausted, -1 if none
+static int NextFromLeaves(File *pFile, Page &leaf, int &nNext, Record &rec)
+{
+	while (!leaf.GetFirst(&rec))
+	{
+		if (nNext == -1)
+			return 0;
+		pFile->GetPage(&leaf, nNext);
+		Record header;
+		leaf.GetFirst(&header);
+		nNext = header.GetIntAtt(1);
+	}
+	return 1;
+}
+
+void BTree::BulkLoad(Pipe &sortedIn)
+{
+	int nPageSize = m_pFile->GetPageSize();
+	int nCompression = m_pFile->GetCompression();
+	int nFill = (int) (nPageSize * BTREE_FILL_FACTOR);
+	ComparisonEngine ce;
+
+	// the old tree is read through a mapping while the
+	// new one is written next to it, then takes its place
+	m_pReadAhead->Stop();
+	m_pFile->Close();
+	File oldFile;
+	Page oldLeaf;
+	int nOldNext = -1;
+	if (m_nRoot != -1)
+	{
+		oldFile.Open(READ_ONLY, const_cast<char*>(m_sFilePath.c_str()));
+		oldFile.SetAccessPattern(SEQUENTIAL_ACCESS);
+		nOldNext = m_nFirstLeaf;
+	}
+	string sTmpFile = m_sFilePath + ".tmp";
+	m_pFile->Open(TRUNCATE, const_cast<char*>(sTmpFile.c_str()), nPageSize, nCompression);
+
+	// leaves: merge the two sorted streams, cutting a leaf whenever
+	// the next record would take it over the fill factor
+	vector<Record*> vLeaf, vKeys;
+	int nBytes = sizeof(int) + 5 * sizeof(int);	// page count and header
+	int nPage = 0;
+	Record *pFromPipe = new Record, *pFromOld = new Record;
+	int bPipe = sortedIn.Remove(pFromPipe);
+	int bOld = NextFromLeaves(&oldFile, oldLeaf, nOldNext, *pFromOld);
+	while (bPipe || bOld)
+	{
+		Record *pRec = new Record;
+		if (bPipe && (!bOld || ce.Compare(pFromPipe, pFromOld, m_pSortInfo->myOrder) < 0))
+		{
+			pRec->Consume(pFromPipe);
+			bPipe = sortedIn.Remove(pFromPipe);
+		}
+		else
+		{
+			pRec->Consume(pFromOld);
+			bOld = NextFromLeaves(&oldFile, oldLeaf, nOldNext, *pFromOld);
+		}
+
+		int nLen = ((int *) pRec->bits)[0];
+		if (!vLeaf.empty() && nBytes + nLen > nFill)
+		{
+			WriteNode(nPage, 0, nPage + 1, vLeaf, 0, vLeaf.size());
+			for (int i = 0; i < vLeaf.size(); i++)
+				delete vLeaf[i];
+			vLeaf.clear();
+			nBytes = sizeof(int) + 5 * sizeof(int);
+			nPage++;
+		}
+		if (vLeaf.empty())
+		{
+			Record *pKey = new Record;
+			MakeKey(*pRec, nPage, *pKey);
+			vKeys.push_back(pKey);
+		}
+		vLeaf.push_back(pRec);
+		nBytes += nLen;
+	}
+	delete pFromPipe;
+	delete pFromOld;
+	if (!vLeaf.empty())
+	{
+		WriteNode(nPage, 0, -1, vLeaf, 0, vLeaf.size());
+		for (int i = 0; i < vLeaf.size(); i++)
+			delete vLeaf[i];
+		nPage++;
+	}
+	oldFile.Close();
+
+	m_nRoot = vKeys.empty() ? -1 : 0;
+	m_nHeight = 0;
+	m_nFirstLeaf = m_nRoot;
+
+	// levels above: the first key of every node of a level is
+	// the entry of that node in the level above
+	while (vKeys.size() > 1)
+	{
+		vector<Record*> vUpper;
+		m_nHeight++;
+		int nFirst = 0;
+		while (nFirst < vKeys.size())
+		{
+			int nLast = nFirst + 1;
+			nBytes = sizeof(int) + 5 * sizeof(int);
+			while (nLast < vKeys.size() && nBytes + ((int *) vKeys[nLast]->bits)[0] <= nFill)
+				nBytes += ((int *) vKeys[nLast++]->bits)[0];
+
+			WriteNode(nPage, m_nHeight, GetChild(*vKeys[nFirst]), vKeys, nFirst + 1, nLast);
+			SetChild(*vKeys[nFirst], nPage);
+			vUpper.push_back(vKeys[nFirst]);
+			for (int i = nFirst + 1; i < nLast; i++)
+				delete vKeys[i];
+			nFirst = nLast;
+			nPage++;
+		}
+		vKeys.swap(vUpper);
+	}
+	if (!vKeys.empty())
+	{
+		m_nRoot = GetChild(*vKeys[0]);
+		delete vKeys[0];
+	}
+
+	m_pFile->Close();
+	if (rename(sTmpFile.c_str(), m_sFilePath.c_str()) != 0)
+		perror("error in renaming temp file");
+	m_pFile->Open(APPEND, const_cast<char*>(m_sFilePath.c_str()));
+	WriteMetaData();
+	MoveFirst();
+}
+
+void BTree::Add (Record &rec)
+{
+	OrderMaker *pOrder = m_pSortInfo->myOrder;
+	Record aRecord;
+	aRecord.Consume(&rec);
+
+	// first record, the root is a leaf
+	if (m_nRoot == -1)
+	{
+		vector<Record*> vRecs(1, &aRecord);
+		WriteNode(0, 0, -1, vRecs, 0, 1);
+		m_nRoot = 0;
+		m_nHeight = 0;
+		m_nFirstLeaf = 0;
+		MoveFirst();
+		return;
+	}
+
+	// equal keys go after the ones already there
+	vector<int> vPath;
+	int nLevel, nLink;
+	int nPage = FindLeaf(aRecord, pOrder, true, &vPath);
+	ReadNode(*m_pNodePage, nPage, nLevel, nLink);
+	int nPos = FindSlot(*m_pNodePage, aRecord, pOrder, true, true);
+
+	// splits go up the path, separators alternate between the two records
+	Record separators[2];
+	int nCurr = 0;
+	int bSplit = InsertEntry(*m_pNodePage, nPage, 0, nLink, nPos, aRecord, separators[nCurr]);
+	while (bSplit && !vPath.empty())
+	{
+		nPage = vPath.back();
+		vPath.pop_back();
+		ReadNode(*m_pNodePage, nPage, nLevel, nLink);
+		nPos = FindSlot(*m_pNodePage, separators[nCurr], &m_KeyOrder, true, false);
+		bSplit = InsertEntry(*m_pNodePage, nPage, nLevel, nLink, nPos,
+							 separators[nCurr], separators[1 - nCurr]);
+		nCurr = 1 - nCurr;
+	}
+
+	// the root was split, the tree grows by one level
+	if (bSplit)
+	{
+		int nNewRoot = GetNumPages();
+		vector<Record*> vRecs(1, &separators[nCurr]);
+		WriteNode(nNewRoot, m_nHeight + 1, m_nRoot, vRecs, 0, 1);
+		m_nRoot = nNewRoot;
+		m_nHeight++;
+	}
+
+	// pages of the scan may have changed
+	MoveFirst();
+}
+
+int BTree::InsertEntry(Page &node, int nPage, int nLevel, int nLink, int nPos,
+					   Record &entry, Record &separator)
+{
+	int nRecs = node.GetNumRecs();
+	int nBytes = sizeof(int) + 5 * sizeof(int) + ((int *) entry.bits)[0];
+	Record rec;
+	for (int i = 0; i < nRecs; i++)
+	{
+		node.GetRecord(i, &rec);
+		nBytes += ((int *) rec.bits)[0];
+	}
+
+	// most of the time it fits, copy the records straight over
+	if (nBytes <= m_pFile->GetPageSize())
+	{
+		StartNode(nLevel, nLink);
+		for (int i = 0; i < nRecs; i++)
+		{
+			if (i == nPos)
+				AppendToNode(entry);
+			node.GetRecord(i, &rec);
+			AppendToNode(rec);
+		}
+		if (nPos >= nRecs)
+			AppendToNode(entry);
+		m_pFile->AddPage(m_pOutPage, nPage);
+		return 0;
+	}
+
+	// views on the records of the node, with the new one in its place
+	vector<Record*> vRecs;
+	vRecs.reserve(nRecs + 1);
+	for (int i = 0; i < nRecs; i++)
+	{
+		if (i == nPos)
+			vRecs.push_back(&entry);
+		Record *pRec = new Record;
+		node.GetRecord(i, pRec);
+		vRecs.push_back(pRec);
+	}
+	if (nPos >= nRecs)
+		vRecs.push_back(&entry);
+
+	// cut in the middle, by size; the right half goes to a new page
+	int nSplit = 0, nLeft = sizeof(int) + 5 * sizeof(int);
+	while (nSplit < (int) vRecs.size() - 1 &&
+		   (nSplit == 0 || 2 * (nLeft + ((int *) vRecs[nSplit]->bits)[0]) <= nBytes))
+		nLeft += ((int *) vRecs[nSplit++]->bits)[0];
+	int nNewPage = GetNumPages();
+
+	// WriteNode consumes the records, take the separator out first
+	if (nLevel == 0)
+	{
+		// leaves stay chained, the separator is the first key on the right
+		MakeKey(*vRecs[nSplit], nNewPage, separator);
+		WriteNode(nNewPage, 0, nLink, vRecs, nSplit, vRecs.size());
+		WriteNode(nPage, 0, nNewPage, vRecs, 0, nSplit);
+	}
+	else
+	{
+		// the middle entry moves up, its child is the first one on the right
+		int nRightLink = GetChild(*vRecs[nSplit]);
+		separator.Copy(vRecs[nSplit]);
+		SetChild(separator, nNewPage);
+		WriteNode(nNewPage, nLevel, nRightLink, vRecs, nSplit + 1, vRecs.size());
+		WriteNode(nPage, nLevel, nLink, vRecs, 0, nSplit);
+	}
+
+	for (int i = 0; i < vRecs.size(); i++)
+		if (vRecs[i] != &entry)
+			delete vRecs[i];
+	return 1;
+}
+
+void BTree::StartNode(int nLevel, int nLink)
+{
+	m_pOutPage->EmptyItOut();
+	m_pOutPage->SetPageSize(m_pFile->GetPageSize());
+
+	Record header;
+	MakeHeader(nLevel, nLink, header);
+	m_pOutPage->Append(&header);
+}
+
+void BTree::AppendToNode(Record &rec)
+{
+	if (!m_pOutPage->Append(&rec))
+	{
+		cerr << "BAD: a record does not fit in a B+-tree node of " << m_sFilePath << "\n";
+		exit(1);
+	}
+}
+
+void BTree::WriteNode(int nPage, int nLevel, int nLink, vector<Record*> &vRecs,
+					  int nFrom, int nTo)
+{
+	StartNode(nLevel, nLink);
+	for (int i = nFrom; i < nTo; i++)
+		AppendToNode(*vRecs[i]);
+	m_pFile->AddPage(m_pOutPage, nPage);
+}
+
+void BTree::ReadNode(Page &page, int nPage, int &nLevel, int &nLink)
+{
+	m_pFile->GetPage(&page, nPage);
+
+	Record header;
+	if (!page.GetFirst(&header))
+	{
+		cerr << "BAD: page " << nPage << " of " << m_sFilePath << " is not a B+-tree node\n";
+		exit(1);
+	}
+	nLevel = header.GetIntAtt(0);
+	nLink = header.GetIntAtt(1);
+}
+
+void BTree::MakeHeader(int nLevel, int nLink, Record &header)
+{
+	// two Int attributes
+	Record rec;
+	rec.bits = RecordMemory::Alloc(5 * sizeof(int));
+	((int *) rec.bits)[0] = 5 * sizeof(int);
+	((int *) rec.bits)[1] = 3 * sizeof(int);
+	((int *) rec.bits)[2] = 4 * sizeof(int);
+	((int *) rec.bits)[3] = nLevel;
+	((int *) rec.bits)[4] = nLink;
+	header.Consume(&rec);
+}
+
+void BTree::MakeKey(Record &data, int nChild, Record &key)
+{
+	OrderMaker *pOrder = m_pSortInfo->myOrder;
+	int nAtts = pOrder->numAtts;
+	char *src = data.bits;
+	int nSrcAtts = ((int *) src)[1] / sizeof(int) - 1;
+
+	// first find out how big the key is; attributes keep
+	// the alignment they have in a record made by ComposeRecord
+	int nPos = sizeof(int) * (nAtts + 2);
+	for (int i = 0; i < nAtts; i++)
+	{
+		int att = pOrder->whichAtts[i];
+		int nStart = ((int *) src)[att + 1];
+		int nEnd = (att + 1 < nSrcAtts) ? ((int *) src)[att + 2] : ((int *) src)[0];
+		if (pOrder->whichTypes[i] == Double)
+			while (nPos % sizeof(double) != 0)
+				nPos += sizeof(int);
+		nPos += nEnd - nStart;
+	}
+	nPos += sizeof(int);
+
+	// then copy the attributes over, followed by the child
+	Record rec;
+	rec.bits = RecordMemory::Alloc(nPos);
+	((int *) rec.bits)[0] = nPos;
+	nPos = sizeof(int) * (nAtts + 2);
+	for (int i = 0; i < nAtts; i++)
+	{
+		int att = pOrder->whichAtts[i];
+		int nStart = ((int *) src)[att + 1];
+		int nEnd = (att + 1 < nSrcAtts) ? ((int *) src)[att + 2] : ((int *) src)[0];
+		if (pOrder->whichTypes[i] == Double)
+			while (nPos % sizeof(double) != 0)
+				nPos += sizeof(int);
+		((int *) rec.bits)[i + 1] = nPos;
+		memcpy(rec.bits + nPos, src + nStart, nEnd - nStart);
+		nPos += nEnd - nStart;
+	}
+	((int *) rec.bits)[nAtts + 1] = nPos;
+	*((int *) (rec.bits + nPos)) = nChild;
+	key.Consume(&rec);
+}
+
+int BTree::GetChild(Record &key)
+{
+	return key.GetIntAtt(m_KeyOrder.numAtts);
+}
+
+void BTree::SetChild(Record &key, int nChild)
+{
+	*((int *) (key.bits + ((int *) key.bits)[m_KeyOrder.numAtts + 1])) = nChild;
+}
+
+int BTree::FindSlot(Page &page, Record &target, OrderMaker *pTargetOrder,
+					bool bAfterEqual, bool bLeaf)
+{
+	ComparisonEngine ce;
+	OrderMaker *pOrder = bLeaf ? m_pSortInfo->myOrder : &m_KeyOrder;
+	Record rec;
+
+	int nLow = 0, nHigh = page.GetNumRecs();
+	while (nLow < nHigh)
+	{
+		int nMid = (nLow + nHigh) / 2;
+		page.GetRecord(nMid, &rec);
+		int nCmp = ce.Compare(&target, pTargetOrder, &rec, pOrder);
+		if (nCmp > 0 || (bAfterEqual && nCmp == 0))
+			nLow = nMid + 1;
+		else
+			nHigh = nMid;
+	}
+	return nLow;
+}
+
+int BTree::FindLeaf(Record &target, OrderMaker *pTargetOrder, bool bAfterEqual,
+					vector<int> *pPath)
+{
+	int nPage = m_nRoot;
+	int nLevel, nLink;
+	Record entry;
+	for (int i = m_nHeight; i > 0; i--)
+	{
+		ReadNode(*m_pNodePage, nPage, nLevel, nLink);
+		if (pPath)
+			pPath->push_back(nPage);
+
+		// last entry below (or not above) the target; none means the
+		// child that holds the smallest keys
+		int nSlot = FindSlot(*m_pNodePage, target, pTargetOrder, bAfterEqual, false);
+		if (nSlot == 0)
+			nPage = nLink;
+		else
+		{
+			m_pNodePage->GetRecord(nSlot - 1, &entry);
+			nPage = GetChild(entry);
+		}
+	}
+	return nPage;
+}
+
+void BTree::MoveFirst ()
+{
+	m_pPage->EmptyItOut();
+	m_nCurrPage = -1;
+	m_nNextPage = -1;
+	m_bFileOrderScan = false;
+	m_pReadAhead->Reset();
+	m_pFile->SetAccessPattern(SEQUENTIAL_ACCESS);
+
+	m_bQueryStarted = false;
+	m_bQueryDone = false;
+	delete m_pQueryOrderMaker;
+	m_pQueryOrderMaker = NULL;
+	m_pStopOrder = NULL;
+}
+
+void BTree::LoadLeaf(int nPage)
+{
+	int nLevel, nLink;
+	ReadNode(*m_pPage, nPage, nLevel, nLink);
+	m_nCurrPage = nPage;
+
+	if (m_bFileOrderScan)
+	{
+		// internal nodes have nothing to give
+		if (nLevel != 0)
+			m_pPage->EmptyItOut();
+		m_nNextPage = (nPage + 1 < GetNumPages()) ? nPage + 1 : -1;
+	}
+	else
+		m_nNextPage = nLink;
+
+	// leaves written by a bulk load follow each other
+	if (m_nNextPage == nPage + 1)
+		m_pReadAhead->Advance(nPage, GetNumPages() - 1);
+}
+
+int BTree::FetchNext(Record &fetchme)
+{
+	while (m_nCurrPage == -1 || !m_pPage->GetFirst(&fetchme))
+	{
+		int nNext = m_nNextPage;
+		if (m_nCurrPage == -1)
+		{
+			if (m_nRoot == -1)
+				return RET_FAILURE;
+			nNext = m_bFileOrderScan ? 0 : m_nFirstLeaf;
+		}
+		if (nNext == -1)
+			return RET_FAILURE;
+		LoadLeaf(nNext);
+	}
+	return RET_SUCCESS;
+}
+
+void BTree::Seek(Record &literal, OrderMaker *pLiteralOrder)
+{
+	if (m_nRoot == -1)
+		return;
+
+	// going down the tree jumps around, read-ahead would only waste I/O
+	m_pFile->SetAccessPattern(RANDOM_ACCESS);
+	int nLeaf = FindLeaf(literal, pLiteralOrder, false, NULL);
+	LoadLeaf(nLeaf);
+
+	// skip what is below the literal in that leaf
+	int nSkip = FindSlot(*m_pPage, literal, pLiteralOrder, false, true);
+	Record rec;
+	for (int i = 0; i < nSkip; i++)
+		m_pPage->GetFirst(&rec);
+}
+
+// Function to fetch the next record in the file in "fetchme"
+// Returns 0 on failure
+int BTree::GetNext (Record &fetchme)
+{
+	return FetchNext(fetchme);
+}
+
+// Function to fetch the next record in "fetchme" that matches
+// the given CNF, returns 0 on failure.
+int BTree::GetNext (Record &fetchme, CNF &cnf, Record &literal)
+{
+	OrderMaker *pOrder = m_pSortInfo->myOrder;
+
+	/* Logic:
+	 * On the first call, see what the CNF tells about the key:
+	 * an equality on a prefix of the key, or else a range on its first
+	 * attribute. Go down the tree to the first record that can match,
+	 * and stop the scan at the first one above the equality or the
+	 * upper bound. Without any of them (or for a SEQUENTIAL_ACCESS scan)
+	 * every leaf is read. The CNF is applied to every record.
+	 */
+	if (!m_bQueryStarted)
+	{
+		m_bQueryStarted = true;
+		if (m_eAccess == SEQUENTIAL_ACCESS)
+		{
+			// order does not matter to a selection, go through the pages as they are on disk
+			if (m_nCurrPage == -1)
+				m_bFileOrderScan = true;
+		}
+		else if ((m_pQueryOrderMaker = cnf.GetMatchingOrder(*pOrder)) != NULL)
+		{
+			Seek(literal, m_pQueryOrderMaker);
+			m_pStopOrder = m_pQueryOrderMaker;
+		}
+		else
+		{
+			int nLow, nHigh;
+			cnf.GetRangeBounds(pOrder->whichAtts[0], nLow, nHigh);
+			if (nLow != -1)
+			{
+				m_LowOrder.numAtts = 1;
+				m_LowOrder.whichAtts[0] = nLow;
+				m_LowOrder.whichTypes[0] = pOrder->whichTypes[0];
+				Seek(literal, &m_LowOrder);
+			}
+			if (nHigh != -1)
+			{
+				m_HighOrder.numAtts = 1;
+				m_HighOrder.whichAtts[0] = nHigh;
+				m_HighOrder.whichTypes[0] = pOrder->whichTypes[0];
+				m_pStopOrder = &m_HighOrder;
+			}
+		}
+	}
+
+	if (m_bQueryDone)
+		return RET_FAILURE;
+
+	ComparisonEngine compEngine;
+	while (FetchNext(fetchme))
+	{
+		// past the last record that can match
+		if (m_pStopOrder && compEngine.Compare(&literal, m_pStopOrder, &fetchme, pOrder) < 0)
+			break;
+		if (compEngine.Compare(&fetchme, &literal, &cnf))
+			return RET_SUCCESS;
+	}
+
+	//if control is here then no matching record was found
+	m_bQueryDone = true;
+	return RET_FAILURE;
+}
+
+void BTree::SetAccessPattern (AccessPattern pattern)
+{
+	m_eAccess = pattern;
+}
+
+int BTree::GetNumPages()
+{
+	// the header counts as a page
+	int nLength = m_pFile->GetLength();
+	return (nLength > 0) ? nLength - 1 : 0;
+}
+
+// Create <table_name>.meta.data file
+// And write the sort order and where the tree starts in it
+void BTree::WriteMetaData()
+{
+	if (!m_sFilePath.empty())
+	{
+		ofstream meta_out;
+		meta_out.open(string(m_sFilePath + m_sMetaSuffix).c_str(), ios::trunc);
+
+		//---- <tbl_name>.meta.data file looks like this ----
+		//tree
+		//<runLength>
+		//<number of attributes in orderMaker>
+		//<attribute index><type>
+		//....
+		//<root page, -1 if empty>
+		//<levels above the leaves>
+		//<first leaf page>
+
+		meta_out << "tree\n";
+		meta_out << m_pSortInfo->runLength << "\n";
+		meta_out << m_pSortInfo->myOrder->ToString();
+		meta_out << m_nRoot << "\n";
+		meta_out << m_nHeight << "\n";
+		meta_out << m_nFirstLeaf << "\n";
+		meta_out.close();
+	}
+}
@@ -0,0 +1,145 @@
+#ifndef BTREE_H
+#define BTREE_H
+
+#include <vector>
+#include "GenericDBFile.h"
+#include "Pipe.h"
+#include "BigQ.h"
+#include "Sorted.h"
+
+// share of a leaf filled by a bulk load, the rest is left for later inserts
+#define BTREE_FILL_FACTOR 0.9
+
+// Page based B+-tree keyed by the OrderMaker of its SortInfo.
+// Every page of the file is a node, and holds Records:
+//  - the first one is the node header, two Ints: the level of the node
+//    (0 for a leaf) and a page link; the next leaf for a leaf (-1 for the
+//    last one), the child holding the smallest keys for an internal node
+//  - a leaf then holds the data records in key order
+//  - an internal node then holds its entries in key order; an entry is the
+//    key attributes (in OrderMaker order) followed by an Int: the child
+//    holding the keys >= the entry and < the next entry
+// The root, the height and the first leaf are kept in the .meta.data file
+class BTree : public GenericDBFile
+{
+	private:
+		SortInfo *m_pSortInfo;
+		OrderMaker m_KeyOrder;		// order of the keys inside an entry
+		File *m_pFile;
+		ReadAhead *m_pReadAhead;
+		string m_sFilePath;
+		string m_sMetaSuffix;
+		bool m_bReadOnly;
+
+		int m_nRoot;				// page of the root, -1 if the tree is empty
+		int m_nHeight;				// levels above the leaves
+		int m_nFirstLeaf;
+
+		Page *m_pNodePage;			// scratch pages for going down the tree
+		Page *m_pOutPage;			// and for writing nodes
+
+		// scan state
+		Page *m_pPage;				// leaf the scan is in
+		int m_nCurrPage;			// its page number, -1 before the first one
+		int m_nNextPage;			// leaf after it, -1 if none
+		AccessPattern m_eAccess;
+		bool m_bFileOrderScan;		// going through the pages, not the leaf links
+
+		// state of GetNext(CNF), kept until MoveFirst or Add
+		bool m_bQueryStarted;
+		bool m_bQueryDone;
+		OrderMaker *m_pQueryOrderMaker;	// equality on a prefix of the key
+		OrderMaker m_LowOrder;			// bounds on the first key attribute,
+		OrderMaker m_HighOrder;			// positions in the literal
+		OrderMaker *m_pStopOrder;		// stop once the literal is below this
+
+		// Private functions
+		void WriteMetaData();
+		int GetNumPages();
+
+		// node access
+		void ReadNode(Page &page, int nPage, int &nLevel, int &nLink);
+		void MakeHeader(int nLevel, int nLink, Record &header);
+		void MakeKey(Record &data, int nChild, Record &key);
+		int GetChild(Record &key);
+		void SetChild(Record &key, int nChild);
+
+		// number of records (leaf) or entries (internal node) of the page
+		// that are below "target", or not above it when bAfterEqual
+		int FindSlot(Page &page, Record &target, OrderMaker *pTargetOrder,
+					 bool bAfterEqual, bool bLeaf);
+
+		// leaf where "target" is, or would be; pPath gets the internal
+		// nodes on the way down, root first
+		int FindLeaf(Record &target, OrderMaker *pTargetOrder, bool bAfterEqual,
+					 vector<int> *pPath);
+
+		// puts "entry" at position nPos of the node; returns 1 if the node
+		// had to be split, then separator is the entry to add in the parent
+		int InsertEntry(Page &node, int nPage, int nLevel, int nLink, int nPos,
+						Record &entry, Record &separator);
+
+		// fill m_pOutPage with a node: header first, then the records
+		void StartNode(int nLevel, int nLink);
+		void AppendToNode(Record &rec);
+
+		// writes the records (views or owned) as one node
+		void WriteNode(int nPage, int nLevel, int nLink, vector<Record*> &vRecs,
+					   int nFrom, int nTo);
+
+		// builds a new tree in m_pFile from records coming in key order
+		void BulkLoad(Pipe &sortedIn);
+
+		// next record of the scan, following the leaves (or the pages of
+		// the file, for a SEQUENTIAL_ACCESS scan)
+		int FetchNext(Record &fetchMe);
+		void LoadLeaf(int nPage);
+
+		// puts the scan on the first record that is not below the literal
+		void Seek(Record &literal, OrderMaker *pLiteralOrder);
+
+	public:
+		BTree();
+		~BTree();
+
+		// name = location of the file
+		// startup = SortInfo, the tree is keyed on its OrderMaker
+		// return value: 1 on success, 0 on failure
+		int Create (char *name, void *startup, int pageSize = PAGE_SIZE, int compression = COMPRESS_NONE);
+
+		// This function assumes that the DBFile already exists
+		// and has previously been created and then closed.
+		int Open (char *name, FileOpenMode mode = APPEND);
+
+		// Closes the file.
+		// The return value is a 1 on success and a zero on failure
+		int Close ();
+
+		// Bulk loads the DBFile instance from a text file. The records are
+		// sorted with a BigQ, merged with those already in the tree, and
+		// the tree is rebuilt bottom up
+		void Load (Schema &mySchema, char *loadMe);
+
+		// Forces the pointer to correspond to the first record in the file
+		void MoveFirst();
+
+		// Inserts the record in its leaf, splitting nodes as needed
+		// Note: addMe is consumed by this function and cannot be used again
+		void Add (Record &addMe);
+
+		// Fetch next record, in key order
+		int GetNext (Record &fetchMe);
+
+		// Applies CNF and then fetches the next record. The first call after
+		// MoveFirst goes down the tree to the first record that can match an
+		// equality on a key prefix, or a range on the first key attribute,
+		// and the scan stops past the last one
+		int GetNext (Record &fetchMe, CNF &applyMe, Record &literal);
+
+		// SEQUENTIAL_ACCESS: the predicates are not selective, GetNext(CNF)
+		// reads the leaves in file order instead of going down the tree
+		void SetAccessPattern (AccessPattern pattern);
+		int GetPageSize () { return m_pFile->GetPageSize(); }
+};
+
+#endif
@@ -1,11 +1,28 @@
 #include "BigQ.h"
 #include "math.h"
-#include <queue>
+#include <sys/time.h>
+#include <unistd.h>
+#include <sstream>
 
 using namespace std;
 
-BigQ :: BigQ (Pipe &in, Pipe &out, OrderMaker &sortorder, int runlen)
-	: m_runFile(), m_nRunLen(runlen), m_sFileName(), m_nAppendCount(0)
+static double Now()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+pthread_mutex_t BigQ::m_statsMutex = PTHREAD_MUTEX_INITIALIZER;
+deque<RunStats> BigQ::m_qStats;
+
+BigQ :: BigQ (Pipe &in, Pipe &out, OrderMaker &sortorder, int runlen, int pageSize, int compression,
+			  RunGeneration runGen, int nSortThreads, const char *label)
+	: m_runFile(), m_nRunLen(max(runlen, SORT_MIN_PAGES)), m_nPageSize(pageSize), m_nCompression(compression),
+	  m_sFileName(), m_sLabel(label), m_nAppendCount(0), m_eRunGen(runGen), m_nPagesBefore(0), m_nRunRecords(0),
+	  m_stats(), m_nSortThreads(nSortThreads), m_nRunPages(max(runlen, SORT_MIN_PAGES)), m_vSortThreads(), m_vBuffers(), m_vFree(),
+	  m_qToSort(), m_mSorted(), m_nFilled(0), m_nWritten(0), m_bInputDone(false),
+	  m_nInitialRuns(0), m_nFanIn(0), m_nFinalFanIn(0), m_vMergePlan(), m_vFinalRuns(), m_sPlan()
 {
     //init data structures
     m_pInPipe = &in;
@@ -14,9 +31,28 @@ BigQ :: BigQ (Pipe &in, Pipe &out, OrderMaker &sortorder, int runlen)
 //    m_sFileName = "runFile" + getTime();
     m_sFileName = "runFile" + System::getusec();
 
-    m_runFile.Create(const_cast<char*>(m_sFileName.c_str()));
+    m_runFile.Create(const_cast<char*>(m_sFileName.c_str()), m_nPageSize, m_nCompression);
 	m_runFile.Close();
 
+	// one thread per processor, the reading one included
+	if (m_nSortThreads < 0)
+	{
+		long nProcs = sysconf(_SC_NPROCESSORS_ONLN);
+		m_nSortThreads = min((long) SORT_MAX_THREADS, max(nProcs, 1L)) - 1;
+	}
+	if (m_eRunGen == REPLACEMENT_SELECTION)
+		m_nSortThreads = 0;
+
+	// the buffers of the runs in flight share the memory, a page or more
+	// each, and there is no point in threads without a run to sort
+	m_nSortThreads = max(0, min(m_nSortThreads, m_nRunLen - 2));
+	if (m_nSortThreads > 0)
+		m_nRunPages = m_nRunLen / (m_nSortThreads + 2);
+	pthread_mutex_init(&m_runMutex, NULL);
+	pthread_cond_init(&m_freeVar, NULL);
+	pthread_cond_init(&m_sortVar, NULL);
+	pthread_cond_init(&m_writeVar, NULL);
+
 #ifdef _DEBUG
         cout<<"BigQ : temp runFile name : " << m_sFileName << endl;
 //    m_pSortOrder->Print();
@@ -31,17 +67,16 @@ BigQ :: BigQ (Pipe &in, Pipe &out, OrderMaker &sortorder, int runlen)
 BigQ::~BigQ ()
 {
     // loop over m_vRuns and empty it out
-	Run * r = NULL;
-	for (int i=0; i < m_vRuns.size(); i++)
-	{
-		r = m_vRuns.at(i);
-		delete r;
-		r = NULL;
-	}
+	ClearRuns();
 
 	// remove runFile
 	if(remove(m_sFileName.c_str()) != 0)
     	perror("error in removing old file");
+
+	pthread_mutex_destroy(&m_runMutex);
+	pthread_cond_destroy(&m_freeVar);
+	pthread_cond_destroy(&m_sortVar);
+	pthread_cond_destroy(&m_writeVar);
 }
 
 void* BigQ::getRunsFromInputPipeHelper(void* context)
@@ -53,6 +88,7 @@ void* BigQ::getRunsFromInputPipeHelper(void* context)
 #ifdef _DEBUG
     cout<<"called from Helper"<<endl;
 #endif
+    return NULL;
 }
 
 void* BigQ::getRunsFromInputPipe()
@@ -60,105 +96,362 @@ void* BigQ::getRunsFromInputPipe()
 #ifdef _DEBUG
     cout<<"\n\n "<< m_sFileName << " :inside getRunsFrom Pipe"<<endl;
 #endif
+    double dStart = Now();
+    if (m_eRunGen == REPLACEMENT_SELECTION)
+        getRunsBySelection();
+    else
+        getRunsBySorting();
+
+	#ifdef _DEBUG
+	for (int l = 0; l < m_vRunLengths.size(); l++)
+	{
+		cout << "\nRun " << l << " length " << m_vRunLengths.at(l);
+	}
+	#endif
+    double dRunsDone = Now();
+
+    //now call mergeRuns here!
+    MergeRuns();
+    SetStats(dRunsDone - dStart, Now() - dRunsDone);
+    m_pOutPipe->ShutDown();
+    return NULL;
+}
+
+void BigQ::getRunsBySorting()
+{
     Record recFromPipe;
-    vector<Record*> aRunVector;		
-    Page currentPage;
+    int pageBytes = sizeof(int);    // what Page::Append counts for the page being filled
     int pageCountPerRun = 0;
-    bool allSorted = true;
-    bool overflowRec = false;
 
 	int recs = 0;
 
+    StartRunThreads();
+    RunBuffer *pBuf = GetFreeBuffer();
     while(m_pInPipe->Remove(&recFromPipe))
     {
 		recs++;
-        Record *copyRec = new Record();
-        copyRec->Copy(&recFromPipe); //because currentPage.Append() would consume the record
+        int len = ((int *) recFromPipe.bits)[0];
 
-        //initially pageCountPerRun is always less than m_nRunLen (as runLen can't be 0)
-        if(!currentPage.Append(&recFromPipe))
+        //initially pageCountPerRun is always less than m_nRunPages (as it can't be 0)
+        if(pageBytes + len > m_nPageSize)
         {
-            //page full, start new page and increase the page count both global and local
+            //page full, start new page and increase the page count
             pageCountPerRun++;
-            currentPage.EmptyItOut();
-            currentPage.Append(&recFromPipe);
-            if(pageCountPerRun >= m_nRunLen)
+            pageBytes = sizeof(int);
+            if(pageCountPerRun >= m_nRunPages)
             {
-                //this is the only check for pageCount >= runLen and is sufficient
-                //because pageCount can never increase until a record spills over
-                overflowRec = true;
+                //one run is full, hand it to be sorted and written
+                //then start the next run with this record
+                SubmitRun(pBuf);
+                pBuf = GetFreeBuffer();
                 pageCountPerRun = 0;    //reset pageCountPerRun for next run as current run is full
             }
         }
-        if(!overflowRec)
+        pageBytes += len;
+
+        //copy the record into the arena, the pipe gets its bits back right away
+        if(pBuf->vRecs.size() == pBuf->vRecPool.size())
+            pBuf->vRecPool.push_back(new Record());
+        Record *copyRec = pBuf->vRecPool[pBuf->vRecs.size()];
+        pBuf->arena.Copy(recFromPipe, *copyRec);
+        pBuf->vRecs.push_back(copyRec);
+    }
+#ifdef _DEBUG
+    cout<<"\n\n "<< m_sFileName << " : "<< recs << "recs removed from inPipe"<<endl;
+#endif
+
+    //done with all records in pipe, if there is anything in the buffer
+    //it should be sorted and written out to file
+    if(!pBuf->vRecs.empty())
+        SubmitRun(pBuf);
+    StopRunThreads();
+}
+
+void BigQ::StartRunThreads()
+{
+    // one buffer being filled, one being sorted by every sorter and one
+    // being written
+    int nBuffers = (m_nSortThreads > 0) ? m_nSortThreads + 2 : 1;
+    for (int i = 0; i < nBuffers; i++)
+    {
+        m_vBuffers.push_back(new RunBuffer());
+        m_vFree.push_back(m_vBuffers.back());
+    }
+
+    for (int i = 0; i < m_nSortThreads; i++)
+    {
+        pthread_t thread;
+        pthread_create(&thread, NULL, &SortRunsHelper, (void*)this);
+        m_vSortThreads.push_back(thread);
+    }
+    if (m_nSortThreads > 0)
+        pthread_create(&m_writeThread, NULL, &WriteRunsHelper, (void*)this);
+}
+
+void BigQ::StopRunThreads()
+{
+    pthread_mutex_lock(&m_runMutex);
+    m_bInputDone = true;
+    pthread_cond_broadcast(&m_sortVar);
+    pthread_cond_broadcast(&m_writeVar);
+    pthread_mutex_unlock(&m_runMutex);
+
+    for (int i = 0; i < m_vSortThreads.size(); i++)
+        pthread_join(m_vSortThreads[i], NULL);
+    if (m_nSortThreads > 0)
+        pthread_join(m_writeThread, NULL);
+
+    for (int i = 0; i < m_vBuffers.size(); i++)
+    {
+        RunBuffer *pBuf = m_vBuffers[i];
+        for (int j = 0; j < pBuf->vRecPool.size(); j++)
+            delete pBuf->vRecPool[j];
+        delete pBuf;
+    }
+    m_vBuffers.clear();
+    m_vFree.clear();
+}
+
+BigQ::RunBuffer* BigQ::GetFreeBuffer()
+{
+    pthread_mutex_lock(&m_runMutex);
+    while (m_vFree.empty())
+        pthread_cond_wait(&m_freeVar, &m_runMutex);
+    RunBuffer *pBuf = m_vFree.back();
+    m_vFree.pop_back();
+    pthread_mutex_unlock(&m_runMutex);
+    return pBuf;
+}
+
+void BigQ::SubmitRun(RunBuffer *pBuf)
+{
+    if (m_nSortThreads == 0)
+    {
+        sort(pBuf->vRecs.begin(), pBuf->vRecs.end(), CompareMyRecords(m_pSortOrder));
+        appendRunToFile(pBuf->vRecs);
+        pBuf->vRecs.clear();
+        pBuf->arena.Reset();
+        pthread_mutex_lock(&m_runMutex);
+        m_vFree.push_back(pBuf);
+        pthread_mutex_unlock(&m_runMutex);
+        return;
+    }
+
+    pthread_mutex_lock(&m_runMutex);
+    pBuf->nSeq = m_nFilled++;
+    m_qToSort.push_back(pBuf);
+    pthread_cond_signal(&m_sortVar);
+    pthread_mutex_unlock(&m_runMutex);
+}
+
+void* BigQ::SortRunsHelper(void* context)
+{
+    return ((BigQ *)context)->SortRuns();
+}
+
+void* BigQ::SortRuns()
+{
+    while (true)
+    {
+        pthread_mutex_lock(&m_runMutex);
+        while (m_qToSort.empty() && !m_bInputDone)
+            pthread_cond_wait(&m_sortVar, &m_runMutex);
+        if (m_qToSort.empty())
+        {
+            pthread_mutex_unlock(&m_runMutex);
+            break;
+        }
+        RunBuffer *pBuf = m_qToSort.front();
+        m_qToSort.pop_front();
+        pthread_mutex_unlock(&m_runMutex);
+
+        sort(pBuf->vRecs.begin(), pBuf->vRecs.end(), CompareMyRecords(m_pSortOrder));
+
+        pthread_mutex_lock(&m_runMutex);
+        m_mSorted[pBuf->nSeq] = pBuf;
+        pthread_cond_signal(&m_writeVar);
+        pthread_mutex_unlock(&m_runMutex);
+    }
+    return NULL;
+}
+
+void* BigQ::WriteRunsHelper(void* context)
+{
+    return ((BigQ *)context)->WriteRuns();
+}
+
+void* BigQ::WriteRuns()
+{
+    // in the order the runs were read, whichever sorter is done first
+    while (true)
+    {
+        pthread_mutex_lock(&m_runMutex);
+        while (m_mSorted.find(m_nWritten) == m_mSorted.end() &&
+               !(m_bInputDone && m_nWritten == m_nFilled))
+            pthread_cond_wait(&m_writeVar, &m_runMutex);
+        if (m_mSorted.find(m_nWritten) == m_mSorted.end())
         {
-            aRunVector.push_back(copyRec); //whether it's a new page or old page, just push back the copy onto vector
-            allSorted = false;
-            continue;   //don't sort i.e. go down until the run is full
+            pthread_mutex_unlock(&m_runMutex);
+            break;
         }
+        RunBuffer *pBuf = m_mSorted[m_nWritten];
+        m_mSorted.erase(m_nWritten);
+        pthread_mutex_unlock(&m_runMutex);
+
+        appendRunToFile(pBuf->vRecs);
+        pBuf->vRecs.clear();
+        pBuf->arena.Reset();
+
+        pthread_mutex_lock(&m_runMutex);
+        m_nWritten++;
+        m_vFree.push_back(pBuf);
+        pthread_cond_signal(&m_freeVar);
+        pthread_mutex_unlock(&m_runMutex);
+    }
+    return NULL;
+}
 
-        //control here means one run is full, sort it and write to file
-        //then insert the overflow Rec and start over
+void BigQ::getRunsBySelection()
+{
+    // records in memory, by their length as Page::Append counts it,
+    // up to what runlen pages hold
+    long nBudget = (long) m_nRunLen * (m_nPageSize - sizeof(int));
+    long nBytes = 0;
 
-        sort(aRunVector.begin(), aRunVector.end(), CompareMyRecords(m_pSortOrder));
-        appendRunToFile(aRunVector);
+    vector<HeapEntry> vHeap;
+    vector<Record*> vRecPool;   // Record objects whose bits went to the run file
+    bool bInput = true;
 
-        //now clear the vector to begin for new run
-        //pageRecord must have been reset already as run was full
-        aRunVector.clear();
-        allSorted = true;
-        if(overflowRec)     //this would always be the case
+    while (nBytes < nBudget)
+    {
+        Record *pRec = new Record();
+        if (!m_pInPipe->Remove(pRec))
         {
-            aRunVector.push_back(copyRec);  //value in copyRec is still intact
-            allSorted = false;
-            overflowRec = false;
+            delete pRec;
+            bInput = false;
+            break;
         }
+        nBytes += ((int *) pRec->bits)[0];
+        vHeap.push_back(HeapEntry(pRec, 0));
     }
-#ifdef _DEBUG
-    cout<<"\n\n "<< m_sFileName << " : "<< recs << "recs removed from inPipe"<<endl;
-#endif
+    for (int i = (int) vHeap.size() / 2 - 1; i >= 0; i--)
+        SiftDown(vHeap, i);
 
-    //done with all records in pipe, if there is anything in vector
-    //it should be sorted and written out to file
-    if(!allSorted)
+    int nRun = -1;
+    while (!vHeap.empty())
     {
-        //sort the vector
-        sort(aRunVector.begin(), aRunVector.end(), CompareMyRecords(m_pSortOrder));
-        appendRunToFile(aRunVector);    //flush everything to file
+        HeapEntry out = vHeap[0];
 
-#ifdef _DEBUG
-//    //get the records from runfile and feed 'em to outpipe
-//    m_runFile.Open(const_cast<char*>(m_sFileName.c_str()));
-//    m_runFile.MoveFirst();
-//    Record *rc = new Record();
-//    int recCtr = 0;
-//    while (m_runFile.GetNext(*rc) == 1)
-//    {
-//    m_pOutPipe->Insert(rc);
-//            recCtr++;
-//    }
-//    cout << "\n\n Records sent to outpipe = " << recCtr <<endl;
-//    m_runFile.Close();
-#endif
+        // the heap holds only records of the next run
+        if (out.nRun != nRun)
+        {
+            if (nRun >= 0)
+                EndRun();
+            StartRun();
+            nRun = out.nRun;
+        }
+        nBytes -= ((int *) out.pRec->bits)[0];
+
+        // the next record takes the place of the one going out, or the
+        // last one of the heap does once the input is over; records that
+        // come before the one going out wait for the next run
+        Record *pRec = NULL;
+        if (bInput && nBytes < nBudget)
+        {
+            pRec = NewHeapRecord(vRecPool);
+            if (!m_pInPipe->Remove(pRec))
+            {
+                vRecPool.push_back(pRec);
+                pRec = NULL;
+                bInput = false;
+            }
+        }
+        if (pRec)
+        {
+            nBytes += ((int *) pRec->bits)[0];
+            int nTo = (ce.Compare(pRec, out.pRec, m_pSortOrder) < 0) ? nRun + 1 : nRun;
+            vHeap[0] = HeapEntry(pRec, nTo);
+        }
+        else
+        {
+            vHeap[0] = vHeap.back();
+            vHeap.pop_back();
+        }
+        if (!vHeap.empty())
+            SiftDown(vHeap, 0);
 
+        // a record shorter than the one that went out leaves room for more
+        while (bInput && nBytes < nBudget)
+        {
+            pRec = NewHeapRecord(vRecPool);
+            if (!m_pInPipe->Remove(pRec))
+            {
+                vRecPool.push_back(pRec);
+                bInput = false;
+                break;
+            }
+            nBytes += ((int *) pRec->bits)[0];
+            int nTo = (ce.Compare(pRec, out.pRec, m_pSortOrder) < 0) ? nRun + 1 : nRun;
+            vHeap.push_back(HeapEntry(pRec, nTo));
+            SiftUp(vHeap, vHeap.size() - 1);
+        }
 
+        AddToRun(*out.pRec);
+        vRecPool.push_back(out.pRec);
     }
+    if (nRun >= 0)
+        EndRun();
 
-	#ifdef _DEBUG
-	for (int l = 0; l < m_vRunLengths.size(); l++)
-	{
-		cout << "\nRun " << l << " length " << m_vRunLengths.at(l);
-	}
-	#endif
+    for (int i = 0; i < vRecPool.size(); i++)
+        delete vRecPool[i];
+}
 
-    //now call mergeRuns here!
-    MergeRuns();
-    m_pOutPipe->ShutDown();
+Record* BigQ::NewHeapRecord(vector<Record*> &vRecPool)
+{
+    if (vRecPool.empty())
+        return new Record();
+    Record *pRec = vRecPool.back();
+    vRecPool.pop_back();
+    return pRec;
+}
+
+void BigQ::SiftDown(vector<HeapEntry> &vHeap, int nPos)
+{
+    // the hole goes down to a leaf along the records that go out first,
+    // then the entry goes up from there: a new record mostly belongs
+    // near the bottom, which saves a compare on every level
+    HeapEntry entry = vHeap[nPos];
+    int nTop = nPos;
+    int nSize = vHeap.size();
+    int nChild = 2 * nPos + 1;
+    while (nChild < nSize)
+    {
+        if (nChild + 1 < nSize && GoesAfter(vHeap[nChild], vHeap[nChild + 1]))
+            nChild++;
+        vHeap[nPos] = vHeap[nChild];
+        nPos = nChild;
+        nChild = 2 * nPos + 1;
+    }
+    vHeap[nPos] = entry;
+    SiftUp(vHeap, nPos, nTop);
+}
+
+void BigQ::SiftUp(vector<HeapEntry> &vHeap, int nPos, int nTop)
+{
+    HeapEntry entry = vHeap[nPos];
+    while (nPos > nTop)
+    {
+        int nParent = (nPos - 1) / 2;
+        if (!GoesAfter(vHeap[nParent], entry))
+            break;
+        vHeap[nPos] = vHeap[nParent];
+        nPos = nParent;
+    }
+    vHeap[nPos] = entry;
 }
 
 void BigQ::appendRunToFile(vector<Record*>& aRun)
 {
-    m_runFile.Open(const_cast<char*>(m_sFileName.c_str()));     //open with the same name
     int length = aRun.size();
 
 	#ifdef _DEBUG
@@ -167,22 +460,34 @@ void BigQ::appendRunToFile(vector<Record*>& aRun)
 	cout << "\n\n---- BigQ::appendRunToFile aRun.size() = " << length;
 	#endif
 
-	int nPagesBefore = m_runFile.GetFileLength();
+    StartRun();
+    for(int i = 0; i < length; i++)
+        AddToRun(*aRun[i]);
+    EndRun();
+}
 
+void BigQ::StartRun()
+{
+    m_runFile.Open(const_cast<char*>(m_sFileName.c_str()));     //open with the same name
+	m_nPagesBefore = m_runFile.GetFileLength();
+    m_nRunRecords = 0;
+}
+
+void BigQ::AddToRun(Record &rec)
+{
 	//insert first record into new page so that a clear demarcation can be established
     //start this demarcation from 2nd run (don't do it for first run )
-    int i = 0;
-    if(m_nAppendCount > 0)
-    {
-        m_runFile.Add(*aRun[0], true);
-        i = 1;
-    }
-    for(; i < length; i++)
-        m_runFile.Add(*aRun[i]);
+    m_runFile.Add(rec, m_nRunRecords == 0 && m_nAppendCount > 0);
+    m_nRunRecords++;
+}
 
+void BigQ::EndRun()
+{
     m_runFile.Close();
+	int nPagesBefore = m_nPagesBefore;
 	int nPagesAfter = m_runFile.GetFileLength();
 	m_nAppendCount++;
+    m_vRunRecords.push_back(m_nRunRecords);
 
 	#ifdef _DEBUG
 	cout <<"\n\n "<< m_sFileName << " :\n***\nm_vRunLengths.size() = " <<  m_vRunLengths.size();
@@ -207,6 +512,87 @@ void BigQ::appendRunToFile(vector<Record*>& aRun)
 	}
 }
 
+void BigQ::SetStats(double dRunSeconds, double dMergeSeconds)
+{
+    RunStats stats;
+    stats.sLabel = m_sLabel;
+    stats.dRunSeconds = dRunSeconds;
+    stats.dMergeSeconds = dMergeSeconds;
+    stats.nRuns = m_nInitialRuns;
+    stats.nMemoryPages = m_nRunLen;
+    stats.nSortThreads = m_nSortThreads;
+    stats.nRunPages = m_nRunPages;
+    stats.bSelection = (m_eRunGen == REPLACEMENT_SELECTION);
+    for (int i = 0; i < m_nInitialRuns; i++)
+    {
+        stats.nRecords += m_vRunRecords[i];
+        stats.nPages += m_vRunLengths[i];
+        if (i == 0 || m_vRunLengths[i] < stats.nMinPages)
+            stats.nMinPages = m_vRunLengths[i];
+        if (m_vRunLengths[i] > stats.nMaxPages)
+            stats.nMaxPages = m_vRunLengths[i];
+    }
+    stats.nFanIn = m_nFanIn;
+    stats.nMergeSteps = m_vMergePlan.size();
+    for (int i = m_nInitialRuns; i < m_vRunLengths.size(); i++)
+        stats.nMergePages += m_vRunLengths[i];
+    stats.sPlan = m_sPlan;
+    m_stats = stats;
+
+    pthread_mutex_lock(&m_statsMutex);
+    m_qStats.push_back(stats);
+    if (m_qStats.size() > SORT_STATS_KEPT)
+        m_qStats.pop_front();
+    pthread_mutex_unlock(&m_statsMutex);
+}
+
+void BigQ::GetAllRunStats(vector<RunStats> &vStats)
+{
+    pthread_mutex_lock(&m_statsMutex);
+    vStats.assign(m_qStats.begin(), m_qStats.end());
+    pthread_mutex_unlock(&m_statsMutex);
+}
+
+void BigQ::ClearRunStats()
+{
+    pthread_mutex_lock(&m_statsMutex);
+    m_qStats.clear();
+    pthread_mutex_unlock(&m_statsMutex);
+}
+
+void BigQ::PrintRunStats(ostream &out)
+{
+    vector<RunStats> vStats;
+    GetAllRunStats(vStats);
+    for (int i = 0; i < vStats.size(); i++)
+    {
+        RunStats &stats = vStats[i];
+        out << "BigQ " << stats.sLabel << ": " << stats.nRecords << " records sorted in " << stats.nRuns
+            << " run" << (stats.nRuns != 1 ? "s" : "") << " of " << stats.nPages << " pages ("
+            << (stats.bSelection ? "replacement selection" : "sorted runs") << ", "
+            << stats.nMemoryPages << " pages of memory";
+        if (!stats.bSelection)
+            out << ", " << stats.nSortThreads << " sorter thread" << (stats.nSortThreads != 1 ? "s" : "")
+                << ", " << stats.nRunPages << " pages per run buffer";
+        if (stats.nRuns > 0)
+            out << ", " << stats.nMinPages << "/" << (double) stats.nPages / stats.nRuns << "/"
+                << stats.nMaxPages << " pages min/avg/max per run";
+        if (stats.nMergeSteps > 0)
+            out << ", " << stats.nMergeSteps << " intermediate merge" << (stats.nMergeSteps != 1 ? "s" : "")
+                << " of fan-in " << stats.nFanIn << " writing " << stats.nMergePages << " pages";
+        out << "; " << stats.dRunSeconds << " secs making runs, " << stats.dMergeSeconds
+            << " secs merging)\n";
+    }
+}
+
+void BigQ::PrintMergePlan(ostream &out)
+{
+    vector<RunStats> vStats;
+    GetAllRunStats(vStats);
+    for (int i = 0; i < vStats.size(); i++)
+        out << vStats[i].sPlan;
+}
+
 
 /* --------------- Phase-2 of TPMMS: MergeRuns() --------------- */
 
@@ -217,206 +603,283 @@ void BigQ::appendRunToFile(vector<Record*>& aRun)
 int BigQ::MergeRuns()
 {
     m_runFile.Close();
-    m_runFile.Open((char*)m_sFileName.c_str());
-	ComparisonEngine ce;
-	int nPagesFetched = 0;
-	int nRunsAlive = 0;
-	int nTotalPages = m_runFile.GetFileLength() - 1;
+    m_nInitialRuns = m_vRunLengths.size();
 
-	// delete this
-	int recs = 0;
-
-    // we need to do an m-way merge
-    // m = total pages/run length
-	const int nMWayRun = m_vRunLengths.size();
-
-	// Priority queue that contains sorted records
-	priority_queue < Record_n_Run, vector <Record_n_Run>,
-					 less<vector<Record_n_Run>::value_type> > pqRecords;
-
-    // ---- Initial setup ----
-    // There are m_nRunLen pages in one run
-    // so fetch 1st page from each run
-    // and put them in m_vRuns vector (sized nMWayRun)
-
-    int runHeadPage = 0;
-    Run * pRun = NULL;
-    Record * pRec = NULL;
+    // a page for every run read, and one for the run written
+    m_nFanIn = m_nRunLen - 1;
+    m_nFinalFanIn = m_nRunLen;
+    PlanMerge();
 
 #ifdef _DEBUG
-    cout<< m_sFileName <<" : nMWayRun = "<<nMWayRun<<endl;
+    cout << m_sPlan;
 #endif
 
-    for (int i = 0; i < nMWayRun; i++)
+    for (int i = 0; i < m_vMergePlan.size(); i++)
     {
-		// Run length of 0th run is 1 extra, as 0th page doesn't contain data
-        pRun = new Run(m_vRunLengths.at(i));
-        pRun->set_curPage(runHeadPage);
-        m_runFile.GetPage(pRun->getPage(), pRun->get_and_inc_pagecount());
-		nPagesFetched++;
-		nRunsAlive++;
-
-		#ifdef _DEBUG
-		cout <<"\n\n "<< m_sFileName << " :\n\n runHeadPage = " << runHeadPage
-			 << "\n nPagesFetched = "<< nPagesFetched
-			 << "\n nRunsAlive = "<< nRunsAlive;
-		#endif
-
-        // fetch 1st record and push in the priority queue
-        pRec = new Record();
-        int ret = pRun->getPage()->GetFirst(pRec);
-        if (!ret)
-        {
-            // initially every page should have at least one record
-            // error here... really bad!
-            return RET_FAILURE;
-        }
+        FileUtil in;
+        in.Open((char*)m_sFileName.c_str(), READ_ONLY);
+        StartRun();
+        int ret = MergeRunSet(in, m_vMergePlan[i].vInputs, false);
+        EndRun();
+        in.Close();
+        if (ret != RET_SUCCESS)
+            return ret;
+    }
 
-        if (pRec)
+    if (m_vFinalRuns.empty())
+        return RET_SUCCESS;
+    FileUtil in;
+    in.Open((char*)m_sFileName.c_str(), READ_ONLY);
+    int ret = MergeRunSet(in, m_vFinalRuns, true);
+    in.Close();
+    return ret;
+}
+
+long BigQ::PlanMerges(int nFanIn, int nFinalFanIn, bool bSmallestFirst,
+                      vector<MergeStep> &vSteps, vector<int> &vFinal)
+{
+    // pages and number of the runs left to merge
+    vector< pair<long, int> > vLive;
+    for (int i = 0; i < m_vRunLengths.size(); i++)
+        vLive.push_back(make_pair((long) m_vRunLengths[i], i));
+    int nNextRun = m_vRunLengths.size();
+    long nIO = 0;
+
+    if (bSmallestFirst)
+    {
+        // every merge takes nFanIn - 1 runs off, the first one takes what
+        // is left over so that the last merge gets exactly nFinalFanIn
+        int nTooMany = (int) vLive.size() - nFinalFanIn;
+        int nTake = (nTooMany > 0) ? (nTooMany - 1) % (nFanIn - 1) + 2 : 0;
+        while (vLive.size() > nFinalFanIn)
         {
-            Record_n_Run rr(m_pSortOrder, &ce, pRec, i);
-            pqRecords.push(rr);
-            pRec = NULL;
+            sort(vLive.begin(), vLive.end());
+            MergeStep step;
+            step.nPages = 0;
+            for (int i = 0; i < nTake; i++)
+            {
+                step.vInputs.push_back(vLive[i].second);
+                step.nPages += vLive[i].first;
+            }
+            sort(step.vInputs.begin(), step.vInputs.end());
+            vLive.erase(vLive.begin(), vLive.begin() + nTake);
+            vLive.push_back(make_pair(step.nPages, nNextRun++));
+            vSteps.push_back(step);
+            nIO += 2 * step.nPages;
+            nTake = nFanIn;
         }
-        else
+    }
+    else
+    {
+        // nFanIn runs after another, a run left alone goes to the next pass
+        while (vLive.size() > nFinalFanIn)
         {
-            // pRec cannot be NULL here... very wrong
-            return RET_FAILURE;
+            vector< pair<long, int> > vPass;
+            for (int i = 0; i < vLive.size(); i += nFanIn)
+            {
+                int nEnd = min(i + nFanIn, (int) vLive.size());
+                if (nEnd - i == 1)
+                {
+                    vPass.push_back(vLive[i]);
+                    continue;
+                }
+                MergeStep step;
+                step.nPages = 0;
+                for (int j = i; j < nEnd; j++)
+                {
+                    step.vInputs.push_back(vLive[j].second);
+                    step.nPages += vLive[j].first;
+                }
+                vPass.push_back(make_pair(step.nPages, nNextRun++));
+                vSteps.push_back(step);
+                nIO += 2 * step.nPages;
+            }
+            vLive = vPass;
         }
+    }
 
-        // increment page-counter to go to the next run
-        runHeadPage += m_vRunLengths.at(i);
-        m_vRuns.push_back(pRun);
+    for (int i = 0; i < vLive.size(); i++)
+        vFinal.push_back(vLive[i].second);
+    sort(vFinal.begin(), vFinal.end());
+    return nIO;
+}
+
+void BigQ::PlanMerge()
+{
+    vector<MergeStep> vPassSteps;
+    vector<int> vPassFinal;
+    long nSmallestIO = PlanMerges(m_nFanIn, m_nFinalFanIn, true, m_vMergePlan, m_vFinalRuns);
+    long nPassIO = PlanMerges(m_nFanIn, m_nFinalFanIn, false, vPassSteps, vPassFinal);
+    if (nPassIO < nSmallestIO)
+    {
+        m_vMergePlan = vPassSteps;
+        m_vFinalRuns = vPassFinal;
     }
 
-	#ifdef _DEBUG
-	cout <<"\n\n "<< m_sFileName << " : m_vRuns.size() = " << m_vRuns.size()
-		 << "\n pqRecords.size() = " << pqRecords.size() << endl;
-	#endif
+    long nPages = 0;
+    for (int i = 0; i < m_vRunLengths.size(); i++)
+        nPages += m_vRunLengths[i];
+
+    stringstream plan;
+    plan << "*** BigQ Merge: " << m_sLabel << " ***\n"
+         << "Runs: " << m_vRunLengths.size() << " of " << nPages << " pages\n"
+         << "Memory: " << m_nRunLen << " pages, fan-in " << m_nFanIn << ", "
+         << m_nFinalFanIn << " in the last merge\n";
+    int nNextRun = m_vRunLengths.size();
+    for (int i = 0; i < m_vMergePlan.size(); i++)
+    {
+        plan << "Merge " << i + 1 << ": runs";
+        for (int j = 0; j < m_vMergePlan[i].vInputs.size(); j++)
+            plan << " " << m_vMergePlan[i].vInputs[j];
+        plan << " (" << m_vMergePlan[i].nPages << " pages) -> run " << nNextRun++ << "\n";
+    }
+    plan << "Last merge: runs";
+    for (int j = 0; j < m_vFinalRuns.size(); j++)
+        plan << " " << m_vFinalRuns[j];
+    plan << " (" << nPages << " pages) -> out pipe\n"
+         << "Intermediate I/O: " << min(nSmallestIO, nPassIO) << " pages ("
+         << (nPassIO < nSmallestIO ? "pass by pass" : "smallest runs first") << "; "
+         << nSmallestIO << " smallest runs first, " << nPassIO << " pass by pass)\n";
+    m_sPlan = plan.str();
+}
+
+int BigQ::GetRunStart(int nRun)
+{
+    // the runs follow one another in the run file
+    int nStart = 0;
+    for (int i = 0; i < nRun; i++)
+        nStart += m_vRunLengths[i];
+    return nStart;
+}
+
+int BigQ::MergeRunSet(FileUtil &in, vector<int> &vInputs, bool bToPipe)
+{
+	int nTotalPages = in.GetFileLength() - 1;
 
+    // we need to do an m-way merge
+    // m = total pages/run length
+	const int nMWayRun = vInputs.size();
+    if (nMWayRun == 0)
+        return RET_SUCCESS;
+
+    // every run reads ahead on its own, keep all of them
+    // within half of the buffer pool or they evict each other
+    int nReadAhead = (BUFFER_POOL_FRAMES / 2) / nMWayRun;
+    in.SetReadAhead(min(nReadAhead, READ_AHEAD_PAGES));
+
+    // two Records per run, views on its page: the head, and the next
+    // one, fetched while the head goes through the out-pipe
+    Record *vRunRecs = new Record[2 * nMWayRun];
+    vector<Record*> vHeads(nMWayRun, (Record*) NULL);     // NULL once a run is over
+    vector<int> vSide(nMWayRun, 0);
 
-    // fetch 1st record from each page
-    // and push it in the min priority queue
-    bool bFileEmpty = false;
-    int nRunToFetchRecFrom = 0;
-    while (bFileEmpty == false)
+    // ---- Initial setup ----
+    // fetch 1st page of each run
+    for (int i = 0; i < nMWayRun; i++)
     {
-        if (pqRecords.size() < nRunsAlive)
+        Run *pRun = new Run(m_vRunLengths.at(vInputs[i]));
+        pRun->set_curPage(GetRunStart(vInputs[i]));
+        in.GetPage(pRun->getPage(), pRun->get_and_inc_pagecount(), pRun->get_lastPage());
+        m_vRuns.push_back(pRun);
+
+        // initially every page should have at least one record
+        if (!pRun->getPage()->GetFirst(&vRunRecs[2 * i]))
+        {
+            delete [] vRunRecs;
+            ClearRuns();
+            return RET_FAILURE;
+        }
+        vHeads[i] = &vRunRecs[2 * i];
+    }
+
+    // loser tree over the runs: node n of 1 .. nMWayRun - 1 holds the run
+    // that lost the match at n, node 0 the one that won them all. The
+    // run i plays from leaf nMWayRun + i, its parent is (nMWayRun + i) / 2
+    vector<int> vTree(nMWayRun, 0);
+    vector<int> vWinners(nMWayRun, 0);
+    for (int n = nMWayRun - 1; n >= 1; n--)
+    {
+        int nLeft = (2 * n >= nMWayRun) ? 2 * n - nMWayRun : vWinners[2 * n];
+        int nRight = (2 * n + 1 >= nMWayRun) ? 2 * n + 1 - nMWayRun : vWinners[2 * n + 1];
+        if (Beats(vHeads, nRight, nLeft))
+            swap(nLeft, nRight);
+        vWinners[n] = nLeft;
+        vTree[n] = nRight;
+    }
+    vTree[0] = (nMWayRun > 1) ? vWinners[1] : 0;
+
+    int recs = 0;
+    while (true)
+    {
+        int nWinner = vTree[0];
+        Record *pOut = vHeads[nWinner];
+        if (pOut == NULL)
+            break;      // every run is over
+
+        // the next record of the run, its key on the way to the cache
+        // while the head goes out; a new page of the run can only be
+        // read once the head, a view on the old one, is out
+        Run *pRun = m_vRuns[nWinner];
+        Record *pNext = &vRunRecs[2 * nWinner + 1 - vSide[nWinner]];
+        if (pRun->getPage()->GetFirst(pNext))
         {
-            pRec = new Record;
-            int ret = m_vRuns.at(nRunToFetchRecFrom)->getPage()->GetFirst(pRec);
-            if (!ret)
+            __builtin_prefetch(pNext->bits);
+            if (bToPipe)
+                m_pOutPipe->Insert(pOut);
+            else
+                AddToRun(*pOut);
+        }
+        else
+        {
+            if (bToPipe)
+                m_pOutPipe->Insert(pOut);
+            else
+                AddToRun(*pOut);
+            pNext = NULL;
+            if (pRun->canFetchPage(nTotalPages))
             {
-                // records from this page are over
-                // see if new page from this run can be fetched
-                if (m_vRuns.at(nRunToFetchRecFrom)->canFetchPage(nTotalPages))
-                {
-					#ifdef _DEBUG
-					cout << "\n\n records outed till now = "<< recs;
-					#endif
-
-                    // fetch next page
-                    m_runFile.GetPage(m_vRuns.at(nRunToFetchRecFrom)->getPage(),
-                                      m_vRuns.at(nRunToFetchRecFrom)->get_and_inc_pagecount());
-					nPagesFetched++;
-
-					#ifdef _DEBUG
-					cout << "\n\ncanFetchPage is true for run " << nRunToFetchRecFrom
-						 << "\n so nPagesFetched = " << nPagesFetched <<endl;
-					#endif
-
-                    // fetch first record from this page now
-                    int ret2 = m_vRuns.at(nRunToFetchRecFrom)->getPage()->GetFirst(pRec);
-                    if (!ret2)
-                    {
-                        cout << "\nBigQ::MergeRuns --> fetching record from page x of run "
-                             << nRunToFetchRecFrom << " failed. Fatal!\n\n";
-                        return RET_FAILURE;
-                    }
-                }
-                else
+                in.GetPage(pRun->getPage(), pRun->get_and_inc_pagecount(),
+                                  pRun->get_lastPage());
+                pNext = &vRunRecs[2 * nWinner + 1 - vSide[nWinner]];
+                if (!pRun->getPage()->GetFirst(pNext))
                 {
-                    // all the pages from this run have been fetched
-                    // size of M in the m-way run would reduce by one.. logically
-					nRunsAlive--;
-
-					#ifdef _DEBUG
-					cout << "\n\ncanFetchPage is *false* for run " << nRunToFetchRecFrom
-						 << "\n--- nPagesFetched = "<< nPagesFetched
-            			 << "\n--- nRunsAlive = "<< nRunsAlive;
-					cout << "\n\n records outed till now = "<< recs;
-					#endif
-
-                    // this run is over, fetch next record from the next alive run
-                    nRunToFetchRecFrom = 0;
-					while (nRunToFetchRecFrom < nMWayRun)
-					{
-						if (m_vRuns.at(nRunToFetchRecFrom)->is_alive())
-							break;
-						nRunToFetchRecFrom++;
-					}
-
-					// if no run is alive, all pages from all runs have been fetched
-					if (nRunToFetchRecFrom == nMWayRun)
-						bFileEmpty = true;
-
-					delete pRec;
-					pRec = NULL;	// because no record was fetched
+                    cout << "\nBigQ::MergeRuns --> fetching record from page x of run "
+                         << nWinner << " failed. Fatal!\n\n";
+                    delete [] vRunRecs;
+                    ClearRuns();
+                    return RET_FAILURE;
                 }
             }
-
-            // got the record, push it in the min priority queue
-            // for now, push it in a vector
-            if (pRec)
-            {
-				Record_n_Run rr(m_pSortOrder, &ce, pRec, nRunToFetchRecFrom);
-		        pqRecords.push(rr);
-                pRec = NULL;
-            }
         }
+        recs++;
+        vSide[nWinner] = 1 - vSide[nWinner];
+        vHeads[nWinner] = pNext;
 
-        // priority queue is full, pop min record
-        if (nRunsAlive != 0 && pqRecords.size() == nRunsAlive)
+        // the run plays its way up again, against the losers on its path
+        for (int n = (nMWayRun + nWinner) / 2; n >= 1; n /= 2)
         {
-            // find min record
-            Record_n_Run rr = pqRecords.top();
-			pqRecords.pop();
-            // push min element through out-pipe
-            m_pOutPipe->Insert(rr.get_rec());
-            // keep track of which run this record belonged too
-            // need to fetch next record from the run of that page
-            nRunToFetchRecFrom = rr.get_run();
-            // do not delete memory allocated for record,
-			recs++;
+            if (Beats(vHeads, vTree[n], nWinner))
+                swap(vTree[n], nWinner);
         }
+        vTree[0] = nWinner;
     }
-	
-	#ifdef _DEBUG
-	cout << "\n\n records outed till now = "<< recs;
-	#endif
 
-    // empty the priority queue
-    while (pqRecords.size() > 0)
-    {
-		// find min record
-        Record_n_Run rr = pqRecords.top();
-		pqRecords.pop();
-        // push min element through out-pipe
-		m_pOutPipe->Insert(rr.get_rec());
-        // keep track of which run this record belonged too
-        // need to fetch next record from the run of that page
-        nRunToFetchRecFrom = rr.get_run();
-        // do not delete memory allocated for record,
-		recs++;
-    }
-	
 	#ifdef _DEBUG
 	cout << "\n\n records outed till now = "<< recs;
 	#endif
 
+    delete [] vRunRecs;
+    ClearRuns();
     return RET_SUCCESS;
 }
 
+void BigQ::ClearRuns()
+{
+	for (int i = 0; i < m_vRuns.size(); i++)
+		delete m_vRuns[i];
+	m_vRuns.clear();
+}
+
 string BigQ::getTime()
 {
    time_t now;
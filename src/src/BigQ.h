@@ -4,6 +4,9 @@
 #include <pthread.h>
 #include <iostream>
 #include <vector>
+#include <deque>
+#include <map>
+#include <string>
 #include <algorithm>
 #include "Pipe.h"
 #include "File.h"
@@ -13,6 +16,47 @@
 
 using namespace std;
 
+// how a BigQ makes its sorted runs
+enum RunGeneration
+{
+	// the runlen pages of records are shared by the runs in flight, which
+	// are sorted by a pool of threads and written by another one
+	SORTED_RUNS,
+	// a heap of runlen pages of records; the smallest one goes out to the
+	// run while it is not before the last one that did. Runs average twice
+	// the memory, and input that is already sorted makes a single run
+	REPLACEMENT_SELECTION
+};
+
+// the runs a BigQ made
+struct RunStats
+{
+	string sLabel;		// of the BigQ, eg the operator it sorts for
+	int nRuns;
+	long nRecords;
+	long nPages;
+	int nMinPages;		// of a run
+	int nMaxPages;
+	int nMemoryPages;	// the run length the BigQ was given, SORT_MIN_PAGES or more
+	int nSortThreads;	// that sorted the runs, 0 if the reading one did
+	int nRunPages;		// of records per run in flight, at most nMemoryPages
+	bool bSelection;	// made by replacement selection
+	double dRunSeconds;	// making the runs, waits on the in pipe included
+	double dMergeSeconds;	// merging them, waits on the out pipe included
+
+	// the merge keeps to nMemoryPages pages, one per run it reads and one
+	// for the run it writes: runs are merged nFanIn at a time into
+	// intermediate runs until there are few enough for the last merge
+	int nFanIn;
+	int nMergeSteps;		// intermediate merges
+	long nMergePages;		// pages they wrote, and read again
+	string sPlan;			// the merge plan, see BigQ::PrintMergePlan
+
+	RunStats() : sLabel(), nRuns(0), nRecords(0), nPages(0), nMinPages(0), nMaxPages(0),
+		nMemoryPages(0), nSortThreads(0), nRunPages(0), bSelection(false), dRunSeconds(0), dMergeSeconds(0),
+		nFanIn(0), nMergeSteps(0), nMergePages(0), sPlan() {}
+};
+
 // class to store run information
 class Run
 {
@@ -79,6 +123,12 @@ public:
 		m_nCurrPage = currentPageNum;
 	}
 
+	// last page of this run in the file, used to bound read-ahead
+	int get_lastPage()
+	{
+		return m_nCurrPage - m_nPagesFetched + m_nRunLen - 1;
+	}
+
 	int get_and_inc_pagecount()
 	{
 		int tmp = m_nCurrPage;
@@ -88,42 +138,6 @@ public:
 	}
 };
 
-// Class to store records and comparator for priority queue
-class Record_n_Run
-{
-private:
-	OrderMaker *m_pSortOrder;
-	ComparisonEngine *m_pCE;
-	Record * m_pRec;
-	int m_nRun;
-
-public:
-
-	Record_n_Run(OrderMaker *pOrderMaker, ComparisonEngine *pCE, Record *rec, int run)
-		: m_pSortOrder(pOrderMaker), m_pCE(pCE), m_pRec(rec), m_nRun(run)
-	{}
-
-	~Record_n_Run() {}
-
-	Record * get_rec()
-	{
-		return m_pRec;
-	}
-
-	int get_run()
-	{
-		return m_nRun;
-	}
-
-	bool operator< (const Record_n_Run& r) const
-	{
-            Record_n_Run* rr = const_cast<Record_n_Run*>(&r);
-            if(m_pCE->Compare(m_pRec, rr->get_rec(), m_pSortOrder) > 0)
-                    return true;
-            return false;
-	}
-};
-
 class BigQ
 {
 private:
@@ -131,16 +145,105 @@ private:
 	Pipe *m_pInPipe, *m_pOutPipe;
 	OrderMaker *m_pSortOrder;
 	int m_nRunLen;
+	int m_nPageSize;	// page size of the run file, runs are m_nRunLen such pages
+	int m_nCompression;	// PageCompression of the run file
 	string m_sFileName;
+	string m_sLabel;
 	ComparisonEngine ce;
 	vector<int> m_vRunLengths;
+	vector<long> m_vRunRecords;	// records of every run
 	int m_nAppendCount;
+	RunGeneration m_eRunGen;
+
+	// of the run being written
+	int m_nPagesBefore;
+	long m_nRunRecords;
+
+	RunStats m_stats;
+	static pthread_mutex_t m_statsMutex;
+	static deque<RunStats> m_qStats;	// of the last SORT_STATS_KEPT BigQs
+
+	// the records of a run of SORTED_RUNS, on their way from the reading
+	// thread to a sorter thread and to the writer thread
+	struct RunBuffer
+	{
+		vector<Record*> vRecs;
+		vector<Record*> vRecPool;	// Record objects, reused from run to run
+		RecordArena arena;			// and their bits, all freed once the run is written
+		int nSeq;					// the runs are written in the order they were read
+	};
+
+	int m_nSortThreads;
+	int m_nRunPages;				// of a buffer, m_nRunLen shared by all of them
+	vector<pthread_t> m_vSortThreads;
+	pthread_t m_writeThread;
+	pthread_mutex_t m_runMutex;
+	pthread_cond_t m_freeVar;		// a buffer got written
+	pthread_cond_t m_sortVar;		// a buffer got filled
+	pthread_cond_t m_writeVar;		// a buffer got sorted
+	vector<RunBuffer*> m_vBuffers;
+	vector<RunBuffer*> m_vFree;
+	deque<RunBuffer*> m_qToSort;
+	map<int, RunBuffer*> m_mSorted;
+	int m_nFilled;					// runs handed to the sorters
+	int m_nWritten;
+	bool m_bInputDone;
 
 private:
 	// -------- phase - 1 --------------
 	void appendRunToFile(vector<Record*>&);
 	void* getRunsFromInputPipe();
 	static void* getRunsFromInputPipeHelper(void*);
+	void getRunsBySorting();
+	void getRunsBySelection();
+
+	// sorter and writer threads of SORTED_RUNS; with none, the reading
+	// thread sorts and writes every run itself
+	void StartRunThreads();
+	void StopRunThreads();
+	RunBuffer* GetFreeBuffer();
+	void SubmitRun(RunBuffer *pBuf);
+	static void* SortRunsHelper(void*);
+	void* SortRuns();
+	static void* WriteRunsHelper(void*);
+	void* WriteRuns();
+
+	// a run is written a record at a time between StartRun and EndRun
+	void StartRun();
+	void AddToRun(Record &rec);
+	void EndRun();
+	void SetStats(double dRunSeconds, double dMergeSeconds);
+
+	// heap of replacement selection: the record, and the run it goes to
+	struct HeapEntry
+	{
+		Record *pRec;
+		int nRun;
+		HeapEntry(Record *rec, int run) : pRec(rec), nRun(run) {}
+	};
+
+	// true if the head of run a goes out before that of run b: it is
+	// smaller, or as small and of an earlier run, or b is over
+	bool Beats(vector<Record*> &vHeads, int a, int b)
+	{
+		if (vHeads[a] == NULL || vHeads[b] == NULL)
+			return vHeads[b] == NULL && vHeads[a] != NULL;
+		int nCmp = ce.Compare(vHeads[a], vHeads[b], m_pSortOrder);
+		return nCmp < 0 || (nCmp == 0 && a < b);
+	}
+
+	// true if e1 goes out after e2: a later run, or a larger record
+	bool GoesAfter(const HeapEntry &e1, const HeapEntry &e2)
+	{
+		if (e1.nRun != e2.nRun)
+			return e1.nRun > e2.nRun;
+		return ce.Compare(e1.pRec, e2.pRec, m_pSortOrder) > 0;
+	}
+
+	// min-heap of vHeap, the first record to go out on top
+	void SiftDown(vector<HeapEntry> &vHeap, int nPos);
+	void SiftUp(vector<HeapEntry> &vHeap, int nPos, int nTop = 0);
+	Record* NewHeapRecord(vector<Record*> &vRecPool);
 
 	struct CompareMyRecords
 	{
@@ -164,12 +267,62 @@ private:
 	string getTime();
 
 	// -------- phase - 2 --------------
-	vector<Run *> m_vRuns;  // max size of this vector will be m_nPageCount/m_nRunLen
+	vector<Run *> m_vRuns;  // runs of the merge in progress
     int MergeRuns();
 
+	// a merge of runs into a new one, appended to the run file
+	struct MergeStep
+	{
+		vector<int> vInputs;	// runs, in the order of m_vRunLengths
+		long nPages;
+	};
+
+	int m_nInitialRuns;				// the runs made from the in pipe
+	int m_nFanIn;					// of an intermediate merge
+	int m_nFinalFanIn;				// ... and of the last one
+	vector<MergeStep> m_vMergePlan;	// intermediate merges, in order
+	vector<int> m_vFinalRuns;		// runs of the last merge, into the out pipe
+	string m_sPlan;
+
+	// the merges that bring the runs down to nFinalFanIn, nFanIn at a
+	// time; bSmallestFirst always merges the smallest runs, first as few
+	// as it takes for the others to be merged nFanIn at a time, otherwise
+	// the runs are merged in passes over all of them. Returns the pages
+	// the intermediate merges read and write
+	long PlanMerges(int nFanIn, int nFinalFanIn, bool bSmallestFirst,
+					vector<MergeStep> &vSteps, vector<int> &vFinal);
+	// the cheaper of the two plans, with m_nFanIn and m_nFinalFanIn
+	void PlanMerge();
+
+	// merges the runs of the run file, open in "in", into the out pipe or
+	// into a new run
+	int MergeRunSet(FileUtil &in, vector<int> &vInputs, bool bToPipe);
+	int GetRunStart(int nRun);
+	void ClearRuns();
+
 public:
-	BigQ (Pipe &in, Pipe &out, OrderMaker &sortorder, int runlen);
+	// nSortThreads sorter threads besides the one reading the pipe, and a
+	// writer, keep SORTED_RUNS runs in flight, up to nSortThreads + 2 runs
+	// that share the runlen pages, at least one page each; -1 is one per
+	// processor up to SORT_MAX_THREADS, 0 sorts and writes every run of
+	// runlen pages on the reading thread. A runlen below SORT_MIN_PAGES
+	// is raised to it. label names the BigQ in its run stats
+	BigQ (Pipe &in, Pipe &out, OrderMaker &sortorder, int runlen, int pageSize = PAGE_SIZE,
+		  int compression = COMPRESS_NONE, RunGeneration runGen = SORTED_RUNS,
+		  int nSortThreads = -1, const char *label = "sort");
 	~BigQ ();
+
+	// the runs of this BigQ, once its out pipe is shut down
+	void GetRunStats(RunStats &stats) { stats = m_stats; }
+
+	// of the last BigQs of the process that made their runs, oldest
+	// first, one line per BigQ; ClearRunStats forgets them
+	static void GetAllRunStats(vector<RunStats> &vStats);
+	static void PrintRunStats(ostream &out);
+	static void ClearRunStats();
+
+	// the merges they did, one per line, EXPLAIN style
+	static void PrintMergePlan(ostream &out);
 };
 
 #endif
@@ -0,0 +1,391 @@
+#include <string.h>
+#include <math.h>
+#include <fstream>
+#include <sstream>
+#include "BloomFilter.h"
+
+pthread_mutex_t BloomFilterSet::m_statsMutex = PTHREAD_MUTEX_INITIALIZER;
+unsigned long BloomFilterSet::m_nPagesChecked = 0;
+unsigned long BloomFilterSet::m_nPagesSkipped = 0;
+
+BloomFilter::BloomFilter(int whichAtt, Type type, double fpRate) :
+	m_nWhichAtt(whichAtt), m_eType(type), m_dFpRate(fpRate), m_nOpenPage(-1),
+	m_bOpenUnknown(false)
+{
+	if (m_dFpRate <= 0 || m_dFpRate >= 1)
+		m_dFpRate = BLOOM_FP_RATE;
+
+	// optimal for a filter with as many bits per key: k = ln(2) * m / n
+	m_dBitsPerKey = -log(m_dFpRate) / (log(2.0) * log(2.0));
+	m_nHashes = (int) (m_dBitsPerKey * log(2.0) + 0.5);
+	if (m_nHashes < 1)
+		m_nHashes = 1;
+	else if (m_nHashes > 30)
+		m_nHashes = 30;
+}
+
+void BloomFilter::Add(Record &rec, int nPage)
+{
+	if (nPage != m_nOpenPage)
+	{
+		Flush();
+		m_nOpenPage = nPage;
+	}
+
+	// a record of some other schema: the page gets no filter
+	int nAtts = ((int *) rec.bits)[1] / sizeof(int) - 1;
+	if (m_nWhichAtt >= nAtts)
+		m_bOpenUnknown = true;
+	else
+		m_vOpenHashes.push_back(rec.HashAtt(m_nWhichAtt, m_eType));
+}
+
+void BloomFilter::Flush()
+{
+	if (m_nOpenPage < 0)
+		return;
+
+	if (m_nOpenPage >= m_vPages.size())
+		m_vPages.resize(m_nOpenPage + 1);
+	PageBloom &bloom = m_vPages[m_nOpenPage];
+	if (m_bOpenUnknown || m_vOpenHashes.empty())
+	{
+		bloom.nKeys = 0;
+		bloom.vBits.clear();
+		m_vOpenHashes.clear();
+		m_bOpenUnknown = false;
+		m_nOpenPage = -1;
+		return;
+	}
+
+	int nKeys = m_vOpenHashes.size();
+	long nBits = (long) ceil(nKeys * m_dBitsPerKey);
+	if (nBits < 64)
+		nBits = 64;
+	nBits = (nBits + 7) & ~7L;
+
+	bloom.nKeys = nKeys;
+	bloom.vBits.assign(nBits / 8, 0);
+	for (int i = 0; i < nKeys; i++)
+	{
+		unsigned long long h1 = m_vOpenHashes[i] & 0xffffffffull;
+		unsigned long long h2 = (m_vOpenHashes[i] >> 32) | 1;
+		for (int k = 0; k < m_nHashes; k++)
+		{
+			unsigned long long nBit = (h1 + k * h2) % nBits;
+			bloom.vBits[nBit >> 3] |= (1 << (nBit & 7));
+		}
+	}
+
+	m_vOpenHashes.clear();
+	m_nOpenPage = -1;
+}
+
+void BloomFilter::Reopen(int nPage)
+{
+	Flush();
+	if (nPage < m_vPages.size())
+	{
+		m_vPages[nPage].nKeys = 0;
+		m_vPages[nPage].vBits.clear();
+	}
+	m_nOpenPage = nPage;
+}
+
+bool BloomFilter::MayContain(int nPage, unsigned long long nHash)
+{
+	if (nPage >= m_vPages.size() || m_vPages[nPage].vBits.empty())
+		return true;
+
+	PageBloom &bloom = m_vPages[nPage];
+	unsigned long long nBits = bloom.vBits.size() * 8;
+	unsigned long long h1 = nHash & 0xffffffffull;
+	unsigned long long h2 = (nHash >> 32) | 1;
+	for (int k = 0; k < m_nHashes; k++)
+	{
+		unsigned long long nBit = (h1 + k * h2) % nBits;
+		if (!(bloom.vBits[nBit >> 3] & (1 << (nBit & 7))))
+			return false;
+	}
+	return true;
+}
+
+void BloomFilter::Clear()
+{
+	m_vPages.clear();
+	m_vOpenHashes.clear();
+	m_nOpenPage = -1;
+	m_bOpenUnknown = false;
+}
+
+// <pages> then, for every page, <keys> <bytes> and the bits
+void BloomFilter::Write(ostream &out)
+{
+	int nPages = m_vPages.size();
+	out.write((char *) &nPages, sizeof(int));
+	for (int p = 0; p < nPages; p++)
+	{
+		int nKeys = m_vPages[p].nKeys;
+		int nBytes = m_vPages[p].vBits.size();
+		out.write((char *) &nKeys, sizeof(int));
+		out.write((char *) &nBytes, sizeof(int));
+		if (nBytes > 0)
+			out.write((char *) &m_vPages[p].vBits[0], nBytes);
+	}
+}
+
+bool BloomFilter::Read(istream &in)
+{
+	Clear();
+	int nPages = 0;
+	if (!in.read((char *) &nPages, sizeof(int)) || nPages < 0)
+		return false;
+
+	m_vPages.resize(nPages);
+	for (int p = 0; p < nPages; p++)
+	{
+		int nBytes = 0;
+		in.read((char *) &m_vPages[p].nKeys, sizeof(int));
+		if (!in.read((char *) &nBytes, sizeof(int)) || nBytes < 0)
+		{
+			Clear();
+			return false;
+		}
+		m_vPages[p].vBits.resize(nBytes);
+		if (nBytes > 0 && !in.read((char *) &m_vPages[p].vBits[0], nBytes))
+		{
+			Clear();
+			return false;
+		}
+	}
+	return true;
+}
+
+BloomFilterSet::BloomFilterSet(FileUtil *pBase) : m_pBase(pBase), m_bDirty(false)
+{}
+
+BloomFilterSet::~BloomFilterSet()
+{
+	Close();
+}
+
+string BloomFilterSet::GetBloomPath(const string &binPath)
+{
+	return binPath + ".bloom";
+}
+
+void BloomFilterSet::GetBloomList(const string &binPath, vector<int> &vAtts,
+								  vector<Type> &vTypes, vector<double> &vFpRates)
+{
+	ifstream meta_in;
+	meta_in.open((binPath + ".meta.data").c_str());
+	string line;
+	while (getline(meta_in, line))
+	{
+		stringstream ss(line);
+		string word, type;
+		int nAtt;
+		double dFpRate;
+		if (ss >> word && word.compare("bloom") == 0 && ss >> nAtt >> type >> dFpRate)
+		{
+			vAtts.push_back(nAtt);
+			vTypes.push_back(TypeFromString(type));
+			vFpRates.push_back(dFpRate);
+		}
+	}
+}
+
+void BloomFilterSet::Open(const string &binPath, FileOpenMode mode)
+{
+	Close();
+	m_sBinPath = binPath;
+
+	vector<int> vAtts;
+	vector<Type> vTypes;
+	vector<double> vFpRates;
+	GetBloomList(binPath, vAtts, vTypes, vFpRates);
+	if (vAtts.empty())
+		return;
+	for (int i = 0; i < vAtts.size(); i++)
+		m_vFilters.push_back(new BloomFilter(vAtts[i], vTypes[i], vFpRates[i]));
+
+	// <filters> then, for every filter, <attribute> and its pages
+	ifstream bloom_in;
+	bloom_in.open(GetBloomPath(binPath).c_str(), ios::binary);
+	int nFilters = 0;
+	if (bloom_in.read((char *) &nFilters, sizeof(int)))
+	{
+		for (int i = 0; i < nFilters; i++)
+		{
+			int nAtt = -1;
+			if (!bloom_in.read((char *) &nAtt, sizeof(int)))
+				break;
+			BloomFilter scratch(nAtt, Int, BLOOM_FP_RATE);
+			BloomFilter *pFilter = &scratch;
+			for (int j = 0; j < m_vFilters.size(); j++)
+				if (m_vFilters[j]->GetWhichAtt() == nAtt)
+					pFilter = m_vFilters[j];
+			if (!pFilter->Read(bloom_in))
+				break;
+		}
+	}
+	bloom_in.close();
+
+	// the last page of the file is filled further by Add
+	if (m_pBase != NULL && mode != READ_ONLY)
+	{
+		int nLast = m_pBase->GetFileLength() - 2;
+		if (nLast < 0)
+			return;
+		for (int i = 0; i < m_vFilters.size(); i++)
+			m_vFilters[i]->Reopen(nLast);
+
+		Record rec;
+		for (int nSlot = 0; m_pBase->GetRecord(nLast, nSlot, rec); nSlot++)
+		{
+			for (int i = 0; i < m_vFilters.size(); i++)
+				m_vFilters[i]->Add(rec, nLast);
+		}
+	}
+}
+
+void BloomFilterSet::Close()
+{
+	for (int i = 0; i < m_vFilters.size(); i++)
+		m_vFilters[i]->Flush();
+
+	if (m_bDirty && !m_sBinPath.empty())
+	{
+		ofstream bloom_out;
+		bloom_out.open(GetBloomPath(m_sBinPath).c_str(), ios::binary | ios::trunc);
+		int nFilters = m_vFilters.size();
+		bloom_out.write((char *) &nFilters, sizeof(int));
+		for (int i = 0; i < nFilters; i++)
+		{
+			int nAtt = m_vFilters[i]->GetWhichAtt();
+			bloom_out.write((char *) &nAtt, sizeof(int));
+			m_vFilters[i]->Write(bloom_out);
+		}
+		bloom_out.close();
+	}
+
+	for (int i = 0; i < m_vFilters.size(); i++)
+		delete m_vFilters[i];
+	m_vFilters.clear();
+	m_bDirty = false;
+}
+
+void BloomFilterSet::InsertLast()
+{
+	if (m_vFilters.empty())
+		return;
+
+	Record rec;
+	int nPage, nSlot;
+	if (!m_pBase->GetLastAdded(rec, nPage, nSlot))
+		return;
+	for (int i = 0; i < m_vFilters.size(); i++)
+		m_vFilters[i]->Add(rec, nPage);
+	m_bDirty = true;
+}
+
+void BloomFilterSet::Rebuild()
+{
+	if (m_vFilters.empty())
+		return;
+	for (int i = 0; i < m_vFilters.size(); i++)
+		m_vFilters[i]->Clear();
+	m_bDirty = true;
+
+	RecordScan scan;
+	scan.Open(m_sBinPath);
+	Record rec;
+	int nPage, nSlot;
+	while (scan.GetNext(rec, nPage, nSlot))
+	{
+		for (int i = 0; i < m_vFilters.size(); i++)
+			m_vFilters[i]->Add(rec, nPage);
+	}
+	scan.Close();
+
+	for (int i = 0; i < m_vFilters.size(); i++)
+		m_vFilters[i]->Flush();
+}
+
+int BloomFilterSet::FilterPages(CNF &cnf, Record &literal, vector<bool> &vRead)
+{
+	if (m_vFilters.empty())
+		return 0;
+
+	// for every AND clause the filters can rule out, the filter and
+	// the literal hash of each of its comparisons
+	vector< vector<BloomFilter*> > vClauseFilters;
+	vector< vector<unsigned long long> > vClauseHashes;
+	for (int i = 0; i < cnf.numAnds; i++)
+	{
+		vector<BloomFilter*> vFilters;
+		vector<unsigned long long> vHashes;
+		for (int j = 0; j < cnf.orLens[i]; j++)
+		{
+			Comparison &c = cnf.orList[i][j];
+			if (c.op != Equals)
+				break;
+
+			int nAtt, nLit;
+			CompOperator op;
+			if (!c.GetAttOpLiteral(nAtt, nLit, op))
+				break;
+
+			BloomFilter *pFilter = NULL;
+			for (int k = 0; k < m_vFilters.size(); k++)
+				if (m_vFilters[k]->GetWhichAtt() == nAtt && m_vFilters[k]->GetType() == c.attType)
+					pFilter = m_vFilters[k];
+			if (pFilter == NULL)
+				break;
+
+			vFilters.push_back(pFilter);
+			vHashes.push_back(literal.HashAtt(nLit, c.attType));
+		}
+		if (vFilters.size() == cnf.orLens[i])
+		{
+			vClauseFilters.push_back(vFilters);
+			vClauseHashes.push_back(vHashes);
+		}
+	}
+	if (vClauseFilters.empty())
+		return 0;
+
+	int nChecked = 0, nSkipped = 0;
+	for (int p = 0; p < vRead.size(); p++)
+	{
+		if (!vRead[p])
+			continue;
+		nChecked++;
+		for (int i = 0; i < vClauseFilters.size() && vRead[p]; i++)
+		{
+			bool bMayHold = false;
+			for (int j = 0; j < vClauseFilters[i].size() && !bMayHold; j++)
+				bMayHold = vClauseFilters[i][j]->MayContain(p, vClauseHashes[i][j]);
+			if (!bMayHold)
+			{
+				vRead[p] = false;
+				nSkipped++;
+			}
+		}
+	}
+
+	pthread_mutex_lock(&m_statsMutex);
+	m_nPagesChecked += nChecked;
+	m_nPagesSkipped += nSkipped;
+	pthread_mutex_unlock(&m_statsMutex);
+	return nSkipped;
+}
+
+void BloomFilterSet::PrintStats(ostream &out)
+{
+	pthread_mutex_lock(&m_statsMutex);
+	if (m_nPagesChecked > 0)
+		out << "Bloom filters: " << m_nPagesSkipped << " of " << m_nPagesChecked
+			<< " pages skipped\n";
+	pthread_mutex_unlock(&m_statsMutex);
+}
@@ -0,0 +1,124 @@
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+#include <pthread.h>
+#include <string>
+#include <vector>
+#include <iostream>
+#include "Defs.h"
+#include "Record.h"
+#include "Comparison.h"
+#include "FileUtil.h"
+
+using namespace std;
+
+// false positive rate of a Bloom filter created without FPRATE
+#define BLOOM_FP_RATE 0.01
+
+// filter of one data page; it is sized for the records of the page once
+// the page is full, empty while the page is still being filled
+struct PageBloom
+{
+	int nKeys;
+	vector<unsigned char> vBits;
+
+	PageBloom() : nKeys(0) {}
+};
+
+// Bloom filters on one attribute of a heap file, one per data page: a
+// scan for an equality with the literal does not read the pages whose
+// filter does not hold the value.
+// A filter gets -ln(fpRate) / ln(2)^2 bits per record of its page, and
+// the bits of a value are picked by double hashing of its 64 bit hash
+class BloomFilter
+{
+	private:
+		int m_nWhichAtt;
+		Type m_eType;
+		double m_dFpRate;
+		double m_dBitsPerKey;
+		int m_nHashes;
+
+		vector<PageBloom> m_vPages;
+
+		// hashes of the records of the page being filled
+		int m_nOpenPage;
+		vector<unsigned long long> m_vOpenHashes;
+		bool m_bOpenUnknown;	// it has records of some other schema
+
+	public:
+		BloomFilter(int whichAtt, Type type, double fpRate);
+		~BloomFilter() {}
+
+		// records of page nPage; the filter of a page is made when a
+		// record of a later page comes, or on Flush
+		void Add(Record &rec, int nPage);
+		void Flush();
+
+		// the filter of page nPage is dropped, its records are added again
+		void Reopen(int nPage);
+
+		// false if no record of page nPage has the value with this hash;
+		// a page without filter may hold anything
+		bool MayContain(int nPage, unsigned long long nHash);
+
+		void Clear();
+
+		// the filters, in the binary format of the .bloom file
+		void Write(ostream &out);
+		bool Read(istream &in);
+
+		int GetWhichAtt() { return m_nWhichAtt; }
+		Type GetType() { return m_eType; }
+		double GetFpRate() { return m_dFpRate; }
+};
+
+// The Bloom filters of a heap file, listed in its .meta.data with a
+// "bloom <attribute> <type> <false positive rate>" line each.
+// The filters themselves are kept in the <file>.bloom sidecar, written
+// on Close
+class BloomFilterSet
+{
+	private:
+		FileUtil *m_pBase;		// the base file, owned by the caller
+		string m_sBinPath;
+		vector<BloomFilter*> m_vFilters;
+		bool m_bDirty;
+
+		// process wide statistics, printed after a query
+		static pthread_mutex_t m_statsMutex;
+		static unsigned long m_nPagesChecked;
+		static unsigned long m_nPagesSkipped;
+
+	public:
+		BloomFilterSet(FileUtil *pBase);
+		~BloomFilterSet();
+
+		static string GetBloomPath(const string &binPath);
+
+		// reads the Bloom filter list of the base file binPath
+		static void GetBloomList(const string &binPath, vector<int> &vAtts,
+								 vector<Type> &vTypes, vector<double> &vFpRates);
+
+		// reads the filters of the base file; in APPEND mode the last page
+		// gets more records, its filter is made again on Close
+		void Open(const string &binPath, FileOpenMode mode = APPEND);
+		void Close();
+
+		bool IsEmpty() { return m_vFilters.empty(); }
+
+		// adds the record the base file got last to every filter
+		void InsertLast();
+
+		// builds every filter again from the records of the base file
+		void Rebuild();
+
+		// clears in vRead the pages on which an AND clause of the CNF, made
+		// only of equalities between a filtered attribute and the literal,
+		// can not hold; returns the number of pages it cleared
+		int FilterPages(CNF &cnf, Record &literal, vector<bool> &vRead);
+
+		static void PrintStats(ostream &out);
+};
+
+#endif
@@ -0,0 +1,481 @@
+#include "BufferPool.h"
+
+#include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/uio.h>
+
+BufferPool* BufferPool::bp = NULL;
+
+BufferPool::BufferPool(size_t nCapacity) : m_nCapacity(nCapacity), m_nBytes(0), m_vFrames(),
+	m_vUnused(), m_mPageTable(), m_nClockHand(0), m_nHits(0), m_nMisses(0), m_nEvictions(0),
+	m_nWriteBacks(0), m_nWriteCalls(0), m_nPrefetches(0), m_nPrefetchHits(0), m_nWaits(0)
+{
+	// frames are allocated as pages come in; the clock needs them to stay
+	// where they are, so the slots of the smallest pages are made up front
+	m_vFrames.resize(nCapacity / MIN_PAGE_SIZE);
+	for (int i = m_vFrames.size() - 1; i >= 0; i--)
+		m_vUnused.push_back(i);
+
+	pthread_mutex_init(&m_mutex, NULL);
+	pthread_cond_init(&m_loaded, NULL);
+}
+
+BufferPool::~BufferPool()
+{
+	// nothing can be written back here, files owning dirty
+	// pages flush them when they are closed
+	for (int i = 0; i < m_vFrames.size(); i++)
+		free(m_vFrames[i].bits);
+	pthread_mutex_destroy(&m_mutex);
+	pthread_cond_destroy(&m_loaded);
+}
+
+BufferPool* BufferPool::getBufferPool()
+{
+	// function-local static, so that it is constructed on first use
+	// and before any File could possibly need it
+	static BufferPool s((size_t) BUFFER_POOL_FRAMES * PAGE_SIZE);
+	if (!bp)
+		bp = &s;
+	return bp;
+}
+
+int BufferPool::NewFrame(int length)
+{
+	// frames are aligned so that they can be used for O_DIRECT I/O
+	void *pMemory = NULL;
+	if (m_vUnused.empty() || posix_memalign(&pMemory, IO_ALIGNMENT, length) != 0)
+	{
+		cout << "ERROR : Not enough memory. EXIT !!!\n";
+		exit(1);
+	}
+
+	int i = m_vUnused.back();
+	m_vUnused.pop_back();
+	m_vFrames[i].bits = (char*) pMemory;
+	m_vFrames[i].size = length;
+	m_nBytes += length;
+	return i;
+}
+
+void BufferPool::FreeFrame(int i)
+{
+	Frame &frame = m_vFrames[i];
+	free(frame.bits);
+	frame.bits = NULL;
+	m_nBytes -= frame.size;
+	frame.size = 0;
+	m_vUnused.push_back(i);
+}
+
+int BufferPool::GetVictimFrame(int length)
+{
+	if (m_nBytes + length <= m_nCapacity)
+		return NewFrame(length);
+
+	// sweep at most twice: first sweep may only clear reference bits.
+	// A frame of another size is freed, until that made room for one
+	int nFrames = m_vFrames.size();
+	for (int i = 0; i < 2 * nFrames; i++)
+	{
+		Frame &frame = m_vFrames[m_nClockHand];
+		int victim = m_nClockHand;
+		m_nClockHand = (m_nClockHand + 1) % nFrames;
+
+		if (frame.bits == NULL)
+			continue;
+
+		if (frame.bValid)
+		{
+			if (frame.pinCount > 0)
+				continue;
+
+			if (frame.bRefBit)
+			{
+				frame.bRefBit = false;
+				continue;
+			}
+
+			// found a victim, write it out if needed and evict it
+			if (frame.bDirty)
+				WriteFrame(frame);
+			m_mPageTable.erase(frame.key);
+			frame.bValid = false;
+			m_nEvictions++;
+		}
+
+		if (frame.size == length)
+			return victim;
+		FreeFrame(victim);
+		if (m_nBytes + length <= m_nCapacity)
+			return NewFrame(length);
+	}
+	return -1;
+}
+
+size_t ReadAt(int fileDes, char *buf, size_t length, off_t offset)
+{
+	size_t nDone = 0;
+	while (nDone < length)
+	{
+		ssize_t n = pread(fileDes, buf + nDone, length - nDone, offset + nDone);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0)
+		{
+			cerr << "BAD: read of " << length << " bytes at offset " << offset
+				 << " failed : " << strerror(errno) << "\n";
+			exit(1);
+		}
+		if (n == 0)		// end of file
+			break;
+		nDone += n;
+	}
+	return nDone;
+}
+
+void WriteAt(int fileDes, const char *buf, size_t length, off_t offset)
+{
+	size_t nDone = 0;
+	while (nDone < length)
+	{
+		ssize_t n = pwrite(fileDes, buf + nDone, length - nDone, offset + nDone);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+		{
+			cerr << "BAD: write of " << length << " bytes at offset " << offset
+				 << " failed : " << strerror(errno) << "\n";
+			exit(1);
+		}
+		nDone += n;
+	}
+}
+
+void BufferPool::WriteFrame(Frame &frame)
+{
+	// collect the dirty pages following this one in the same file; with
+	// sequential appends this turns page-sized writes into big ones
+	Frame *cluster[MAX_WRITE_CLUSTER];
+	struct iovec iov[MAX_WRITE_CLUSTER];
+	int nFrames = 0;
+
+	cluster[nFrames++] = &frame;
+	while (nFrames < MAX_WRITE_CLUSTER && nFrames < IOV_MAX)
+	{
+		Frame *pLast = cluster[nFrames - 1];
+		PageKey next(pLast->key.dev, pLast->key.ino, pLast->key.page + 1);
+		map<PageKey, int>::iterator it = m_mPageTable.find(next);
+		if (it == m_mPageTable.end())
+			break;
+
+		// pinned frames may be in the middle of being written into
+		Frame &f = m_vFrames[it->second];
+		if (!f.bDirty || f.bLoading || f.pinCount > 0 ||
+			f.fileDes != frame.fileDes || f.offset != pLast->offset + pLast->length)
+			break;
+		cluster[nFrames++] = &f;
+	}
+
+	size_t nTotal = 0;
+	for (int i = 0; i < nFrames; i++)
+	{
+		iov[i].iov_base = cluster[i]->bits;
+		iov[i].iov_len = cluster[i]->length;
+		nTotal += cluster[i]->length;
+	}
+
+	ssize_t n = pwritev(frame.fileDes, iov, nFrames, frame.offset);
+	while (n < 0 && errno == EINTR)
+		n = pwritev(frame.fileDes, iov, nFrames, frame.offset);
+	if (n < 0)
+	{
+		cerr << "BufferPool: write of page " << frame.key.page << " failed : "
+			 << strerror(errno) << "\n";
+		exit(1);
+	}
+
+	// finish a partial write page by page
+	size_t nStart = 0;
+	for (int i = 0; (size_t)n < nTotal && i < nFrames; i++)
+	{
+		size_t nLength = cluster[i]->length;
+		if ((size_t)n < nStart + nLength)
+		{
+			size_t nSkip = ((size_t)n > nStart) ? n - nStart : 0;
+			WriteAt(frame.fileDes, cluster[i]->bits + nSkip, nLength - nSkip,
+					cluster[i]->offset + nSkip);
+		}
+		nStart += nLength;
+	}
+
+	for (int i = 0; i < nFrames; i++)
+		cluster[i]->bDirty = false;
+	m_nWriteBacks += nFrames;
+	m_nWriteCalls++;
+}
+
+void BufferPool::LoadFrame(Frame &frame)
+{
+	// the frame is pinned, so nobody can take it away while we read
+	pthread_mutex_unlock(&m_mutex);
+	size_t nRead = ReadAt(frame.fileDes, frame.bits, frame.length, frame.offset);
+	// pages never written (holes, or past the end) read as empty pages
+	if (nRead < (size_t)frame.length)
+		memset(frame.bits + nRead, 0, frame.length - nRead);
+	pthread_mutex_lock(&m_mutex);
+
+	frame.bLoading = false;
+	pthread_cond_broadcast(&m_loaded);
+}
+
+char* BufferPool::PinPage(int fileDes, const PageKey &key, off_t offset, int length,
+						  bool bReadFromDisk)
+{
+	pthread_mutex_lock(&m_mutex);
+
+	// page is already in the pool
+	map<PageKey, int>::iterator it = m_mPageTable.find(key);
+	if (it != m_mPageTable.end())
+	{
+		Frame &frame = m_vFrames[it->second];
+		frame.pinCount++;
+		frame.bRefBit = true;
+		m_nHits++;
+
+		// the page may have been cached through a descriptor that has been
+		// closed since (and reused for another file), write back through ours
+		frame.fileDes = fileDes;
+
+		// read-ahead got here first but has not finished yet
+		if (frame.bLoading)
+		{
+			m_nWaits++;
+			while (frame.bLoading)
+				pthread_cond_wait(&m_loaded, &m_mutex);
+		}
+		else if (frame.bPrefetched)
+			m_nPrefetchHits++;
+		frame.bPrefetched = false;
+
+		pthread_mutex_unlock(&m_mutex);
+		return frame.bits;
+	}
+
+	// otherwise bring it in
+	m_nMisses++;
+	int victim = GetVictimFrame(length);
+	if (victim == -1)
+	{
+		cerr << "BufferPool: all " << m_vFrames.size() - m_vUnused.size() << " frames are pinned\n";
+		exit(1);
+	}
+
+	Frame &frame = m_vFrames[victim];
+	frame.key = key;
+	frame.fileDes = fileDes;
+	frame.offset = offset;
+	frame.length = length;
+	frame.pinCount = 1;
+	frame.bDirty = false;
+	frame.bRefBit = true;
+	frame.bValid = true;
+	frame.bLoading = bReadFromDisk;
+	frame.bPrefetched = false;
+	m_mPageTable[key] = victim;
+
+	if (bReadFromDisk)
+		LoadFrame(frame);
+
+	pthread_mutex_unlock(&m_mutex);
+	return frame.bits;
+}
+
+char* BufferPool::PinDecodedPage(const PageKey &key, int length, bool &bFill)
+{
+	pthread_mutex_lock(&m_mutex);
+
+	bFill = false;
+	map<PageKey, int>::iterator it = m_mPageTable.find(key);
+	if (it != m_mPageTable.end())
+	{
+		Frame &frame = m_vFrames[it->second];
+		frame.pinCount++;
+		frame.bRefBit = true;
+		m_nHits++;
+		if (frame.bLoading)
+		{
+			m_nWaits++;
+			while (frame.bLoading)
+				pthread_cond_wait(&m_loaded, &m_mutex);
+		}
+		pthread_mutex_unlock(&m_mutex);
+		return frame.bits;
+	}
+
+	m_nMisses++;
+	int victim = GetVictimFrame(length);
+	if (victim == -1)
+	{
+		cerr << "BufferPool: all " << m_vFrames.size() - m_vUnused.size() << " frames are pinned\n";
+		exit(1);
+	}
+
+	// no descriptor: the frame is never dirty, so never written
+	Frame &frame = m_vFrames[victim];
+	frame.key = key;
+	frame.fileDes = -1;
+	frame.offset = 0;
+	frame.length = length;
+	frame.pinCount = 1;
+	frame.bDirty = false;
+	frame.bRefBit = true;
+	frame.bValid = true;
+	frame.bLoading = true;
+	frame.bPrefetched = false;
+	m_mPageTable[key] = victim;
+	bFill = true;
+
+	pthread_mutex_unlock(&m_mutex);
+	return frame.bits;
+}
+
+void BufferPool::FilledPage(const PageKey &key)
+{
+	pthread_mutex_lock(&m_mutex);
+
+	map<PageKey, int>::iterator it = m_mPageTable.find(key);
+	if (it != m_mPageTable.end())
+		m_vFrames[it->second].bLoading = false;
+	pthread_cond_broadcast(&m_loaded);
+
+	pthread_mutex_unlock(&m_mutex);
+}
+
+void BufferPool::Prefetch(int fileDes, const PageKey &key, off_t offset, int length)
+{
+	pthread_mutex_lock(&m_mutex);
+
+	int victim = -1;
+	if (m_mPageTable.find(key) == m_mPageTable.end())
+		victim = GetVictimFrame(length);
+
+	// already cached, or no room for it: the reader will do it
+	if (victim == -1)
+	{
+		pthread_mutex_unlock(&m_mutex);
+		return;
+	}
+
+	// keep it pinned while loading, and unpinned afterwards
+	Frame &frame = m_vFrames[victim];
+	frame.key = key;
+	frame.fileDes = fileDes;
+	frame.offset = offset;
+	frame.length = length;
+	frame.pinCount = 1;
+	frame.bDirty = false;
+	frame.bRefBit = true;
+	frame.bValid = true;
+	frame.bLoading = true;
+	frame.bPrefetched = true;
+	m_mPageTable[key] = victim;
+	m_nPrefetches++;
+
+	LoadFrame(frame);
+	frame.pinCount--;
+
+	pthread_mutex_unlock(&m_mutex);
+}
+
+bool BufferPool::IsCached(const PageKey &key)
+{
+	pthread_mutex_lock(&m_mutex);
+	bool bCached = (m_mPageTable.find(key) != m_mPageTable.end());
+	pthread_mutex_unlock(&m_mutex);
+	return bCached;
+}
+
+void BufferPool::UnpinPage(const PageKey &key, bool bDirty)
+{
+	pthread_mutex_lock(&m_mutex);
+
+	map<PageKey, int>::iterator it = m_mPageTable.find(key);
+	if (it != m_mPageTable.end())
+	{
+		Frame &frame = m_vFrames[it->second];
+		if (frame.pinCount > 0)
+			frame.pinCount--;
+		if (bDirty)
+			frame.bDirty = true;
+	}
+
+	pthread_mutex_unlock(&m_mutex);
+}
+
+void BufferPool::FlushFile(dev_t dev, ino_t ino)
+{
+	pthread_mutex_lock(&m_mutex);
+
+	// pages of one file are adjacent in the page table
+	map<PageKey, int>::iterator it = m_mPageTable.lower_bound(PageKey(dev, ino, 0));
+	for (; it != m_mPageTable.end() && it->first.dev == dev && it->first.ino == ino; it++)
+	{
+		Frame &frame = m_vFrames[it->second];
+		if (frame.bDirty)
+			WriteFrame(frame);
+	}
+
+	pthread_mutex_unlock(&m_mutex);
+}
+
+void BufferPool::DiscardFile(dev_t dev, ino_t ino)
+{
+	pthread_mutex_lock(&m_mutex);
+
+	// let reads still in progress on this file finish first
+	map<PageKey, int>::iterator it = m_mPageTable.lower_bound(PageKey(dev, ino, 0));
+	while (it != m_mPageTable.end() && it->first.dev == dev && it->first.ino == ino)
+	{
+		if (m_vFrames[it->second].bLoading)
+		{
+			pthread_cond_wait(&m_loaded, &m_mutex);
+			it = m_mPageTable.lower_bound(PageKey(dev, ino, 0));
+		}
+		else
+			it++;
+	}
+
+	it = m_mPageTable.lower_bound(PageKey(dev, ino, 0));
+	while (it != m_mPageTable.end() && it->first.dev == dev && it->first.ino == ino)
+	{
+		Frame &frame = m_vFrames[it->second];
+		frame.bValid = false;
+		frame.bDirty = false;
+		frame.pinCount = 0;
+		m_mPageTable.erase(it++);
+	}
+
+	pthread_mutex_unlock(&m_mutex);
+}
+
+void BufferPool::PrintStats(ostream &out)
+{
+	pthread_mutex_lock(&m_mutex);
+	unsigned long nRequests = m_nHits + m_nMisses;
+	out << "Buffer pool (" << m_vFrames.size() - m_vUnused.size() << " frames, "
+		<< m_nBytes / 1024 << "K): "
+		<< m_nHits << " hits, " << m_nMisses << " misses";
+	if (nRequests > 0)
+		out << " (" << (100.0 * m_nHits) / nRequests << "% hit ratio)";
+	out << ", " << m_nEvictions << " evictions, "
+		<< m_nWriteBacks << " write-backs (in " << m_nWriteCalls << " writes)\n";
+	if (m_nPrefetches > 0)
+		out << "Read-ahead: " << m_nPrefetches << " pages prefetched, "
+			<< m_nPrefetchHits << " found ready, "
+			<< m_nWaits << " waits for a read in progress\n";
+	pthread_mutex_unlock(&m_mutex);
+}
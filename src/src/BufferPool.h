@@ -0,0 +1,166 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <pthread.h>
+#include <sys/types.h>
+#include <iostream>
+#include <vector>
+#include <map>
+#include "Defs.h"
+
+using namespace std;
+
+// Identifies one physical page of one file on disk. Files are identified by
+// device + inode (and not by name), so that a file which gets renamed (eg the
+// tmpFile of Sorted) keeps its cached pages
+struct PageKey
+{
+	dev_t dev;
+	ino_t ino;
+	off_t page;
+
+	PageKey() : dev(0), ino(0), page(0) {}
+	PageKey(dev_t d, ino_t i, off_t p) : dev(d), ino(i), page(p) {}
+
+	bool operator< (const PageKey& k) const
+	{
+		if (dev != k.dev)
+			return dev < k.dev;
+		if (ino != k.ino)
+			return ino < k.ino;
+		return page < k.page;
+	}
+};
+
+// One slot of the buffer pool, holding the binary image of a page. Frames
+// are as big as the pages they hold, so small pages take little memory
+struct Frame
+{
+	char *bits;		// "size" bytes of its own, NULL for an unused slot
+	int size;
+	PageKey key;
+	int fileDes;	// needed to write the page back when it is dirty
+	off_t offset;	// where the page lives in the file
+	int length;		// page size of the file, <= PAGE_SIZE
+	int pinCount;
+	bool bDirty;
+	bool bRefBit;	// second-chance bit for CLOCK replacement
+	bool bValid;
+	bool bLoading;		// read from disk in progress, bits not usable yet
+	bool bPrefetched;	// brought in by read-ahead and not used yet
+
+	Frame() : bits(NULL), size(0), key(), fileDes(-1), offset(0), length(PAGE_SIZE), pinCount(0),
+			  bDirty(false), bRefBit(false), bValid(false),
+			  bLoading(false), bPrefetched(false)
+	{}
+};
+
+// Process-wide page cache shared by every File, holding up to "capacity"
+// bytes of pages of any size. Pages are pinned while a
+// caller is reading from / writing into the frame, pinned frames are never
+// evicted. Replacement is done using CLOCK (second chance). Dirty pages are
+// written back on eviction or when the owning file is flushed.
+// Reads are done outside of the pool lock: a frame being read in is marked
+// bLoading, and anybody else pinning it waits on m_loaded until it is done
+class BufferPool
+{
+private:
+	static BufferPool *bp;
+
+	size_t m_nCapacity;		// bytes the frames may take in all
+	size_t m_nBytes;		// ... and take now
+	vector<Frame> m_vFrames;
+	vector<int> m_vUnused;	// slots of m_vFrames without memory
+	map<PageKey, int> m_mPageTable;	// page -> index in m_vFrames
+	int m_nClockHand;
+	pthread_mutex_t m_mutex;
+	pthread_cond_t m_loaded;	// signalled when a frame stops bLoading
+
+	// statistics
+	unsigned long m_nHits;
+	unsigned long m_nMisses;
+	unsigned long m_nEvictions;
+	unsigned long m_nWriteBacks;
+	unsigned long m_nWriteCalls;	// write-backs are clustered, see WriteFrame
+	unsigned long m_nPrefetches;	// pages read in by read-ahead
+	unsigned long m_nPrefetchHits;	// ... and later found ready by a reader
+	unsigned long m_nWaits;			// readers that had to wait for a read in progress
+
+	BufferPool(size_t nCapacity);
+
+	// returns the index of a free (or freshly evicted) frame of "length"
+	// bytes, -1 if there is no room for one as the frames are pinned.
+	// Frames of other sizes are evicted and freed to make room if needed.
+	// Caller must hold m_mutex
+	int GetVictimFrame(int length);
+
+	// a frame of "length" bytes in an unused slot, and the other way
+	// round. Caller must hold m_mutex
+	int NewFrame(int length);
+	void FreeFrame(int i);
+
+	// write the frame to its file and mark it clean, along with the dirty
+	// frames holding the pages right after it (up to MAX_WRITE_CLUSTER),
+	// in one pwritev. Caller must hold m_mutex
+	void WriteFrame(Frame &frame);
+
+	// read the page of a frame marked bLoading from disk, dropping m_mutex
+	// while doing so. Caller must hold m_mutex
+	void LoadFrame(Frame &frame);
+
+public:
+	virtual ~BufferPool();
+
+	static BufferPool* getBufferPool();
+
+	// pin the page "key", "length" bytes stored at "offset" in the file open
+	// at "fileDes", and return its bits; if bReadFromDisk is false the caller
+	// is going to overwrite the whole page, so it is not read in on a miss
+	char* PinPage(int fileDes, const PageKey &key, off_t offset, int length,
+				  bool bReadFromDisk = true);
+
+	// pin the decoded image of page "key" of a compressed file, "length"
+	// bytes. Its frame is never written back, the file writes the page
+	// packed. If the page is not cached, bFill is set: the caller fills
+	// the frame, then calls FilledPage; others pinning it wait till then
+	char* PinDecodedPage(const PageKey &key, int length, bool &bFill);
+	void FilledPage(const PageKey &key);
+
+	// release a page pinned by PinPage; bDirty = true if it was modified
+	void UnpinPage(const PageKey &key, bool bDirty);
+
+	// bring the page "key" in without pinning it, so that a later PinPage
+	// finds it in memory. Used by the ReadAhead thread; does nothing if
+	// the page is already cached or every frame is pinned
+	void Prefetch(int fileDes, const PageKey &key, off_t offset, int length);
+
+	// true if the page is in the pool (or on its way in)
+	bool IsCached(const PageKey &key);
+
+	// write back all the dirty pages of the given file
+	void FlushFile(dev_t dev, ino_t ino);
+
+	// drop all the pages of the given file without writing them back;
+	// used when a file is truncated and its old pages are garbage
+	void DiscardFile(dev_t dev, ino_t ino);
+
+	unsigned long GetHits() { return m_nHits; }
+	unsigned long GetMisses() { return m_nMisses; }
+	unsigned long GetEvictions() { return m_nEvictions; }
+	unsigned long GetWriteBacks() { return m_nWriteBacks; }
+	unsigned long GetWriteCalls() { return m_nWriteCalls; }
+	unsigned long GetPrefetches() { return m_nPrefetches; }
+	unsigned long GetPrefetchHits() { return m_nPrefetchHits; }
+	unsigned long GetWaits() { return m_nWaits; }
+	int GetNumFrames() { return m_vFrames.size() - m_vUnused.size(); }
+
+	void PrintStats(ostream &out);
+};
+
+// pread/pwrite that retry on EINTR and partial transfers and exit on
+// errors. ReadAt returns the number of bytes read, less than "length"
+// only at the end of the file
+size_t ReadAt(int fileDes, char *buf, size_t length, off_t offset);
+void WriteAt(int fileDes, const char *buf, size_t length, off_t offset);
+
+#endif
@@ -0,0 +1,384 @@
+#include "BulkLoader.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <algorithm>
+
+LoadStats BulkLoader::m_lastStats;
+
+static double Now()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+BulkLoader::BulkLoader() : m_pSchema(NULL), m_nPageSize(PAGE_SIZE), m_nFd(-1), m_pMap(NULL),
+	m_nMapLen(0), m_vBlocks(), m_vThreads(), m_nNextToParse(0), m_nReading(0), m_nPage(0),
+	m_nWindow(1), m_bStop(false), m_pLastPage(NULL), m_vFreePages(), m_export(), m_bExport(false),
+	m_nExportPage(0), m_pExportPage(NULL), m_nRecords(0), m_dStart(0)
+{
+	pthread_mutex_init(&m_mutex, NULL);
+	pthread_cond_init(&m_parsedVar, NULL);
+	pthread_cond_init(&m_windowVar, NULL);
+}
+
+BulkLoader::~BulkLoader()
+{
+	Close();
+	pthread_mutex_destroy(&m_mutex);
+	pthread_cond_destroy(&m_parsedVar);
+	pthread_cond_destroy(&m_windowVar);
+}
+
+bool BulkLoader::Open(char *loadMe, Schema &mySchema, int nPageSize)
+{
+	Close();
+	m_dStart = Now();
+	m_pSchema = &mySchema;
+	m_nPageSize = nPageSize;
+	m_nRecords = 0;
+
+	if (ExportFile::IsExportFile(loadMe))
+		return OpenExport(loadMe, mySchema);
+
+	m_nFd = open(loadMe, O_RDONLY);
+	if (m_nFd < 0)
+		return false;
+	struct stat fileStat;
+	if (fstat(m_nFd, &fileStat) != 0)
+	{
+		close(m_nFd);
+		m_nFd = -1;
+		return false;
+	}
+
+	// an empty file has no blocks
+	m_nMapLen = fileStat.st_size;
+	if (m_nMapLen > 0)
+	{
+		void *map = mmap(NULL, m_nMapLen, PROT_READ, MAP_PRIVATE, m_nFd, 0);
+		if (map == MAP_FAILED)
+		{
+			close(m_nFd);
+			m_nFd = -1;
+			m_nMapLen = 0;
+			return false;
+		}
+		m_pMap = (char *) map;
+		madvise(m_pMap, m_nMapLen, MADV_SEQUENTIAL);
+	}
+	MakeBlocks();
+
+	// the loading thread is a parser too
+	long nProcs = sysconf(_SC_NPROCESSORS_ONLN);
+	int nThreads = min((long) LOAD_MAX_THREADS, max(nProcs, 1L)) - 1;
+	nThreads = min(nThreads, (int) m_vBlocks.size() - 1);
+	m_nWindow = 2 * (nThreads + 1);
+	m_nNextToParse = 0;
+	m_nReading = 0;
+	m_nPage = 0;
+	m_bStop = false;
+	for (int i = 0; i < nThreads; i++)
+	{
+		pthread_t thread;
+		// fewer threads only make it slower
+		if (pthread_create(&thread, NULL, &ParseBlocksHelper, (void*)this) != 0)
+			break;
+		m_vThreads.push_back(thread);
+	}
+	return true;
+}
+
+bool BulkLoader::OpenExport(char *loadMe, Schema &mySchema)
+{
+	if (!m_export.Open(loadMe))
+		return false;
+	if (!m_export.HasTypesOf(mySchema))
+	{
+		cerr << "BAD: " << loadMe << " has records of some other schema\n";
+		m_export.Close();
+		return false;
+	}
+	m_bExport = true;
+	m_nExportPage = 0;
+	m_nMapLen = (size_t) m_export.GetNumPages() * m_export.GetPageSize();
+	return true;
+}
+
+void BulkLoader::MakeBlocks()
+{
+	m_vBlocks.clear();
+	const char *pEnd = m_pMap + m_nMapLen;
+	const char *pBegin = m_pMap;
+	while (pBegin < pEnd)
+	{
+		// the block ends with the line it cuts
+		const char *pCut = pBegin + min((size_t) LOAD_BLOCK_BYTES, (size_t) (pEnd - pBegin));
+		const char *eol = (pCut < pEnd) ? (const char *) memchr(pCut, '\n', pEnd - pCut) : NULL;
+		Block block;
+		block.pBegin = pBegin;
+		block.pEnd = (eol != NULL) ? eol + 1 : pEnd;
+		block.bParsed = false;
+		m_vBlocks.push_back(block);
+		pBegin = block.pEnd;
+	}
+}
+
+void* BulkLoader::ParseBlocksHelper(void *context)
+{
+	return ((BulkLoader *) context)->ParseBlocks();
+}
+
+void* BulkLoader::ParseBlocks()
+{
+	pthread_mutex_lock(&m_mutex);
+	while (!m_bStop && m_nNextToParse < m_vBlocks.size())
+	{
+		if (m_nNextToParse >= m_nReading + m_nWindow)
+		{
+			pthread_cond_wait(&m_windowVar, &m_mutex);
+			continue;
+		}
+		Block &block = m_vBlocks[m_nNextToParse++];
+		pthread_mutex_unlock(&m_mutex);
+		ParseBlock(block);
+		pthread_mutex_lock(&m_mutex);
+		block.bParsed = true;
+		pthread_cond_signal(&m_parsedVar);
+	}
+	pthread_mutex_unlock(&m_mutex);
+	return NULL;
+}
+
+void BulkLoader::ParseBlock(Block &block)
+{
+	char *space = RecordMemory::Alloc(PAGE_SIZE);
+	TextParser parser(*m_pSchema);
+	TextScanner text(block.pBegin, block.pEnd);
+	long nRecords = 0;
+	Record rec;
+	Page *pPage = NewPage();
+	while (!text.AtEnd() && rec.SuckNextRecord(parser, text, space))
+	{
+		nRecords++;
+		if (!pPage->Append(&rec))
+		{
+			block.vPages.push_back(pPage);
+			pPage = NewPage();
+			if (!pPage->Append(&rec))
+			{
+				cerr << "BAD: a record of the text file is larger than a page of "
+					 << m_nPageSize << " bytes\n";
+				exit(1);
+			}
+		}
+	}
+	if (pPage->GetNumRecs() > 0)
+		block.vPages.push_back(pPage);
+	else
+	{
+		pthread_mutex_lock(&m_mutex);
+		m_vFreePages.push_back(pPage);
+		pthread_mutex_unlock(&m_mutex);
+	}
+	RecordMemory::Free(space);
+
+	pthread_mutex_lock(&m_mutex);
+	m_nRecords += nRecords;
+	pthread_mutex_unlock(&m_mutex);
+}
+
+Page* BulkLoader::NewPage()
+{
+	Page *pPage = NULL;
+	pthread_mutex_lock(&m_mutex);
+	if (!m_vFreePages.empty())
+	{
+		pPage = m_vFreePages.back();
+		m_vFreePages.pop_back();
+	}
+	pthread_mutex_unlock(&m_mutex);
+
+	if (pPage == NULL)
+	{
+		pPage = new (std::nothrow) Page();
+		if (pPage == NULL)
+		{
+			cout << "ERROR : Not enough memory. EXIT !!!\n";
+			exit(1);
+		}
+		pPage->SetPageSize(m_nPageSize);
+	}
+	return pPage;
+}
+
+Page* BulkLoader::GetNextExportPage()
+{
+	if (m_pLastPage == NULL)
+		m_pLastPage = NewPage();
+	m_pLastPage->EmptyItOut();
+
+	// pages of the size of the file are handed out as they are
+	if (m_export.GetPageSize() == m_nPageSize)
+	{
+		if (m_nExportPage >= m_export.GetNumPages())
+			return NULL;
+		m_export.GetPage(*m_pLastPage, m_nExportPage++);
+		m_nRecords += m_pLastPage->GetNumRecs();
+		return m_pLastPage;
+	}
+
+	// the others are cut, or filled, to that size: a record leaves the
+	// page of the export file only once it is appended to the other one
+	if (m_pExportPage == NULL)
+		m_pExportPage = NewPage();
+	Record rec;
+	while (true)
+	{
+		if (m_pExportPage->GetNumRecs() == 0)
+		{
+			if (m_nExportPage >= m_export.GetNumPages())
+				break;
+			m_export.GetPage(*m_pExportPage, m_nExportPage++);
+			continue;
+		}
+		m_pExportPage->GetRecord(0, &rec);
+		if (!m_pLastPage->Append(&rec))
+		{
+			if (m_pLastPage->GetNumRecs() > 0)
+				break;
+			cerr << "BAD: a record of the export file is larger than a page of "
+				 << m_nPageSize << " bytes\n";
+			exit(1);
+		}
+		m_pExportPage->GetFirst(&rec);
+		m_nRecords++;
+	}
+	return (m_pLastPage->GetNumRecs() > 0) ? m_pLastPage : NULL;
+}
+
+Page* BulkLoader::GetNextPage()
+{
+	if (m_bExport)
+		return GetNextExportPage();
+
+	pthread_mutex_lock(&m_mutex);
+	if (m_pLastPage != NULL)
+	{
+		m_pLastPage->EmptyItOut();
+		m_vFreePages.push_back(m_pLastPage);
+		m_pLastPage = NULL;
+	}
+
+	while (m_nReading < m_vBlocks.size())
+	{
+		Block &block = m_vBlocks[m_nReading];
+		if (!block.bParsed)
+		{
+			// no thread took it, rather than waiting it is parsed here
+			if (m_nNextToParse == m_nReading)
+			{
+				m_nNextToParse++;
+				pthread_mutex_unlock(&m_mutex);
+				ParseBlock(block);
+				pthread_mutex_lock(&m_mutex);
+				block.bParsed = true;
+			}
+			else
+				pthread_cond_wait(&m_parsedVar, &m_mutex);
+			continue;
+		}
+
+		if (m_nPage < block.vPages.size())
+		{
+			m_pLastPage = block.vPages[m_nPage++];
+			pthread_mutex_unlock(&m_mutex);
+			return m_pLastPage;
+		}
+
+		// the block is done with, a parser can take one more
+		block.vPages.clear();
+		m_nReading++;
+		m_nPage = 0;
+		pthread_cond_broadcast(&m_windowVar);
+	}
+	pthread_mutex_unlock(&m_mutex);
+	return NULL;
+}
+
+void BulkLoader::Close()
+{
+	if (m_bExport)
+	{
+		m_lastStats.nRecords = m_nRecords;
+		m_lastStats.nBytes = m_nMapLen;
+		m_lastStats.nThreads = 1;
+		m_lastStats.dSeconds = Now() - m_dStart;
+		m_lastStats.bExport = true;
+		m_export.Close();
+		m_bExport = false;
+		delete m_pLastPage;
+		delete m_pExportPage;
+		m_pLastPage = NULL;
+		m_pExportPage = NULL;
+		m_nMapLen = 0;
+		return;
+	}
+
+	if (m_nFd < 0)
+		return;
+
+	pthread_mutex_lock(&m_mutex);
+	m_bStop = true;
+	pthread_cond_broadcast(&m_windowVar);
+	pthread_mutex_unlock(&m_mutex);
+	for (int i = 0; i < m_vThreads.size(); i++)
+		pthread_join(m_vThreads[i], NULL);
+
+	m_lastStats.nRecords = m_nRecords;
+	m_lastStats.nBytes = m_nMapLen;
+	m_lastStats.nThreads = m_vThreads.size() + 1;
+	m_lastStats.dSeconds = Now() - m_dStart;
+	m_lastStats.bExport = false;
+	m_vThreads.clear();
+
+	// pages of blocks a load that stopped early did not get to
+	for (int i = 0; i < m_vBlocks.size(); i++)
+	{
+		for (int j = 0; j < m_vBlocks[i].vPages.size(); j++)
+			delete m_vBlocks[i].vPages[j];
+	}
+	m_vBlocks.clear();
+	if (m_pLastPage != NULL)
+		m_vFreePages.push_back(m_pLastPage);
+	m_pLastPage = NULL;
+	for (int i = 0; i < m_vFreePages.size(); i++)
+		delete m_vFreePages[i];
+	m_vFreePages.clear();
+
+	if (m_pMap != NULL)
+		munmap(m_pMap, m_nMapLen);
+	m_pMap = NULL;
+	m_nMapLen = 0;
+	close(m_nFd);
+	m_nFd = -1;
+}
+
+void BulkLoader::PrintStats(ostream &out)
+{
+	LoadStats &stats = m_lastStats;
+	out << stats.nRecords << " records loaded in " << stats.dSeconds << " secs (";
+	if (stats.dSeconds > 0)
+		out << (long) (stats.nRecords / stats.dSeconds) << " records/sec, "
+			<< stats.nBytes / stats.dSeconds / 1048576 << " MB/sec, ";
+	if (stats.bExport)
+		out << "export file, no parsing)\n";
+	else
+		out << stats.nThreads << " parser thread" << (stats.nThreads > 1 ? "s" : "") << ", "
+			<< TextScanner::GetInstructionSet() << " delimiter scan)\n";
+}
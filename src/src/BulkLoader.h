@@ -0,0 +1,118 @@
+#ifndef BULK_LOADER_H
+#define BULK_LOADER_H
+
+#include <pthread.h>
+#include <vector>
+#include <iostream>
+#include "Defs.h"
+#include "Record.h"
+#include "Schema.h"
+#include "File.h"
+#include "TextParser.h"
+#include "ExportFile.h"
+
+using namespace std;
+
+// what a load did, see BulkLoader::GetLastStats
+struct LoadStats
+{
+	long nRecords;
+	long nBytes;		// of the text file
+	int nThreads;		// that parsed it, the loading one included
+	double dSeconds;
+	bool bExport;		// the file was an export file, nothing was parsed
+
+	LoadStats() : nRecords(0), nBytes(0), nThreads(0), dSeconds(0), bExport(false) {}
+};
+
+// Parser of a text file of records (see TextParser) for the Load of
+// the files. The file is mapped in memory and cut, at the end of a line,
+// in blocks of about LOAD_BLOCK_BYTES. Parser threads take the blocks in
+// turn and lay out their records in pages of the page size of the file
+// being loaded, while the loading thread gets the pages in the order of
+// the text file: a Heap writes them as they are, the others add their
+// records. The loading thread parses a block itself when it would
+// otherwise wait for it, so that with a single processor there is no
+// parser thread at all. The parsers keep at most a few blocks per thread
+// ahead of the loading one, which bounds the memory the pages take.
+// An export file (see ExportFile) is not parsed: its pages are handed
+// out as they are, or their records laid out again in pages of the page
+// size of the file being loaded if it is another one
+class BulkLoader
+{
+	private:
+		struct Block
+		{
+			const char *pBegin;
+			const char *pEnd;
+			vector<Page*> vPages;
+			bool bParsed;
+		};
+
+		Schema *m_pSchema;
+		int m_nPageSize;
+
+		int m_nFd;
+		char *m_pMap;
+		size_t m_nMapLen;
+		vector<Block> m_vBlocks;
+
+		vector<pthread_t> m_vThreads;
+		pthread_mutex_t m_mutex;
+		pthread_cond_t m_parsedVar;		// a block got parsed
+		pthread_cond_t m_windowVar;		// the loading thread went to the next block
+		int m_nNextToParse;		// first block no thread took yet
+		int m_nReading;			// block the loading thread is in
+		int m_nPage;			// page of it GetNextPage hands out next
+		int m_nWindow;			// blocks parsed ahead of it, at most
+		bool m_bStop;
+
+		Page *m_pLastPage;		// the one GetNextPage handed out last
+		vector<Page*> m_vFreePages;
+
+		// of an export file, instead of the blocks
+		ExportFile m_export;
+		bool m_bExport;
+		long m_nExportPage;		// page of it that is read next
+		Page *m_pExportPage;	// its records not handed out yet
+
+		long m_nRecords;
+		double m_dStart;
+		static LoadStats m_lastStats;
+
+		static void* ParseBlocksHelper(void*);
+		void* ParseBlocks();
+
+		// lays out the records of the block in pages, without the lock
+		void ParseBlock(Block &block);
+		Page* NewPage();
+
+		// cuts the mapped file in blocks
+		void MakeBlocks();
+
+		bool OpenExport(char *loadMe, Schema &mySchema);
+		Page* GetNextExportPage();
+
+	public:
+		BulkLoader();
+		~BulkLoader();
+
+		// maps the text file and starts the parser threads; the pages are
+		// filled up to nPageSize. Returns false if the file can not be read,
+		// or if it is an export file of records of some other schema
+		bool Open(char *loadMe, Schema &mySchema, int nPageSize = PAGE_SIZE);
+
+		// the next page of records, in the order of the text file, NULL
+		// once they are all out. The page is the caller's, who may take
+		// its records, until the next call
+		Page* GetNextPage();
+
+		// stops the threads and unmaps the file
+		void Close();
+
+		// of the last load that was closed
+		static void GetLastStats(LoadStats &stats) { stats = m_lastStats; }
+		static void PrintStats(ostream &out);
+};
+
+#endif
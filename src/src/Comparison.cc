@@ -63,6 +63,24 @@ void Comparison :: Print () {
 }
 
 
+bool Comparison :: GetAttOpLiteral (int &whichAtt, int &litAtt, CompOperator &compOp) {
+
+	compOp = op;
+	if (operand1 == Left && operand2 == Literal) {
+		whichAtt = whichAtt1;
+		litAtt = whichAtt2;
+	} else if (operand1 == Literal && operand2 == Left) {
+		whichAtt = whichAtt2;
+		litAtt = whichAtt1;
+		if (op == LessThan)
+			compOp = GreaterThan;
+		else if (op == GreaterThan)
+			compOp = LessThan;
+	} else {
+		return false;
+	}
+	return true;
+}
 
 
 OrderMaker :: OrderMaker() {
@@ -788,3 +806,36 @@ OrderMaker* CNF :: GetMatchingOrder(OrderMaker& file_order)
     }
 
 }
+
+int CNF :: GetRangeBounds(int whichAtt, int &lowAtt, int &highAtt)
+{
+    lowAtt = -1;
+    highAtt = -1;
+
+    for (int i = 0; i < numAnds; i++)
+    {
+        // a disjunction does not bound anything
+        if (orLens[i] != 1)
+            continue;
+
+        // att op literal, or literal op att which is att (flipped op) literal
+        int nAtt, litAtt;
+        CompOperator op;
+        if (!orList[i][0].GetAttOpLiteral(nAtt, litAtt, op) || nAtt != whichAtt)
+            continue;
+
+        // nothing is tighter than an equality
+        if (op == Equals)
+        {
+            lowAtt = litAtt;
+            highAtt = litAtt;
+            return 2;
+        }
+        else if (op == GreaterThan)
+            lowAtt = litAtt;
+        else
+            highAtt = litAtt;
+    }
+
+    return (lowAtt != -1) + (highAtt != -1);
+}
@@ -15,6 +15,10 @@ class Comparison {
 
 	friend class ComparisonEngine;
 	friend class CNF;
+	friend class ZoneMap;
+	friend class BloomFilterSet;
+	friend class Pax;
+	friend class DictionarySet;
 
 	Target operand1;
 	int whichAtt1;
@@ -34,6 +38,11 @@ public:
 
 	// print to the screen
 	void Print ();
+
+	// for a comparison of an attribute of the record with a literal, gives
+	// the attribute, the literal attribute and the operator as in
+	// "att op literal" (literal < att is att > literal); false otherwise
+	bool GetAttOpLiteral (int &whichAtt, int &litAtt, CompOperator &compOp);
 };
 
 
@@ -74,6 +83,10 @@ class Record;
 class CNF {
 
 	friend class ComparisonEngine;
+	friend class ZoneMap;
+	friend class BloomFilterSet;
+	friend class Pax;
+	friend class DictionarySet;
 
 	Comparison orList[MAX_ANDS][MAX_ORS];
 	
@@ -108,6 +121,13 @@ public:
         //returns common attributes of 2 OrderMakers in a 3rd OrderMaker
         //if no attributes match, it returns null
         OrderMaker* GetMatchingOrder(OrderMaker& file_order);
+
+        // looks for the comparisons of attribute "whichAtt" of the record
+        // with a literal that must hold (disjunctions of length one), and
+        // gives the position in the literal of a lower and of an upper bound
+        // on the attribute, -1 if there is none; an equality is both bounds.
+        // Returns the number of bounds found
+        int GetRangeBounds(int whichAtt, int &lowAtt, int &highAtt);
 };
 
 #endif
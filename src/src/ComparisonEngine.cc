@@ -1,6 +1,7 @@
 
 #include "ComparisonEngine.h"
 #include "Comparison.h"
+#include "RecordLayout.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -173,6 +174,31 @@ int ComparisonEngine :: Compare (Record *left, Record *literal, CNF *myCompariso
 }
 
 
+// the same, on a record in the compact format of "layout"
+int ComparisonEngine :: Compare (Record *left, Record *literal, CNF *myComparison, RecordLayout *layout) {
+
+	for (int i = 0; i < myComparison->numAnds; i++) {
+
+		for (int j = 0; j < myComparison->orLens[i]; j++) {
+
+			// this returns a 0 if the comparison did not eval to true
+			int result = Run(left, literal, &myComparison->orList[i][j], layout);
+			
+			if (result != 0) {
+				break;	
+			}
+			
+			// if we made it through all of the comparisons without a hit, return a 0
+			if (j == myComparison->orLens[i] - 1) {
+				return 0;
+			}
+		}
+	}
+
+	return 1;	
+}
+
+
 // this is just like the last one, except that it deals with a pair of records
 int ComparisonEngine :: Compare (Record *left, Record *right, Record *literal, CNF *myComparison) {
 
@@ -418,3 +444,70 @@ int ComparisonEngine :: Run (Record *left, Record *right, Record *literal, Compa
 }
 
 
+
+// This is an internal function used by the comparison engine; the values
+// of the compact record need not be aligned, and its strings have no NUL
+int ComparisonEngine :: Run (Record *left, Record *literal, Comparison *c, RecordLayout *layout) {
+
+	char *val1, *val2;
+	int len1, len2;
+
+	char *left_bits = left->GetBits();
+	char *lit_bits = literal->GetBits();
+
+	// first get a pointer to the first value to compare
+	if (c->operand1 == Left) {
+		val1 = layout->GetAtt(left_bits, c->whichAtt1, len1);
+	} else {
+		val1 = lit_bits + ((int *) lit_bits)[c->whichAtt1 + 1];
+		len1 = (c->attType == String) ? strlen (val1) : 0;
+	}
+
+	// next get a pointer to the second value to compare
+	if (c->operand2 == Left) {
+		val2 = layout->GetAtt(left_bits, c->whichAtt2, len2);
+	} else {
+		val2 = lit_bits + ((int *) lit_bits)[c->whichAtt2 + 1];
+		len2 = (c->attType == String) ? strlen (val2) : 0;
+	}
+
+	int val1Int, val2Int, tempResult;
+	double val1Double, val2Double;
+
+	// now check the type and the comparison operation
+	switch (c->attType) {
+
+		case Int:
+		memcpy (&val1Int, val1, sizeof (int));
+		memcpy (&val2Int, val2, sizeof (int));
+		tempResult = (val1Int < val2Int) ? -1 : (val1Int > val2Int);
+		break;
+
+		case Double:
+		memcpy (&val1Double, val1, sizeof (double));
+		memcpy (&val2Double, val2, sizeof (double));
+		if (c->op == Equals)
+			return (val1Double == val2Double);
+		tempResult = (val1Double < val2Double) ? -1 : (val1Double > val2Double);
+		break;
+
+		// as strcmp would on the strings with their NUL
+		default:
+		tempResult = memcmp (val1, val2, (len1 < len2) ? len1 : len2);
+		if (tempResult == 0)
+			tempResult = len1 - len2;
+		break;
+	}
+
+	switch (c->op) {
+
+		case LessThan:
+		return tempResult < 0;
+
+		case GreaterThan:
+		return tempResult > 0;
+
+		default:
+		return tempResult == 0;
+	}
+}
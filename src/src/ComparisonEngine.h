@@ -12,6 +12,7 @@ class Record;
 class Comparison;
 class OrderMaker;
 class CNF;
+class RecordLayout;
 
 class ComparisonEngine {
 
@@ -19,6 +20,7 @@ private:
 
 	int Run(Record *left, Record *literal, Comparison *c);
 	int Run(Record *left, Record *right, Record *literal, Comparison *c);
+	int Run(Record *left, Record *literal, Comparison *c, RecordLayout *layout);
 
 public:
 
@@ -46,6 +48,10 @@ public:
 	// like the last one, but for unary operations
 	int Compare(Record *left, Record *literal, CNF *myComparison);
 
+	// same, for a record stored in the compact format of a heap file
+	// (see RecordLayout); the literal is an ordinary record
+	int Compare(Record *left, Record *literal, CNF *myComparison, RecordLayout *layout);
+
 
 };
 
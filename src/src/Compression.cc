@@ -0,0 +1,194 @@
+#include <string.h>
+#include "Compression.h"
+
+// shortest match worth a sequence
+#define LZ_MIN_MATCH 4
+
+// the hash table of Pack has 2^LZ_HASH_BITS entries
+#define LZ_HASH_BITS 13
+
+// farthest a match can be, the offset takes 2 bytes
+#define LZ_MAX_OFFSET 65535
+
+static inline unsigned int ReadU32(const unsigned char *p)
+{
+	unsigned int v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline int HashU32(unsigned int v)
+{
+	return (v * 2654435761U) >> (32 - LZ_HASH_BITS);
+}
+
+// writes the part of a literal count or match length above 15
+static inline unsigned char* PutLength(unsigned char *op, int nLen)
+{
+	while (nLen >= 255)
+	{
+		*op++ = 255;
+		nLen -= 255;
+	}
+	*op++ = (unsigned char) nLen;
+	return op;
+}
+
+static unsigned char* PutSequence(unsigned char *op, const unsigned char *literals,
+								  int nLiterals, int nOffset, int nMatch)
+{
+	unsigned char *token = op++;
+	int nLitCode = (nLiterals >= 15) ? 15 : nLiterals;
+	if (nLiterals >= 15)
+		op = PutLength(op, nLiterals - 15);
+	memcpy(op, literals, nLiterals);
+	op += nLiterals;
+
+	// the last sequence has no match
+	if (nMatch == 0)
+	{
+		*token = (unsigned char) (nLitCode << 4);
+		return op;
+	}
+
+	*op++ = (unsigned char) (nOffset & 0xff);
+	*op++ = (unsigned char) (nOffset >> 8);
+	nMatch -= LZ_MIN_MATCH;
+	int nMatchCode = (nMatch >= 15) ? 15 : nMatch;
+	if (nMatch >= 15)
+		op = PutLength(op, nMatch - 15);
+	*token = (unsigned char) ((nLitCode << 4) | nMatchCode);
+	return op;
+}
+
+int LZCodec::MaxPackedSize(int n)
+{
+	// everything as literals: a token, and one count byte per 255 of them
+	return n + n / 255 + 16;
+}
+
+int LZCodec::Pack(const char *src, int n, char *dst)
+{
+	const unsigned char *base = (const unsigned char *) src;
+	const unsigned char *end = base + n;
+	const unsigned char *ip = base;
+	const unsigned char *anchor = base;		// first byte not packed yet
+	unsigned char *op = (unsigned char *) dst;
+
+	// position + 1 of the last 4 bytes with a given hash, 0 for none
+	int table[1 << LZ_HASH_BITS];
+	memset(table, 0, sizeof(table));
+
+	// a match starts at least LZ_MIN_MATCH bytes before the end
+	const unsigned char *lastStart = (n > LZ_MIN_MATCH) ? end - LZ_MIN_MATCH : base;
+	int nMisses = 0;
+	while (ip < lastStart)
+	{
+		unsigned int seq = ReadU32(ip);
+		int h = HashU32(seq);
+		int nCandidate = table[h] - 1;
+		table[h] = ip - base + 1;
+
+		// data that does not pack gets skipped faster and faster
+		if (nCandidate < 0 || (ip - base) - nCandidate > LZ_MAX_OFFSET ||
+			ReadU32(base + nCandidate) != seq)
+		{
+			nMisses++;
+			ip += 1 + (nMisses >> 5);
+			continue;
+		}
+		nMisses = 0;
+
+		const unsigned char *match = base + nCandidate;
+		while (ip > anchor && match > base && ip[-1] == match[-1])
+		{
+			ip--;
+			match--;
+		}
+
+		int nMatch = LZ_MIN_MATCH;
+		while (ip + nMatch + 4 <= end && ReadU32(ip + nMatch) == ReadU32(match + nMatch))
+			nMatch += 4;
+		while (ip + nMatch < end && ip[nMatch] == match[nMatch])
+			nMatch++;
+
+		op = PutSequence(op, anchor, ip - anchor, ip - match, nMatch);
+		ip += nMatch;
+		anchor = ip;
+
+		// so that the next match can start right after this one
+		if (ip - 2 > base && ip < lastStart)
+			table[HashU32(ReadU32(ip - 2))] = ip - 2 - base + 1;
+	}
+
+	op = PutSequence(op, anchor, end - anchor, 0, 0);
+	return op - (unsigned char *) dst;
+}
+
+int LZCodec::Unpack(const char *src, int nPacked, char *dst, int nMax)
+{
+	const unsigned char *ip = (const unsigned char *) src;
+	const unsigned char *ipEnd = ip + nPacked;
+	unsigned char *op = (unsigned char *) dst;
+	unsigned char *opEnd = op + nMax;
+
+	while (ip < ipEnd)
+	{
+		int token = *ip++;
+
+		int nLiterals = token >> 4;
+		if (nLiterals == 15)
+		{
+			int b;
+			do
+			{
+				if (ip >= ipEnd)
+					return -1;
+				b = *ip++;
+				nLiterals += b;
+			} while (b == 255);
+		}
+		if (nLiterals > ipEnd - ip || nLiterals > opEnd - op)
+			return -1;
+		memcpy(op, ip, nLiterals);
+		ip += nLiterals;
+		op += nLiterals;
+
+		// the last sequence
+		if (ip >= ipEnd)
+			break;
+
+		if (ipEnd - ip < 2)
+			return -1;
+		int nOffset = ip[0] | (ip[1] << 8);
+		ip += 2;
+
+		int nMatch = token & 15;
+		if (nMatch == 15)
+		{
+			int b;
+			do
+			{
+				if (ip >= ipEnd)
+					return -1;
+				b = *ip++;
+				nMatch += b;
+			} while (b == 255);
+		}
+		nMatch += LZ_MIN_MATCH;
+		if (nOffset == 0 || nOffset > op - (unsigned char *) dst || nMatch > opEnd - op)
+			return -1;
+
+		// a match closer than its length repeats itself, copy byte by byte
+		unsigned char *match = op - nOffset;
+		if (nOffset >= nMatch)
+			memcpy(op, match, nMatch);
+		else
+		{
+			for (int i = 0; i < nMatch; i++)
+				op[i] = match[i];
+		}
+		op += nMatch;
+	}
+	return op - (unsigned char *) dst;
+}
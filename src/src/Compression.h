@@ -0,0 +1,32 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include "Defs.h"
+
+// LZ77 codec in the spirit of LZ4, used by File for the pages of a
+// compressed file. It needs no dictionary and no state between pages.
+// The packed form is a list of sequences, each of them
+//   token: literal count (high 4 bits), match length - LZ_MIN_MATCH (low 4)
+//   more literal count bytes if the count is >= 15 (255 = one more follows)
+//   the literals
+//   2 bytes offset of the match, little endian, back from the current position
+//   more match length bytes if the length is >= 15 + LZ_MIN_MATCH
+// The last sequence has only literals (maybe none), and no offset.
+// A run of the same bytes is a match that overlaps itself, so RLE comes
+// for free
+class LZCodec
+{
+	public:
+		// the largest packed form of n bytes
+		static int MaxPackedSize(int n);
+
+		// packs the n bytes of src into dst, which must hold
+		// MaxPackedSize(n) bytes; returns the packed size
+		static int Pack(const char *src, int n, char *dst);
+
+		// unpacks the nPacked bytes of src into dst, which can hold nMax
+		// bytes; returns the unpacked size, -1 if src is not a packed form
+		static int Unpack(const char *src, int nPacked, char *dst, int nMax);
+};
+
+#endif
@@ -10,14 +10,21 @@ DBFile::~DBFile()
 }
 
 // name = location of the file
-// fType = heap, sorted, tree
+// fType = heap, sorted, tree, pax
 // return value: 1 on success, 0 on failure
-int DBFile::Create (char *name, fType myType, void *startup)
+int DBFile::Create (char *name, fType myType, void *startup, int pageSize, int compression)
 {
+    if(!File::IsValidPageSize(pageSize))
+        return RET_INVALID_PAGE_SIZE;
+
     if(myType == heap)
         m_pGenDBFile = new Heap();
     else if(myType == sorted)
         m_pGenDBFile = new Sorted();
+    else if(myType == tree)
+        m_pGenDBFile = new BTree();
+    else if(myType == pax)
+        m_pGenDBFile = new Pax();
     else
         return RET_UNSUPPORTED_FILE_TYPE;
 
@@ -26,12 +33,12 @@ int DBFile::Create (char *name, fType myType, void *startup)
         cout<<"Not enough memory. EXIT."<<endl;
         exit(1);
     }
-    return m_pGenDBFile->Create(name, startup);
+    return m_pGenDBFile->Create(name, startup, pageSize, compression);
 }
 
 // This function assumes that the DBFile already exists
 // and has previously been created and then closed.
-int DBFile::Open (char *name)
+int DBFile::Open (char *name, FileOpenMode mode)
 {
     //read metadata and create appropriate object
     if(!m_pGenDBFile)
@@ -65,9 +72,19 @@ int DBFile::Open (char *name)
                             m_pGenDBFile = new Sorted();
                             break;
                         }
+                        else if(line.compare("tree") == 0)
+                        {
+                            m_pGenDBFile = new BTree();
+                            break;
+                        }
+                        else if(line.compare("pax") == 0)
+                        {
+                            m_pGenDBFile = new Pax();
+                            break;
+                        }
 		}
     }
-    return m_pGenDBFile->Open(name);
+    return m_pGenDBFile->Open(name, mode);
 }
 
 // Closes the file.
@@ -128,3 +145,29 @@ int DBFile::GetNext (Record &fetchMe, CNF &applyMe, Record &literal)
         m_pGenDBFile->GetNext(fetchMe, applyMe, literal);
 }
 
+// Hint for the next GetNext(CNF)
+void DBFile::SetAccessPattern (AccessPattern pattern)
+{
+    if(!m_pGenDBFile)
+        cout<<"Attempted to set the access pattern of an unopened file (DEBUG)";
+    else
+        m_pGenDBFile->SetAccessPattern(pattern);
+}
+
+void DBFile::SetProjection (int *keepMe, int numAttsToKeep)
+{
+    if(!m_pGenDBFile)
+        cout<<"Attempted to set the projection of an unopened file (DEBUG)";
+    else
+        m_pGenDBFile->SetProjection(keepMe, numAttsToKeep);
+}
+
+int DBFile::GetPageSize ()
+{
+    if(!m_pGenDBFile)
+    {
+        cout<<"Attempted to get the page size of an unopened file (DEBUG)";
+        return PAGE_SIZE;
+    }
+    return m_pGenDBFile->GetPageSize();
+}
@@ -4,13 +4,16 @@
 #include "GenericDBFile.h"
 #include "Heap.h"
 #include "Sorted.h"
+#include "BTree.h"
+#include "Pax.h"
 
 // Enum for file types
 typedef enum
 {
 	heap,
 	sorted,
-	tree
+	tree,
+	pax
 } fType;
 
 class DBFile
@@ -23,20 +26,24 @@ public:
     ~DBFile();
 
     // name = location of the file
-    // fType = heap, sorted, tree
+    // fType = heap, sorted, tree, pax
+    // pageSize = page size of the file, a power of 2 between MIN_PAGE_SIZE and PAGE_SIZE
+    // compression = COMPRESS_NONE, or COMPRESS_LZ to keep the pages packed on disk
     // return value: 1 on success, 0 on failure
-    int Create (char *name, fType myType, void *startup);
+    int Create (char *name, fType myType, void *startup, int pageSize = PAGE_SIZE,
+                int compression = COMPRESS_NONE);
 
     // This function assumes that the DBFile already exists
     // and has previously been created and then closed.
-    int Open (char *name);
+    // mode = APPEND, or READ_ONLY for a memory mapped reader
+    int Open (char *name, FileOpenMode mode = APPEND);
 
     // Closes the file.
     // The return value is a 1 on success and a zero on failure
     int Close ();
 
-    // Bulk loads the DBFile instance from a text file,
-    // appending new data to it using the SuckNextRecord function from Record.h
+    // Bulk loads the DBFile instance from a text file, or an export file,
+    // appending new data to it with a BulkLoader (see BulkLoader.h)
     // loadMe is the name of the data file to bulk load.
     void Load (Schema &mySchema, char *loadMe);
 
@@ -53,6 +60,15 @@ public:
     // Applies CNF and then fetches the next record
     int GetNext (Record &fetchMe, CNF &applyMe, Record &literal);
 
+    // Hint for the next GetNext(CNF), see GenericDBFile::SetAccessPattern
+    void SetAccessPattern (AccessPattern pattern);
+
+    // Attributes the next scans need, see GenericDBFile::SetProjection
+    void SetProjection (int *keepMe, int numAttsToKeep);
+
+    // page size of the open file, in bytes; PAGE_SIZE if it is not open
+    int GetPageSize ();
+
 };
 
 #endif
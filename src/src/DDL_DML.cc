@@ -1,10 +1,19 @@
 #include "DDL_DML.h"
 #include <string.h>
+#include <unistd.h>
 
 using namespace std;
 
+Schema& DDL_DML::GetSchema(const char *sCatalog, const string &sTabName)
+{
+	delete m_pSchema;
+	m_pSchema = new Schema(const_cast<char*>(sCatalog), const_cast<char*>(sTabName.c_str()));
+	return *m_pSchema;
+}
+
 int DDL_DML::CreateTable(string sTabName, vector<Attribute> & col_atts_vec, 
-						  bool bSortedTable, vector<string> * pSortColAttsVec)
+						  fType eTableType, vector<string> * pSortColAttsVec, int nPageSize,
+						  int nCompression, int nRecordFormat)
 {
 	// assign values to member variable
 	int nNumAtts = col_atts_vec.size();
@@ -14,6 +23,14 @@ int DDL_DML::CreateTable(string sTabName, vector<Attribute> & col_atts_vec,
 	if (check_existing_table(sTabName))
 		return RET_TABLE_ALREADY_EXISTS;
 
+	// check before anything gets written in the catalog
+	if (!File::IsValidPageSize(nPageSize))
+		return RET_INVALID_PAGE_SIZE;
+
+	// only FileUtil knows of compact records
+	if (nRecordFormat != RECORD_FORMAT_V1 && eTableType != heap)
+		return RET_UNSUPPORTED_FILE_TYPE;
+
 	// Write this schema in the catalog file
 	FILE * out = fopen ("catalog", "a");
 	fprintf (out, "\nBEGIN\n%s\n%s.tbl", sTabName.c_str(), sTabName.c_str());
@@ -34,13 +51,13 @@ int DDL_DML::CreateTable(string sTabName, vector<Attribute> & col_atts_vec,
 	fclose(out);
 
 	// Fetch this schema into schema object
-	pSchema = new Schema("catalog", (char*)sTabName.c_str());
+	pSchema = &GetSchema("catalog", sTabName);
 	
 	// Make binary file path
 	string sBinOutput = sTabName + ".bin";
 
-	// Sorted file
-	if (bSortedTable)
+	// Sorted file, or B+-tree keyed on the sort columns
+	if (eTableType == sorted || eTableType == tree)
 	{
 		int nSortAtts = pSortColAttsVec->size();
         // Make an OrderMaker and store it
@@ -66,7 +83,8 @@ int DDL_DML::CreateTable(string sTabName, vector<Attribute> & col_atts_vec,
 		sort_info_struct.myOrder = pOrderMaker;
 		sort_info_struct.runLength = 50;
 
-		DbFileObj.Create((char*)sBinOutput.c_str(), sorted, (void*)&sort_info_struct);	
+		DbFileObj.Create((char*)sBinOutput.c_str(), eTableType, (void*)&sort_info_struct, nPageSize,
+						 nCompression);
 
 		// delete order maker now
 		delete pOrderMaker; 
@@ -74,16 +92,20 @@ int DDL_DML::CreateTable(string sTabName, vector<Attribute> & col_atts_vec,
 	}
 	else
 	{
-		// heap file
-		DbFileObj.Create((char*)sBinOutput.c_str(), heap, NULL);
+		// heap or PAX file
+		DbFileObj.Create((char*)sBinOutput.c_str(), eTableType, NULL, nPageSize, nCompression);
 	}
 	
 	// Close the DB file
 	DbFileObj.Close();
 
-	// delete schema object
-	delete pSchema;
-	pSchema = NULL;
+	// the heap file stores its records in the layout of the schema
+	if (nRecordFormat == RECORD_FORMAT_V2)
+	{
+		RecordLayout layout;
+		layout.SetTypes(*pSchema);
+		layout.Write(sBinOutput);
+	}
 
 	cout << "\nTable " << sTabName.c_str() << " has been created successfully!\n";
 	return RET_SUCCESS;
@@ -105,12 +127,13 @@ int DDL_DML::LoadTable(string sTabName, string sFileName)
 		return RET_COULDNT_OPEN_FILE_TO_LOAD;
 
 	//Fetch schema and load the file
-	Schema file_schema("catalog", (char*)sTabName.c_str());
+	Schema &file_schema = GetSchema("catalog", sTabName);
 	DbFileObj.Load(file_schema, (char*)sRawFile.c_str());
 	DbFileObj.Close();
 
 	cout << "\nTable " << sTabName.c_str() << " has been loaded and  " 
 		 << sBinFile.c_str() << " has been created successfully!\n";
+	BulkLoader::PrintStats(cout);
 	return RET_SUCCESS;
 }
 
@@ -178,9 +201,21 @@ int DDL_DML::DropTable(string sTabName)
 	}
 	output_file.close();
 
-	// delete the binary file
+	// delete the binary file, and its indexes
 	string sBinFile = sTabName + ".bin";
 	remove(sBinFile.c_str());
+
+	vector<int> vIndexAtts;
+	vector<Type> vIndexTypes;
+	IndexSet::GetIndexList(sBinFile, vIndexAtts, vIndexTypes);
+	IndexSet::Remove(sBinFile, vIndexAtts);
+	remove(BloomFilterSet::GetBloomPath(sBinFile).c_str());
+	remove(DictionarySet::GetDictPath(sBinFile).c_str());
+
+	vector<string> vDeltaRuns;
+	DeltaRuns::GetRunList(sBinFile, vDeltaRuns);
+	for (int i = 0; i < vDeltaRuns.size(); i++)
+		remove(vDeltaRuns[i].c_str());
 	
 	// delete meta.data file
 	sBinFile = sBinFile + ".meta.data";
@@ -190,6 +225,328 @@ int DDL_DML::DropTable(string sTabName)
 	return RET_SUCCESS;
 }
 
+int DDL_DML::CreateIndex(string sTabName, string sColName)
+{
+	if (!check_existing_table(sTabName))
+		return RET_TABLE_NOT_IN_DATABASE;
+
+	Schema &file_schema = GetSchema("catalog", sTabName);
+	int nAtt = file_schema.Find((char*)sColName.c_str());
+	if (nAtt == -1)
+		return RET_INDEX_COLUMN_NOT_FOUND;
+
+	string sBinFile = sTabName + ".bin";
+	string sMetaFile = sBinFile + ".meta.data";
+
+	// only heap and sorted files keep their record ids
+	// until they are rewritten, B+-tree nodes get split
+	ifstream meta_in;
+	meta_in.open(sMetaFile.c_str());
+	string sFileType;
+	meta_in >> sFileType;
+	meta_in.close();
+	if (sFileType.compare("heap") != 0 && sFileType.compare("sorted") != 0)
+		return RET_UNSUPPORTED_FILE_TYPE;
+
+	vector<int> vIndexAtts;
+	vector<Type> vIndexTypes;
+	IndexSet::GetIndexList(sBinFile, vIndexAtts, vIndexTypes);
+	for (int i = 0; i < vIndexAtts.size(); i++)
+		if (vIndexAtts[i] == nAtt)
+			return RET_INDEX_ALREADY_EXISTS;
+
+	// index the records already in the table
+	Type eType = file_schema.FindType((char*)sColName.c_str());
+	HashIndex index;
+	index.Create(sBinFile, nAtt, eType);
+	index.Build(sBinFile);
+	int nEntries = index.GetNumEntries();
+	index.Close();
+
+	// from now on the table keeps it up to date
+	ofstream meta_out;
+	meta_out.open(sMetaFile.c_str(), ios::app);
+	meta_out << "\nindex " << nAtt << " " << TypeToString(eType) << "\n";
+	meta_out.close();
+
+	cout << "\nIndex on " << sTabName.c_str() << "(" << sColName.c_str() << ") has been created with "
+		 << nEntries << " entries!\n";
+	return RET_SUCCESS;
+}
+
+int DDL_DML::CreateBloomFilter(string sTabName, string sColName, double dFpRate)
+{
+	if (!check_existing_table(sTabName))
+		return RET_TABLE_NOT_IN_DATABASE;
+
+	if (dFpRate <= 0 || dFpRate >= 1)
+		return RET_INVALID_FP_RATE;
+
+	Schema &file_schema = GetSchema("catalog", sTabName);
+	int nAtt = file_schema.Find((char*)sColName.c_str());
+	if (nAtt == -1)
+		return RET_INDEX_COLUMN_NOT_FOUND;
+
+	string sBinFile = sTabName + ".bin";
+	string sMetaFile = sBinFile + ".meta.data";
+
+	// the filters are per page of a heap, the other
+	// file types move their records to other pages
+	ifstream meta_in;
+	meta_in.open(sMetaFile.c_str());
+	string sFileType;
+	meta_in >> sFileType;
+	meta_in.close();
+	if (sFileType.compare("heap") != 0)
+		return RET_UNSUPPORTED_FILE_TYPE;
+
+	vector<int> vBloomAtts;
+	vector<Type> vBloomTypes;
+	vector<double> vFpRates;
+	BloomFilterSet::GetBloomList(sBinFile, vBloomAtts, vBloomTypes, vFpRates);
+	for (int i = 0; i < vBloomAtts.size(); i++)
+		if (vBloomAtts[i] == nAtt)
+			return RET_BLOOM_ALREADY_EXISTS;
+
+	// from now on the table keeps it up to date
+	Type eType = file_schema.FindType((char*)sColName.c_str());
+	ofstream meta_out;
+	meta_out.open(sMetaFile.c_str(), ios::app);
+	meta_out << "\nbloom " << nAtt << " " << TypeToString(eType) << " " << dFpRate << "\n";
+	meta_out.close();
+
+	// filter the pages already in the table, the other filters as well
+	BloomFilterSet blooms(NULL);
+	blooms.Open(sBinFile);
+	blooms.Rebuild();
+	blooms.Close();
+
+	cout << "\nBloom filter on " << sTabName.c_str() << "(" << sColName.c_str()
+		 << ") has been created with a false positive rate of " << dFpRate << "!\n";
+	return RET_SUCCESS;
+}
+
+int DDL_DML::CreateDictionary(string sTabName, string sColName)
+{
+	if (!check_existing_table(sTabName))
+		return RET_TABLE_NOT_IN_DATABASE;
+
+	Schema &file_schema = GetSchema("catalog", sTabName);
+	int nAtt = file_schema.Find((char*)sColName.c_str());
+	if (nAtt == -1)
+		return RET_INDEX_COLUMN_NOT_FOUND;
+	if (file_schema.FindType((char*)sColName.c_str()) != String)
+		return RET_DICT_COLUMN_NOT_STRING;
+
+	string sBinFile = sTabName + ".bin";
+	string sMetaFile = sBinFile + ".meta.data";
+
+	// FileUtil does the coding, the other file types have their own
+	ifstream meta_in;
+	meta_in.open(sMetaFile.c_str());
+	string sFileType;
+	meta_in >> sFileType;
+	meta_in.close();
+	if (sFileType.compare("heap") != 0)
+		return RET_UNSUPPORTED_FILE_TYPE;
+
+	// the codes are in the layout of Record, a record has one or the other
+	RecordLayout layout;
+	layout.Open(sBinFile);
+	if (!layout.IsEmpty())
+		return RET_DICT_COMPACT_TABLE;
+
+	vector<int> vDictAtts;
+	DictionarySet::GetDictList(sBinFile, vDictAtts);
+	for (int i = 0; i < vDictAtts.size(); i++)
+		if (vDictAtts[i] == nAtt)
+			return RET_DICT_ALREADY_EXISTS;
+
+	// the dictionaries the table has, and the new one, which gets the
+	// values already in the table
+	DictionarySet oldDicts, newDicts;
+	oldDicts.Open(sBinFile);
+	newDicts.Open(sBinFile);
+	newDicts.SetTypes(file_schema);
+	newDicts.AddDictionary(nAtt);
+
+	FileUtil in;
+	in.SetDictionaries(oldDicts.IsEmpty() ? NULL : &oldDicts);
+	if (in.Open((char*)sBinFile.c_str(), READ_ONLY) != RET_SUCCESS)
+		return RET_FILE_NOT_FOUND;
+	Record rec;
+	while (in.GetNext(rec))
+		newDicts.Learn(rec);
+	vector< vector<int> > vRemaps;
+	newDicts.Merge(vRemaps);
+
+	// the records take less room with the codes, so they are all
+	// written again, to other pages
+	string sTmpFile = sBinFile + ".tmp";
+	FileUtil out;
+	out.Create((char*)sTmpFile.c_str(), in.GetPageSize(), in.GetCompression());
+	out.SetDictionaries(&newDicts);
+	in.MoveFirst();
+	int nRecs = 0;
+	while (in.GetNext(rec))
+	{
+		out.Add(rec);
+		nRecs++;
+	}
+	out.Close();
+	in.Close();
+	rename(sTmpFile.c_str(), sBinFile.c_str());
+	newDicts.Close();
+
+	// from now on the table keeps it up to date
+	ofstream meta_out;
+	meta_out.open(sMetaFile.c_str(), ios::app);
+	meta_out << "\ndict " << nAtt << "\n";
+	meta_out.close();
+
+	// the indexes, the Bloom filters and the zone maps
+	// point at the pages the records were on
+	vector<int> vIndexAtts;
+	vector<Type> vIndexTypes;
+	IndexSet::GetIndexList(sBinFile, vIndexAtts, vIndexTypes);
+	for (int i = 0; i < vIndexAtts.size(); i++)
+	{
+		HashIndex index;
+		index.Create(sBinFile, vIndexAtts[i], vIndexTypes[i]);
+		index.Build(sBinFile);
+		index.Close();
+	}
+
+	BloomFilterSet blooms(NULL);
+	blooms.Open(sBinFile);
+	blooms.Rebuild();
+	blooms.Close();
+
+	ZoneMap zoneMap;
+	zoneMap.Read(sMetaFile);
+	zoneMap.Build(sBinFile);
+	zoneMap.Write(sMetaFile);
+
+	cout << "\nDictionary on " << sTabName.c_str() << "(" << sColName.c_str() << ") has been created, "
+		 << nRecs << " records are encoded!\n";
+	return RET_SUCCESS;
+}
+
+int DDL_DML::ExportTable(string sTabName, string sFileName)
+{
+	if (!check_existing_table(sTabName))
+		return RET_TABLE_NOT_IN_DATABASE;
+
+	Schema &file_schema = GetSchema("catalog", sTabName);
+	string sBinFile = sTabName + ".bin";
+	string sMetaFile = sBinFile + ".meta.data";
+
+	ifstream meta_in;
+	meta_in.open(sMetaFile.c_str());
+	string sFileType;
+	meta_in >> sFileType;
+	meta_in.close();
+
+	// the pages of a heap that stores its records as they are,
+	// are those of the export file; the others are read record by record
+	bool bWholePages = false;
+	int nPageSize = PAGE_SIZE;
+	FileUtil heapFile;
+	if (sFileType.compare("heap") == 0)
+	{
+		if (heapFile.Open((char*)sBinFile.c_str(), READ_ONLY) != RET_SUCCESS)
+			return RET_FILE_NOT_FOUND;
+		nPageSize = heapFile.GetPageSize();
+
+		vector<int> vDictAtts;
+		DictionarySet::GetDictList(sBinFile, vDictAtts);
+		RecordLayout layout;
+		layout.Open(sBinFile);
+		bWholePages = vDictAtts.empty() && layout.IsEmpty();
+	}
+
+	ExportFile out;
+	if (!out.Create(sFileName.c_str(), file_schema, nPageSize))
+		return RET_COULDNT_WRITE_EXPORT_FILE;
+
+	bool bWritten = true;
+	if (bWholePages)
+	{
+		Page page;
+		int nPages = max(heapFile.GetFileLength() - 1, 0);
+		for (int i = 0; i < nPages && bWritten; i++)
+		{
+			heapFile.GetPage(&page, i, nPages - 1);
+			bWritten = out.AddPage(page);
+		}
+		heapFile.Close();
+	}
+	else
+	{
+		if (sFileType.compare("heap") == 0)
+			heapFile.Close();
+		DBFile DbFileObj;
+		if (DbFileObj.Open((char*)sBinFile.c_str()) == 0)
+			return RET_FILE_NOT_FOUND;
+		DbFileObj.MoveFirst();
+		Record rec;
+		while (bWritten && DbFileObj.GetNext(rec))
+			bWritten = out.Add(rec);
+		DbFileObj.Close();
+	}
+	long nRecords = out.GetNumRecords();
+	long nPages = out.GetNumPages();
+	if (!out.Close() || !bWritten)
+		return RET_COULDNT_WRITE_EXPORT_FILE;
+
+	cout << "\nTable " << sTabName.c_str() << " has been exported to " << sFileName.c_str() << ", "
+		 << nRecords << " records in " << nPages << " pages!\n";
+	return RET_SUCCESS;
+}
+
+int DDL_DML::ImportTable(string sTabName, string sFileName)
+{
+	if (!check_existing_table(sTabName))
+		return RET_TABLE_NOT_IN_DATABASE;
+
+	ExportFile in;
+	if (!in.Open(sFileName.c_str()))
+		return RET_COULDNT_OPEN_FILE_TO_LOAD;
+	Schema &file_schema = GetSchema("catalog", sTabName);
+	bool bSameTypes = in.HasTypesOf(file_schema);
+	in.Close();
+	if (!bSameTypes)
+		return RET_IMPORT_SCHEMA_MISMATCH;
+
+	// the BulkLoader takes its pages as they are
+	return LoadTable(sTabName, sFileName);
+}
+
+int DDL_DML::CreateTableAsSelect(string sTabName, string sFileName)
+{
+	ExportFile in;
+	if (!in.Open(sFileName.c_str()))
+		return RET_COULDNT_OPEN_FILE_TO_LOAD;
+	vector<string> vNames;
+	vector<Type> vTypes;
+	in.GetAtts(vNames, vTypes);
+	in.Close();
+
+	vector<Attribute> col_atts_vec;
+	for (int i = 0; i < vNames.size(); i++)
+	{
+		Attribute att;
+		att.name = (char*)vNames[i].c_str();
+		att.myType = vTypes[i];
+		col_atts_vec.push_back(att);
+	}
+
+	int ret = CreateTable(sTabName, col_atts_vec);
+	if (ret == RET_SUCCESS)
+		ret = LoadTable(sTabName, sFileName);
+	remove(sFileName.c_str());
+	return ret;
+}
 
 bool DDL_DML::check_existing_table(string sTabName)
 {
@@ -1,7 +1,7 @@
 /* 
 
 Name: DDL_DML.h
-Purpose: Create table, load data into table, drop table
+Purpose: Create table, load data into table, drop table, export and import tables
 
 */
 
@@ -14,17 +14,42 @@ Purpose: Create table, load data into table, drop table
 #include <fstream>
 #include <vector>
 #include "DBFile.h"
+#include "BloomFilter.h"
+#include "Dictionary.h"
+#include "RecordLayout.h"
+#include "BulkLoader.h"
+#include "ExportFile.h"
 
 class DDL_DML
 {
-	bool check_existing_table(string sTabName);
+private:
+	Schema *m_pSchema;		// see GetSchema
+
+	// the schema of the table, read from the catalog file sCatalog; it is
+	// kept until the next call, or until the object goes away
+	Schema& GetSchema(const char *sCatalog, const string &sTabName);
+
 public:
-	DDL_DML() {}
-	~DDL_DML() {}
+	DDL_DML() : m_pSchema(NULL) {}
+	~DDL_DML() { delete m_pSchema; }
+	bool check_existing_table(string sTabName);
 	int CreateTable(string sTabName, vector<Attribute> & col_atts_vec, 
-					 bool sorted_table = false, vector<string> * sort_col_vec = NULL);
+					 fType table_type = heap, vector<string> * sort_col_vec = NULL,
+					 int nPageSize = PAGE_SIZE, int nCompression = COMPRESS_NONE,
+					 int nRecordFormat = RECORD_FORMAT_V1);
 	int LoadTable(string sTabName, string sFileName);
 	int DropTable(string sTabName);
+	int CreateIndex(string sTabName, string sColName);
+	int CreateBloomFilter(string sTabName, string sColName, double dFpRate = BLOOM_FP_RATE);
+	int CreateDictionary(string sTabName, string sColName);
+
+	// writes the records of the table in an export file (see ExportFile)
+	int ExportTable(string sTabName, string sFileName);
+	// appends the records of an export file to the table
+	int ImportTable(string sTabName, string sFileName);
+	// a heap table of the attributes and the records of an export
+	// file, written by a query (see Node_WriteOut), which is removed
+	int CreateTableAsSelect(string sTabName, string sFileName);
 };
 
 #endif
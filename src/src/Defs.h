@@ -5,7 +5,70 @@
 #define MAX_ANDS 20
 #define MAX_ORS 20
 
+// default, and largest, page size; every file can have its own page size,
+// a power of 2 between MIN_PAGE_SIZE and PAGE_SIZE, stored in its header
 #define PAGE_SIZE 131072
+#define MIN_PAGE_SIZE 4096
+
+// size of the process-wide BufferPool, in PAGE_SIZE pages; its frames
+// are as big as the pages they hold, so it holds more of smaller pages
+#define BUFFER_POOL_FRAMES 256
+
+// every file starts with a small header (see File), followed by the data
+// pages; see File::PageOffset
+#define FILE_HEADER_SIZE 4096
+
+// I/O granularity: frames and headers are aligned on this, as O_DIRECT needs
+#define IO_ALIGNMENT 4096
+
+// at most this many adjacent dirty pages are written with a single pwritev
+#define MAX_WRITE_CLUSTER 32
+
+// files grow in steps of this many pages, reserved with fallocate
+#define FILE_GROW_PAGES 16
+
+// uncomment to open files with O_DIRECT, bypassing the OS page cache;
+// the BufferPool then is the only cache
+// #define USE_O_DIRECT
+
+// a compressed file (see File) keeps each page in its packed size; a
+// page is packed only if that saves at least this many bytes
+#define MIN_COMPRESSION_GAIN 64
+
+// default number of pages a sequential scan keeps in flight ahead of
+// the reader (see ReadAhead); 0 turns read-ahead off
+#define READ_AHEAD_PAGES 4
+
+// the bulk loader (see BulkLoader) cuts the text file in blocks of about
+// this many bytes, parsed by at most LOAD_MAX_THREADS threads, the loading
+// one included
+#define LOAD_BLOCK_BYTES 4194304
+#define LOAD_MAX_THREADS 8
+
+// an export file (see ExportFile) starts with this, and the version of
+// its format
+#define EXPORT_MAGIC "DBEXPORT"
+#define EXPORT_VERSION 1
+
+// a sorted file (see Sorted, DeltaRuns) keeps the records added to it in
+// sorted delta runs; a run takes in the newer one while it is not this
+// many times as large, and the runs are merged into the file once they
+// hold 1 / DELTA_SIZE_RATIO of its records or there are more than
+// DELTA_MAX_RUNS of them
+#define DELTA_SIZE_RATIO 4
+#define DELTA_MAX_RUNS 8
+
+// a BigQ sorts its runs on at most SORT_MAX_THREADS threads, the one
+// reading its input included, and writes them on another one
+#define SORT_MAX_THREADS 8
+
+// the least memory a BigQ works with, in pages: its merges read two runs
+// and write a third one. A smaller runlen is raised to it
+#define SORT_MIN_PAGES 3
+
+// the run stats of the last SORT_STATS_KEPT BigQs are kept for
+// BigQ::PrintRunStats
+#define SORT_STATS_KEPT 16
 
 // Error codes
 #define RET_FAILURE 0
@@ -20,6 +83,16 @@
 #define RET_COULDNT_OPEN_FILE_TO_LOAD 7
 #define RET_COULDNT_OPEN_CATALOG_FILE 8
 #define RET_TABLE_NOT_IN_DATABASE 9
+#define RET_INVALID_PAGE_SIZE 10
+#define RET_INDEX_COLUMN_NOT_FOUND 11
+#define RET_INDEX_ALREADY_EXISTS 12
+#define RET_BLOOM_ALREADY_EXISTS 13
+#define RET_INVALID_FP_RATE 14
+#define RET_DICT_ALREADY_EXISTS 15
+#define RET_DICT_COLUMN_NOT_STRING 16
+#define RET_DICT_COMPACT_TABLE 17
+#define RET_IMPORT_SCHEMA_MISMATCH 18
+#define RET_COULDNT_WRITE_EXPORT_FILE 19
 
 
 enum Target {Left, Right, Literal};
@@ -27,7 +100,19 @@ enum CompOperator {LessThan, GreaterThan, Equals};
 enum Type {Int, Double, String};
 
 // Enum for file opening modes
-enum FileOpenMode { TRUNCATE = 0, APPEND = 1};
+// READ_ONLY files are memory mapped and can not be written to
+enum FileOpenMode { TRUNCATE = 0, APPEND = 1, READ_ONLY = 2};
+
+// How the pages of a file are stored, chosen when it is created:
+// as they are, or packed with LZCodec (see Compression.h)
+enum PageCompression { COMPRESS_NONE = 0, COMPRESS_LZ = 1 };
+
+// How the records of a heap file are stored, chosen when it is created:
+// in the layout of Record, or in the compact one of RecordLayout
+enum RecordFormat { RECORD_FORMAT_V1 = 1, RECORD_FORMAT_V2 = 2 };
+
+// Hint on how the pages of a (read only) file are going to be accessed
+enum AccessPattern { SEQUENTIAL_ACCESS, RANDOM_ACCESS };
 
 
 unsigned int Random_Generate();
@@ -0,0 +1,274 @@
+#include <stdio.h>
+#include <fstream>
+#include <sstream>
+#include "DeltaRuns.h"
+
+static string GetRunPath(const string &binPath, int nId)
+{
+	stringstream ss;
+	ss << binPath << ".delta" << nId;
+	return ss.str();
+}
+
+DeltaRuns::DeltaRuns() : m_sBinPath(), m_pOrder(NULL), m_nPageSize(PAGE_SIZE),
+	m_nCompression(COMPRESS_NONE), m_vRuns(), m_nNextId(0), m_nBaseRecords(0)
+{}
+
+DeltaRuns::~DeltaRuns()
+{
+	Clear();
+}
+
+void DeltaRuns::SetFile(const string &binPath, OrderMaker *pOrder, int nPageSize, int nCompression)
+{
+	m_sBinPath = binPath;
+	m_pOrder = pOrder;
+	m_nPageSize = nPageSize;
+	m_nCompression = nCompression;
+}
+
+void DeltaRuns::Clear()
+{
+	for (int i = 0; i < m_vRuns.size(); i++)
+	{
+		if (m_vRuns[i].pFile)
+		{
+			m_vRuns[i].pFile->Close();
+			delete m_vRuns[i].pFile;
+		}
+	}
+	m_vRuns.clear();
+	m_nNextId = 0;
+	m_nBaseRecords = 0;
+}
+
+void DeltaRuns::Read(const string &metaPath)
+{
+	Clear();
+
+	ifstream meta_in;
+	meta_in.open(metaPath.c_str());
+	string line;
+	while (getline(meta_in, line))
+	{
+		istringstream ss(line);
+		string word;
+		ss >> word;
+		if (word.compare("deltaruns") == 0)
+			ss >> m_nNextId >> m_nBaseRecords;
+		else if (word.compare("deltarun") == 0)
+		{
+			DeltaRun run;
+			run.nId = -1;
+			run.nRecords = 0;
+			run.pFile = NULL;
+			ss >> run.nId >> run.nRecords;
+			if (ss && run.nId >= 0)
+				m_vRuns.push_back(run);
+		}
+	}
+}
+
+void DeltaRuns::Write(const string &metaPath)
+{
+	// keep everything but the runs
+	vector<string> vLines;
+	ifstream meta_in;
+	meta_in.open(metaPath.c_str());
+	string line;
+	while (getline(meta_in, line))
+	{
+		if (line.compare(0, 9, "deltarun ") != 0 && line.compare(0, 10, "deltaruns ") != 0)
+			vLines.push_back(line);
+	}
+	meta_in.close();
+
+	ofstream meta_out;
+	meta_out.open(metaPath.c_str(), ios::trunc);
+	for (int i = 0; i < vLines.size(); i++)
+		meta_out << vLines[i] << "\n";
+	meta_out << "deltaruns " << m_nNextId << " " << m_nBaseRecords << "\n";
+	for (int i = 0; i < m_vRuns.size(); i++)
+		meta_out << "deltarun " << m_vRuns[i].nId << " " << m_vRuns[i].nRecords << "\n";
+	meta_out.close();
+}
+
+long DeltaRuns::GetRecords()
+{
+	long nRecords = 0;
+	for (int i = 0; i < m_vRuns.size(); i++)
+		nRecords += m_vRuns[i].nRecords;
+	return nRecords;
+}
+
+string DeltaRuns::GetPath(int nRun)
+{
+	return GetRunPath(m_sBinPath, m_vRuns[nRun].nId);
+}
+
+void DeltaRuns::RemoveRun(DeltaRun &run)
+{
+	if (run.pFile)
+	{
+		run.pFile->Close();
+		delete run.pFile;
+		run.pFile = NULL;
+	}
+	if (remove(GetRunPath(m_sBinPath, run.nId).c_str()) != 0)
+		perror("error in removing delta run");
+}
+
+DeltaRun DeltaRuns::MergeRuns(vector<FileUtil*> &vIn)
+{
+	DeltaRun run;
+	run.nId = m_nNextId++;
+	run.pFile = NULL;
+
+	FileUtil out;
+	string sPath = GetRunPath(m_sBinPath, run.nId);
+	out.Create(const_cast<char*>(sPath.c_str()), m_nPageSize, m_nCompression);
+	run.nRecords = Merge(vIn, *m_pOrder, out, NULL);
+	out.Close();
+	return run;
+}
+
+void DeltaRuns::AddRun(Pipe &in, int nFrozen)
+{
+	DeltaRun run;
+	run.nId = m_nNextId++;
+	run.nRecords = 0;
+	run.pFile = NULL;
+
+	FileUtil out;
+	string sPath = GetRunPath(m_sBinPath, run.nId);
+	out.Create(const_cast<char*>(sPath.c_str()), m_nPageSize, m_nCompression);
+	Record rec;
+	while (in.Remove(&rec))
+	{
+		out.Add(rec);
+		run.nRecords++;
+	}
+	out.Close();
+
+	if (run.nRecords == 0)
+	{
+		remove(sPath.c_str());
+		return;
+	}
+	m_vRuns.push_back(run);
+
+	// a run that is not DELTA_SIZE_RATIO times as large as the newer one
+	// takes it in, the older one first so that equal keys keep their order
+	while (m_vRuns.size() >= nFrozen + 2)
+	{
+		DeltaRun &older = m_vRuns[m_vRuns.size() - 2];
+		DeltaRun &newer = m_vRuns[m_vRuns.size() - 1];
+		if (older.nRecords >= DELTA_SIZE_RATIO * newer.nRecords)
+			break;
+
+		vector<FileUtil*> vIn;
+		vIn.push_back(GetRun(m_vRuns.size() - 2));
+		vIn.push_back(GetRun(m_vRuns.size() - 1));
+		DeltaRun merged = MergeRuns(vIn);
+
+		RemoveRun(m_vRuns[m_vRuns.size() - 1]);
+		RemoveRun(m_vRuns[m_vRuns.size() - 2]);
+		m_vRuns.pop_back();
+		m_vRuns.back() = merged;
+	}
+}
+
+void DeltaRuns::DropOldest(int nRuns)
+{
+	for (int i = 0; i < nRuns && i < m_vRuns.size(); i++)
+		RemoveRun(m_vRuns[i]);
+	m_vRuns.erase(m_vRuns.begin(), m_vRuns.begin() + min(nRuns, (int) m_vRuns.size()));
+}
+
+FileUtil* DeltaRuns::GetRun(int nRun)
+{
+	DeltaRun &run = m_vRuns[nRun];
+	if (run.pFile == NULL)
+	{
+		string sPath = GetRunPath(m_sBinPath, run.nId);
+		run.pFile = new FileUtil();
+		if (run.pFile->Open(const_cast<char*>(sPath.c_str()), READ_ONLY) != RET_SUCCESS)
+		{
+			cerr << "BAD: the delta run " << sPath << " can not be opened\n";
+			exit(1);
+		}
+		run.pFile->MoveFirst();
+	}
+	return run.pFile;
+}
+
+void DeltaRuns::MoveFirst()
+{
+	for (int i = 0; i < m_vRuns.size(); i++)
+	{
+		if (m_vRuns[i].pFile)
+			m_vRuns[i].pFile->MoveFirst();
+	}
+}
+
+bool DeltaRuns::NeedCompaction()
+{
+	return m_vRuns.size() > DELTA_MAX_RUNS || GetRecords() * DELTA_SIZE_RATIO >= m_nBaseRecords;
+}
+
+long DeltaRuns::Merge(vector<FileUtil*> &vIn, OrderMaker &order, FileUtil &out, FenceIndex *pFences,
+					  IndexSet *pIndexes, ZoneMap *pZones)
+{
+	ComparisonEngine ce;
+	vector<Record*> vHeads(vIn.size(), (Record*) NULL);
+	for (int i = 0; i < vIn.size(); i++)
+	{
+		vIn[i]->MoveFirst();
+		vHeads[i] = new Record();
+		if (!vIn[i]->GetNext(*vHeads[i]))
+		{
+			delete vHeads[i];
+			vHeads[i] = NULL;
+		}
+	}
+
+	// the first of the smallest records, so that equal keys keep the
+	// order of the files
+	long nRecords = 0;
+	while (true)
+	{
+		int nMin = -1;
+		for (int i = 0; i < vHeads.size(); i++)
+		{
+			if (vHeads[i] && (nMin == -1 || ce.Compare(vHeads[i], vHeads[nMin], &order) < 0))
+				nMin = i;
+		}
+		if (nMin == -1)
+			break;
+
+		out.Add(*vHeads[nMin]);
+		if (pFences)
+			pFences->AddLast(out);
+		if (pIndexes)
+			pIndexes->InsertLast();
+		if (pZones)
+			pZones->AddLast(out);
+		nRecords++;
+
+		if (!vIn[nMin]->GetNext(*vHeads[nMin]))
+		{
+			delete vHeads[nMin];
+			vHeads[nMin] = NULL;
+		}
+	}
+	return nRecords;
+}
+
+void DeltaRuns::GetRunList(const string &binPath, vector<string> &vPaths)
+{
+	DeltaRuns runs;
+	runs.SetFile(binPath, NULL, PAGE_SIZE, COMPRESS_NONE);
+	runs.Read(binPath + ".meta.data");
+	for (int i = 0; i < runs.GetCount(); i++)
+		vPaths.push_back(runs.GetPath(i));
+}
@@ -0,0 +1,104 @@
+#ifndef DELTA_RUNS_H
+#define DELTA_RUNS_H
+
+#include <string>
+#include <vector>
+#include "Defs.h"
+#include "Record.h"
+#include "Comparison.h"
+#include "FileUtil.h"
+#include "FenceIndex.h"
+#include "HashIndex.h"
+#include "ZoneMap.h"
+#include "Pipe.h"
+
+using namespace std;
+
+// one sorted run of records, in a file of its own
+struct DeltaRun
+{
+	int nId;			// the file is <table>.bin.delta<nId>
+	long nRecords;
+	FileUtil *pFile;	// open while it is read, NULL otherwise
+};
+
+// Records added to a sorted file since they were last merged into it.
+// Every batch of records the BigQ sorts goes into a run of its own, the
+// newest last; a run is merged with the one before it as long as that one
+// is less than DELTA_SIZE_RATIO times as large, so that the runs get
+// larger going back in time and there are only a few of them. Adding a
+// batch costs about as much as the batch, the sorted file reads the runs
+// along with itself and merges them into itself once they hold a large
+// enough part of its records (see Sorted). The runs are kept in the
+// .meta.data file of the table, as a line
+//   deltaruns <id of the next run> <records of the file itself>
+// followed by one line per run, the oldest first
+//   deltarun <id> <records>
+class DeltaRuns
+{
+	private:
+		string m_sBinPath;
+		OrderMaker *m_pOrder;
+		int m_nPageSize;
+		int m_nCompression;
+		vector<DeltaRun> m_vRuns;
+		int m_nNextId;
+		long m_nBaseRecords;	// of the sorted file, 0 if not known
+
+		// a new run, with the records of the files merged in sort order;
+		// the files are the caller's
+		DeltaRun MergeRuns(vector<FileUtil*> &vIn);
+
+		// deletes the file of the run
+		void RemoveRun(DeltaRun &run);
+
+	public:
+		DeltaRuns();
+		~DeltaRuns();
+
+		// the sorted file the runs are of, and how its pages are written
+		void SetFile(const string &binPath, OrderMaker *pOrder, int nPageSize, int nCompression);
+
+		// forgets about every run, without deleting their files
+		void Clear();
+
+		// reads the runs from, or writes them to, the .meta.data file
+		// metaPath; Write keeps the other lines of the file as they are
+		void Read(const string &metaPath);
+		void Write(const string &metaPath);
+
+		int GetCount() { return m_vRuns.size(); }
+		long GetRecords();
+		long GetBaseRecords() { return m_nBaseRecords; }
+		void SetBaseRecords(long nRecords) { m_nBaseRecords = nRecords; }
+		string GetPath(int nRun);
+
+		// the sorted records of the pipe, up to its shutdown, in a new run;
+		// then merges the newest runs by the size ratio, all but the
+		// nFrozen oldest ones, which a compaction is reading
+		void AddRun(Pipe &in, int nFrozen);
+
+		// closes and deletes the nRuns oldest runs, after they went into
+		// the sorted file
+		void DropOldest(int nRuns);
+
+		// the run nRun, open for GetNext; MoveFirst starts all of them over
+		FileUtil* GetRun(int nRun);
+		void MoveFirst();
+
+		// true if the runs hold enough records to be merged into the file
+		bool NeedCompaction();
+
+		// the records of the files merged in sort order into "out", which
+		// is open; the fences, index entries and zones of "out" are added
+		// to pFences, pIndexes and pZones unless they are NULL. Returns the
+		// number of records
+		static long Merge(vector<FileUtil*> &vIn, OrderMaker &order, FileUtil &out,
+						  FenceIndex *pFences, IndexSet *pIndexes = NULL,
+						  ZoneMap *pZones = NULL);
+
+		// the files of the runs of the sorted file binPath, see DROP TABLE
+		static void GetRunList(const string &binPath, vector<string> &vPaths);
+};
+
+#endif
@@ -0,0 +1,567 @@
+#include <string.h>
+#include <stdlib.h>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include "Dictionary.h"
+
+// bytes a string takes in a record, as SuckNextRecord lays it out
+static int GetStoredLength(int nChars)
+{
+	int len = nChars + 1;
+	if (len % sizeof(int) != 0)
+		len += sizeof(int) - (len % sizeof(int));
+	return len;
+}
+
+Dictionary::Dictionary(int whichAtt) : m_nWhichAtt(whichAtt), m_nMaxLen(0)
+{}
+
+// first value >= (bStrict false) or > (bStrict true) the given one
+static int Search(vector<string> &vValues, const char *value, bool bStrict)
+{
+	int low = 0, high = vValues.size();
+	while (low < high)
+	{
+		int mid = (low + high) / 2;
+		int cmp = strcmp(vValues[mid].c_str(), value);
+		if (cmp < 0 || (bStrict && cmp == 0))
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
+}
+
+int Dictionary::Encode(const char *value)
+{
+	int code = Search(m_vValues, value, false);
+	if (code < m_vValues.size() && strcmp(m_vValues[code].c_str(), value) == 0)
+		return code;
+	return -1;
+}
+
+int Dictionary::LowerBound(const char *value)
+{
+	return Search(m_vValues, value, false);
+}
+
+int Dictionary::UpperBound(const char *value)
+{
+	return Search(m_vValues, value, true);
+}
+
+void Dictionary::Learn(const char *value)
+{
+	if (Encode(value) == -1)
+		m_sNewValues.insert(value);
+}
+
+bool Dictionary::Merge(vector<int> &vRemap)
+{
+	vRemap.clear();
+	if (m_sNewValues.empty())
+		return false;
+
+	// both lists are sorted: a value keeps its place among the old ones,
+	// moved up by the new ones that come before it
+	vector<string> vValues;
+	vValues.reserve(m_vValues.size() + m_sNewValues.size());
+	vRemap.resize(m_vValues.size());
+	set<string>::iterator it = m_sNewValues.begin();
+	for (int i = 0; i < m_vValues.size(); i++)
+	{
+		while (it != m_sNewValues.end() && strcmp(it->c_str(), m_vValues[i].c_str()) < 0)
+			vValues.push_back(*it++);
+		vRemap[i] = vValues.size();
+		vValues.push_back(m_vValues[i]);
+	}
+	while (it != m_sNewValues.end())
+		vValues.push_back(*it++);
+	m_sNewValues.clear();
+
+	m_vValues.swap(vValues);
+	m_vLens.resize(m_vValues.size());
+	for (int i = 0; i < m_vValues.size(); i++)
+	{
+		m_vLens[i] = GetStoredLength(m_vValues[i].size());
+		m_nMaxLen = max(m_nMaxLen, m_vLens[i]);
+	}
+	return true;
+}
+
+void Dictionary::Write(ostream &out)
+{
+	int nValues = m_vValues.size();
+	out.write((char *) &nValues, sizeof(int));
+	for (int i = 0; i < nValues; i++)
+	{
+		int nChars = m_vValues[i].size();
+		out.write((char *) &nChars, sizeof(int));
+		out.write(m_vValues[i].c_str(), nChars);
+	}
+}
+
+bool Dictionary::Read(istream &in)
+{
+	m_vValues.clear();
+	m_vLens.clear();
+	m_nMaxLen = 0;
+	int nValues = 0;
+	if (!in.read((char *) &nValues, sizeof(int)) || nValues < 0)
+		return false;
+
+	m_vValues.resize(nValues);
+	m_vLens.resize(nValues);
+	vector<char> vChars;
+	for (int i = 0; i < nValues; i++)
+	{
+		int nChars = 0;
+		if (!in.read((char *) &nChars, sizeof(int)) || nChars < 0)
+			return false;
+		vChars.resize(nChars + 1);
+		if (nChars > 0 && !in.read(&vChars[0], nChars))
+			return false;
+		m_vValues[i].assign(&vChars[0], nChars);
+		m_vLens[i] = GetStoredLength(nChars);
+		m_nMaxLen = max(m_nMaxLen, m_vLens[i]);
+	}
+	return true;
+}
+
+DictionarySet::DictionarySet() : m_bDirty(false)
+{
+	m_pBuf = new (std::nothrow) char[PAGE_SIZE];
+	if (m_pBuf == NULL)
+	{
+		cout << "ERROR : Not enough memory. EXIT !!!\n";
+		exit(1);
+	}
+}
+
+DictionarySet::~DictionarySet()
+{
+	Close();
+	delete [] m_pBuf;
+	m_pBuf = NULL;
+}
+
+string DictionarySet::GetDictPath(const string &binPath)
+{
+	return binPath + ".dict";
+}
+
+void DictionarySet::GetDictList(const string &binPath, vector<int> &vAtts)
+{
+	ifstream meta_in;
+	meta_in.open((binPath + ".meta.data").c_str());
+	string line;
+	while (getline(meta_in, line))
+	{
+		stringstream ss(line);
+		string word;
+		int nAtt;
+		if (ss >> word && word.compare("dict") == 0 && ss >> nAtt)
+			vAtts.push_back(nAtt);
+	}
+}
+
+void DictionarySet::Open(const string &binPath)
+{
+	Close();
+	m_sBinPath = binPath;
+
+	vector<int> vAtts;
+	GetDictList(binPath, vAtts);
+	if (vAtts.empty())
+		return;
+	for (int i = 0; i < vAtts.size(); i++)
+		AddDictionary(vAtts[i]);
+
+	// <attributes> and their types, <dictionaries> then, for every
+	// dictionary, <attribute> and its values
+	ifstream dict_in;
+	dict_in.open(GetDictPath(binPath).c_str(), ios::binary);
+	int nAtts = 0;
+	if (!dict_in.read((char *) &nAtts, sizeof(int)) || nAtts < 0)
+	{
+		cerr << "BAD: the dictionaries of " << binPath << " can not be read\n";
+		exit(1);
+	}
+	m_vTypes.resize(nAtts);
+	for (int i = 0; i < nAtts; i++)
+	{
+		int type = 0;
+		dict_in.read((char *) &type, sizeof(int));
+		m_vTypes[i] = (Type) type;
+	}
+	m_vAttDicts.resize(max((int) m_vAttDicts.size(), nAtts), NULL);
+
+	int nDicts = 0;
+	dict_in.read((char *) &nDicts, sizeof(int));
+	for (int i = 0; i < nDicts; i++)
+	{
+		int nAtt = -1;
+		if (!dict_in.read((char *) &nAtt, sizeof(int)))
+			break;
+		Dictionary scratch(nAtt);
+		Dictionary *pDict = &scratch;
+		if (nAtt >= 0 && nAtt < m_vAttDicts.size() && m_vAttDicts[nAtt] != NULL)
+			pDict = m_vAttDicts[nAtt];
+		if (!pDict->Read(dict_in))
+		{
+			cerr << "BAD: the dictionaries of " << binPath << " can not be read\n";
+			exit(1);
+		}
+	}
+	dict_in.close();
+	MakeRuns();
+	m_bDirty = false;
+}
+
+void DictionarySet::Close()
+{
+	if (m_bDirty && !m_sBinPath.empty())
+	{
+		ofstream dict_out;
+		dict_out.open(GetDictPath(m_sBinPath).c_str(), ios::binary | ios::trunc);
+		int nAtts = m_vTypes.size();
+		dict_out.write((char *) &nAtts, sizeof(int));
+		for (int i = 0; i < nAtts; i++)
+		{
+			int type = m_vTypes[i];
+			dict_out.write((char *) &type, sizeof(int));
+		}
+		int nDicts = m_vDicts.size();
+		dict_out.write((char *) &nDicts, sizeof(int));
+		for (int i = 0; i < nDicts; i++)
+		{
+			int nAtt = m_vDicts[i]->GetWhichAtt();
+			dict_out.write((char *) &nAtt, sizeof(int));
+			m_vDicts[i]->Write(dict_out);
+		}
+		dict_out.close();
+	}
+
+	for (int i = 0; i < m_vDicts.size(); i++)
+		delete m_vDicts[i];
+	m_vDicts.clear();
+	m_vAttDicts.clear();
+	m_vTypes.clear();
+	m_vRuns.clear();
+	m_bDirty = false;
+}
+
+void DictionarySet::SetTypes(Schema &mySchema)
+{
+	int nAtts = mySchema.GetNumAtts();
+	Attribute *atts = mySchema.GetAtts();
+	m_vTypes.resize(nAtts);
+	for (int i = 0; i < nAtts; i++)
+		m_vTypes[i] = atts[i].myType;
+	m_vAttDicts.resize(max((int) m_vAttDicts.size(), nAtts), NULL);
+	MakeRuns();
+	m_bDirty = true;
+}
+
+void DictionarySet::AddDictionary(int whichAtt)
+{
+	if (whichAtt >= m_vAttDicts.size())
+		m_vAttDicts.resize(whichAtt + 1, NULL);
+	if (m_vAttDicts[whichAtt] != NULL)
+		return;
+	Dictionary *pDict = new Dictionary(whichAtt);
+	m_vDicts.push_back(pDict);
+	m_vAttDicts[whichAtt] = pDict;
+	MakeRuns();
+	m_bDirty = true;
+}
+
+void DictionarySet::MakeRuns()
+{
+	m_vRuns.clear();
+	for (int i = 0; i < m_vTypes.size(); i++)
+	{
+		bool bDict = (i < m_vAttDicts.size() && m_vAttDicts[i] != NULL);
+		if (bDict || m_vRuns.empty() || m_vRuns.back().bDict)
+		{
+			AttRun run;
+			run.nFirst = i;
+			run.bDict = bDict;
+			run.bDouble = false;
+			m_vRuns.push_back(run);
+		}
+		m_vRuns.back().nLast = i;
+		m_vRuns.back().bDouble |= (m_vTypes[i] == Double);
+	}
+}
+
+int DictionarySet::GetValueLength(char *src, int whichAtt)
+{
+	if (m_vTypes[whichAtt] == Int)
+		return sizeof(int);
+	else if (m_vTypes[whichAtt] == Double)
+		return sizeof(double);
+	return GetStoredLength(strlen(src + ATT_OFFSET(src, whichAtt)));
+}
+
+int DictionarySet::Convert(char *src, char *out, bool bEncode)
+{
+	int nAtts = m_vTypes.size();
+	if (!Record::HasNumAtts(src, nAtts))
+	{
+		cerr << "BAD: a record of some other schema in " << m_sBinPath
+			 << ", whose dictionaries are for " << nAtts << " attributes\n";
+		exit(1);
+	}
+
+	// the layout of SuckNextRecord: ints, and strings padded to an int,
+	// back to back, and doubles double aligned
+	int pos = sizeof(int) * (nAtts + 1);
+	for (int r = 0; r < m_vRuns.size(); r++)
+	{
+		AttRun &run = m_vRuns[r];
+		int i = run.nFirst;
+		char *value = src + ATT_OFFSET(src, i);
+		if (run.bDict && bEncode)
+		{
+			int code = m_vAttDicts[i]->Encode(value);
+			if (code == -1)
+				return -1;
+			ATT_OFFSET(out, i) = pos;
+			*((int *) (out + pos)) = code;
+			pos += sizeof(int);
+			continue;
+		}
+		else if (run.bDict)
+		{
+			Dictionary *pDict = m_vAttDicts[i];
+			int code = *((int *) value);
+			int len = pDict->GetLength(code);
+			ATT_OFFSET(out, i) = pos;
+			*((int *) (out + pos + len - sizeof(int))) = 0;
+			strcpy(out + pos, pDict->Decode(code));
+			pos += len;
+			continue;
+		}
+
+		// the attributes in between keep their layout if their doubles
+		// stay aligned: they move all at once
+		int nStart = ATT_OFFSET(src, i);
+		int nShift = pos - nStart;
+		if (!run.bDouble || nShift % sizeof(double) == 0)
+		{
+			int nEnd = ATT_OFFSET(src, run.nLast) + GetValueLength(src, run.nLast);
+			memcpy(out + pos, src + nStart, nEnd - nStart);
+			for (; i <= run.nLast; i++)
+				ATT_OFFSET(out, i) = ATT_OFFSET(src, i) + nShift;
+			pos += nEnd - nStart;
+			continue;
+		}
+
+		for (; i <= run.nLast; i++)
+		{
+			if (m_vTypes[i] == Double)
+			{
+				while (pos % sizeof(double) != 0)
+				{
+					*((int *) (out + pos)) = 0;
+					pos += sizeof(int);
+				}
+			}
+			int len = GetValueLength(src, i);
+			ATT_OFFSET(out, i) = pos;
+			memcpy(out + pos, src + ATT_OFFSET(src, i), len);
+			pos += len;
+		}
+	}
+	((int *) out)[0] = pos;
+	return pos;
+}
+
+bool DictionarySet::Encode(Record &rec)
+{
+	int len = Convert(rec.bits, m_pBuf, true);
+	if (len == -1)
+		return false;
+	rec.CopyBits(m_pBuf, len);
+	return true;
+}
+
+void DictionarySet::Decode(Record &stored, Record &rec)
+{
+	int len = Convert(stored.bits, m_pBuf, false);
+	rec.CopyBits(m_pBuf, len);
+}
+
+int DictionarySet::Decode(Record &stored, char *dst, Record &rec)
+{
+	int len = Convert(stored.bits, dst, false);
+	rec.SetView(dst);
+	return len;
+}
+
+int DictionarySet::GetMaxGrowth()
+{
+	// a value instead of its code, and an int before every double
+	// if they are not aligned the same way any more
+	int nGrowth = 0;
+	for (int i = 0; i < m_vDicts.size(); i++)
+		nGrowth += m_vDicts[i]->GetMaxLength();
+	for (int i = 0; i < m_vTypes.size(); i++)
+		if (m_vTypes[i] == Double)
+			nGrowth += sizeof(int);
+	return nGrowth;
+}
+
+void DictionarySet::Learn(Record &rec)
+{
+	for (int i = 0; i < m_vDicts.size(); i++)
+	{
+		int nAtt = m_vDicts[i]->GetWhichAtt();
+		m_vDicts[i]->Learn(rec.bits + ATT_OFFSET(rec.bits, nAtt));
+	}
+}
+
+void DictionarySet::Learn(FILE *textFile)
+{
+	int nAtts = m_vTypes.size();
+	if (nAtts == 0)
+		return;
+
+	// the attributes of the records follow each other, each of them ends
+	// with a '|', as SuckNextRecord reads them
+	string value;
+	int nAtt = 0;
+	int c;
+	while ((c = getc(textFile)) != EOF)
+	{
+		if (c != '|')
+		{
+			if (m_vAttDicts[nAtt] != NULL)
+				value += (char) c;
+			continue;
+		}
+		if (m_vAttDicts[nAtt] != NULL)
+		{
+			m_vAttDicts[nAtt]->Learn(value.c_str());
+			value.clear();
+		}
+		nAtt = (nAtt + 1) % nAtts;
+	}
+}
+
+bool DictionarySet::Merge(vector< vector<int> > &vRemaps)
+{
+	bool bChanged = false;
+	vRemaps.resize(m_vDicts.size());
+	for (int i = 0; i < m_vDicts.size(); i++)
+		bChanged |= m_vDicts[i]->Merge(vRemaps[i]);
+	if (bChanged)
+		m_bDirty = true;
+	return bChanged;
+}
+
+void DictionarySet::Recode(Page &page, vector< vector<int> > &vRemaps)
+{
+	Record view;
+	int nRecs = page.GetNumRecs();
+	for (int r = 0; r < nRecs; r++)
+	{
+		page.GetRecord(r, &view);
+		for (int i = 0; i < m_vDicts.size(); i++)
+		{
+			if (vRemaps[i].empty())
+				continue;
+			int *pCode = (int *) (view.bits + ATT_OFFSET(view.bits, m_vDicts[i]->GetWhichAtt()));
+			*pCode = vRemaps[i][*pCode];
+		}
+	}
+}
+
+bool DictionarySet::TranslateCNF(CNF &cnf, Record &literal, CNF &codeCnf, Record &codeLiteral)
+{
+	codeCnf = cnf;
+	vector<int> vCodes;		// the literals the comparisons get, in order
+
+	// the codes go after the attributes of the literal the CNF looks at
+	int nLitAtts = 0;
+	for (int i = 0; i < cnf.numAnds; i++)
+	{
+		for (int j = 0; j < cnf.orLens[i]; j++)
+		{
+			Comparison &c = cnf.orList[i][j];
+			if (c.operand1 == Literal)
+				nLitAtts = max(nLitAtts, c.whichAtt1 + 1);
+			if (c.operand2 == Literal)
+				nLitAtts = max(nLitAtts, c.whichAtt2 + 1);
+		}
+	}
+	for (int i = 0; i < cnf.numAnds; i++)
+	{
+		for (int j = 0; j < cnf.orLens[i]; j++)
+		{
+			Comparison &c = codeCnf.orList[i][j];
+			bool bDict1 = (c.operand1 == Left && c.whichAtt1 < m_vAttDicts.size() &&
+						   m_vAttDicts[c.whichAtt1] != NULL);
+			bool bDict2 = (c.operand2 == Left && c.whichAtt2 < m_vAttDicts.size() &&
+						   m_vAttDicts[c.whichAtt2] != NULL);
+			if (!bDict1 && !bDict2)
+				continue;
+
+			// only the dictionary attribute against a literal can be rewritten
+			int nAtt, nLit;
+			CompOperator op;
+			if (!c.GetAttOpLiteral(nAtt, nLit, op))
+				return false;
+
+			// att < X is code < first code >= X, att > X is code >= first
+			// code > X, and a value that is not in the dictionary equals
+			// no code
+			Dictionary *pDict = m_vAttDicts[nAtt];
+			const char *value = literal.bits + ATT_OFFSET(literal.bits, nLit);
+			int code;
+			if (op == Equals)
+				code = pDict->Encode(value);
+			else if (op == LessThan)
+				code = pDict->LowerBound(value);
+			else
+				code = pDict->UpperBound(value) - 1;
+
+			if (c.operand1 == Literal)
+				c.whichAtt1 = nLitAtts + vCodes.size();
+			else
+				c.whichAtt2 = nLitAtts + vCodes.size();
+			c.attType = Int;
+			vCodes.push_back(code);
+		}
+	}
+
+	// the literal, with the codes after its own attributes; those are
+	// moved by a multiple of 8 bytes so that its doubles stay aligned
+	int nAtts = nLitAtts + vCodes.size();
+	int nOldHeader = sizeof(int) * (nLitAtts + 1);
+	int nHeader = sizeof(int) * (nAtts + 1);
+	int nShift = ((nHeader - nOldHeader) + 7) & ~7;
+	int nOldLen = (literal.bits == NULL) ? nOldHeader : ((int *) literal.bits)[0];
+	int nLen = nOldLen + nShift + sizeof(int) * vCodes.size();
+	if (nLen > PAGE_SIZE)
+		return false;
+
+	char *out = m_pBuf;
+	memset(out, 0, nOldHeader + nShift);
+	if (nOldLen > nOldHeader)
+		memcpy(out + nOldHeader + nShift, literal.bits + nOldHeader, nOldLen - nOldHeader);
+	for (int i = 0; i < nLitAtts; i++)
+		ATT_OFFSET(out, i) = ATT_OFFSET(literal.bits, i) + nShift;
+	for (int i = 0; i < vCodes.size(); i++)
+	{
+		int pos = nOldLen + nShift + sizeof(int) * i;
+		ATT_OFFSET(out, nLitAtts + i) = pos;
+		*((int *) (out + pos)) = vCodes[i];
+	}
+	((int *) out)[0] = nLen;
+
+	codeLiteral.CopyBits(out, nLen);
+	return true;
+}
@@ -0,0 +1,160 @@
+#ifndef DICTIONARY_H
+#define DICTIONARY_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <set>
+#include <iostream>
+#include "Defs.h"
+#include "Record.h"
+#include "Comparison.h"
+
+using namespace std;
+
+// attributes next to each other that DictionarySet lays out the same way:
+// one with a dictionary, or those in between two of them
+struct AttRun
+{
+	int nFirst;
+	int nLast;
+	bool bDict;
+	bool bDouble;		// one of them is a double
+};
+
+// Order preserving dictionary of a String attribute: the values are kept
+// sorted, and the code of a value is its rank among them, so that two
+// codes compare as their values do under strcmp
+class Dictionary
+{
+	private:
+		int m_nWhichAtt;
+		vector<string> m_vValues;
+		vector<int> m_vLens;		// bytes a value takes in a record
+		int m_nMaxLen;				// the most of them
+
+		// values not in the dictionary yet, see Learn
+		set<string> m_sNewValues;
+
+	public:
+		Dictionary(int whichAtt);
+		~Dictionary() {}
+
+		// code of the value, -1 if it is not in the dictionary
+		int Encode(const char *value);
+
+		// the value of a code, and the bytes it takes in a record, that is
+		// with its NUL and padded to an int
+		const char* Decode(int code) { return m_vValues[code].c_str(); }
+		int GetLength(int code) { return m_vLens[code]; }
+
+		// first code whose value is >= (LowerBound) or > (UpperBound) the
+		// value; GetNumValues() if there is none
+		int LowerBound(const char *value);
+		int UpperBound(const char *value);
+
+		// the value goes in with the next Merge
+		void Learn(const char *value);
+
+		// adds the values learnt since the last Merge; vRemap gets the new
+		// code of every old one. Returns false if no value was new
+		bool Merge(vector<int> &vRemap);
+
+		int GetWhichAtt() { return m_nWhichAtt; }
+		int GetNumValues() { return m_vValues.size(); }
+		int GetMaxLength() { return m_nMaxLen; }
+
+		// the values, in the binary format of the .dict file
+		void Write(ostream &out);
+		bool Read(istream &in);
+};
+
+// The dictionaries of a heap file, listed in its .meta.data with a
+// "dict <attribute>" line each. The values, with the types of the
+// attributes of the records, are kept in the <file>.dict sidecar.
+// A stored record has the code of its value, an Int, in place of every
+// String attribute with a dictionary; FileUtil encodes the records it
+// is given and decodes those it hands out, so only a scan that asks for
+// the stored records (see TranslateCNF) sees the codes.
+// A value that a dictionary does not have yet changes the codes of the
+// values that come after it: the records already stored are given their
+// new codes (see FileUtil::Recode), in place as a code always takes an int
+class DictionarySet
+{
+	private:
+		string m_sBinPath;
+		vector<Dictionary*> m_vDicts;
+		vector<Dictionary*> m_vAttDicts;	// of every attribute, NULL if none
+		vector<Type> m_vTypes;				// of the decoded records
+		vector<AttRun> m_vRuns;
+		bool m_bDirty;
+
+		// buffer in which Encode and Decode lay out a record
+		char *m_pBuf;
+
+		// lays out the record src with or without the codes in out;
+		// returns its length, -1 if a value is not in its dictionary
+		// (bEncode only)
+		int Convert(char *src, char *out, bool bEncode);
+		void MakeRuns();
+
+		// bytes attribute whichAtt of record src takes, without padding
+		// before it
+		int GetValueLength(char *src, int whichAtt);
+
+	public:
+		DictionarySet();
+		~DictionarySet();
+
+		static string GetDictPath(const string &binPath);
+
+		// reads the dictionary list of the base file binPath
+		static void GetDictList(const string &binPath, vector<int> &vAtts);
+
+		// reads the dictionaries of the base file, and the types of its
+		// records; they are written back on Close if they got new values
+		void Open(const string &binPath);
+		void Close();
+
+		bool IsEmpty() { return m_vDicts.empty(); }
+
+		// for CREATE DICTIONARY: the types of the records, and one more
+		// (empty) dictionary on attribute whichAtt
+		void SetTypes(Schema &mySchema);
+		void AddDictionary(int whichAtt);
+
+		// the stored form of a record; false if the record has values that
+		// are not in the dictionaries, it is then left as it is
+		bool Encode(Record &rec);
+
+		// the record a stored one stands for, in rec, which owns its bits
+		void Decode(Record &stored, Record &rec);
+
+		// same, laid out in dst, which must hold the stored record and
+		// GetMaxGrowth() more bytes; rec is a view on it. Returns its length
+		int Decode(Record &stored, char *dst, Record &rec);
+		int GetMaxGrowth();
+
+		// the values of a record, or of a text file of records (see
+		// SuckNextRecord), go in with the next Merge
+		void Learn(Record &rec);
+		void Learn(FILE *textFile);
+
+		// adds the values learnt to the dictionaries; vRemaps gets, for
+		// every dictionary, the new code of every old one. Returns false if
+		// no value was new, the stored records keep their codes then
+		bool Merge(vector< vector<int> > &vRemaps);
+
+		// gives the stored records of the page the codes of Merge
+		void Recode(Page &page, vector< vector<int> > &vRemaps);
+
+		// a CNF and a literal that do on the stored records what the given
+		// ones do on the decoded records: a comparison of an attribute
+		// that has a dictionary with the literal becomes a comparison of
+		// the code with the code of the literal (equality), or with the
+		// first code past it (ranges). Returns false if the CNF compares
+		// such an attribute with anything else
+		bool TranslateCNF(CNF &cnf, Record &literal, CNF &codeCnf, Record &codeLiteral);
+};
+
+#endif
@@ -0,0 +1,298 @@
+#include "ExportFile.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <iostream>
+
+// the fixed part of the header, see ExportFile.h
+struct ExportHeader
+{
+	char magic[8];
+	int version;
+	int pageSize;
+	int headerSize;
+	int numAtts;
+	long long numPages;
+	long long numRecords;
+};
+
+ExportFile::ExportFile() : m_nFd(-1), m_bWriting(false), m_nPageSize(PAGE_SIZE), m_nHeaderSize(0),
+	m_nPages(0), m_nRecords(0), m_vNames(), m_vTypes(), m_pMap(NULL), m_nMapLen(0),
+	m_pPage(NULL), m_pBuffer(NULL)
+{}
+
+ExportFile::~ExportFile()
+{
+	Close();
+}
+
+int ExportFile::HeaderSize()
+{
+	int nSize = sizeof(ExportHeader);
+	for (int i = 0; i < m_vNames.size(); i++)
+		nSize += sizeof(int) + m_vNames[i].size() + 1;
+	return (nSize + IO_ALIGNMENT - 1) / IO_ALIGNMENT * IO_ALIGNMENT;
+}
+
+bool ExportFile::Create(const char *fName, Schema &mySchema, int nPageSize)
+{
+	Close();
+	if (!File::IsValidPageSize(nPageSize))
+		return false;
+
+	m_nFd = open(fName, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+	if (m_nFd < 0)
+		return false;
+	m_bWriting = true;
+
+	Attribute *atts = mySchema.GetAtts();
+	for (int i = 0; i < mySchema.GetNumAtts(); i++)
+	{
+		m_vNames.push_back(atts[i].name);
+		m_vTypes.push_back(atts[i].myType);
+	}
+	m_nPageSize = nPageSize;
+	m_nHeaderSize = HeaderSize();
+	m_nPages = 0;
+	m_nRecords = 0;
+
+	m_pPage = new (std::nothrow) Page();
+	m_pBuffer = new (std::nothrow) char[m_nPageSize];
+	if (m_pPage == NULL || m_pBuffer == NULL)
+	{
+		cout << "ERROR : Not enough memory. EXIT !!!\n";
+		exit(1);
+	}
+	m_pPage->SetPageSize(m_nPageSize);
+	return true;
+}
+
+bool ExportFile::WritePage(Page &page)
+{
+	if (page.GetBinarySize() > m_nPageSize)
+	{
+		cerr << "BAD: a page of " << page.GetBinarySize() << " bytes in an export file of pages of "
+			 << m_nPageSize << " bytes\n";
+		exit(1);
+	}
+
+	// the zeros after the records are part of the page
+	int nSize = page.GetBinarySize();
+	page.ToBinary(m_pBuffer);
+	memset(m_pBuffer + nSize, 0, m_nPageSize - nSize);
+	off_t offset = (off_t) m_nHeaderSize + (off_t) m_nPages * m_nPageSize;
+	if (pwrite(m_nFd, m_pBuffer, m_nPageSize, offset) != m_nPageSize)
+		return false;
+	m_nPages++;
+	m_nRecords += page.GetNumRecs();
+	return true;
+}
+
+bool ExportFile::AddPage(Page &addMe)
+{
+	if (addMe.GetNumRecs() == 0)
+		return true;
+
+	// the records of the last Add go first
+	if (m_pPage->GetNumRecs() > 0)
+	{
+		bool bWritten = WritePage(*m_pPage);
+		m_pPage->EmptyItOut();
+		if (!bWritten)
+			return false;
+	}
+	return WritePage(addMe);
+}
+
+bool ExportFile::Add(Record &addMe)
+{
+	if (m_pPage->Append(&addMe))
+		return true;
+
+	bool bWritten = WritePage(*m_pPage);
+	m_pPage->EmptyItOut();
+	if (!m_pPage->Append(&addMe))
+	{
+		cerr << "BAD: a record is larger than a page of " << m_nPageSize << " bytes\n";
+		exit(1);
+	}
+	return bWritten;
+}
+
+void ExportFile::WriteHeader(char *buf)
+{
+	memset(buf, 0, m_nHeaderSize);
+	ExportHeader *pHeader = (ExportHeader *) buf;
+	memcpy(pHeader->magic, EXPORT_MAGIC, sizeof(pHeader->magic));
+	pHeader->version = EXPORT_VERSION;
+	pHeader->pageSize = m_nPageSize;
+	pHeader->headerSize = m_nHeaderSize;
+	pHeader->numAtts = m_vTypes.size();
+	pHeader->numPages = m_nPages;
+	pHeader->numRecords = m_nRecords;
+
+	char *pAtt = buf + sizeof(ExportHeader);
+	for (int i = 0; i < m_vTypes.size(); i++)
+	{
+		int nType = m_vTypes[i];
+		memcpy(pAtt, &nType, sizeof(int));
+		pAtt += sizeof(int);
+		memcpy(pAtt, m_vNames[i].c_str(), m_vNames[i].size() + 1);
+		pAtt += m_vNames[i].size() + 1;
+	}
+}
+
+bool ExportFile::ReadHeader(char *buf, size_t nLen)
+{
+	if (nLen < sizeof(ExportHeader))
+		return false;
+	ExportHeader *pHeader = (ExportHeader *) buf;
+	if (memcmp(pHeader->magic, EXPORT_MAGIC, sizeof(pHeader->magic)) != 0)
+		return false;
+	if (pHeader->version != EXPORT_VERSION)
+	{
+		cerr << "BAD: an export file of version " << pHeader->version << ", this is version "
+			 << EXPORT_VERSION << "\n";
+		return false;
+	}
+	if (!File::IsValidPageSize(pHeader->pageSize) || pHeader->headerSize < sizeof(ExportHeader) ||
+		pHeader->numAtts < 0 || pHeader->numPages < 0 ||
+		(size_t) pHeader->headerSize + (size_t) pHeader->numPages * pHeader->pageSize > nLen)
+		return false;
+
+	m_nPageSize = pHeader->pageSize;
+	m_nHeaderSize = pHeader->headerSize;
+	m_nPages = pHeader->numPages;
+	m_nRecords = pHeader->numRecords;
+
+	char *pAtt = buf + sizeof(ExportHeader);
+	char *pEnd = buf + m_nHeaderSize;
+	for (int i = 0; i < pHeader->numAtts; i++)
+	{
+		int nType;
+		if (pAtt + sizeof(int) >= pEnd)
+			return false;
+		memcpy(&nType, pAtt, sizeof(int));
+		pAtt += sizeof(int);
+		char *pNul = (char *) memchr(pAtt, 0, pEnd - pAtt);
+		if (pNul == NULL || nType < Int || nType > String)
+			return false;
+		m_vTypes.push_back((Type) nType);
+		m_vNames.push_back(string(pAtt));
+		pAtt = pNul + 1;
+	}
+	return true;
+}
+
+bool ExportFile::Open(const char *fName)
+{
+	Close();
+	m_nFd = open(fName, O_RDONLY);
+	if (m_nFd < 0)
+		return false;
+	m_bWriting = false;
+
+	struct stat fileStat;
+	void *map = MAP_FAILED;
+	if (fstat(m_nFd, &fileStat) == 0 && fileStat.st_size > 0)
+		map = mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, m_nFd, 0);
+	if (map == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+	m_pMap = (char *) map;
+	m_nMapLen = fileStat.st_size;
+
+	if (!ReadHeader(m_pMap, m_nMapLen))
+	{
+		Close();
+		return false;
+	}
+	madvise(m_pMap, m_nMapLen, MADV_SEQUENTIAL);
+	return true;
+}
+
+void ExportFile::GetPage(Page &putItHere, long whichPage)
+{
+	if (whichPage < 0 || whichPage >= m_nPages)
+	{
+		cerr << "BAD: you tried to read page " << whichPage << " of an export file of "
+			 << m_nPages << " pages\n";
+		exit(1);
+	}
+	putItHere.FromBinary(m_pMap + m_nHeaderSize + (size_t) whichPage * m_nPageSize);
+}
+
+bool ExportFile::Close()
+{
+	if (m_nFd < 0)
+		return true;
+
+	bool bOk = true;
+	if (m_bWriting)
+	{
+		// the records of the last Add, then the header
+		if (m_pPage->GetNumRecs() > 0)
+			bOk = WritePage(*m_pPage);
+		char *pHeader = new (std::nothrow) char[m_nHeaderSize];
+		if (pHeader == NULL)
+		{
+			cout << "ERROR : Not enough memory. EXIT !!!\n";
+			exit(1);
+		}
+		WriteHeader(pHeader);
+		bOk = bOk && pwrite(m_nFd, pHeader, m_nHeaderSize, 0) == m_nHeaderSize;
+		delete [] pHeader;
+		delete m_pPage;
+		delete [] m_pBuffer;
+		m_pPage = NULL;
+		m_pBuffer = NULL;
+	}
+	if (m_pMap != NULL)
+		munmap(m_pMap, m_nMapLen);
+	m_pMap = NULL;
+	m_nMapLen = 0;
+
+	bOk = (close(m_nFd) == 0) && bOk;
+	m_nFd = -1;
+	m_bWriting = false;
+	m_vNames.clear();
+	m_vTypes.clear();
+	return bOk;
+}
+
+void ExportFile::GetAtts(vector<string> &vNames, vector<Type> &vTypes)
+{
+	vNames = m_vNames;
+	vTypes = m_vTypes;
+}
+
+bool ExportFile::HasTypesOf(Schema &mySchema)
+{
+	if (mySchema.GetNumAtts() != m_vTypes.size())
+		return false;
+	Attribute *atts = mySchema.GetAtts();
+	for (int i = 0; i < m_vTypes.size(); i++)
+	{
+		if (atts[i].myType != m_vTypes[i])
+			return false;
+	}
+	return true;
+}
+
+bool ExportFile::IsExportFile(const char *fName)
+{
+	char magic[8];
+	int nFd = open(fName, O_RDONLY);
+	if (nFd < 0)
+		return false;
+	bool bExport = read(nFd, magic, sizeof(magic)) == sizeof(magic) &&
+				   memcmp(magic, EXPORT_MAGIC, sizeof(magic)) == 0;
+	close(nFd);
+	return bExport;
+}
@@ -0,0 +1,105 @@
+#ifndef EXPORT_FILE_H
+#define EXPORT_FILE_H
+
+#include <string>
+#include <vector>
+#include "Defs.h"
+#include "Record.h"
+#include "Schema.h"
+#include "File.h"
+
+using namespace std;
+
+// A table, or the output of a query, in a binary form that is loaded
+// without parsing anything (see EXPORT, IMPORT and CREATE TABLE AS SELECT).
+// The file starts with a header, padded with zeros to a multiple of
+// IO_ALIGNMENT bytes:
+//
+//     offset  0  char[8]  EXPORT_MAGIC
+//             8  int      EXPORT_VERSION
+//            12  int      page size, a valid page size of File
+//            16  int      header size, where the first page starts
+//            20  int      number of attributes
+//            24  long     number of pages (8 bytes)
+//            32  long     number of records (8 bytes)
+//            40           for every attribute, its Type (int: 0 Int,
+//                         1 Double, 2 String) and its name with its NUL
+//
+// followed by the pages, each of them page size bytes, in the form of
+// Page::ToBinary: the number of records (int), then the records in the
+// layout of Record back to back; the rest of the page is zeros. That is
+// how an uncompressed heap file stores its pages, so a heap of the same
+// page size takes them as they are. Numbers are in the byte order of the
+// machine that wrote the file
+class ExportFile
+{
+	private:
+		int m_nFd;
+		bool m_bWriting;
+		int m_nPageSize;
+		int m_nHeaderSize;
+		long m_nPages;
+		long m_nRecords;
+		vector<string> m_vNames;
+		vector<Type> m_vTypes;
+
+		// of the file being read
+		char *m_pMap;
+		size_t m_nMapLen;
+
+		// of the file being written: the page Add fills, and
+		// a page size buffer of zeros ToBinary writes in
+		Page *m_pPage;
+		char *m_pBuffer;
+
+		// writes the records of the page at the end of the file
+		bool WritePage(Page &page);
+
+		// the header, at the start of buf, which holds m_nHeaderSize bytes
+		void WriteHeader(char *buf);
+		bool ReadHeader(char *buf, size_t nLen);
+
+		int HeaderSize();
+
+	public:
+		ExportFile();
+		~ExportFile();
+
+		// a new export file of records of the schema, in pages of
+		// nPageSize bytes; false if it can not be written
+		bool Create(const char *fName, Schema &mySchema, int nPageSize = PAGE_SIZE);
+
+		// adds the records of the page that GetFirst has not handed out,
+		// in a page of their own. The page keeps them
+		bool AddPage(Page &addMe);
+
+		// adds the record, which is consumed, to the last page
+		bool Add(Record &addMe);
+
+		// maps the export file in memory; false if it can not be read or
+		// is not an export file
+		bool Open(const char *fName);
+
+		// gives the records of page whichPage (0 to GetNumPages () - 1)
+		// to the page, which must be able to hold GetPageSize () bytes
+		void GetPage(Page &putItHere, long whichPage);
+
+		// writes the header of a new file, then closes it
+		bool Close();
+
+		int GetPageSize() { return m_nPageSize; }
+		long GetNumPages() { return m_nPages; }
+		long GetNumRecords() { return m_nRecords; }
+
+		// the attributes the records have
+		void GetAtts(vector<string> &vNames, vector<Type> &vTypes);
+
+		// true if the records have the attributes of the schema, the
+		// names aside
+		bool HasTypesOf(Schema &mySchema);
+
+		// true if fName starts with EXPORT_MAGIC
+		static bool IsExportFile(const char *fName);
+};
+
+#endif
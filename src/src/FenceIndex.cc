@@ -0,0 +1,239 @@
+#include <string.h>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include "FenceIndex.h"
+#include "ZoneMap.h"
+#include "File.h"
+
+// a key goes out as the values of its attributes, like a zone map
+static void WriteKey(ostream &out, vector<Type> &vTypes, vector<KeyValue> &vKey)
+{
+	for (int i = 0; i < vTypes.size(); i++)
+		ZoneMap::WriteValue(out, vTypes[i], vKey[i].dVal, vKey[i].sVal);
+}
+
+static void ReadKey(istream &in, vector<Type> &vTypes, vector<KeyValue> &vKey)
+{
+	vKey.resize(vTypes.size());
+	for (int i = 0; i < vTypes.size(); i++)
+		ZoneMap::ReadValue(in, vTypes[i], vKey[i].dVal, vKey[i].sVal);
+}
+
+FenceIndex::FenceIndex() : m_vTypes(), m_vAtts(), m_vPages(), m_nPages(0), m_bDirty(false)
+{}
+
+void FenceIndex::SetOrder(OrderMaker &sortOrder)
+{
+	m_vTypes.clear();
+	m_vAtts.clear();
+	for (int i = 0; i < sortOrder.numAtts; i++)
+	{
+		m_vAtts.push_back(sortOrder.whichAtts[i]);
+		m_vTypes.push_back(sortOrder.whichTypes[i]);
+	}
+}
+
+void FenceIndex::Clear()
+{
+	m_vPages.clear();
+	m_nPages = 0;
+	m_bDirty = true;
+}
+
+void FenceIndex::Read(const string &metaPath)
+{
+	m_vPages.clear();
+	m_nPages = -1;
+	m_bDirty = false;
+
+	ifstream meta_in;
+	meta_in.open(metaPath.c_str());
+	string line;
+	while (getline(meta_in, line))
+	{
+		istringstream ss(line);
+		string word;
+		ss >> word;
+		if (word.compare("fencekeys") == 0)
+		{
+			ss >> m_nPages;
+			if (m_nPages >= 0)
+				m_vPages.resize(m_nPages);
+		}
+		else if (word.compare("fence") == 0 && m_nPages >= 0)
+		{
+			int nPage = -1;
+			ss >> nPage;
+			if (nPage < 0 || nPage >= m_nPages)
+				continue;
+			ReadKey(ss, m_vTypes, m_vPages[nPage].vFirst);
+			ReadKey(ss, m_vTypes, m_vPages[nPage].vLast);
+			// cut short, do not trust any of it
+			if (!ss)
+				m_nPages = -1;
+		}
+	}
+
+	// a page without its fences
+	for (int p = 0; p < m_vPages.size(); p++)
+	{
+		if (m_vPages[p].vFirst.size() != m_vTypes.size())
+			m_nPages = -1;
+	}
+}
+
+void FenceIndex::Write(const string &metaPath)
+{
+	// keep everything but the fences
+	vector<string> vLines;
+	ifstream meta_in;
+	meta_in.open(metaPath.c_str());
+	string line;
+	while (getline(meta_in, line))
+	{
+		if (line.compare(0, 6, "fence ") != 0 && line.compare(0, 10, "fencekeys ") != 0)
+			vLines.push_back(line);
+	}
+	meta_in.close();
+
+	ofstream meta_out;
+	meta_out.open(metaPath.c_str(), ios::trunc);
+	for (int i = 0; i < vLines.size(); i++)
+		meta_out << vLines[i] << "\n";
+
+	if (Covers(m_nPages))
+	{
+		meta_out << "fencekeys " << m_nPages << "\n";
+
+		// doubles have to come back exactly as they went out
+		meta_out << setprecision(17);
+		for (int p = 0; p < m_vPages.size(); p++)
+		{
+			meta_out << "fence " << p;
+			WriteKey(meta_out, m_vTypes, m_vPages[p].vFirst);
+			WriteKey(meta_out, m_vTypes, m_vPages[p].vLast);
+			meta_out << "\n";
+		}
+	}
+	meta_out.close();
+	m_bDirty = false;
+}
+
+void FenceIndex::GetKey(Record &rec, vector<KeyValue> &vKey)
+{
+	char *bits = rec.bits;
+	vKey.resize(m_vTypes.size());
+	for (int i = 0; i < m_vTypes.size(); i++)
+	{
+		char *att = bits + ATT_OFFSET(bits, m_vAtts[i]);
+		if (m_vTypes[i] == String)
+			vKey[i].sVal = att;
+		else
+			vKey[i].dVal = (m_vTypes[i] == Int) ? *((int *) att) : *((double *) att);
+	}
+}
+
+void FenceIndex::Add(Record &rec, int nPage)
+{
+	if (nPage >= m_vPages.size())
+	{
+		m_vPages.resize(nPage + 1);
+		m_nPages = nPage + 1;
+		GetKey(rec, m_vPages[nPage].vFirst);
+	}
+	GetKey(rec, m_vPages[nPage].vLast);
+	m_bDirty = true;
+}
+
+void FenceIndex::AddLast(FileUtil &file)
+{
+	Record lastRec;
+	int nPage, nSlot;
+	if (file.GetLastAdded(lastRec, nPage, nSlot))
+		Add(lastRec, nPage);
+}
+
+void FenceIndex::Build(const string &binPath)
+{
+	Clear();
+
+	File base;
+	base.Open(READ_ONLY, const_cast<char*>(binPath.c_str()));
+	base.SetAccessPattern(SEQUENTIAL_ACCESS);
+	int nPages = (base.GetLength() > 0) ? base.GetLength() - 1 : 0;
+
+	Page page;
+	Record rec;
+	m_vPages.resize(nPages);
+	for (int p = 0; p < nPages; p++)
+	{
+		base.GetPage(&page, p);
+		int nRecs = page.GetNumRecs();
+		if (nRecs == 0)
+		{
+			// an empty page can not tell, no search is done then
+			m_nPages = -1;
+			break;
+		}
+		page.GetRecord(0, &rec);
+		GetKey(rec, m_vPages[p].vFirst);
+		page.GetRecord(nRecs - 1, &rec);
+		GetKey(rec, m_vPages[p].vLast);
+	}
+	if (m_nPages == 0)
+		m_nPages = nPages;
+	base.Close();
+}
+
+int FenceIndex::Compare(Record &literal, OrderMaker &queryOrder, vector<KeyValue> &vKey)
+{
+	char *bits = literal.bits;
+	for (int i = 0; i < queryOrder.numAtts && i < vKey.size(); i++)
+	{
+		char *att = bits + ATT_OFFSET(bits, queryOrder.whichAtts[i]);
+		if (queryOrder.whichTypes[i] == String)
+		{
+			int nCmp = strcmp(att, vKey[i].sVal.c_str());
+			if (nCmp != 0)
+				return nCmp;
+		}
+		else
+		{
+			double dVal = (queryOrder.whichTypes[i] == Int) ? *((int *) att) : *((double *) att);
+			if (dVal != vKey[i].dVal)
+				return (dVal < vKey[i].dVal) ? -1 : 1;
+		}
+	}
+	return 0;
+}
+
+int FenceIndex::FindFirstPage(Record &literal, OrderMaker &queryOrder, int nFrom)
+{
+	// the pages whose last record is before the literal come first
+	int low = max(nFrom, 0), high = m_vPages.size();
+	while (low < high)
+	{
+		int mid = (low + high) / 2;
+		if (Compare(literal, queryOrder, m_vPages[mid].vLast) > 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return (low < m_vPages.size()) ? low : -1;
+}
+
+int FenceIndex::FindLastPage(Record &literal, OrderMaker &queryOrder)
+{
+	// the pages whose first record is not after the literal come first
+	int low = 0, high = m_vPages.size();
+	while (low < high)
+	{
+		int mid = (low + high) / 2;
+		if (Compare(literal, queryOrder, m_vPages[mid].vFirst) >= 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low - 1;
+}
@@ -0,0 +1,91 @@
+#ifndef FENCE_INDEX_H
+#define FENCE_INDEX_H
+
+#include <string>
+#include <vector>
+#include "Defs.h"
+#include "Record.h"
+#include "Comparison.h"
+#include "FileUtil.h"
+
+using namespace std;
+
+// one attribute of a sort key; Int and Double values are kept in
+// the double, String values in the string
+struct KeyValue
+{
+	double dVal;
+	string sVal;
+};
+
+// sort keys of the first and the last record of a page
+struct PageFence
+{
+	vector<KeyValue> vFirst;
+	vector<KeyValue> vLast;
+};
+
+// Fence keys of a sorted file: for every data page, the values of the
+// sort attributes of its first and last records. The pages a search on
+// a prefix of the sort order has to read are found in memory, the file
+// is read from the first of them on. The fences are kept in the
+// .meta.data file of the table, as a line
+//   fencekeys <number of pages>
+// followed by one line per page
+//   fence <page> <first key> <last key>
+// with the values of the sort attributes in the order of the sort, a
+// String written as <length>:<characters>
+class FenceIndex
+{
+	private:
+		vector<Type> m_vTypes;		// of the sort attributes
+		vector<int> m_vAtts;		// ... and where they are in a record
+		vector<PageFence> m_vPages;
+		int m_nPages;				// pages of the file the fences are of
+		bool m_bDirty;				// changed since Read
+
+		void GetKey(Record &rec, vector<KeyValue> &vKey);
+
+		// < 0, 0, > 0 if the literal comes before, with or after the key,
+		// on the first queryOrder.numAtts attributes of the sort
+		int Compare(Record &literal, OrderMaker &queryOrder, vector<KeyValue> &vKey);
+
+	public:
+		FenceIndex();
+		~FenceIndex() {}
+
+		// the sort order of the file
+		void SetOrder(OrderMaker &sortOrder);
+		bool IsDirty() { return m_bDirty; }
+
+		// forgets about every page
+		void Clear();
+
+		// true if every page of a file of nPages pages has its fences
+		bool Covers(int nPages) { return m_nPages == nPages && m_vPages.size() == nPages; }
+
+		// reads the fences from, or writes them to, the .meta.data file
+		// metaPath; Write keeps the other lines of the file as they are
+		void Read(const string &metaPath);
+		void Write(const string &metaPath);
+
+		// "rec" is the last record of page nPage so far; pages come in order
+		void Add(Record &rec, int nPage);
+
+		// Add of the record that was added last to the file
+		void AddLast(FileUtil &file);
+
+		// fences of every page of the file binPath, from scratch
+		void Build(const string &binPath);
+
+		// the first page from nFrom on whose last record is not before the
+		// literal, on the query order (a prefix of the sort order, see
+		// CNF::GetMatchingOrder); -1 if there is none
+		int FindFirstPage(Record &literal, OrderMaker &queryOrder, int nFrom);
+
+		// the last page whose first record is not after the literal;
+		// -1 if there is none
+		int FindLastPage(Record &literal, OrderMaker &queryOrder);
+};
+
+#endif
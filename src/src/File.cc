@@ -1,21 +1,45 @@
 #include "File.h"
-#include "TwoWayList.cc"
+#include "BufferPool.h"
+#include "Compression.h"
 
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include <string.h>
+#include <errno.h>
+#include <stdio.h>
 #include <iostream>
 #include <stdlib.h>
+#include <algorithm>
+
+// what is at the start of every file; the rest of the
+// FILE_HEADER_SIZE bytes of the header are zero
+#define FILE_MAGIC "DBPAGES"
+#define FILE_VERSION 1
+
+struct FileHeader {
+	char magic[8];
+	int version;
+	int pageSize;	// 0 in files written before page sizes were stored
+	off_t length;	// in pages, counting the header as page 0
+	int compression;		// PageCompression, 0 in older files
+	off_t extentsOffset;	// where the PageExtents of a compressed file are
+};
 
 
 
 Page :: Page () {
 	curSizeInBytes = sizeof (int);
+	endOfRecs = sizeof (int);
 	numRecs = 0;
+	firstRec = 0;
+	pageSize = PAGE_SIZE;
 
-	myRecs = new (std::nothrow) TwoWayList<Record>;
-	if (myRecs == NULL)
+	// always big enough for the largest page, whatever the file
+	myBits = new (std::nothrow) char[PAGE_SIZE];
+	if (myBits == NULL)
 	{
 		cout << "ERROR : Not enough memory. EXIT !!!\n";
 		exit(1);
@@ -23,62 +47,106 @@ Page :: Page () {
 }
 
 Page :: ~Page () {
-	delete myRecs;
+	delete [] myBits;
 }
 
 
 void Page :: EmptyItOut () {
 
-	// get rid of all of the records
-	while (1) {
-		Record temp;
-		if (!GetFirst (&temp))
-			break;
-	}	
+	// records live in myBits, so there is nothing to free
+	slots.clear ();
 
 	// reset the page size
 	curSizeInBytes = sizeof (int);
+	endOfRecs = sizeof (int);
 	numRecs = 0;
+	firstRec = 0;
 }
 
 
 int Page :: GetFirst (Record *firstOne) {
 
-	// move to the first record
-	myRecs->MoveToStart ();
-
 	// make sure there is data 
-	if (!myRecs->RightLength ()) {
+	if (firstRec == numRecs) {
 		return 0;
 	}
 
-	// and remove it
-	myRecs->Remove (firstOne);
-	numRecs--;
+	// hand out a view on the record, no copy is made
+	char *b = myBits + slots[firstRec++];
+	firstOne->SetView (b);
 
-	char *b = firstOne->GetBits();
 	curSizeInBytes -= ((int *) b)[0];
 
 	return 1;
 }
 
 
+int Page :: GetNumRecs () {
+	return numRecs - firstRec;
+}
+
+
+int Page :: GetRecord (int which, Record *putItHere) {
+
+	if (which < 0 || firstRec + which >= numRecs) {
+		return 0;
+	}
+
+	putItHere->SetView (myBits + slots[firstRec + which]);
+	return 1;
+}
+
+
+void Page :: Compact () {
+
+	if (firstRec == 0)
+		return;
+
+	// slide the remaining records to the front
+	int from = (firstRec < numRecs) ? slots[firstRec] : endOfRecs;
+	int len = endOfRecs - from;
+	memmove (myBits + sizeof (int), myBits + from, len);
+
+	int shift = from - sizeof (int);
+	for (int i = firstRec; i < numRecs; i++)
+		slots[i - firstRec] = slots[i] - shift;
+
+	numRecs -= firstRec;
+	slots.resize (numRecs);
+	firstRec = 0;
+	endOfRecs = sizeof (int) + len;
+}
+
+
 int Page :: Append (Record *addMe) {
 	char *b = addMe->GetBits();
+	int len = ((int *) b)[0];
 
 	// first see if we can fit the record
-	if (curSizeInBytes + ((int *) b)[0] > PAGE_SIZE) {
+	if (curSizeInBytes + len > pageSize) {
 		return 0;
 	}
 
-	// move to the last record
-	myRecs->MoveToFinish ();
+	// records already handed out still take up space at the front; a view
+	// on one of the records of this page would move with them
+	if (endOfRecs + len > pageSize) {
+		if (b >= myBits && b < myBits + pageSize) {
+			addMe->CopyBits (b, len);
+			b = addMe->GetBits ();
+		}
+		Compact ();
+	}
 
-	// and add it
-	curSizeInBytes += ((int *) b)[0];
-	myRecs->Insert(addMe);
+	// copy the record in at the end
+	memcpy (myBits + endOfRecs, b, len);
+	slots.push_back (endOfRecs);
+	endOfRecs += len;
+	curSizeInBytes += len;
 	numRecs++;
 
+	// and consume it
+	addMe->SetBits (NULL);
+
 	return 1;	
 }
 
@@ -86,22 +154,17 @@ int Page :: Append (Record *addMe) {
 void Page :: ToBinary (char *bits) {
 
 	// first write the number of records on the page
-	((int *) bits)[0] = numRecs;
+	((int *) bits)[0] = numRecs - firstRec;
 
-	char *curPos = bits + sizeof (int);
+	// the records are already laid out back to back, copy them in one go
+	int from = (firstRec < numRecs) ? slots[firstRec] : endOfRecs;
+	memcpy (bits + sizeof (int), myBits + from, endOfRecs - from);
+}
 
-	// and copy the records one-by-one
-	myRecs->MoveToStart ();
-	for (int i = 0; i < numRecs; i++) {	
-		char *b = myRecs->Current(0)->GetBits();
-		
-		// copy over the bits of the current record
-		memcpy (curPos, b, ((int *) b)[0]);
-		curPos += ((int *) b)[0];
 
-		// and traverse the list
-		myRecs->Advance ();
-	}
+int Page :: GetBinarySize () {
+	int from = (firstRec < numRecs) ? slots[firstRec] : endOfRecs;
+	return sizeof (int) + endOfRecs - from;
 }
 
 
@@ -116,49 +179,82 @@ void Page :: FromBinary (char *bits) {
 		exit (1);
 	}
 
-	// and now get the binary representations of each
-	char *curPos = bits + sizeof (int);
-
-	// first, empty out the list of current records
-	myRecs->MoveToStart ();
-	while (myRecs->RightLength ()) {
-		Record temp;
-		myRecs->Remove(&temp);
+	// build up the slot directory, walking over the record lengths
+	slots.resize (numRecs);
+	int curPos = sizeof (int);
+	for (int i = 0; i < numRecs; i++) {
+		slots[i] = curPos;
+		curPos += ((int *) (bits + curPos))[0];
 	}
 
-	// now loop through and re-populate it
-	Record *temp = new (std::nothrow) Record();
-	if (temp == NULL)
-	{
-		cout << "ERROR : Not enough memory. EXIT !!!\n";
-		exit(1);
-	}
+	// and take a copy of the records
+	memcpy (myBits, bits, curPos);
 
-	curSizeInBytes = sizeof (int);
-	for (int i = 0; i < numRecs; i++) {
+	firstRec = 0;
+	endOfRecs = curPos;
+	curSizeInBytes = curPos;
+}
+
+File :: File () : myFilDes (-1), curLength (0), allocLength (0), pageSize (PAGE_SIZE),
+	myDev (0), myIno (0),
+	readOnly (false), myMap (NULL), myMapLen (0), myPattern (-1),
+	compression (COMPRESS_NONE), dataEnd (FILE_HEADER_SIZE), packBuf (NULL), rawBuf (NULL) {
+}
 
-		// get the length of the current record
-		int len = ((int *) curPos)[0];
-		curSizeInBytes += len;
+File :: ~File () {
+	// make sure no dirty page of ours outlives the file descriptor
+	if (myFilDes >= 0 && !readOnly)
+		BufferPool::getBufferPool()->FlushFile (myDev, myIno);
+	Unmap ();
+	delete [] packBuf;
+	delete [] rawBuf;
+}
 
-		// create the record
-		temp->CopyBits(curPos, len);
 
-		// add it
-		myRecs->Insert(temp);
+void File :: Unmap () {
+	if (myMap != NULL)
+		munmap (myMap, myMapLen);
+	myMap = NULL;
+	myMapLen = 0;
+	myPattern = -1;
+}
 
-		// and move along
-		myRecs->Advance ();
-		curPos += len;
-	}
 
-	delete temp;
+char *File :: MappedPage (off_t whichPage) {
+	if (myMap == NULL || PageOffset (whichPage) + pageSize > (off_t) myMapLen)
+		return NULL;
+	return myMap + PageOffset (whichPage);
 }
 
-File :: File () {
+
+bool File :: IsValidPageSize (int size) {
+	// a power of 2, so that pages stay aligned for O_DIRECT and mmap
+	return size >= MIN_PAGE_SIZE && size <= PAGE_SIZE && (size & (size - 1)) == 0;
 }
 
-File :: ~File () {
+
+int File :: GetPageSize () {
+	return pageSize;
+}
+
+
+int File :: GetCompression () {
+	return compression;
+}
+
+
+void File :: SetAccessPattern (AccessPattern pattern) {
+	// madvise is a system call, don't repeat it for nothing
+	if (myMap == NULL || myPattern == pattern)
+		return;
+	myPattern = pattern;
+
+	if (pattern == RANDOM_ACCESS) {
+		madvise (myMap, myMapLen, MADV_RANDOM);
+	} else {
+		madvise (myMap, myMapLen, MADV_SEQUENTIAL);
+		madvise (myMap, myMapLen, MADV_WILLNEED);
+	}
 }
 
 
@@ -173,68 +269,141 @@ void File :: GetPage (Page *putItHere, off_t whichPage) {
 		exit (1);
 	}
 
-	// read in the specified page
-	char *bits = new (std::nothrow) char[PAGE_SIZE];
-	if (bits == NULL)
-	{
-		cout << "ERROR : Not enough memory. EXIT !!!\n";
-		exit(1);
+	if (compression != COMPRESS_NONE) {
+		GetPackedPage (putItHere, whichPage);
+		return;
+	}
+
+	// a mapped page is already in memory, just parse it
+	char *mapped = MappedPage (whichPage);
+	if (mapped != NULL) {
+		putItHere->FromBinary (mapped);
+		return;
 	}
 
-	lseek (myFilDes, PAGE_SIZE * whichPage, SEEK_SET);
-	read (myFilDes, bits, PAGE_SIZE);
+	// read in the specified page, through the buffer pool
+	BufferPool *pool = BufferPool::getBufferPool();
+	PageKey key (myDev, myIno, whichPage);
+	char *bits = pool->PinPage (myFilDes, key, PageOffset (whichPage), pageSize);
 	putItHere->FromBinary (bits);
-	delete [] bits;
+	pool->UnpinPage (key, false);
 	
 }
 
 
+void File :: Prefetch (off_t whichPage) {
+
+	// this is because the first page has no data
+	whichPage++;
+
+	// silently ignore pages that are not there (yet); the pages of a
+	// compressed file are unpacked into the pool by GetPage, see IsInMemory
+	if (whichPage >= curLength || compression != COMPRESS_NONE)
+		return;
+
+	// a mapped file has no frames, just ask the kernel for the page
+	char *mapped = MappedPage (whichPage);
+	if (mapped != NULL) {
+		madvise (mapped, pageSize, MADV_WILLNEED);
+		return;
+	}
+
+	BufferPool::getBufferPool()->Prefetch (myFilDes, PageKey (myDev, myIno, whichPage),
+		PageOffset (whichPage), pageSize);
+}
+
+
+bool File :: IsInMemory (off_t whichPage) {
+
+	// this is because the first page has no data
+	whichPage++;
+
+	if (MappedPage (whichPage) != NULL)
+		return true;
+
+	// the pages of a compressed file are read in their packed size,
+	// with the kernel's own read-ahead
+	if (compression != COMPRESS_NONE)
+		return true;
+
+	return BufferPool::getBufferPool()->IsCached (PageKey (myDev, myIno, whichPage));
+}
+
+
 void File :: AddPage (Page *addMe, off_t whichPage) {
 
+	if (readOnly) {
+		cerr << "BAD: you tried to write to a file opened READ_ONLY\n";
+		exit (1);
+	}
+
 	// this is because the first page has no data
 	whichPage++;
 
-	// if we are trying to add past the end of the file, then
-	// zero all of the pages out
+	// if we are trying to add past the end of the file, the pages in
+	// between are left as holes, which read back as empty pages
 	if (whichPage >= curLength) {
-		
-		// do the zeroing
-		for (off_t i = curLength; i < whichPage; i++) {
-			int foo = 0;
-			lseek (myFilDes, PAGE_SIZE * i, SEEK_SET);
-			write (myFilDes, &foo, sizeof (int));
+
+		// reserve space ahead, in big steps, so that the file
+		// does not get fragmented one page at a time
+		if (compression == COMPRESS_NONE && whichPage >= allocLength) {
+			allocLength = whichPage + FILE_GROW_PAGES;
+#ifdef FALLOC_FL_KEEP_SIZE
+			// the size of the file stays as it is; file systems that can not
+			// reserve space simply find it on write
+			if (fallocate (myFilDes, FALLOC_FL_KEEP_SIZE, PageOffset (whichPage),
+					PageOffset (allocLength) - PageOffset (whichPage)) != 0 && errno != EOPNOTSUPP)
+				perror ("fallocate");
+#endif
 		}
 
 		// set the size
 		curLength = whichPage + 1;	
 	}
 
-	// now write the page
-	char *bits = new (std::nothrow) char[PAGE_SIZE];
-	if (bits == NULL)
-	{
-		cout << "ERROR : Not enough memory. EXIT !!!\n";
-		exit(1);
+	if (compression != COMPRESS_NONE) {
+		AddPackedPage (addMe, whichPage);
+		return;
 	}
 
+	// now write the page; the whole page is overwritten, so
+	// there is no need to read its old contents in
+	BufferPool *pool = BufferPool::getBufferPool();
+	PageKey key (myDev, myIno, whichPage);
+	char *bits = pool->PinPage (myFilDes, key, PageOffset (whichPage), pageSize, false);
 	addMe->ToBinary (bits);
-	lseek (myFilDes, PAGE_SIZE * whichPage, SEEK_SET);
-	write (myFilDes, bits, PAGE_SIZE);
-	delete [] bits;
+	pool->UnpinPage (key, true);
 #ifdef F_DEBUG
 	cerr << " File: curLength " << curLength << " whichPage " << whichPage << endl;
 #endif
 }
 
 
-void File :: Open (int fileLen, char *fName) {
+void File :: Open (int fileLen, char *fName, int newPageSize, int newCompression) {
+
+	if (fileLen == 0 && !IsValidPageSize (newPageSize)) {
+		cerr << "BAD! " << newPageSize << " is not a valid page size, it must be a power of 2 between "
+			 << MIN_PAGE_SIZE << " and " << PAGE_SIZE << "\n";
+		exit (1);
+	}
+	if (fileLen == 0 && newCompression != COMPRESS_NONE && newCompression != COMPRESS_LZ) {
+		cerr << "BAD! " << newCompression << " is not a page compression\n";
+		exit (1);
+	}
 
 	// figure out the flags for the system open call
         int mode;
         if (fileLen == 0)
                 mode = O_TRUNC | O_RDWR | O_CREAT;
+        else if (fileLen == READ_ONLY)
+                mode = O_RDONLY;
         else
                 mode = O_RDWR;
+        readOnly = (fileLen == READ_ONLY);
+#ifdef USE_O_DIRECT
+        if (!readOnly)
+                mode |= O_DIRECT;
+#endif
 
 	// actually do the open
         myFilDes = open (fName, mode, S_IRUSR | S_IWUSR);
@@ -249,15 +418,92 @@ void File :: Open (int fileLen, char *fName) {
 		exit (1);
 	}
 
-	// read in the buffer if needed
+	// remember who we are, so our pages can be found in the buffer pool
+	struct stat fileStat;
+	fstat (myFilDes, &fileStat);
+	myDev = fileStat.st_dev;
+	myIno = fileStat.st_ino;
+
+	// a truncated file has no valid pages, whatever is cached
+	// (eg from a deleted file that used the same inode) is garbage
+	if (fileLen == 0)
+		BufferPool::getBufferPool()->DiscardFile (myDev, myIno);
+
+	// read in the header if needed
+	curLength = 0;
+	pageSize = newPageSize;
+	compression = newCompression;
+	off_t extentsOffset = 0;
 	if (fileLen != 0) {
 
-		// read in the first few bits, which is the page size
-		lseek (myFilDes, 0, SEEK_SET);
-		read (myFilDes, &curLength, sizeof (off_t));
+		// aligned for O_DIRECT; kept off the heap, as a 4K block coming and
+		// going there upsets malloc's handling of the PAGE_SIZE buffers
+		char header[FILE_HEADER_SIZE] __attribute__ ((aligned (IO_ALIGNMENT)));
+		size_t nRead = ReadAt (myFilDes, header, FILE_HEADER_SIZE, 0);
+
+		// a file that was never closed has no header yet, it is empty
+		if (nRead >= sizeof (FileHeader)) {
+			FileHeader *fh = (FileHeader *) header;
+			if (strncmp (fh->magic, FILE_MAGIC, sizeof (fh->magic)) != 0 || fh->version != FILE_VERSION) {
+				cerr << "BAD! " << fName << " is not a data file, or was written by an older version\n";
+				exit (1);
+			}
+			curLength = fh->length;
+			pageSize = (fh->pageSize == 0) ? PAGE_SIZE : fh->pageSize;
+			if (!IsValidPageSize (pageSize)) {
+				cerr << "BAD! " << fName << " has an invalid page size " << pageSize << "\n";
+				exit (1);
+			}
+			compression = fh->compression;
+			extentsOffset = fh->extentsOffset;
+		} else {
+			compression = COMPRESS_NONE;
+		}
+	}
+	allocLength = curLength;
+
+	// the extents of a compressed file; it is read and written
+	// in odd sizes, which O_DIRECT does not take
+	extents.clear ();
+	freeExtents.clear ();
+	dataEnd = FILE_HEADER_SIZE;
+	if (compression != COMPRESS_NONE) {
+#ifdef USE_O_DIRECT
+		fcntl (myFilDes, F_SETFL, fcntl (myFilDes, F_GETFL) & ~O_DIRECT);
+#endif
+		if (packBuf == NULL) {
+			packBuf = new (std::nothrow) char[2 * sizeof (int) + LZCodec::MaxPackedSize (PAGE_SIZE)];
+			rawBuf = new (std::nothrow) char[PAGE_SIZE];
+			if (packBuf == NULL || rawBuf == NULL) {
+				cout << "ERROR : Not enough memory. EXIT !!!\n";
+				exit (1);
+			}
+		}
+		if (curLength > 0) {
+			ReadExtents (extentsOffset);
+			dataEnd = extentsOffset;
+			FindFreeExtents ();
+		}
+	}
 
-	} else {
-		curLength = 0;
+	// map a read only file; if that does not work we simply
+	// fall back on reading it through the buffer pool
+	if (readOnly && curLength > 1) {
+
+		// pages still dirty in the pool would not be seen through the map
+		BufferPool::getBufferPool()->FlushFile (myDev, myIno);
+
+		myMapLen = (compression != COMPRESS_NONE) ? dataEnd : PageOffset (curLength);
+		if (myMapLen > (size_t) fileStat.st_size)
+			myMapLen = fileStat.st_size;
+
+		void *map = (myMapLen > 0) ? mmap (NULL, myMapLen, PROT_READ, MAP_SHARED, myFilDes, 0) : MAP_FAILED;
+		if (map == MAP_FAILED) {
+			myMap = NULL;
+			myMapLen = 0;
+		} else {
+			myMap = (char *) map;
+		}
 	}
 
 }
@@ -270,12 +516,52 @@ off_t File :: GetLength () {
 
 int File :: Close () {
 
-	// write out the current length in pages
-	lseek (myFilDes, 0, SEEK_SET);
-	write (myFilDes, &curLength, sizeof (off_t));
+	// already closed (eg BigQ closes its run file twice)
+	if (myFilDes < 0)
+		return curLength;
+
+	// nothing to write back for a read only file
+	if (readOnly) {
+		Unmap ();
+		close (myFilDes);
+		myFilDes = -1;
+		return curLength;
+	}
+
+	// push our dirty pages out of the buffer pool
+	BufferPool::getBufferPool()->FlushFile (myDev, myIno);
+
+	// write out the header with the current length in pages
+	char header[FILE_HEADER_SIZE] __attribute__ ((aligned (IO_ALIGNMENT)));
+	memset (header, 0, FILE_HEADER_SIZE);
+	FileHeader *fh = (FileHeader *) header;
+	strncpy (fh->magic, FILE_MAGIC, sizeof (fh->magic));
+	fh->version = FILE_VERSION;
+	fh->pageSize = pageSize;
+	fh->length = curLength;
+	fh->compression = compression;
+
+	// the extents of a compressed file go right after its last page
+	if (compression != COMPRESS_NONE) {
+		extents.resize (curLength);
+		if (curLength > 0)
+			WriteAt (myFilDes, (char *) &extents[0], curLength * sizeof (PageExtent), dataEnd);
+		fh->extentsOffset = dataEnd;
+	}
+	WriteAt (myFilDes, header, FILE_HEADER_SIZE, 0);
+
+	// drop the extents written the last time, a compressed file may have
+	// shrunk since; the space reserved past the end of an uncompressed one
+	// is given back by a truncate to its own size
+	if (compression != COMPRESS_NONE)
+		ftruncate (myFilDes, dataEnd + curLength * sizeof (PageExtent));
+	else if (allocLength > curLength)
+		ftruncate (myFilDes, curLength > 0 ? PageOffset (curLength) : FILE_HEADER_SIZE);
+	allocLength = curLength;
 
 	// close the file
 	close (myFilDes);
+	myFilDes = -1;
 
 	// and return the size
 	return curLength;
@@ -283,3 +569,185 @@ int File :: Close () {
 }
 
 
+
+
+void File :: ReadExtents (off_t offset) {
+
+	extents.resize (curLength);
+	size_t nBytes = curLength * sizeof (PageExtent);
+	if (ReadAt (myFilDes, (char *) &extents[0], nBytes, offset) != nBytes) {
+		cerr << "BAD! the page extents of a compressed file are cut short\n";
+		exit (1);
+	}
+}
+
+
+static bool ExtentBefore (const PageExtent &a, const PageExtent &b) {
+	return a.offset < b.offset;
+}
+
+
+void File :: FindFreeExtents () {
+
+	vector <PageExtent> used;
+	for (size_t i = 0; i < extents.size (); i++)
+		if (extents[i].offset != 0)
+			used.push_back (extents[i]);
+	sort (used.begin (), used.end (), ExtentBefore);
+
+	// what no page takes between the header and dataEnd
+	off_t end = FILE_HEADER_SIZE;
+	for (size_t i = 0; i < used.size (); i++) {
+		if (used[i].offset > end) {
+			PageExtent gap = {end, 0, (int) (used[i].offset - end)};
+			freeExtents.push_back (gap);
+		}
+		end = max (end, used[i].offset + used[i].room);
+	}
+	if (dataEnd > end)
+		dataEnd = end;
+}
+
+
+off_t File :: TakeExtent (int room) {
+
+	// the first gap that can take it, what is left of it stays free
+	for (size_t i = 0; i < freeExtents.size (); i++) {
+		if (freeExtents[i].room >= room) {
+			off_t offset = freeExtents[i].offset;
+			freeExtents[i].offset += room;
+			freeExtents[i].room -= room;
+			if (freeExtents[i].room == 0)
+				freeExtents.erase (freeExtents.begin () + i);
+			return offset;
+		}
+	}
+
+	off_t offset = dataEnd;
+	dataEnd += room;
+	return offset;
+}
+
+
+void File :: FreeExtent (off_t offset, int room) {
+
+	if (offset + room != dataEnd) {
+		PageExtent gap = {offset, 0, room};
+		freeExtents.push_back (gap);
+		return;
+	}
+
+	// the space at the end shrinks, and takes the gaps right before it
+	dataEnd = offset;
+	bool bFound = true;
+	while (bFound) {
+		bFound = false;
+		for (size_t i = 0; i < freeExtents.size (); i++) {
+			if (freeExtents[i].offset + freeExtents[i].room == dataEnd) {
+				dataEnd = freeExtents[i].offset;
+				freeExtents.erase (freeExtents.begin () + i);
+				bFound = true;
+				break;
+			}
+		}
+	}
+}
+
+
+void File :: UnpackPage (PageExtent &ext, off_t whichPage, char *putItHere) {
+
+	char *bits = packBuf;
+	if (myMap != NULL && ext.offset + ext.length <= (off_t) myMapLen)
+		bits = myMap + ext.offset;
+	else if (ReadAt (myFilDes, packBuf, ext.length, ext.offset) != (size_t) ext.length) {
+		cerr << "BAD: page " << whichPage << " of a compressed file is cut short\n";
+		exit (1);
+	}
+
+	// the raw size of the page and how it was packed, then the page
+	int rawSize = ((int *) bits)[0];
+	char *data = bits + 2 * sizeof (int);
+	if (((int *) bits)[1] == COMPRESS_NONE) {
+		memcpy (putItHere, data, rawSize);
+		return;
+	}
+
+	if (LZCodec::Unpack (data, ext.length - 2 * sizeof (int), putItHere, pageSize) != rawSize) {
+		cerr << "BAD: page " << whichPage << " of a compressed file does not unpack\n";
+		exit (1);
+	}
+}
+
+
+void File :: GetPackedPage (Page *putItHere, off_t whichPage) {
+
+	// a page that was never written is empty
+	PageExtent &ext = extents[whichPage];
+	if (ext.offset == 0) {
+		putItHere->EmptyItOut ();
+		return;
+	}
+
+	// the page is unpacked once, into the buffer pool
+	BufferPool *pool = BufferPool::getBufferPool();
+	PageKey key (myDev, myIno, whichPage);
+	bool bFill;
+	char *bits = pool->PinDecodedPage (key, pageSize, bFill);
+	if (bFill) {
+		UnpackPage (ext, whichPage, bits);
+		pool->FilledPage (key);
+	}
+	putItHere->FromBinary (bits);
+	pool->UnpinPage (key, false);
+}
+
+
+void File :: AddPackedPage (Page *addMe, off_t whichPage) {
+
+	int rawSize = addMe->GetBinarySize ();
+	addMe->ToBinary (rawBuf);
+
+	// a page that does not pack is kept as it is
+	int *head = (int *) packBuf;
+	char *data = packBuf + 2 * sizeof (int);
+	int packed = LZCodec::Pack (rawBuf, rawSize, data);
+	if (packed + MIN_COMPRESSION_GAIN > rawSize) {
+		memcpy (data, rawBuf, rawSize);
+		packed = rawSize;
+		head[1] = COMPRESS_NONE;
+	} else {
+		head[1] = compression;
+	}
+	head[0] = rawSize;
+
+	// pages start 8 bytes aligned, so that their ints and doubles are
+	int length = 2 * sizeof (int) + packed;
+	int room = (length + 7) & ~7;
+
+	if (whichPage >= (off_t) extents.size ())
+		extents.resize (whichPage + 1);
+	PageExtent &ext = extents[whichPage];
+	if (ext.offset != 0 && length > ext.room && ext.offset + ext.room == dataEnd) {
+		// the last page grows where it is
+		dataEnd += room - ext.room;
+		ext.room = room;
+	} else if (ext.offset == 0 || length > ext.room) {
+		if (ext.offset != 0)
+			FreeExtent (ext.offset, ext.room);
+		ext.offset = TakeExtent (room);
+		ext.room = room;
+	}
+	ext.length = length;
+
+	WriteAt (myFilDes, packBuf, length, ext.offset);
+
+	// readers find the page unpacked in the pool
+	BufferPool *pool = BufferPool::getBufferPool();
+	PageKey key (myDev, myIno, whichPage);
+	bool bFill;
+	char *bits = pool->PinDecodedPage (key, pageSize, bFill);
+	memcpy (bits, rawBuf, rawSize);
+	if (bFill)
+		pool->FilledPage (key);
+	pool->UnpinPage (key, false);
+}
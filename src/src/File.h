@@ -1,7 +1,8 @@
 #ifndef FILE_H
 #define FILE_H
 
-#include "TwoWayList.h"
+#include <sys/types.h>
+#include <vector>
 #include "Record.h"
 #include "Schema.h"
 #include "Comparison.h"
@@ -13,10 +14,20 @@ using namespace std;
 
 class Page {
 private:
-	TwoWayList <Record> *myRecs;
-	
+	// the page is kept in its binary form: the record count, followed by
+	// the records back to back. slots is the in-memory slot directory that
+	// gives the byte offset of every record inside myBits
+	char *myBits;
+	vector <int> slots;
+
 	int numRecs;
-	int curSizeInBytes;
+	int firstRec;		// slot of the record GetFirst hands out next
+	int endOfRecs;		// first unused byte of myBits
+	int curSizeInBytes;	// bytes taken by the records not yet handed out
+	int pageSize;		// how many bytes the records may take, <= PAGE_SIZE
+
+	// move the records not yet handed out to the front of the page
+	void Compact ();
 
 public:
 	// constructor
@@ -31,9 +42,21 @@ public:
 	void FromBinary (char *bits);
 
 	// the deletes the first record from a page and returns it; returns
-	// a zero if there were no records on the page
+	// a zero if there were no records on the page. firstOne does not get
+	// a copy of the record, it is a view on the page's own buffer that stays
+	// valid until the page is refilled, emptied or appended to; it is copied
+	// out only if it is consumed (eg inserted in a Pipe) or Copy'ed
 	int GetFirst (Record *firstOne);
 
+	// number of records on the page that GetFirst has not handed out yet
+	int GetNumRecs ();
+
+	// gives a view on the which-th of those records (0 is the one GetFirst
+	// would hand out next) without taking it off the page, so that a page
+	// of sorted records can be binary searched; returns a zero if there
+	// is no such record
+	int GetRecord (int which, Record *putItHere);
+
 	// this appends the record to the end of a page.  The return value
 	// is a one on success and a aero if there is no more space
 	// note that the record is consumed so it will have no value after
@@ -42,6 +65,22 @@ public:
 	// empty it out
 	void EmptyItOut ();
 
+	// number of bytes ToBinary writes
+	int GetBinarySize ();
+
+	// page size of the file this page goes to (PAGE_SIZE by default);
+	// Append refuses records that would make the page bigger than this
+	void SetPageSize (int size) { pageSize = size; }
+	int GetPageSize () { return pageSize; }
+
+};
+
+
+// where a page of a compressed file is, see File
+struct PageExtent {
+	off_t offset;	// 0 for a page never written
+	int length;		// bytes it takes now
+	int room;		// bytes it can take without moving
 };
 
 
@@ -50,6 +89,51 @@ private:
 
 	int myFilDes;
 	off_t curLength; 
+	off_t allocLength;	// pages reserved on disk, grows by FILE_GROW_PAGES
+	int pageSize;		// bytes per page of this file, stored in the header
+
+	// identity of the open file, used to key its pages in the BufferPool
+	dev_t myDev;
+	ino_t myIno;
+
+	// a READ_ONLY file is mapped in memory; its pages are copied straight
+	// out of the mapping, without a read () or a trip through the BufferPool
+	bool readOnly;
+	char *myMap;
+	size_t myMapLen;
+	int myPattern;	// last AccessPattern given to madvise, -1 if none
+
+	void Unmap ();
+
+	// returns where the page lives in the mapping, NULL if it is not mapped
+	char *MappedPage (off_t whichPage);
+
+	// where page "whichPage" (>= 1) starts on disk
+	off_t PageOffset (off_t whichPage) {
+		return (off_t) FILE_HEADER_SIZE + (whichPage - 1) * pageSize;
+	}
+
+	// a compressed file keeps its pages back to back after the header,
+	// each one in its packed size; the BufferPool caches them unpacked.
+	// The extents of the pages follow the last page on disk, they are
+	// read on Open and written on Close. A page that grows is moved to
+	// free space that can take it, or to the end, unless it is the last
+	// one; the space it leaves is free. The free space is not stored, it
+	// is the gaps between the extents when the file is opened
+	int compression;		// PageCompression, stored in the header
+	vector <PageExtent> extents;	// indexed by page, like curLength
+	vector <PageExtent> freeExtents;	// offset and room of the gaps
+	off_t dataEnd;			// where the free space at the end starts
+	char *packBuf;			// a page as it is on disk
+	char *rawBuf;			// ... and as Page::ToBinary writes it
+
+	void ReadExtents (off_t offset);
+	void FindFreeExtents ();
+	off_t TakeExtent (int room);
+	void FreeExtent (off_t offset, int room);
+	void UnpackPage (PageExtent &ext, off_t whichPage, char *putItHere);
+	void GetPackedPage (Page *putItHere, off_t whichPage);
+	void AddPackedPage (Page *addMe, off_t whichPage);
 
 public:
 
@@ -63,15 +147,44 @@ public:
 	// create the file.  If the parameter is zero, a new file is created
 	// the file; if notNew is zero, then the file is created and any other
 	// file located at that location is erased.  Otherwise, the file is
-	// simply opened
-	void Open (int length, char *fName);
-
-	// allows someone to explicitly get a specified page from the file
+	// simply opened. If the parameter is READ_ONLY the file is opened for
+	// reading only, and mapped in memory.
+	// On disk the file starts with a FILE_HEADER_SIZE header holding its
+	// length, page size and compression, data pages follow it.
+	// newPageSize and newCompression are for a newly created file; an
+	// existing file keeps its own
+	void Open (int length, char *fName, int newPageSize = PAGE_SIZE,
+			   int newCompression = COMPRESS_NONE);
+
+	// returns the page size of the file, in bytes
+	int GetPageSize ();
+
+	// returns the PageCompression of the file
+	int GetCompression ();
+
+	// true if a file can be created with this page size
+	static bool IsValidPageSize (int size);
+
+	// tells the kernel how a READ_ONLY file is about to be read: scans want
+	// read-ahead, binary searches do not. No-op if the file is not mapped
+	void SetAccessPattern (AccessPattern pattern);
+
+	// allows someone to explicitly get a specified page from the file;
+	// pages are served from the process-wide BufferPool when cached
 	void GetPage (Page *putItHere, off_t whichPage);
 
+	// starts bringing the specified page into memory, so that a later
+	// GetPage does not have to wait for the disk. Called by ReadAhead
+	void Prefetch (off_t whichPage);
+
+	// tells whether GetPage can serve the page without going to disk;
+	// always true for a mapped file, the kernel does its read-ahead
+	bool IsInMemory (off_t whichPage);
+
 	// allows someone to explicitly write a specified page to the file
 	// if the write is past the end of the file, all of the new pages that
-	// are before the page to be written are zeroed out
+	// are before the page to be written are zeroed out. The page is written
+	// into the BufferPool and goes to disk on eviction or on Close ()
 	void AddPage (Page *addMe, off_t whichPage);
 
 	// closes the file and returns the file length (in number of pages)
@@ -1,14 +1,21 @@
+#include <algorithm>
 #include "FileUtil.h"
 
-FileUtil::FileUtil(): m_sFilePath(), m_pPage(NULL), m_nTotalPages(0),
+FileUtil::FileUtil(): m_sFilePath(), m_pPage(NULL), m_pRidPage(NULL), m_nRidPage(-1),
+                      m_pPageFilter(NULL), m_nLastPage(-1), m_pDicts(NULL), m_pLayout(NULL), m_nDecodedUsed(0), m_nTotalPages(0),
    				      m_bDirtyPageExists(false), m_nCurrPage(0),
-					  m_bFileIsOpen(false)
+					  m_bFileIsOpen(false), m_bReadOnly(false)
 {
 	m_pFile = new File();
+	m_pReadAhead = new ReadAhead(m_pFile);
 }
 
 FileUtil::~FileUtil()
 {
+	// stop prefetching before the File goes away
+	delete m_pReadAhead;
+	m_pReadAhead = NULL;
+
 	// delete member File pointer
 	if (m_pFile)
 	{
@@ -22,9 +29,12 @@ FileUtil::~FileUtil()
 		delete m_pPage;
 		m_pPage = NULL;
 	}
+
+	delete m_pRidPage;
+	m_pRidPage = NULL;
 }
 
-int FileUtil::Create(char *f_path)
+int FileUtil::Create(char *f_path, int pageSize, int compression)
 {
 	// saving file path (name)
 	m_sFilePath = f_path;
@@ -32,15 +42,19 @@ int FileUtil::Create(char *f_path)
 	// open a new file. If file with same name already exists
 	// it is wiped clean
 	if (m_pFile)
-		m_pFile->Open(TRUNCATE, f_path);
+		m_pFile->Open(TRUNCATE, f_path, pageSize, compression);
 
-    m_pPage = new Page();
+    if(!m_pPage)
+        m_pPage = new Page();
+    m_pPage->EmptyItOut();
+    m_pPage->SetPageSize(pageSize);
     m_nTotalPages = 0;
+    m_nRidPage = -1;
 
 	m_bFileIsOpen = true;
 }
 
-int FileUtil::Open(char *fname)
+int FileUtil::Open(char *fname, FileOpenMode mode)
 {
 	EventLogger *el = EventLogger::getEventLogger();
 
@@ -62,20 +76,23 @@ int FileUtil::Open(char *fname)
 
         //set file name to current file
         m_sFilePath = fname;
+        m_nRidPage = -1;
 	// open file in append mode, preserving all prev content
 	if (m_pFile)
 	{
-		m_pFile->Open(APPEND, const_cast<char*>(fname));
-        //mode is passed by subclass. Possibilites are - 0 = TRUNCATE, 1= APPEND
+		m_bReadOnly = (mode == READ_ONLY);
+		m_pFile->Open(m_bReadOnly ? READ_ONLY : APPEND, const_cast<char*>(fname));
+        //mode is passed by subclass. Possibilites are - 0 = TRUNCATE, 1= APPEND, 2 = READ_ONLY
         m_nTotalPages = m_pFile->GetLength() - 2;   //get total number of pages which are in the file
         //as File class returns length 0 if no data is written and at least 2 even if 1 byte is written
 
         if(!m_pPage)
         	m_pPage = new Page();
-        if(m_nTotalPages >= 0)
-        	m_pFile->GetPage(m_pPage, m_nTotalPages);   //fetch last page from file on disk
-        else
+        m_pPage->SetPageSize(m_pFile->GetPageSize());   //pages are filled up to the file's page size
+        if(m_nTotalPages < 0)
         	m_nTotalPages = 0;
+        else if(!m_bReadOnly)   // a reader never appends, so it does not need the last page
+        	m_pFile->GetPage(m_pPage, m_nTotalPages);   //fetch last page from file on disk
 
 		m_bFileIsOpen = true;
 	}
@@ -89,6 +106,7 @@ int FileUtil::Close()
     //check if the current file instance has any dirty page,
     //if yes, flush it to disk and close the file.
     WritePageToFile();  //takes care of everything
+    m_pReadAhead->Stop();
     m_pFile->Close();
 	m_bFileIsOpen = false;
     return RET_SUCCESS; // If control came here, return success
@@ -102,10 +120,33 @@ void FileUtil::Add (Record &rec, bool bstartFromNewPage)
 		el->writeLog("FileUtil::Add --> File is not open for adding records\n");
 		exit(0);
 	}
+	if (m_bReadOnly)
+	{
+		el->writeLog("FileUtil::Add --> File " + m_sFilePath + " is open READ_ONLY\n");
+		exit(0);
+	}
 
-    // Consume the record
-    Record aRecord;
-    aRecord.Consume(&rec);
+    // the record is appended as it is, a view included: Page::Append
+    // copies its bits and consumes it. Only a view that Recode could
+    // rewrite under us is copied first
+    Record ownedRecord;
+    Record *pRecord = &rec;
+    if (m_pDicts && rec.IsView())
+    {
+        ownedRecord.Consume(&rec);
+        pRecord = &ownedRecord;
+    }
+    Record &aRecord = *pRecord;
+
+    // a value the dictionaries do not have changes the codes
+    if (m_pDicts && !m_pDicts->Encode(aRecord))
+    {
+        m_pDicts->Learn(aRecord);
+        Recode();
+        m_pDicts->Encode(aRecord);
+    }
+    if (m_pLayout)
+        m_pLayout->Encode(aRecord);
 
     /* Logic:
      * Try adding the record to the current page
@@ -138,17 +179,110 @@ void FileUtil::Add (Record &rec, bool bstartFromNewPage)
 	   	m_bDirtyPageExists = true;
 }
 
+int FileUtil::AddPage (Page &addMe)
+{
+    EventLogger *el = EventLogger::getEventLogger();
+	if (!m_bFileIsOpen)
+	{
+		el->writeLog("FileUtil::AddPage --> File is not open for adding records\n");
+		exit(0);
+	}
+	if (m_bReadOnly)
+	{
+		el->writeLog("FileUtil::AddPage --> File " + m_sFilePath + " is open READ_ONLY\n");
+		exit(0);
+	}
+
+    if (m_bDirtyPageExists)
+        WritePageToFile();
+    else if (m_pPage->GetNumRecs() > 0)
+    {
+        // the last page of the file, read by Open, stays as it is
+        m_pPage->EmptyItOut();
+        m_nTotalPages++;
+    }
+
+    if (m_nTotalPages == m_nRidPage)
+        m_nRidPage = -1;
+    m_pFile->AddPage(&addMe, m_nTotalPages);
+    return m_nTotalPages++;
+}
+
 void FileUtil::MoveFirst ()
 {
+    // the records added last are in m_pPage, which the scan reuses
+    WritePageToFile();
+
     // Reset current page and record pointers
     m_nCurrPage = 0;
     m_pPage->EmptyItOut();
+    m_pReadAhead->Reset();
+    m_pPageFilter = NULL;
+    m_nLastPage = -1;
+}
+
+bool FileUtil::SkipFilteredPages()
+{
+	if (m_pPageFilter)
+	{
+		while (m_nCurrPage < GetScanEnd() && m_nCurrPage < m_pPageFilter->size() &&
+			   !(*m_pPageFilter)[m_nCurrPage])
+			m_nCurrPage++;
+	}
+	return m_nCurrPage < GetScanEnd();
 }
 
 // Function to fetch the next record in the file in "fetchme"
-// from the page m_pPage. It also updates the variable m_nCurrPage
 // Returns 0 on failure
 int FileUtil::GetNext (Record &fetchme)
+{
+	if (!IsEncoded())
+		return GetNextStored(fetchme);
+
+	Record stored;
+	int ret = GetNextStored(stored);
+	if (ret == RET_SUCCESS)
+		Decode(stored, fetchme);
+	return ret;
+}
+
+void FileUtil::Decode (Record &stored, Record &rec)
+{
+	int nGrowth = m_pDicts ? m_pDicts->GetMaxGrowth() : m_pLayout->GetMaxGrowth();
+	int nMax = ((int *) stored.bits)[0] + nGrowth;
+	if (m_nDecodedUsed + nMax > m_vDecoded.size())
+	{
+		DecodeCopy(stored, rec);
+		return;
+	}
+	char *dst = &m_vDecoded[m_nDecodedUsed];
+	int len = m_pDicts ? m_pDicts->Decode(stored, dst, rec) : m_pLayout->Decode(stored, dst, rec);
+	m_nDecodedUsed += (len + 7) & ~7;	// the next one double aligned
+}
+
+void FileUtil::DecodeCopy (Record &stored, Record &rec)
+{
+	if (m_pDicts)
+		m_pDicts->Decode(stored, rec);
+	else
+		m_pLayout->Decode(stored, rec);
+}
+
+void FileUtil::StartDecodedPage ()
+{
+	m_nDecodedUsed = 0;
+	if (!IsEncoded())
+		return;
+	int nGrowth = m_pDicts ? m_pDicts->GetMaxGrowth() : m_pLayout->GetMaxGrowth();
+	int nBytes = m_pFile->GetPageSize() + m_pPage->GetNumRecs() * (nGrowth + 8);
+	if (m_vDecoded.size() < nBytes)
+		m_vDecoded.resize(nBytes);
+}
+
+// Function to fetch the next stored record in the file in "fetchme"
+// from the page m_pPage. It also updates the variable m_nCurrPage
+// Returns 0 on failure
+int FileUtil::GetNextStored (Record &fetchme)
 {
 	EventLogger *el = EventLogger::getEventLogger();
 
@@ -162,7 +296,16 @@ int FileUtil::GetNext (Record &fetchme)
 	// Refer to File :: GetPage (File.cc line 168)
 	if (m_nCurrPage == 0)
 	{
-		m_pFile->GetPage(m_pPage, m_nCurrPage++);
+		// a scan from the start, let the kernel read ahead
+		m_pFile->SetAccessPattern(SEQUENTIAL_ACCESS);
+		if (!SkipFilteredPages())
+			return RET_FAILURE;
+		// read-ahead would bring in the pages the filter leaves out
+		if (m_pPageFilter)
+			m_pFile->GetPage(m_pPage, m_nCurrPage++);
+		else
+			GetPage(m_pPage, m_nCurrPage++, GetScanEnd() - 1);
+		StartDecodedPage();
 	}
 
 	// Try to fetch the first record from current_page
@@ -173,11 +316,15 @@ int FileUtil::GetNext (Record &fetchme)
 		// Check if pages are still left in the file
 		// Note: first page in File doesn't store the data
 		// So if GetFileLength() returns 2 pages, data is actually stored in only one page
-		if (m_nCurrPage < GetFileLength() - 1)	
+		if (SkipFilteredPages())
 		{											
 			// page ran out of records, so empty it and fetch next page
 			m_pPage->EmptyItOut();
-			m_pFile->GetPage(m_pPage, m_nCurrPage++);
+			if (m_pPageFilter)
+				m_pFile->GetPage(m_pPage, m_nCurrPage++);
+			else
+				GetPage(m_pPage, m_nCurrPage++, GetScanEnd() - 1);
+			StartDecodedPage();
 			ret = m_pPage->GetFirst(&fetchme);
 			if (!ret) // failed to fetch next record
 			{
@@ -222,12 +369,89 @@ int FileUtil::GetNext (Record &fetchme, bool searchInCurrentPage)
 
     // Try to fetch the first record from current_page
     // This function will delete this record from the page
-    int ret = m_pPage->GetFirst(&fetchme);
-    if (!ret)
+    if (!IsEncoded())
+        return m_pPage->GetFirst(&fetchme) ? RET_SUCCESS : RET_FAILURE;
+
+    Record stored;
+    if (!m_pPage->GetFirst(&stored))
 		return RET_FAILURE;
-	else
+	DecodeCopy(stored, fetchme);
+	return RET_SUCCESS;
+
+}
+
+int FileUtil::GetRecord (int nPage, int nSlot, Record &fetchme)
+{
+	Record view;
+
+	// the record may still be in the page being filled by Add
+	if (m_bDirtyPageExists && nPage == m_nTotalPages)
+	{
+		if (!m_pPage->GetRecord(nSlot, &view))
+			return RET_FAILURE;
+		if (IsEncoded())
+			DecodeCopy(view, fetchme);
+		else
+			fetchme.Copy(&view);
 		return RET_SUCCESS;
+	}
+
+	if (nPage < 0 || nPage >= GetFileLength() - 1)
+		return RET_FAILURE;
 
+	if (nPage != m_nRidPage)
+	{
+		if (!m_pRidPage)
+			m_pRidPage = new Page();
+		m_pFile->GetPage(m_pRidPage, nPage);
+		m_nRidPage = nPage;
+	}
+	if (!m_pRidPage->GetRecord(nSlot, &view))
+		return RET_FAILURE;
+	if (IsEncoded())
+		DecodeCopy(view, fetchme);
+	else
+		fetchme.Copy(&view);
+	return RET_SUCCESS;
+}
+
+int FileUtil::GetLastAdded (Record &view, int &nPage, int &nSlot)
+{
+	if (!m_bDirtyPageExists)
+		return RET_FAILURE;
+
+	// WritePageToFile puts the page being filled at m_nTotalPages
+	nPage = m_nTotalPages;
+	nSlot = m_pPage->GetNumRecs() - 1;
+	if (!IsEncoded())
+		return m_pPage->GetRecord(nSlot, &view);
+
+	Record stored;
+	if (!m_pPage->GetRecord(nSlot, &stored))
+		return RET_FAILURE;
+	DecodeCopy(stored, view);
+	return RET_SUCCESS;
+}
+
+void FileUtil::Recode()
+{
+	vector< vector<int> > vRemaps;
+	if (!m_pDicts || !m_pDicts->Merge(vRemaps))
+		return;
+
+	// the pages on disk, then the one being filled; the last page on
+	// disk may be there as well, it is overwritten when it is written
+	Page page;
+	page.SetPageSize(m_pFile->GetPageSize());
+	int nPages = max(GetFileLength() - 1, 0);
+	for (int p = 0; p < nPages; p++)
+	{
+		m_pFile->GetPage(&page, p);
+		m_pDicts->Recode(page, vRemaps);
+		m_pFile->AddPage(&page, p);
+	}
+	m_pDicts->Recode(*m_pPage, vRemaps);
+	m_nRidPage = -1;
 }
 
 // Write dirty page to file
@@ -235,6 +459,8 @@ void FileUtil::WritePageToFile()
 {
     if (m_bDirtyPageExists)
     {
+        if (m_nTotalPages == m_nRidPage)
+            m_nRidPage = -1;    // GetRecord has an old copy of it
         m_pFile->AddPage(m_pPage, m_nTotalPages++);
         m_pPage->EmptyItOut();
     }
@@ -266,3 +492,50 @@ void FileUtil::SetCurrentPage(int pageNum)
 	m_pFile->GetPage(m_pPage, pageNum);
 	m_nCurrPage = pageNum+1;
 }
+
+RecordScan::RecordScan() : m_nPages(0), m_nPage(-1), m_nSlot(0)
+{}
+
+void RecordScan::Open(const string &binPath)
+{
+	m_dicts.Open(binPath);
+	m_layout.Open(binPath);
+
+	m_base.Open(READ_ONLY, const_cast<char*>(binPath.c_str()));
+	m_base.SetAccessPattern(SEQUENTIAL_ACCESS);
+	m_nPages = (m_base.GetLength() > 0) ? m_base.GetLength() - 1 : 0;
+	m_nPage = -1;
+	m_nSlot = 0;
+	m_page.EmptyItOut();
+}
+
+void RecordScan::Close()
+{
+	m_base.Close();
+}
+
+int RecordScan::GetNext(Record &rec, int &nPage, int &nSlot)
+{
+	while (m_nSlot >= m_page.GetNumRecs())
+	{
+		if (m_nPage + 1 >= m_nPages)
+			return 0;
+		m_base.GetPage(&m_page, ++m_nPage);
+		m_nSlot = 0;
+	}
+
+	nPage = m_nPage;
+	nSlot = m_nSlot;
+	m_page.GetRecord(m_nSlot++, &rec);
+	if (!m_dicts.IsEmpty())
+	{
+		m_dicts.Decode(rec, m_decoded);
+		rec.Consume(&m_decoded);
+	}
+	else if (!m_layout.IsEmpty())
+	{
+		m_layout.Decode(rec, m_decoded);
+		rec.Consume(&m_decoded);
+	}
+	return 1;
+}
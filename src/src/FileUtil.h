@@ -7,6 +7,9 @@
 #include "Defs.h"
 #include "Record.h"
 #include "File.h"
+#include "ReadAhead.h"
+#include "Dictionary.h"
+#include "RecordLayout.h"
 #include "EventLogger.h"
 
 class FileUtil
@@ -15,25 +18,64 @@ class FileUtil
         string m_sFilePath; // path of the .bin file
         File *m_pFile;      // .bin file where data will be loaded
         Page *m_pPage;
+        Page *m_pRidPage;   // page GetRecord fetched last
+        int m_nRidPage;     // its number, -1 if none
+        vector<bool> *m_pPageFilter;    // pages GetNext reads, NULL = all
+        int m_nLastPage;    // last page GetNext reads, -1 = the last one
+        ReadAhead *m_pReadAhead;    // keeps the next pages of a scan coming
+        DictionarySet *m_pDicts;    // codes of the stored records, NULL if none
+        RecordLayout *m_pLayout;    // compact format of them, NULL if none
+
+        // the records GetNext decoded from m_pPage; they are handed out as
+        // views, valid until the next page is read, as the stored ones are
+        vector<char> m_vDecoded;
+        int m_nDecodedUsed;
         int m_nTotalPages;
         bool m_bDirtyPageExists;
         int  m_nCurrPage;
 		bool m_bFileIsOpen;
+		bool m_bReadOnly;
 
         // Private member functions
         void WritePageToFile();
 
+        // makes room in m_vDecoded for the records of the page just read
+        void StartDecodedPage();
+
+        // true if the records are not stored as they are given
+        inline bool IsEncoded()
+        {
+                return m_pDicts != NULL || m_pLayout != NULL;
+        }
+
+        // the record a stored one stands for, which owns its bits
+        void DecodeCopy(Record &stored, Record &rec);
+
+        // moves m_nCurrPage past the pages the filter leaves out;
+        // returns false if no page is left to read
+        bool SkipFilteredPages();
+
+        // number of pages GetNext goes through, see SetLastPage
+        inline int GetScanEnd()
+        {
+                int nPages = GetFileLength() - 1;
+                return (m_nLastPage >= 0 && m_nLastPage < nPages) ? m_nLastPage + 1 : nPages;
+        }
+
     public:
         FileUtil();
         ~FileUtil();
 
         // name = location of the .bin file
+        // pageSize = page size of the new file, see File::IsValidPageSize
+        // compression = PageCompression of the new file
         // return value: 1 on success, 0 on failure
-        int Create (char *name);
+        int Create (char *name, int pageSize = PAGE_SIZE, int compression = COMPRESS_NONE);
 
         // This function assumes that the File already exists
         // and has previously been created and then closed.
-        int Open (char *name);
+        // mode = APPEND, or READ_ONLY for a memory mapped reader
+        int Open (char *name, FileOpenMode mode = APPEND);
 
         // Closes the file. 
         // The return value is a 1 on success and a zero on failure
@@ -46,9 +88,59 @@ class FileUtil
         // Note: addMe is consumed by this function and cannot be used again
         void Add (Record &addMe, bool startFromNewPage = false);
 
+        // Adds a page of records, as they are to be stored, after the
+        // last one; the next Add starts a new page. Returns the number of
+        // the page, as GetLastAdded gives it
+        int AddPage (Page &addMe);
+
         // Fetch next record (relative to p_currPtr) into fetchMe
         int GetNext (Record &fetchMe);
 
+        // Same, but the record is given as it is stored, with the codes
+        // of the dictionaries or in the compact format; see Decode
+        int GetNextStored (Record &fetchMe);
+
+        // Records are stored with the codes of the dictionaries, which
+        // belong to the caller: Add encodes them, the functions that fetch
+        // records decode them. NULL (the default) stores them as they are
+        inline void SetDictionaries (DictionarySet *pDicts)
+        {
+                m_pDicts = pDicts;
+        }
+
+        // Records are stored in the compact format of the layout (see
+        // RecordLayout), which belongs to the caller, as with the
+        // dictionaries; a file has one or the other
+        inline void SetLayout (RecordLayout *pLayout)
+        {
+                m_pLayout = pLayout;
+        }
+
+        // the record a stored one stands for, a view as those of GetNext
+        void Decode (Record &stored, Record &rec);
+
+        // adds the values the dictionaries learnt to them, and gives the
+        // stored records their new codes
+        void Recode ();
+
+        // Only the pages p with (*pPages)[p] true are read by GetNext (a
+        // page past the end of the vector is read), until MoveFirst or
+        // another filter is set; NULL reads every page. The vector
+        // belongs to the caller
+        inline void SetPageFilter (vector<bool> *pPages)
+        {
+                m_pPageFilter = pPages;
+        }
+
+		// Fetch a copy of the record at slot "nSlot" of page "nPage",
+		// as given by GetLastAdded; returns 0 if there is no such record
+		int GetRecord (int nPage, int nSlot, Record &fetchme);
+
+		// Gives a view on the record the last Add put in the file (a
+		// decoded copy of it, with dictionaries), and where it is going
+		// to be once its page is written out
+		int GetLastAdded (Record &view, int &nPage, int &nSlot);
+
 		// Fetch next record only in the current page
 		// return failure when page exhausts
 		int GetNext (Record &fetchme, bool searchInCurrentPage);
@@ -58,12 +150,46 @@ class FileUtil
         {
                 m_pFile->GetPage(putItHere, whichPage);
         }
+
+        // Same, for a reader going through the pages up to "lastPage" in
+        // order: the pages following "whichPage" are read ahead
+        inline void GetPage(Page *putItHere, off_t whichPage, off_t lastPage)
+        {
+                m_pFile->GetPage(putItHere, whichPage);
+                m_pReadAhead->Advance(whichPage, lastPage);
+        }
+
+        // Number of pages read ahead of a sequential reader, 0 = off
+        inline void SetReadAhead(int nPages)
+        {
+                m_pReadAhead->SetWindow(nPages);
+        }
 		
+        // GetNext reads no page after nPage (-1: up to the end of the
+        // file), and does not read ahead past it either; MoveFirst
+        // forgets it
+        inline void SetLastPage (int nPage)
+        {
+                m_nLastPage = nPage;
+        }
+
 		// Return total pages in the file
         inline int GetFileLength()
         {
             return m_pFile->GetLength();
         }
+
+        // Return the page size of the file, in bytes
+        inline int GetPageSize()
+        {
+            return m_pFile->GetPageSize();
+        }
+
+        // Return the PageCompression of the file
+        inline int GetCompression()
+        {
+            return m_pFile->GetCompression();
+        }
 		
         inline string GetBinFilePath()
         {
@@ -75,6 +201,45 @@ class FileUtil
         void RestoreFileState(Page& oldPage, int nOldPageNumber);
 
         void SetCurrentPage(int pageNum);
+
+        // the page after the one GetNext takes its records from
+        inline int GetCurrentPage()
+        {
+                return m_nCurrPage;
+        }
+
+        // madvise hint for a READ_ONLY file, see File::SetAccessPattern
+        inline void SetAccessPattern(AccessPattern pattern)
+        {
+                m_pFile->SetAccessPattern(pattern);
+        }
+};
+
+// Goes through the records of the .bin file of a table in page order,
+// with the page and slot of each, for the structures that are built from
+// the records already in the table (HashIndex, ZoneMap, BloomFilterSet).
+// The records may be stored with the codes of the table's dictionaries,
+// or in its compact format; they are handed out decoded
+class RecordScan
+{
+    private:
+        DictionarySet m_dicts;
+        RecordLayout m_layout;
+        File m_base;
+        Page m_page;
+        Record m_decoded;
+        int m_nPages;
+        int m_nPage;        // page the next record is taken from
+        int m_nSlot;        // ... and its slot
+
+    public:
+        RecordScan();
+
+        void Open(const string &binPath);
+        void Close();
+
+        // the next record and where it is stored; 0 once they are all out
+        int GetNext(Record &rec, int &nPage, int &nSlot);
 };
 
 
@@ -15,12 +15,16 @@ class GenericDBFile
         virtual ~GenericDBFile() {}
 
         // name = location of the .bin file
+        // pageSize = page size of the new file, see File::IsValidPageSize
+        // compression = PageCompression of the new file
         // return value: 1 on success, 0 on failure
-        virtual int Create (char *name, void *startup)=0;
+        virtual int Create (char *name, void *startup, int pageSize = PAGE_SIZE,
+                            int compression = COMPRESS_NONE)=0;
 
         // This function assumes that the GenericDBFile already exists
         // and has previously been created and then closed.
-        virtual int Open (char *name)=0;
+        // mode = APPEND, or READ_ONLY for a memory mapped reader
+        virtual int Open (char *name, FileOpenMode mode = APPEND)=0;
 
         // Closes the file. 
         // The return value is a 1 on success and a zero on failure
@@ -33,8 +37,8 @@ class GenericDBFile
         // Note: addMe is consumed by this function and cannot be used again
         virtual void Add (Record &addMe)=0;
 
-        // Bulk loads the DBFile instance from a text file,
-        // appending new data to it using the SuckNextRecord function from Record.h
+        // Bulk loads the DBFile instance from a text file, or an export file,
+        // appending new data to it with a BulkLoader (see BulkLoader.h)
         // loadMe is the name of the data file to bulk load.
         virtual void Load (Schema &mySchema, char *loadMe)=0;
 
@@ -43,6 +47,18 @@ class GenericDBFile
 
 		// Applies CNF and then fetches the next record
         virtual int GetNext (Record &fetchMe, CNF &applyMe, Record &literal)=0;
+
+        // Tells how the next GetNext(CNF) scan is expected to go: RANDOM_ACCESS
+        // if the predicates are selective, SEQUENTIAL_ACCESS if most of the file
+        // is going to be read. Only file types with an index make use of it
+        virtual void SetAccessPattern (AccessPattern pattern) {}
+
+        // Tells which attributes the next scans need, the others may be left
+        // zeroed in the records GetNext returns. Only column stores make use of it
+        virtual void SetProjection (int *keepMe, int numAttsToKeep) {}
+
+        // page size of the open file, in bytes
+        virtual int GetPageSize ()=0;
 };
 
 
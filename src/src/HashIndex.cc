@@ -0,0 +1,494 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include "HashIndex.h"
+
+// the index scan goes through the base file in page order
+static bool RidLess(const RecordId &a, const RecordId &b)
+{
+	return (a.page != b.page) ? (a.page < b.page) : (a.slot < b.slot);
+}
+
+HashIndex::HashIndex() : m_sFilePath(), m_sMetaSuffix(".meta.data"), m_bReadOnly(false),
+						 m_nWhichAtt(-1), m_eType(Int), m_KeyOrder(), m_nLevel(0), m_nNext(0),
+						 m_nPages(0), m_nEntries(0), m_nBytes(0)
+{
+	m_pFile = new File();
+	m_pPage = new Page();
+	m_pOutPage = new Page();
+}
+
+HashIndex::~HashIndex()
+{
+	delete m_pFile;
+	m_pFile = NULL;
+
+	delete m_pPage;
+	delete m_pOutPage;
+	m_pPage = m_pOutPage = NULL;
+}
+
+string HashIndex::GetIndexPath(const string &binPath, int whichAtt)
+{
+	stringstream ss;
+	ss << binPath << "." << whichAtt << ".idx";
+	return ss.str();
+}
+
+int HashIndex::Create(const string &binPath, int whichAtt, Type type)
+{
+	m_sFilePath = GetIndexPath(binPath, whichAtt);
+	m_nWhichAtt = whichAtt;
+	m_eType = type;
+	m_KeyOrder.numAtts = 1;
+	m_KeyOrder.whichAtts[0] = 0;
+	m_KeyOrder.whichTypes[0] = type;
+
+	m_pFile->Open(TRUNCATE, const_cast<char*>(m_sFilePath.c_str()), HASH_INDEX_PAGE_SIZE);
+	m_bReadOnly = false;
+	Reset();
+	WriteMetaData();
+	return RET_SUCCESS;
+}
+
+int HashIndex::Open(const string &binPath, int whichAtt, FileOpenMode mode)
+{
+	m_sFilePath = GetIndexPath(binPath, whichAtt);
+
+	//read metadata here
+	ifstream meta_in;
+	meta_in.open((m_sFilePath + m_sMetaSuffix).c_str());
+	if (!meta_in)
+	{
+		cout << "HashIndex::Open: File " << m_sFilePath << m_sMetaSuffix << " does not exist.\n";
+		return RET_FILE_NOT_FOUND;
+	}
+
+	string fileType;
+	string type;
+	int nBuckets, nFree;
+	meta_in >> fileType;
+	meta_in >> m_nWhichAtt >> type;
+	meta_in >> m_nLevel >> m_nNext >> m_nPages >> m_nEntries >> m_nBytes;
+	meta_in >> nBuckets;
+	m_vBuckets.resize(nBuckets);
+	for (int i = 0; i < nBuckets; i++)
+		meta_in >> m_vBuckets[i];
+	meta_in >> nFree;
+	m_vFreePages.resize(nFree);
+	for (int i = 0; i < nFree; i++)
+		meta_in >> m_vFreePages[i];
+	meta_in.close();
+
+	m_eType = TypeFromString(type);
+	m_KeyOrder.numAtts = 1;
+	m_KeyOrder.whichAtts[0] = 0;
+	m_KeyOrder.whichTypes[0] = m_eType;
+
+	m_bReadOnly = (mode == READ_ONLY);
+	m_pFile->Open(m_bReadOnly ? READ_ONLY : APPEND, const_cast<char*>(m_sFilePath.c_str()));
+	return RET_SUCCESS;
+}
+
+// returns 1 if successfully closed the file, 0 otherwise
+int HashIndex::Close()
+{
+	if (!m_bReadOnly)
+		WriteMetaData();
+	m_pFile->Close();
+	return RET_SUCCESS;
+}
+
+void HashIndex::Reset()
+{
+	m_nLevel = 0;
+	m_nNext = 0;
+	m_vBuckets.assign(HASH_INDEX_BUCKETS, -1);
+	m_vFreePages.clear();
+	m_nPages = 0;
+	m_nEntries = 0;
+	m_nBytes = 0;
+}
+
+void HashIndex::Build(const string &binPath)
+{
+	// start over from an empty file
+	m_pFile->Close();
+	m_pFile->Open(TRUNCATE, const_cast<char*>(m_sFilePath.c_str()), HASH_INDEX_PAGE_SIZE);
+	m_bReadOnly = false;
+	Reset();
+
+	RecordScan scan;
+	scan.Open(binPath);
+	Record rec;
+	int nPage, nSlot;
+	while (scan.GetNext(rec, nPage, nSlot))
+		Insert(rec, nPage, nSlot);
+	scan.Close();
+}
+
+void HashIndex::Insert(Record &rec, int nPage, int nSlot)
+{
+	if (m_bReadOnly)
+	{
+		cerr << "BAD: index " << m_sFilePath << " is open READ_ONLY\n";
+		exit(1);
+	}
+
+	Record entry;
+	MakeEntry(rec, nPage, nSlot, entry);
+	m_nBytes += ((int *) entry.bits)[0];
+	m_nEntries++;
+	AddEntry(GetBucket(Hash(rec, m_nWhichAtt)), entry);
+
+	if (m_nBytes > HASH_INDEX_FILL * m_vBuckets.size() * m_pFile->GetPageSize())
+		Split();
+}
+
+int HashIndex::Lookup(Record &literal, int whichAtt, vector<RecordId> &vRids)
+{
+	OrderMaker litOrder;
+	litOrder.numAtts = 1;
+	litOrder.whichAtts[0] = whichAtt;
+	litOrder.whichTypes[0] = m_eType;
+
+	ComparisonEngine compEngine;
+	Record entry;
+	int nFound = 0;
+	int nPage = m_vBuckets[GetBucket(Hash(literal, whichAtt))];
+	while (nPage != -1)
+	{
+		int nLink = ReadPage(*m_pPage, nPage);
+		int nRecs = m_pPage->GetNumRecs();
+		for (int i = 1; i < nRecs; i++)
+		{
+			m_pPage->GetRecord(i, &entry);
+			if (compEngine.Compare(&literal, &litOrder, &entry, &m_KeyOrder) == 0)
+			{
+				RecordId rid;
+				rid.page = entry.GetIntAtt(1);
+				rid.slot = entry.GetIntAtt(2);
+				vRids.push_back(rid);
+				nFound++;
+			}
+		}
+		nPage = nLink;
+	}
+	return nFound;
+}
+
+// FNV-1a over the bytes of the attribute; strings up to their terminator
+unsigned int HashIndex::Hash(Record &rec, int whichAtt)
+{
+	// the bloom filters hash keys the same way
+	return (unsigned int) rec.HashAtt(whichAtt, m_eType);
+}
+
+int HashIndex::GetBucket(unsigned int nHash)
+{
+	unsigned int nBuckets = HASH_INDEX_BUCKETS << m_nLevel;
+	unsigned int nBucket = nHash % nBuckets;
+	if (nBucket < (unsigned int) m_nNext)
+		nBucket = nHash % (2 * nBuckets);
+	return nBucket;
+}
+
+void HashIndex::MakeHeader(int nLink, Record &header)
+{
+	// one Int attribute
+	Record rec;
+	rec.bits = RecordMemory::Alloc(3 * sizeof(int));
+	((int *) rec.bits)[0] = 3 * sizeof(int);
+	((int *) rec.bits)[1] = 2 * sizeof(int);
+	((int *) rec.bits)[2] = nLink;
+	header.Consume(&rec);
+}
+
+void HashIndex::MakeEntry(Record &rec, int nPage, int nSlot, Record &entry)
+{
+	char *src = rec.bits;
+	int nSrcAtts = ((int *) src)[1] / sizeof(int) - 1;
+	int nStart = ((int *) src)[m_nWhichAtt + 1];
+	int nEnd = (m_nWhichAtt + 1 < nSrcAtts) ? ((int *) src)[m_nWhichAtt + 2] : ((int *) src)[0];
+
+	// the key comes right after the 4 ints of the header,
+	// which keeps a Double 8 byte aligned
+	int nKey = 4 * sizeof(int);
+	int nLength = nKey + (nEnd - nStart) + 2 * sizeof(int);
+
+	Record tmp;
+	tmp.bits = RecordMemory::Alloc(nLength);
+	((int *) tmp.bits)[0] = nLength;
+	((int *) tmp.bits)[1] = nKey;
+	((int *) tmp.bits)[2] = nKey + (nEnd - nStart);
+	((int *) tmp.bits)[3] = nKey + (nEnd - nStart) + sizeof(int);
+	memcpy(tmp.bits + nKey, src + nStart, nEnd - nStart);
+	*((int *) (tmp.bits + ((int *) tmp.bits)[2])) = nPage;
+	*((int *) (tmp.bits + ((int *) tmp.bits)[3])) = nSlot;
+	entry.Consume(&tmp);
+}
+
+int HashIndex::ReadPage(Page &page, int nPage)
+{
+	m_pFile->GetPage(&page, nPage);
+	page.SetPageSize(m_pFile->GetPageSize());
+
+	Record header;
+	if (!page.GetRecord(0, &header))
+	{
+		cerr << "BAD: page " << nPage << " of " << m_sFilePath << " is not a hash index page\n";
+		exit(1);
+	}
+	return header.GetIntAtt(0);
+}
+
+int HashIndex::NewPage()
+{
+	if (!m_vFreePages.empty())
+	{
+		int nPage = m_vFreePages.back();
+		m_vFreePages.pop_back();
+		return nPage;
+	}
+	return m_nPages++;
+}
+
+void HashIndex::AddEntry(int nBucket, Record &entry)
+{
+	int nHead = m_vBuckets[nBucket];
+	if (nHead != -1)
+	{
+		ReadPage(*m_pPage, nHead);
+		if (m_pPage->Append(&entry))
+		{
+			m_pFile->AddPage(m_pPage, nHead);
+			return;
+		}
+	}
+
+	// first page of the chain is full, put a new one in front of it
+	int nPage = NewPage();
+	Record header;
+	MakeHeader(nHead, header);
+	m_pOutPage->EmptyItOut();
+	m_pOutPage->SetPageSize(m_pFile->GetPageSize());
+	m_pOutPage->Append(&header);
+	if (!m_pOutPage->Append(&entry))
+	{
+		cerr << "BAD: key too long for index " << m_sFilePath << "\n";
+		exit(1);
+	}
+	m_pFile->AddPage(m_pOutPage, nPage);
+	m_vBuckets[nBucket] = nPage;
+}
+
+void HashIndex::Split()
+{
+	// take the entries out of the bucket, its pages can be reused
+	vector<Record*> vEntries;
+	Record view;
+	int nPage = m_vBuckets[m_nNext];
+	while (nPage != -1)
+	{
+		int nLink = ReadPage(*m_pPage, nPage);
+		int nRecs = m_pPage->GetNumRecs();
+		for (int i = 1; i < nRecs; i++)
+		{
+			m_pPage->GetRecord(i, &view);
+			Record *pEntry = new Record();
+			pEntry->Copy(&view);
+			vEntries.push_back(pEntry);
+		}
+		m_vFreePages.push_back(nPage);
+		nPage = nLink;
+	}
+	m_vBuckets[m_nNext] = -1;
+
+	// the new bucket is the image of the split one at the next level
+	m_vBuckets.push_back(-1);
+	m_nNext++;
+	if (m_nNext == (HASH_INDEX_BUCKETS << m_nLevel))
+	{
+		m_nLevel++;
+		m_nNext = 0;
+	}
+
+	// and the entries go where the next level puts them
+	for (int i = 0; i < vEntries.size(); i++)
+	{
+		AddEntry(GetBucket(Hash(*vEntries[i], 0)), *vEntries[i]);
+		delete vEntries[i];
+	}
+}
+
+// Create <index>.meta.data file
+void HashIndex::WriteMetaData()
+{
+	ofstream meta_out;
+	meta_out.open((m_sFilePath + m_sMetaSuffix).c_str(), ios::trunc);
+
+	//---- <index>.meta.data file looks like this ----
+	//hash
+	//<attribute index> <type>
+	//<level> <next bucket to split> <pages> <entries> <bytes>
+	//<number of buckets>
+	//<first page of every bucket>
+	//<number of free pages>
+	//<free pages>
+
+	meta_out << "hash\n";
+	meta_out << m_nWhichAtt << " " << TypeToString(m_eType) << "\n";
+	meta_out << m_nLevel << " " << m_nNext << " " << m_nPages << " "
+			 << m_nEntries << " " << m_nBytes << "\n";
+	meta_out << m_vBuckets.size() << "\n";
+	for (int i = 0; i < m_vBuckets.size(); i++)
+		meta_out << m_vBuckets[i] << ((i % 16 == 15) ? "\n" : " ");
+	meta_out << "\n" << m_vFreePages.size() << "\n";
+	for (int i = 0; i < m_vFreePages.size(); i++)
+		meta_out << m_vFreePages[i] << ((i % 16 == 15) ? "\n" : " ");
+	meta_out << "\n";
+	meta_out.close();
+}
+
+IndexSet::IndexSet(FileUtil *pBase) : m_pBase(pBase), m_nNextRid(0)
+{}
+
+IndexSet::~IndexSet()
+{
+	Close();
+}
+
+void IndexSet::GetIndexList(const string &binPath, vector<int> &vAtts, vector<Type> &vTypes)
+{
+	ifstream meta_in;
+	meta_in.open((binPath + ".meta.data").c_str());
+	string line;
+	while (getline(meta_in, line))
+	{
+		stringstream ss(line);
+		string word, type;
+		int nAtt;
+		if (ss >> word && word.compare("index") == 0 && ss >> nAtt >> type)
+		{
+			vAtts.push_back(nAtt);
+			vTypes.push_back(TypeFromString(type));
+		}
+	}
+}
+
+void IndexSet::Rename(const string &binPath, const string &toBin, vector<int> &vAtts)
+{
+	for (int i = 0; i < vAtts.size(); i++)
+	{
+		string sFrom = HashIndex::GetIndexPath(binPath, vAtts[i]);
+		string sTo = HashIndex::GetIndexPath(toBin, vAtts[i]);
+		if (rename(sFrom.c_str(), sTo.c_str()) != 0 ||
+			rename((sFrom + ".meta.data").c_str(), (sTo + ".meta.data").c_str()) != 0)
+			perror("error in renaming an index");
+	}
+}
+
+void IndexSet::Remove(const string &binPath, vector<int> &vAtts)
+{
+	for (int i = 0; i < vAtts.size(); i++)
+	{
+		string sIndexFile = HashIndex::GetIndexPath(binPath, vAtts[i]);
+		remove(sIndexFile.c_str());
+		remove((sIndexFile + ".meta.data").c_str());
+	}
+}
+
+void IndexSet::Create(const string &binPath, vector<int> &vAtts, vector<Type> &vTypes)
+{
+	Close();
+
+	for (int i = 0; i < vAtts.size(); i++)
+	{
+		HashIndex *pIndex = new HashIndex();
+		pIndex->Create(binPath, vAtts[i], vTypes[i]);
+		m_vIndexes.push_back(pIndex);
+	}
+}
+
+void IndexSet::Open(const string &binPath, FileOpenMode mode)
+{
+	Close();
+
+	vector<int> vAtts;
+	vector<Type> vTypes;
+	GetIndexList(binPath, vAtts, vTypes);
+	for (int i = 0; i < vAtts.size(); i++)
+	{
+		HashIndex *pIndex = new HashIndex();
+		if (pIndex->Open(binPath, vAtts[i], mode) != RET_SUCCESS)
+		{
+			delete pIndex;
+			continue;
+		}
+		m_vIndexes.push_back(pIndex);
+	}
+}
+
+void IndexSet::Close()
+{
+	for (int i = 0; i < m_vIndexes.size(); i++)
+	{
+		m_vIndexes[i]->Close();
+		delete m_vIndexes[i];
+	}
+	m_vIndexes.clear();
+	m_vRids.clear();
+	m_nNextRid = 0;
+}
+
+void IndexSet::InsertLast()
+{
+	if (m_vIndexes.empty())
+		return;
+
+	Record rec;
+	int nPage, nSlot;
+	if (!m_pBase->GetLastAdded(rec, nPage, nSlot))
+		return;
+	for (int i = 0; i < m_vIndexes.size(); i++)
+		m_vIndexes[i]->Insert(rec, nPage, nSlot);
+}
+
+void IndexSet::Rebuild()
+{
+	for (int i = 0; i < m_vIndexes.size(); i++)
+		m_vIndexes[i]->Build(m_pBase->GetBinFilePath());
+}
+
+int IndexSet::StartScan(CNF &cnf, Record &literal)
+{
+	m_vRids.clear();
+	m_nNextRid = 0;
+
+	for (int i = 0; i < m_vIndexes.size(); i++)
+	{
+		int nLow, nHigh;
+		if (cnf.GetRangeBounds(m_vIndexes[i]->GetWhichAtt(), nLow, nHigh) == 2 && nLow == nHigh)
+		{
+			m_vIndexes[i]->Lookup(literal, nLow, m_vRids);
+			sort(m_vRids.begin(), m_vRids.end(), RidLess);
+			m_pBase->SetAccessPattern(RANDOM_ACCESS);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int IndexSet::GetNext(Record &fetchme, CNF &cnf, Record &literal)
+{
+	ComparisonEngine compEngine;
+	while (m_nNextRid < m_vRids.size())
+	{
+		RecordId &rid = m_vRids[m_nNextRid++];
+		if (m_pBase->GetRecord(rid.page, rid.slot, fetchme) &&
+			compEngine.Compare(&fetchme, &literal, &cnf))
+			return RET_SUCCESS;
+	}
+	return RET_FAILURE;
+}
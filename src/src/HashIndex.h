@@ -0,0 +1,163 @@
+#ifndef HASH_INDEX_H
+#define HASH_INDEX_H
+
+#include <vector>
+#include "Defs.h"
+#include "Record.h"
+#include "File.h"
+#include "Comparison.h"
+#include "FileUtil.h"
+
+// index pages are small, a bucket is read and written for every insert
+#define HASH_INDEX_PAGE_SIZE 4096
+
+// buckets of a new index
+#define HASH_INDEX_BUCKETS 4
+
+// a bucket is split once the entries take more than this
+// share of one page per bucket
+#define HASH_INDEX_FILL 0.75
+
+// position of a record in its file: data page, and slot on that page
+struct RecordId
+{
+	int page;
+	int slot;
+};
+
+// Secondary index on one attribute of a heap or sorted file: a linear hash
+// table that maps a value of the attribute to the RecordIds of the records
+// holding it.
+// Every bucket is a chain of pages of the index file, a page holds Records:
+//  - the first one is the page header, an Int: the next page of the chain,
+//    -1 for the last one
+//  - then the entries: the key attribute, followed by two Ints, the page
+//    and the slot of the record in the base file
+// New entries go into the first page of the chain, a new first page is
+// put in front of the chain when it is full.
+// The buckets, the level and the split pointer of the table are kept in
+// the <index>.meta.data file, written on Close
+class HashIndex
+{
+	private:
+		File *m_pFile;
+		string m_sFilePath;
+		string m_sMetaSuffix;
+		bool m_bReadOnly;
+
+		int m_nWhichAtt;		// attribute of the base file records
+		Type m_eType;
+		OrderMaker m_KeyOrder;	// the key inside an entry
+
+		// linear hashing state
+		int m_nLevel;			// N0 * 2^level buckets are fully split
+		int m_nNext;			// next bucket to split
+		vector<int> m_vBuckets;	// first page of every bucket, -1 if empty
+		vector<int> m_vFreePages;
+		int m_nPages;			// pages used by the file
+		int m_nEntries;
+		long m_nBytes;			// taken by the entries
+
+		Page *m_pPage;			// scratch pages
+		Page *m_pOutPage;
+
+		// Private functions
+		void WriteMetaData();
+		void Reset();
+
+		unsigned int Hash(Record &rec, int whichAtt);
+		int GetBucket(unsigned int nHash);
+
+		void MakeHeader(int nLink, Record &header);
+		void MakeEntry(Record &rec, int nPage, int nSlot, Record &entry);
+		int ReadPage(Page &page, int nPage);	// returns the link
+		int NewPage();
+
+		// puts the entry in front of the chain of the bucket
+		void AddEntry(int nBucket, Record &entry);
+
+		// splits bucket m_nNext in two
+		void Split();
+
+	public:
+		HashIndex();
+		~HashIndex();
+
+		// the index on attribute "whichAtt" of base file "binPath"
+		static string GetIndexPath(const string &binPath, int whichAtt);
+
+		// creates an empty index on attribute "whichAtt" of the base file
+		// return value: 1 on success, 0 on failure
+		int Create(const string &binPath, int whichAtt, Type type);
+
+		// mode = APPEND, or READ_ONLY for an index that is only looked up
+		int Open(const string &binPath, int whichAtt, FileOpenMode mode = APPEND);
+
+		// Closes the file, and writes the metadata
+		int Close();
+
+		// empties the index, then inserts every record of the base file
+		void Build(const string &binPath);
+
+		// adds the entry for "rec", stored at nPage, nSlot in the base file
+		void Insert(Record &rec, int nPage, int nSlot);
+
+		// appends to vRids the records whose key equals attribute
+		// "whichAtt" of the literal; returns how many were found
+		int Lookup(Record &literal, int whichAtt, vector<RecordId> &vRids);
+
+		int GetWhichAtt() { return m_nWhichAtt; }
+		Type GetType() { return m_eType; }
+		int GetNumEntries() { return m_nEntries; }
+};
+
+// The hash indexes of a heap or sorted file, listed in its .meta.data
+// with an "index <attribute> <type>" line each
+class IndexSet
+{
+	private:
+		FileUtil *m_pBase;		// the base file, owned by the caller
+		vector<HashIndex*> m_vIndexes;
+
+		// state of an index scan
+		vector<RecordId> m_vRids;
+		int m_nNextRid;
+
+	public:
+		IndexSet(FileUtil *pBase);
+		~IndexSet();
+
+		// reads the index list of the base file binPath
+		static void GetIndexList(const string &binPath, vector<int> &vAtts,
+								 vector<Type> &vTypes);
+
+		// the index files of the base file binPath on the attributes vAtts
+		// are renamed to those of toBin, or removed
+		static void Rename(const string &binPath, const string &toBin, vector<int> &vAtts);
+		static void Remove(const string &binPath, vector<int> &vAtts);
+
+		// empty indexes on the attributes vAtts of the base file binPath,
+		// which is being written; InsertLast fills them
+		void Create(const string &binPath, vector<int> &vAtts, vector<Type> &vTypes);
+
+		// opens the indexes of the base file
+		void Open(const string &binPath, FileOpenMode mode = APPEND);
+		void Close();
+
+		bool IsEmpty() { return m_vIndexes.empty(); }
+
+		// adds the record the base file got last to every index
+		void InsertLast();
+
+		// builds every index again, once the base file has been rewritten
+		void Rebuild();
+
+		// if the CNF has an equality between an indexed attribute and the
+		// literal, looks the records up and returns 1, 0 otherwise
+		int StartScan(CNF &cnf, Record &literal);
+
+		// next record of the index scan that matches the CNF
+		int GetNext(Record &fetchme, CNF &cnf, Record &literal);
+};
+
+#endif
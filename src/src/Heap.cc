@@ -1,76 +1,187 @@
+#include <algorithm>
 #include "Heap.h"
 
-Heap::Heap()
+Heap::Heap() : m_eAccess(RANDOM_ACCESS), m_bScanStarted(false), m_bIndexScan(false),
+			   m_bCodedScan(false)
 {
 	m_pFile = new FileUtil();
+	m_pIndexes = new IndexSet(m_pFile);
+	m_pZoneMap = new ZoneMap();
+	m_pBlooms = new BloomFilterSet(m_pFile);
+	m_pDicts = new DictionarySet();
+	m_pLayout = new RecordLayout();
 }
 
 Heap::~Heap()
 { 
+	delete m_pIndexes;
+	m_pIndexes = NULL;
+
+	delete m_pZoneMap;
+	m_pZoneMap = NULL;
+
+	delete m_pBlooms;
+	m_pBlooms = NULL;
+
+	delete m_pDicts;
+	m_pDicts = NULL;
+
+	delete m_pLayout;
+	m_pLayout = NULL;
+
 	delete m_pFile;
 	m_pFile = NULL;
 }
 
-int Heap::Create(char *f_path, void *sortInfo)
+int Heap::Create(char *f_path, void *sortInfo, int pageSize, int compression)
 {
     //ignore parameter sortInfo - not required for this file type
-    m_pFile->Create(f_path);
+    m_pDicts->Close();
+    m_pFile->SetDictionaries(NULL);
+    m_pLayout->Clear();
+    m_pFile->SetLayout(NULL);
+    m_pFile->Create(f_path, pageSize, compression);
+    m_pZoneMap->Clear(true);
     WriteMetaData();
 	return RET_SUCCESS;
 }
 
-int Heap::Open(char *fname)
+int Heap::Open(char *fname, FileOpenMode mode)
 {
-    return m_pFile->Open(fname);
+    int ret = m_pFile->Open(fname, mode);
+    if (ret == RET_SUCCESS)
+    {
+        m_pDicts->Open(fname);
+        m_pFile->SetDictionaries(m_pDicts->IsEmpty() ? NULL : m_pDicts);
+        m_pLayout->Open(fname);
+        m_pFile->SetLayout(m_pLayout->IsEmpty() ? NULL : m_pLayout);
+        m_pIndexes->Open(fname, mode);
+        m_pZoneMap->Read(string(fname) + ".meta.data");
+        m_pBlooms->Open(fname, mode);
+    }
+    m_bScanStarted = false;
+    m_bIndexScan = false;
+    m_bCodedScan = false;
+    return ret;
 }
 
 // returns 1 if successfully closed the file, 0 otherwise 
 int Heap::Close()
 {
-    return m_pFile->Close();
+    m_pIndexes->Close();
+    m_pBlooms->Close();
+    if (m_pZoneMap->IsDirty())
+        m_pZoneMap->Write(m_pFile->GetBinFilePath() + ".meta.data");
+    int ret = m_pFile->Close();
+    m_pFile->SetDictionaries(NULL);
+    m_pDicts->Close();
+    m_pFile->SetLayout(NULL);
+    return ret;
 }
 
-/* Load function bulk loads the Heap instance from a text file, appending
- * new data to it using the SuckNextRecord function from Record.h. The character
- * string passed to Load is the name of the data file to bulk load.
+/* Load function bulk loads the Heap instance from a text file, or from an
+ * export file, appending new data to it with a BulkLoader, which parses
+ * the file into pages. The character string passed to Load is the name of
+ * the data file to bulk load.
  */
 void Heap::Load (Schema &mySchema, char *loadMe)
 {
     EventLogger *el = EventLogger::getEventLogger();
 
-    FILE *fileToLoad = fopen(loadMe, "r");
-    if (!fileToLoad)
+    // records added before the zone maps knew the schema are not in them
+    if (m_pZoneMap->SetTypes(mySchema))
     {
-            el->writeLog("Can't open file name :" + string(loadMe));
+        Record lastRec;
+        int nPage = -1, nSlot;
+        m_pFile->GetLastAdded(lastRec, nPage, nSlot);
+        m_pZoneMap->MarkUnknown(max(m_pFile->GetFileLength(), nPage + 1));
+    }
+
+    // the dictionaries get the new values first, so that the codes
+    // of the records already stored change only once
+    if (!m_pDicts->IsEmpty())
+    {
+        ExportFile exportFile;
+        FILE *fileToLoad;
+        if (exportFile.Open(loadMe))
+        {
+            Page page;
+            Record aRecord;
+            for (long i = 0; i < exportFile.GetNumPages(); i++)
+            {
+                exportFile.GetPage(page, i);
+                while (page.GetFirst(&aRecord))
+                    m_pDicts->Learn(aRecord);
+            }
+            exportFile.Close();
+            m_pFile->Recode();
+        }
+        else if ((fileToLoad = fopen(loadMe, "r")) != NULL)
+        {
+            m_pDicts->Learn(fileToLoad);
+            fclose(fileToLoad);
+            m_pFile->Recode();
+        }
+    }
+
+    BulkLoader loader;
+    if (!loader.Open(loadMe, mySchema, m_pFile->GetPageSize()))
+    {
+        el->writeLog("Can't open file name :" + string(loadMe));
+        return;
     }
 
     /* Logic :
-     * first read the record from the file using suckNextRecord()
-     * then add this record to page using Add() function
+     * the pages of the loader go to the file as they are, unless the
+     * records have to be encoded or indexed: they are then added one by one
      */
-
+    bool bWholePages = m_pIndexes->IsEmpty() && m_pBlooms->IsEmpty() &&
+                       m_pDicts->IsEmpty() && m_pLayout->IsEmpty();
+    Page *pPage;
     Record aRecord;
-    while(aRecord.SuckNextRecord(&mySchema, fileToLoad))
-        Add(aRecord);
-
-	fclose(fileToLoad);
+    while ((pPage = loader.GetNextPage()) != NULL)
+    {
+        if (bWholePages)
+        {
+            int nPage = m_pFile->AddPage(*pPage);
+            while (pPage->GetFirst(&aRecord))
+                m_pZoneMap->Add(aRecord, nPage);
+        }
+        else
+        {
+            while (pPage->GetFirst(&aRecord))
+                Add(aRecord);
+        }
+    }
+    loader.Close();
 }
 
 void Heap::Add (Record &rec)
 {
     m_pFile->Add(rec);
+    m_pIndexes->InsertLast();
+    m_pBlooms->InsertLast();
+
+    Record lastRec;
+    int nPage, nSlot;
+    if (m_pFile->GetLastAdded(lastRec, nPage, nSlot))
+        m_pZoneMap->Add(lastRec, nPage);
 }
 
 void Heap::MoveFirst ()
 {
 	m_pFile->MoveFirst();
+	m_bScanStarted = false;
+	m_bIndexScan = false;
+	m_bCodedScan = false;
 }
 
 // Function to fetch the next record in the file in "fetchme"
 // Returns 0 on failure
 int Heap::GetNext (Record &fetchme)
 {
-	m_pFile->GetNext(fetchme);
+	m_bScanStarted = true;
+	return m_pFile->GetNext(fetchme);
 }
 
 
@@ -85,8 +196,56 @@ int Heap::GetNext (Record &fetchme, CNF &cnf, Record &literal)
 	 * satisfies CNF expression so we simple return success (=1) here
 	 */
 
+	// the index, the zone maps and the Bloom filters
+	// can only help a scan from the start
+	if (!m_bScanStarted)
+	{
+		m_bScanStarted = true;
+		m_bIndexScan = (m_eAccess == RANDOM_ACCESS && m_pIndexes->StartScan(cnf, literal));
+		if (!m_bIndexScan)
+		{
+			int nPages = max(m_pFile->GetFileLength() - 1, 0);
+			int nSkipped = m_pZoneMap->GetPagesToRead(cnf, literal, nPages, m_vPageFilter);
+			nSkipped += m_pBlooms->FilterPages(cnf, literal, m_vPageFilter);
+			if (nSkipped > 0)
+				m_pFile->SetPageFilter(&m_vPageFilter);
+			m_bCodedScan = (!m_pDicts->IsEmpty() &&
+							m_pDicts->TranslateCNF(cnf, literal, m_CodeCnf, m_CodeLiteral));
+		}
+	}
+	if (m_bIndexScan)
+		return m_pIndexes->GetNext(fetchme, cnf, literal);
+
 	ComparisonEngine compEngine;
 
+	if (m_bCodedScan)
+	{
+		Record stored;
+		while (m_pFile->GetNextStored(stored))
+		{
+			if (compEngine.Compare(&stored, &m_CodeLiteral, &m_CodeCnf))
+			{
+				m_pFile->Decode(stored, fetchme);
+				return RET_SUCCESS;
+			}
+		}
+		return RET_FAILURE;
+	}
+
+	if (!m_pLayout->IsEmpty())
+	{
+		Record stored;
+		while (m_pFile->GetNextStored(stored))
+		{
+			if (compEngine.Compare(&stored, &literal, &cnf, m_pLayout))
+			{
+				m_pFile->Decode(stored, fetchme);
+				return RET_SUCCESS;
+			}
+		}
+		return RET_FAILURE;
+	}
+
 	while (GetNext(fetchme))
 	{
 		if (compEngine.Compare(&fetchme, &literal, &cnf))
@@ -97,6 +256,11 @@ int Heap::GetNext (Record &fetchme, CNF &cnf, Record &literal)
 	return RET_FAILURE;
 }
 
+void Heap::SetAccessPattern (AccessPattern pattern)
+{
+	m_eAccess = pattern;
+}
+
 // Create <table_name>.meta.data file
 // And write total pages used for table loading in it
 void Heap::WriteMetaData()
@@ -105,7 +269,7 @@ void Heap::WriteMetaData()
    {
         ofstream meta_out;
         meta_out.open(string(m_pFile->GetBinFilePath() + ".meta.data").c_str(), ios::trunc);
-        meta_out << "heap";
+        meta_out << "heap\n";
         meta_out.close();
    }
 }
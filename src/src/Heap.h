@@ -2,11 +2,32 @@
 #define HEAP_H
 
 #include "GenericDBFile.h"
+#include "HashIndex.h"
+#include "ZoneMap.h"
+#include "BloomFilter.h"
+#include "Dictionary.h"
+#include "RecordLayout.h"
+#include "BulkLoader.h"
 
 class Heap : public GenericDBFile
 {
 	private:
 		FileUtil *m_pFile;		
+		IndexSet *m_pIndexes;	// secondary indexes, see CREATE INDEX
+		ZoneMap *m_pZoneMap;	// per page ranges, kept in the .meta.data
+		BloomFilterSet *m_pBlooms;	// per page Bloom filters, see CREATE BLOOM FILTER
+		DictionarySet *m_pDicts;	// codes of String attributes, see CREATE DICTIONARY
+		RecordLayout *m_pLayout;	// compact records, see CREATE TABLE ... COMPACT
+
+		// state of GetNext(CNF), kept until MoveFirst
+		AccessPattern m_eAccess;
+		bool m_bScanStarted;
+		bool m_bIndexScan;		// records come from an index lookup
+		vector<bool> m_vPageFilter;	// pages the zone maps let through
+		bool m_bCodedScan;		// the CNF is applied to the stored records
+		CNF m_CodeCnf;			// and is this one, with this literal
+		Record m_CodeLiteral;
+
 		void WriteMetaData();
 
 	public:
@@ -15,18 +36,18 @@ class Heap : public GenericDBFile
 
 		// name = location of the file
 		// return value: 1 on success, 0 on failure
-		int Create (char *name,  void *startup);
+		int Create (char *name,  void *startup, int pageSize = PAGE_SIZE, int compression = COMPRESS_NONE);
 
 		// This function assumes that the DBFile already exists
 		// and has previously been created and then closed.
-		int Open (char *name);
+		int Open (char *name, FileOpenMode mode = APPEND);
 
 		// Closes the file.
 		// The return value is a 1 on success and a zero on failure
 		int Close ();
 
 		// Bulk loads the DBFile instance from a text file,
-		// appending new data to it using the SuckNextRecord function from Record.h
+		// appending new data to it with a BulkLoader (see BulkLoader.h)
 		// loadMe is the name of the data file to bulk load.
 		void Load (Schema &mySchema, char *loadMe);
 
@@ -40,8 +61,20 @@ class Heap : public GenericDBFile
 		// Fetch next record (relative to p_currPtr) into fetchMe
 		int GetNext (Record &fetchMe);
 
-		// Applies CNF and then fetches the next record
+		// Applies CNF and then fetches the next record. If the scan has
+		// not started yet and the CNF has an equality on an indexed
+		// attribute, only the records the index gives are fetched;
+		// otherwise the pages the zone maps or the Bloom filters rule
+		// out are not read. With dictionaries, the CNF is turned into
+		// one on the codes, and only the records that match are decoded;
+		// so it is with compact records, to which the CNF is applied as
+		// they are
 		int GetNext (Record &fetchMe, CNF &applyMe, Record &literal);
+
+		// SEQUENTIAL_ACCESS: the predicates are not selective,
+		// GetNext(CNF) scans the file instead of using an index
+		void SetAccessPattern (AccessPattern pattern);
+		int GetPageSize () { return m_pFile->GetPageSize(); }
 };
 
 #endif
@@ -7,7 +7,8 @@ Optimizer::Optimizer() : m_pFuncOp(NULL), m_pTblList(NULL), m_pCNF(NULL),
 						 m_pGroupingAtts(NULL), m_pAttsToSelect(NULL),
 						 m_nDistinctAtts(0), m_nDistinctFunc(0),
 						 m_nNumTables(-1), m_nGlobalPipeID(0), m_pFinalNode(NULL),
-						 m_aTableNames(NULL), m_nPrintPlanOnScreen(0), m_sPrintPlanFile()
+						 m_aTableNames(NULL), m_nPrintPlanOnScreen(0), m_sPrintPlanFile(),
+						 m_bExportOutput(false)
 {}
 
 Optimizer::Optimizer(Statistics & s,
@@ -23,7 +24,8 @@ Optimizer::Optimizer(Statistics & s,
 			  m_pGroupingAtts(pGrpAtts), m_pAttsToSelect(pAttsToSelect), 
 			  m_nDistinctAtts(distinct_atts), m_nDistinctFunc(distinct_func),
 			  m_nNumTables(-1), m_nGlobalPipeID(0), m_pFinalNode(NULL), m_aTableNames(NULL), 
-			  m_nPrintPlanOnScreen(print_on_screen), m_sPrintPlanFile(sOutFile)
+			  m_nPrintPlanOnScreen(print_on_screen), m_sPrintPlanFile(sOutFile),
+			  m_bExportOutput(false)
 {
 	// Store alias in sorted fashion in m_vSortedAlias
 	// and the number of tables/alias in m_nNumTables
@@ -104,6 +106,7 @@ int Optimizer::SortAlias()
 		            cout << "\n";
             #endif
             QueryPlanNode * pNode = NULL;
+            AccessPattern eAccess = SEQUENTIAL_ACCESS;
             if (new_AndList != NULL)
             {
                 // Apply "select" CNF on it and push the result in map
@@ -112,6 +115,14 @@ int Optimizer::SortAlias()
                 vec_rels.push_back(sAlias);
                 vec_rels.push_back(m_mAliasToTable[sAlias]);
                 PopulateTableNames(vec_rels);
+
+                // a selective predicate is worth going down an index,
+                // otherwise most of the file is read anyway
+                double dTotal = (*m_Stats.GetRelStats())[sAlias].numTuples;
+                double dEstimate = m_Stats.Estimate(new_AndList, m_aTableNames, 2);
+                if (dEstimate >= 0 && (dTotal == 0 || dEstimate / dTotal <= INDEX_SELECTIVITY))
+                    eAccess = RANDOM_ACCESS;
+
                 m_Stats.Apply(new_AndList, m_aTableNames, 2);
 
                 pCNF = new CNF();
@@ -153,7 +164,9 @@ int Optimizer::SortAlias()
 			}
 
             // Now create the SelectFile Node
-       	    pNode = new Node_SelectFile(sInFile, outPipeId, pCNF, pLit);
+            vector<int> vNeededAtts;
+            GetNeededAtts(sAlias, schema_obj, vNeededAtts);
+       	    pNode = new Node_SelectFile(sInFile, outPipeId, pCNF, pLit, eAccess, vNeededAtts);
 
             // push outPipe --> combo name in the map
             m_mOutPipeToCombo[outPipeId] = sAlias;
@@ -1177,7 +1190,8 @@ void Optimizer::MakeQueryPlan()
         int in = pFinalNode->m_nOutPipe;
 		
 		// Make node for writeout
-        QueryPlanNode * pWriteOutNode = new Node_WriteOut(in, m_sPrintPlanFile, pProjSch);
+        QueryPlanNode * pWriteOutNode = new Node_WriteOut(in, m_sPrintPlanFile, pProjSch,
+														  m_bExportOutput);
 		pWriteOutNode->left = pFinalNode;    // make prev node  left child of distinct
         pFinalNode = pWriteOutNode;          // now final node is writeout (its on top!)
 
@@ -1195,6 +1209,13 @@ void Optimizer::MakeQueryPlan()
 		cout << "\nERROR! No Query Plan possible!\n\n";
 }
 
+void Optimizer::SetExportOutput(string sExportFile)
+{
+	m_nPrintPlanOnScreen = 0;
+	m_sPrintPlanFile = sExportFile;
+	m_bExportOutput = true;
+}
+
 void Optimizer::ExecuteQuery()
 {
     /* Logic:
@@ -1207,6 +1228,7 @@ void Optimizer::ExecuteQuery()
 		return;
 
 	cout << "\n\n--------------- Execution Result ---------------\n\n";
+	BigQ::ClearRunStats();
 	clock_t begin = clock();
 	m_pFinalNode->ExecutePostOrder();		
 	clock_t end = clock();
@@ -1214,7 +1236,14 @@ void Optimizer::ExecuteQuery()
 	double diffticks = end - begin;
 	double diffms = (diffticks*1000)/CLOCKS_PER_SEC;
 
-	cout << "Time elapsed: " << double(diffms/1000) << " secs \n\n\n";
+	cout << "Time elapsed: " << double(diffms/1000) << " secs \n";
+	BufferPool::getBufferPool()->PrintStats(cout);
+	ZoneMap::PrintStats(cout);
+	BloomFilterSet::PrintStats(cout);
+	RecordMemory::PrintStats(cout);
+	BigQ::PrintRunStats(cout);
+	BigQ::PrintMergePlan(cout);
+	cout << "\n\n";
 }
 
 AndList* Optimizer::GetSelectionsFromAndList(string alias)
@@ -1447,6 +1476,68 @@ void Optimizer::RemoveAliasFromColumnName(FuncOperator * func_node)
 	RemoveAliasFromColumnName(temp->right);
 }
 
+// column names used by a function, eg SUM(a.x + a.y)
+static void GetFuncNames(FuncOperator *func_node, vector<string> &vNames)
+{
+	if (func_node == NULL)
+		return;
+	if (func_node->leftOperand != NULL && func_node->leftOperand->code == NAME)
+		vNames.push_back(func_node->leftOperand->value);
+	GetFuncNames(func_node->leftOperator, vNames);
+	GetFuncNames(func_node->right, vNames);
+}
+
+// Attributes of table sAlias the query uses anywhere: in the SELECT list,
+// the function, the GROUP BY or the WHERE clause. vAtts is left empty if
+// all of them are needed.
+// Caveat: names may have lost their alias already (see RemoveAliasFromColumnName),
+// they are then looked up in the table as they are, which can only add attributes
+void Optimizer::GetNeededAtts(string sAlias, Schema &sch, vector<int> &vAtts)
+{
+	vAtts.clear();
+	if (m_pAttsToSelect == NULL && m_pFuncOp == NULL)
+		return;
+
+	vector<string> vNames;
+	for (NameList *pName = m_pAttsToSelect; pName != NULL; pName = pName->next)
+		vNames.push_back(pName->name);
+	for (NameList *pName = m_pGroupingAtts; pName != NULL; pName = pName->next)
+		vNames.push_back(pName->name);
+	GetFuncNames(m_pFuncOp, vNames);
+	for (AndList *pAnd = m_pCNF; pAnd != NULL; pAnd = pAnd->rightAnd)
+	{
+		for (OrList *pOr = pAnd->left; pOr != NULL && pOr->left != NULL; pOr = pOr->rightOr)
+		{
+			if (pOr->left->left->code == NAME)
+				vNames.push_back(pOr->left->left->value);
+			if (pOr->left->right->code == NAME)
+				vNames.push_back(pOr->left->right->value);
+		}
+	}
+
+	vector<bool> vUsed(sch.GetNumAtts(), false);
+	for (int i = 0; i < vNames.size(); i++)
+	{
+		string sName = vNames[i];
+		size_t nDot = sName.find(".");
+		if (nDot != string::npos)
+		{
+			if (sName.substr(0, nDot).compare(sAlias) != 0)
+				continue;
+			sName = sName.substr(nDot + 1);
+		}
+		int nAtt = sch.Find((char*)sName.c_str());
+		if (nAtt != -1)
+			vUsed[nAtt] = true;
+	}
+
+	for (int i = 0; i < vUsed.size(); i++)
+		if (vUsed[i])
+			vAtts.push_back(i);
+	if (vAtts.size() == vUsed.size())
+		vAtts.clear();
+}
+
 void Optimizer::FindOptimalPairing(vector<string> & vAliases, AndList* parseTree, 
 								   pair<string, string> & pair_optimal)
 {
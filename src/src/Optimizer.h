@@ -11,6 +11,9 @@
 #include "EventLogger.h"
 #include "Statistics.h"
 #include "QueryPlan.h"
+#include "BufferPool.h"
+#include "ZoneMap.h"
+#include "BloomFilter.h"
 #include "Record.h"
 #include "Schema.h"
 
@@ -32,6 +35,7 @@ private:
 	int m_nDistinctFunc; 			   // 
 	int m_nPrintPlanOnScreen;		   // 1 means print the plan on screen
 	string m_sPrintPlanFile;		   // Name of the file where plan should be printed
+	bool m_bExportOutput;			   // the file is an export file (see ExportFile)
 
 	// --------- internal members
 	int m_nNumTables, m_nGlobalPipeID;
@@ -70,6 +74,7 @@ private:
     void RemoveAliasFromColumnName(FuncOperator * func_node);
 	void ConcatSchemas(Schema *pRSch, Schema *pLSch, string sName);
 	void FindFirstAttInTable(Schema &sch, string &);
+	void GetNeededAtts(string sAlias, Schema &sch, vector<int> &vAtts);
     void FindOptimalPairing(vector<string>& vAliases,  AndList* parseTree, pair<string, string> &);
 	vector<string> PrintTableCombinations(int combo_len);
 
@@ -97,6 +102,9 @@ public:
 
 	void PrintFuncOperator();
 	void PrintTableList();
+	// the output goes to an export file instead, as CREATE TABLE AS SELECT
+	// wants it; to be called before MakeQueryPlan
+	void SetExportOutput(string sExportFile);
 	void MakeQueryPlan();
     void ExecuteQuery();
 	
@@ -26,8 +26,19 @@
 	struct AttsList *col_atts;
 	int selectFromTable;// 1 if the SQL is select from table
 	int createTable;	// 1 if the SQL is create table
-	int sortedTable;	// 0 = create table as heap, 1 = create table as sorted (use sortingAtts)
+	int sortedTable;	// 0 = create table as heap, 1 = as sorted, 2 = as B+-tree (both use sortingAtts), 3 = as PAX
+	int tablePageSize;	// page size given with PAGESIZE in create table, 0 if none
+	int tableCompressed;	// 1 if COMPRESSED is given in create table
+	int tableCompact;	// 1 if COMPACT is given in create table
 	int insertTable;	// 1 if the command is Insert into table
+	int exportTable;	// 1 if the command is Export table, to file_name
+	int importTable;	// 1 if the command is Import table, from file_name
+	int createTableAs;	// 1 if the SQL is create table as select, into table_name
+	int createIndex;	// 1 if the command is Create index
+	char *indexColumn;	// column of the table to index
+	int createBloomFilter;	// 1 if the command is Create bloom filter, on indexColumn
+	double bloomFpRate;	// false positive rate given with FPRATE, 0 if none
+	int createDictionary;	// 1 if the command is Create dictionary, on indexColumn
 	int dropTable;		// 1 is the command is Drop table
 	int printPlanOnScreen;	// 1 if true
 	int executePlan;		// 1 if true
@@ -71,9 +82,22 @@
 %token STR
 %token HEAP
 %token SORTED
+%token TREE
+%token PAX
+%token INDEX
+%token BLOOM
+%token FILTER
+%token FPRATE
+%token DICTIONARY
 %token ON
+%token PAGESIZE
+%token COMPRESSED
+%token COMPACT
 %token INSERT
 %token INTO
+%token EXPORT
+%token IMPORT
+%token TO
 %token DROP
 %token SET
 %token OUTPUT
@@ -113,6 +137,7 @@ SQL: SELECT WhatIWant FROM Tables WHERE AndList
 	groupingAtts = NULL;
 	selectFromTable = 1;
 	createTable = 0;
+	createTableAs = 0;
 	insertTable = 0;
 	dropTable = 0;
 }
@@ -124,11 +149,38 @@ SQL: SELECT WhatIWant FROM Tables WHERE AndList
 	groupingAtts = $9;
     selectFromTable = 1;
     createTable = 0;
+    createTableAs = 0;
     insertTable = 0;
     dropTable = 0;
 }
 
-| CREATE TABLE TableName '(' AttsAndType ')' AS HEAP
+| CREATE TABLE TableName AS SELECT WhatIWant FROM Tables WHERE AndList
+{
+	tables = $8;
+	boolean = $10;
+	groupingAtts = NULL;
+	selectFromTable = 1;
+	createTable = 0;
+	createTableAs = 1;
+	insertTable = 0;
+	dropTable = 0;
+	table_name = $3;
+}
+
+| CREATE TABLE TableName AS SELECT WhatIWant FROM Tables WHERE AndList GROUP BY Atts
+{
+	tables = $8;
+	boolean = $10;
+	groupingAtts = $13;
+	selectFromTable = 1;
+	createTable = 0;
+	createTableAs = 1;
+	insertTable = 0;
+	dropTable = 0;
+	table_name = $3;
+}
+
+| CREATE TABLE TableName '(' AttsAndType ')' AS HEAP PageSize Compressed Compact
 {
     selectFromTable = 0;
     createTable = 1;
@@ -139,7 +191,18 @@ SQL: SELECT WhatIWant FROM Tables WHERE AndList
 	col_atts = $5;
 }
 
-| CREATE TABLE TableName '(' AttsAndType ')' AS SORTED ON Atts
+| CREATE TABLE TableName '(' AttsAndType ')' AS PAX PageSize Compressed
+{
+    selectFromTable = 0;
+    createTable = 1;
+    insertTable = 0;
+    dropTable = 0;
+	sortedTable = 3;
+	table_name = $3;
+	col_atts = $5;
+}
+
+| CREATE TABLE TableName '(' AttsAndType ')' AS SORTED ON Atts PageSize Compressed
 {
     selectFromTable = 0;
     createTable = 1;
@@ -151,6 +214,51 @@ SQL: SELECT WhatIWant FROM Tables WHERE AndList
 	col_atts = $5;
 }
 
+| CREATE TABLE TableName '(' AttsAndType ')' AS TREE ON Atts PageSize Compressed
+{
+    selectFromTable = 0;
+    createTable = 1;
+    insertTable = 0;
+    dropTable = 0;
+	sortedTable = 2;
+	sortingAtts = $10;
+	table_name = $3;
+	col_atts = $5;
+}
+
+| CREATE INDEX ON TableName '(' Name ')'
+{
+    selectFromTable = 0;
+    createTable = 0;
+    insertTable = 0;
+    dropTable = 0;
+	createIndex = 1;
+	table_name = $4;
+	indexColumn = $6;
+}
+
+| CREATE BLOOM FILTER ON TableName '(' Name ')' FpRate
+{
+    selectFromTable = 0;
+    createTable = 0;
+    insertTable = 0;
+    dropTable = 0;
+	createBloomFilter = 1;
+	table_name = $5;
+	indexColumn = $7;
+}
+
+| CREATE DICTIONARY ON TableName '(' Name ')'
+{
+    selectFromTable = 0;
+    createTable = 0;
+    insertTable = 0;
+    dropTable = 0;
+	createDictionary = 1;
+	table_name = $4;
+	indexColumn = $6;
+}
+
 | INSERT FileName INTO TableName
 {
     selectFromTable = 0;
@@ -161,6 +269,28 @@ SQL: SELECT WhatIWant FROM Tables WHERE AndList
 	table_name = $4;
 }
 
+| EXPORT TABLE TableName TO FileName
+{
+    selectFromTable = 0;
+    createTable = 0;
+    insertTable = 0;
+    dropTable = 0;
+	exportTable = 1;
+	table_name = $3;
+	file_name = $5;
+}
+
+| IMPORT TABLE TableName FROM FileName
+{
+    selectFromTable = 0;
+    createTable = 0;
+    insertTable = 0;
+    dropTable = 0;
+	importTable = 1;
+	table_name = $3;
+	file_name = $5;
+}
+
 | DROP TABLE TableName
 {
     selectFromTable = 0;
@@ -189,6 +319,50 @@ SQL: SELECT WhatIWant FROM Tables WHERE AndList
 	outputFileName = $3;
 }
 
+PageSize: PAGESIZE Int
+{
+	tablePageSize = atoi($2);
+}
+
+| /* empty */
+{
+	tablePageSize = 0;
+}
+;
+
+Compressed: COMPRESSED
+{
+	tableCompressed = 1;
+}
+
+| /* empty */
+{
+	tableCompressed = 0;
+}
+;
+
+Compact: COMPACT
+{
+	tableCompact = 1;
+}
+
+| /* empty */
+{
+	tableCompact = 0;
+}
+;
+
+FpRate: FPRATE Float
+{
+	bloomFpRate = atof($2);
+}
+
+| /* empty */
+{
+	bloomFpRate = 0;
+}
+;
+
 WhatIWant: Function ',' Atts 
 {
 	attsToSelect = $3;
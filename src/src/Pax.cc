@@ -0,0 +1,677 @@
+#include <map>
+#include "Pax.h"
+
+static inline int RoundUp4(int n)
+{
+	return (n + 3) & ~3;
+}
+
+// PAX_FOR_INTS minipage of the nRecs 4 byte values of vData
+static char* EncodeInts(vector<char> &vData, int nRecs)
+{
+	int *pVals = (int *) &vData[0];
+	int nMin = pVals[0], nMax = pVals[0];
+	for (int r = 1; r < nRecs; r++)
+	{
+		if (pVals[r] < nMin)
+			nMin = pVals[r];
+		if (pVals[r] > nMax)
+			nMax = pVals[r];
+	}
+	unsigned int nRange = (unsigned int) nMax - (unsigned int) nMin;
+	int nBits = 0;
+	while (nBits < 32 && (nRange >> nBits) != 0)
+		nBits++;
+
+	int nLen = RoundUp4(4 * sizeof(int) + ((long) nRecs * nBits + 7) / 8);
+	char *bits = RecordMemory::Alloc(nLen);
+	memset(bits, 0, nLen);
+	int *pInts = (int *) bits;
+	pInts[0] = nLen;
+	pInts[1] = PAX_FOR_INTS;
+	pInts[2] = nMin;
+	pInts[3] = nBits;
+
+	unsigned char *pOut = (unsigned char *) (bits + 4 * sizeof(int));
+	unsigned long long nAcc = 0;
+	int nAccBits = 0;
+	for (int r = 0; r < nRecs; r++)
+	{
+		nAcc |= (unsigned long long) ((unsigned int) pVals[r] - (unsigned int) nMin) << nAccBits;
+		nAccBits += nBits;
+		while (nAccBits >= 8)
+		{
+			*pOut++ = (unsigned char) nAcc;
+			nAcc >>= 8;
+			nAccBits -= 8;
+		}
+	}
+	if (nAccBits > 0)
+		*pOut = (unsigned char) nAcc;
+	return bits;
+}
+
+static void DecodeInts(char *minipage, int nRecs, vector<char> &vBuf)
+{
+	int *pInts = (int *) minipage;
+	unsigned int nMin = pInts[2];
+	int nBits = pInts[3];
+	unsigned int nMask = (nBits == 32) ? 0xffffffff : (1u << nBits) - 1;
+
+	vBuf.resize((nRecs > 0 ? nRecs : 1) * sizeof(int));
+	unsigned int *pVals = (unsigned int *) &vBuf[0];
+	unsigned char *pIn = (unsigned char *) (minipage + 4 * sizeof(int));
+	unsigned long long nAcc = 0;
+	int nAccBits = 0;
+	for (int r = 0; r < nRecs; r++)
+	{
+		while (nAccBits < nBits)
+		{
+			nAcc |= (unsigned long long) *pIn++ << nAccBits;
+			nAccBits += 8;
+		}
+		pVals[r] = nMin + (unsigned int) (nAcc & nMask);
+		nAcc >>= nBits;
+		nAccBits -= nBits;
+	}
+}
+
+// PAX_DICTIONARY minipage of the nRecs values of vData, which end at
+// vEnds; NULL if they take more than PAX_DICTIONARY_SIZE different values
+static char* EncodeDictionary(vector<char> &vData, vector<int> &vEnds, int nRecs)
+{
+	map<string, int> mCodes;
+	vector<string> vValues;
+	vector<unsigned char> vCodes(nRecs);
+	int nStart = 0;
+	for (int r = 0; r < nRecs; r++)
+	{
+		string sValue(&vData[0] + nStart, vEnds[r] - nStart);
+		nStart = vEnds[r];
+		map<string, int>::iterator it = mCodes.find(sValue);
+		if (it == mCodes.end())
+		{
+			if (vValues.size() == PAX_DICTIONARY_SIZE)
+				return NULL;
+			it = mCodes.insert(make_pair(sValue, (int) vValues.size())).first;
+			vValues.push_back(sValue);
+		}
+		vCodes[r] = (unsigned char) it->second;
+	}
+
+	int nValues = vValues.size();
+	int nValueBytes = 0;
+	for (int i = 0; i < nValues; i++)
+		nValueBytes += vValues[i].size();
+
+	int nLen = RoundUp4((4 + nValues) * sizeof(int) + nValueBytes + nRecs);
+	char *bits = RecordMemory::Alloc(nLen);
+	memset(bits, 0, nLen);
+	int *pInts = (int *) bits;
+	pInts[0] = nLen;
+	pInts[1] = PAX_DICTIONARY;
+	pInts[2] = nValues;
+	int *pOffsets = pInts + 3;
+	char *pValues = (char *) (pOffsets + nValues + 1);
+	pOffsets[0] = 0;
+	for (int i = 0; i < nValues; i++)
+	{
+		memcpy(pValues + pOffsets[i], vValues[i].data(), vValues[i].size());
+		pOffsets[i + 1] = pOffsets[i] + vValues[i].size();
+	}
+	memcpy(pValues + nValueBytes, &vCodes[0], nRecs);
+	return bits;
+}
+
+// the values of a PAX_DICTIONARY minipage, as a width 0 one has them:
+// nRecs + 1 offsets, then the values
+static void DecodeDictionary(char *minipage, int nRecs, vector<char> &vBuf)
+{
+	int *pInts = (int *) minipage;
+	int nValues = pInts[2];
+	int *pDictOffsets = pInts + 3;
+	char *pValues = (char *) (pDictOffsets + nValues + 1);
+	unsigned char *pCodes = (unsigned char *) (pValues + pDictOffsets[nValues]);
+
+	int nBytes = 0;
+	for (int r = 0; r < nRecs; r++)
+		nBytes += pDictOffsets[pCodes[r] + 1] - pDictOffsets[pCodes[r]];
+
+	vBuf.resize((nRecs + 1) * sizeof(int) + nBytes);
+	int *pOffsets = (int *) &vBuf[0];
+	char *pData = &vBuf[0] + (nRecs + 1) * sizeof(int);
+	pOffsets[0] = 0;
+	for (int r = 0; r < nRecs; r++)
+	{
+		int nCode = pCodes[r];
+		int nLen = pDictOffsets[nCode + 1] - pDictOffsets[nCode];
+		memcpy(pData + pOffsets[r], pValues + pDictOffsets[nCode], nLen);
+		pOffsets[r + 1] = pOffsets[r] + nLen;
+	}
+}
+
+// bytes taken by attribute "whichAtt" of a record
+static inline int GetAttLength(char *bits, int nAtts, int whichAtt)
+{
+	int nEnd = (whichAtt + 1 < nAtts) ? ((int *) bits)[whichAtt + 2] : ((int *) bits)[0];
+	return nEnd - ((int *) bits)[whichAtt + 1];
+}
+
+Pax::Pax() : m_sFilePath(), m_sMetaSuffix(".meta.data"), m_bReadOnly(false),
+			 m_nOutPage(0), m_nOutRecs(0), m_nOutAtts(0), m_bOutDirty(false),
+			 m_nCurrPage(0), m_nCurrRec(0), m_nPageRecs(0), m_nRecBufUsed(0), m_bProjection(false),
+			 m_bQueryStarted(false), m_bCnfCoversNeeded(false)
+{
+	m_pFile = new File();
+	m_pReadAhead = new ReadAhead(m_pFile);
+	m_pPage = new Page();
+}
+
+Pax::~Pax()
+{
+	// stop prefetching before the File goes away
+	delete m_pReadAhead;
+	m_pReadAhead = NULL;
+
+	delete m_pFile;
+	m_pFile = NULL;
+
+	delete m_pPage;
+	m_pPage = NULL;
+}
+
+int Pax::Create(char *f_path, void *startup, int pageSize, int compression)
+{
+	//ignore parameter startup - not required for this file type
+	m_sFilePath = f_path;
+	m_pFile->Open(TRUNCATE, f_path, pageSize, compression);
+	m_bReadOnly = false;
+	m_nOutPage = 0;
+	ClearOutPage(0);
+	m_bOutDirty = false;
+	WriteMetaData();
+	MoveFirst();
+	return RET_SUCCESS;
+}
+
+int Pax::Open(char *fname, FileOpenMode mode)
+{
+	ifstream meta_in;
+	meta_in.open((string(fname) + m_sMetaSuffix).c_str());
+	if (!meta_in)
+	{
+		cout << "Pax::Open: File " << fname << m_sMetaSuffix << " does not exist.\n";
+		return RET_FILE_NOT_FOUND;
+	}
+	meta_in.close();
+
+	m_sFilePath = fname;
+	m_bReadOnly = (mode == READ_ONLY);
+	m_pFile->Open(m_bReadOnly ? READ_ONLY : APPEND, fname);
+	m_bOutDirty = false;
+	if (m_bReadOnly)
+	{
+		m_nOutPage = GetNumPages();
+		ClearOutPage(0);
+	}
+	else
+		ReadLastPage();		// Add goes on filling it
+	MoveFirst();
+	return RET_SUCCESS;
+}
+
+// returns 1 if successfully closed the file, 0 otherwise
+int Pax::Close()
+{
+	if (m_bOutDirty)
+		WriteOutPage();
+	m_pReadAhead->Stop();
+	m_pFile->Close();
+	return RET_SUCCESS;
+}
+
+void Pax::Load (Schema &mySchema, char *loadMe)
+{
+	EventLogger *el = EventLogger::getEventLogger();
+
+	BulkLoader loader;
+	if (!loader.Open(loadMe, mySchema))
+	{
+		el->writeLog("Can't open file name :" + string(loadMe));
+		return;
+	}
+
+	Page *pPage;
+	Record aRecord;
+	while ((pPage = loader.GetNextPage()) != NULL)
+	{
+		while (pPage->GetFirst(&aRecord))
+			Add(aRecord);
+	}
+	loader.Close();
+}
+
+void Pax::MoveFirst()
+{
+	// a scan sees the records added so far
+	if (m_bOutDirty)
+		WriteOutPage();
+	m_nCurrPage = 0;
+	m_nCurrRec = 0;
+	m_nPageRecs = 0;
+	m_bQueryStarted = false;
+	m_pReadAhead->Reset();
+}
+
+void Pax::Add (Record &rec)
+{
+	if (m_bReadOnly)
+	{
+		EventLogger::getEventLogger()->writeLog("Pax::Add --> File " + m_sFilePath +
+												" is open READ_ONLY\n");
+		exit(0);
+	}
+
+	// Consume the record
+	Record aRecord;
+	aRecord.Consume(&rec);
+	char *bits = aRecord.bits;
+	int nAtts = ((int *) bits)[1] / sizeof(int) - 1;
+
+	// the records of a page all have the same attributes
+	if (m_nOutRecs > 0 && nAtts != m_nOutAtts)
+	{
+		WriteOutPage();
+		m_nOutPage++;
+	}
+	if (m_nOutRecs == 0)
+		ClearOutPage(nAtts);
+
+	vector<int> vLens(nAtts);
+	for (int i = 0; i < nAtts; i++)
+		vLens[i] = GetAttLength(bits, nAtts, i);
+
+	if (GetOutPageBytes(&vLens) > m_pFile->GetPageSize())
+	{
+		if (m_nOutRecs == 0)
+		{
+			cerr << "BAD: a record of " << ((int *) bits)[0] << " bytes does not fit in a "
+				 << m_pFile->GetPageSize() << " bytes page\n";
+			exit(1);
+		}
+		WriteOutPage();
+		m_nOutPage++;
+		ClearOutPage(nAtts);
+	}
+
+	for (int i = 0; i < nAtts; i++)
+	{
+		char *att = bits + ((int *) bits)[i + 1];
+		vector<char> &data = m_vOutData[i];
+		data.insert(data.end(), att, att + vLens[i]);
+		m_vOutEnds[i].push_back(data.size());
+
+		if (m_vOutWidths[i] == -1)
+			m_vOutWidths[i] = vLens[i];
+		else if (m_vOutWidths[i] != vLens[i])
+			m_vOutWidths[i] = 0;
+	}
+	m_nOutRecs++;
+	m_bOutDirty = true;
+}
+
+int Pax::GetNext (Record &fetchme)
+{
+	while (m_nCurrRec >= m_nPageRecs)
+	{
+		int nPages = GetNumPages();
+		if (m_nCurrPage >= nPages)
+			return RET_FAILURE;
+		ReadPage(m_nCurrPage);
+		m_pReadAhead->Advance(m_nCurrPage, nPages - 1);
+		m_nCurrPage++;
+	}
+	MakeRecord(m_nCurrRec++, m_bProjection ? &m_vPageNeeded[0] : NULL, true, fetchme);
+	return RET_SUCCESS;
+}
+
+int Pax::GetNext (Record &fetchme, CNF &cnf, Record &literal)
+{
+	if (!m_bQueryStarted)
+	{
+		m_bQueryStarted = true;
+		m_vCnfAtts.clear();
+		for (int i = 0; i < cnf.numAnds; i++)
+		{
+			for (int j = 0; j < cnf.orLens[i]; j++)
+			{
+				Comparison &c = cnf.orList[i][j];
+				int nAtts[2] = { c.operand1 != Literal ? c.whichAtt1 : -1,
+								 c.operand2 != Literal ? c.whichAtt2 : -1 };
+				for (int k = 0; k < 2; k++)
+				{
+					if (nAtts[k] < 0)
+						continue;
+					if (nAtts[k] >= m_vCnfAtts.size())
+						m_vCnfAtts.resize(nAtts[k] + 1, false);
+					m_vCnfAtts[nAtts[k]] = true;
+				}
+			}
+		}
+
+		m_bCnfCoversNeeded = m_bProjection;
+		for (int i = 0; i < m_vNeeded.size() && m_bCnfCoversNeeded; i++)
+			if (m_vNeeded[i] && (i >= m_vCnfAtts.size() || !m_vCnfAtts[i]))
+				m_bCnfCoversNeeded = false;
+
+		// for a page read before the query started
+		SetPageFlags(m_vCnfAtts, m_vPageCnfAtts);
+	}
+
+	ComparisonEngine compEngine;
+	while (true)
+	{
+		while (m_nCurrRec >= m_nPageRecs)
+		{
+			int nPages = GetNumPages();
+			if (m_nCurrPage >= nPages)
+				return RET_FAILURE;
+			ReadPage(m_nCurrPage);
+			m_pReadAhead->Advance(m_nCurrPage, nPages - 1);
+			m_nCurrPage++;
+		}
+
+		int nRec = m_nCurrRec++;
+		MakeRecord(nRec, &m_vPageCnfAtts[0], m_bCnfCoversNeeded, fetchme);
+		if (compEngine.Compare(&fetchme, &literal, &cnf))
+		{
+			if (!m_bCnfCoversNeeded)
+				MakeRecord(nRec, m_bProjection ? &m_vPageNeeded[0] : NULL, true, fetchme);
+			return RET_SUCCESS;
+		}
+	}
+}
+
+void Pax::SetProjection (int *keepMe, int numAttsToKeep)
+{
+	m_bProjection = true;
+	m_vNeeded.clear();
+	for (int i = 0; i < numAttsToKeep; i++)
+	{
+		if (keepMe[i] >= m_vNeeded.size())
+			m_vNeeded.resize(keepMe[i] + 1, false);
+		m_vNeeded[keepMe[i]] = true;
+	}
+	SetPageFlags(m_vNeeded, m_vPageNeeded);
+	m_bQueryStarted = false;
+}
+
+int Pax::GetNumPages()
+{
+	return (m_pFile->GetLength() > 0) ? m_pFile->GetLength() - 1 : 0;
+}
+
+int Pax::GetOutPageBytes(vector<int> *pLens)
+{
+	int nRecs = m_nOutRecs + (pLens ? 1 : 0);
+
+	// record count of the page, then the header record
+	int nBytes = sizeof(int) + 5 * sizeof(int);
+	for (int i = 0; i < m_nOutAtts; i++)
+	{
+		int nWidth = m_vOutWidths[i];
+		int nData = m_vOutData[i].size();
+		if (pLens)
+		{
+			int nLen = (*pLens)[i];
+			nWidth = (nWidth == -1 || nWidth == nLen) ? nLen : 0;
+			nData += nLen;
+		}
+
+		// length and width, then the values
+		nBytes += 2 * sizeof(int) + nData;
+		if (nWidth == 0)
+			nBytes += (nRecs + 1) * sizeof(int);
+	}
+	return nBytes;
+}
+
+void Pax::ClearOutPage(int nAtts)
+{
+	m_nOutRecs = 0;
+	m_nOutAtts = nAtts;
+	m_vOutData.resize(nAtts);
+	m_vOutEnds.resize(nAtts);
+	m_vOutWidths.assign(nAtts, -1);
+	for (int i = 0; i < nAtts; i++)
+	{
+		m_vOutData[i].clear();
+		m_vOutEnds[i].clear();
+	}
+}
+
+void Pax::WriteOutPage()
+{
+	Page page;
+	page.SetPageSize(m_pFile->GetPageSize());
+
+	// header: two Int attributes
+	Record header;
+	header.bits = RecordMemory::Alloc(5 * sizeof(int));
+	((int *) header.bits)[0] = 5 * sizeof(int);
+	((int *) header.bits)[1] = 3 * sizeof(int);
+	((int *) header.bits)[2] = 4 * sizeof(int);
+	((int *) header.bits)[3] = m_nOutRecs;
+	((int *) header.bits)[4] = m_nOutAtts;
+	page.Append(&header);
+
+	for (int i = 0; i < m_nOutAtts; i++)
+	{
+		Record minipage;
+		minipage.bits = MakeMinipage(i);
+		if (!page.Append(&minipage))
+		{
+			cerr << "BAD: Pax page overflow\n";
+			exit(1);
+		}
+	}
+
+	m_pFile->AddPage(&page, m_nOutPage);
+	m_bOutDirty = false;
+}
+
+char* Pax::MakeMinipage(int nAtt)
+{
+	int nWidth = (m_vOutWidths[nAtt] == -1) ? 0 : m_vOutWidths[nAtt];
+	int nData = m_vOutData[nAtt].size();
+	int nOffsets = (nWidth == 0) ? m_nOutRecs + 1 : 0;
+	int nLen = (2 + nOffsets) * sizeof(int) + nData;
+
+	char *bits = RecordMemory::Alloc(nLen);
+	int *pInts = (int *) bits;
+	pInts[0] = nLen;
+	pInts[1] = nWidth;
+	if (nOffsets > 0)
+	{
+		pInts[2] = 0;
+		for (int r = 0; r < m_nOutRecs; r++)
+			pInts[3 + r] = m_vOutEnds[nAtt][r];
+	}
+	if (nData > 0)
+		memcpy(bits + (2 + nOffsets) * sizeof(int), &m_vOutData[nAtt][0], nData);
+
+	// an encoded minipage is kept only if it is smaller
+	if (m_pFile->GetCompression() == COMPRESS_NONE || m_nOutRecs == 0)
+		return bits;
+	char *encoded = NULL;
+	if (nWidth == sizeof(int))
+		encoded = EncodeInts(m_vOutData[nAtt], m_nOutRecs);
+	else if (nWidth == 0)
+		encoded = EncodeDictionary(m_vOutData[nAtt], m_vOutEnds[nAtt], m_nOutRecs);
+	if (encoded != NULL && ((int *) encoded)[0] < nLen)
+	{
+		RecordMemory::Free(bits);
+		return encoded;
+	}
+	RecordMemory::Free(encoded);
+	return bits;
+}
+
+void Pax::ReadLastPage()
+{
+	int nPages = GetNumPages();
+	ClearOutPage(0);
+	m_nOutPage = (nPages > 0) ? nPages - 1 : 0;
+	if (nPages == 0)
+		return;
+
+	ReadPage(m_nOutPage);
+	int nAtts = m_vCols.size();
+	ClearOutPage(nAtts);
+	for (int r = 0; r < m_nPageRecs; r++)
+	{
+		for (int i = 0; i < nAtts; i++)
+		{
+			PaxColumn &col = m_vCols[i];
+			char *att = (col.width > 0) ? col.data + r * col.width : col.data + col.offsets[r];
+			int nLen = (col.width > 0) ? col.width : col.offsets[r + 1] - col.offsets[r];
+			m_vOutData[i].insert(m_vOutData[i].end(), att, att + nLen);
+			m_vOutEnds[i].push_back(m_vOutData[i].size());
+			if (m_vOutWidths[i] == -1)
+				m_vOutWidths[i] = nLen;
+			else if (m_vOutWidths[i] != nLen)
+				m_vOutWidths[i] = 0;
+		}
+	}
+	m_nOutRecs = m_nPageRecs;
+}
+
+void Pax::ReadPage(int nPage)
+{
+	m_pFile->GetPage(m_pPage, nPage);
+
+	// views on the page, valid until the next GetPage
+	Record header;
+	m_pPage->GetRecord(0, &header);
+	m_nPageRecs = ((int *) header.bits)[3];
+	int nAtts = ((int *) header.bits)[4];
+	m_nCurrRec = 0;
+
+	// a record takes at most its bytes on the page, its offsets and a
+	// placeholder per attribute; the buffer must not move while the
+	// records of the page are out
+	int nBufBytes = m_pFile->GetPageSize() + m_nPageRecs * (2 * nAtts + 1) * sizeof(int);
+	if (m_vRecBuf.size() < nBufBytes)
+		m_vRecBuf.resize(nBufBytes);
+	m_nRecBufUsed = 0;
+
+	m_vCols.resize(nAtts);
+	m_vColBufs.resize(nAtts);
+	SetPageFlags(m_vNeeded, m_vPageNeeded);
+	SetPageFlags(m_vCnfAtts, m_vPageCnfAtts);
+	for (int i = 0; i < nAtts; i++)
+	{
+		Record minipage;
+		m_pPage->GetRecord(i + 1, &minipage);
+		PaxColumn &col = m_vCols[i];
+		col.width = ((int *) minipage.bits)[1];
+		if (col.width == PAX_FOR_INTS)
+		{
+			DecodeInts(minipage.bits, m_nPageRecs, m_vColBufs[i]);
+			col.width = sizeof(int);
+			col.offsets = NULL;
+			col.data = &m_vColBufs[i][0];
+		}
+		else if (col.width == PAX_DICTIONARY)
+		{
+			DecodeDictionary(minipage.bits, m_nPageRecs, m_vColBufs[i]);
+			col.width = 0;
+			col.offsets = (int *) &m_vColBufs[i][0];
+			col.data = &m_vColBufs[i][0] + (m_nPageRecs + 1) * sizeof(int);
+		}
+		else if (col.width > 0)
+		{
+			col.offsets = NULL;
+			col.data = minipage.bits + 2 * sizeof(int);
+		}
+		else
+		{
+			col.offsets = (int *) (minipage.bits + 2 * sizeof(int));
+			col.data = minipage.bits + (3 + m_nPageRecs) * sizeof(int);
+		}
+	}
+}
+
+void Pax::SetPageFlags(vector<bool> &vAtts, vector<char> &vFlags)
+{
+	// one more flag, so that the vector is never empty
+	int nAtts = m_vCols.size();
+	vFlags.assign(nAtts + 1, 0);
+	for (int i = 0; i < nAtts && i < vAtts.size(); i++)
+		vFlags[i] = vAtts[i];
+}
+
+void Pax::MakeRecord(int nRec, const char *pWhich, bool bKeep, Record &fetchme)
+{
+	int nAtts = m_vCols.size();
+	PaxColumn *pCols = &m_vCols[0];
+
+	// first find out how big the record is; an attribute that is
+	// not needed takes its width, or an empty string
+	int nLength = (nAtts + 1) * sizeof(int);
+	for (int i = 0; i < nAtts; i++)
+	{
+		PaxColumn &col = pCols[i];
+		bool bNeeded = (pWhich == NULL) || pWhich[i];
+		if (col.width > 0)
+			nLength += col.width;
+		else if (bNeeded)
+			nLength += col.offsets[nRec + 1] - col.offsets[nRec];
+		else
+			nLength += sizeof(int);
+	}
+
+	char *bits = &m_vRecBuf[m_nRecBufUsed];
+	((int *) bits)[0] = nLength;
+	int nPos = (nAtts + 1) * sizeof(int);
+	for (int i = 0; i < nAtts; i++)
+	{
+		PaxColumn &col = pCols[i];
+		bool bNeeded = (pWhich == NULL) || pWhich[i];
+		((int *) bits)[i + 1] = nPos;
+
+		char *att;
+		int nLen;
+		if (col.width > 0)
+		{
+			att = col.data + nRec * col.width;
+			nLen = col.width;
+		}
+		else
+		{
+			att = col.data + col.offsets[nRec];
+			nLen = bNeeded ? col.offsets[nRec + 1] - col.offsets[nRec] : sizeof(int);
+		}
+
+		if (bNeeded)
+			memcpy(bits + nPos, att, nLen);
+		else
+			memset(bits + nPos, 0, nLen);
+		nPos += nLen;
+	}
+
+	fetchme.SetView(bits);
+	if (bKeep)
+		m_nRecBufUsed += nLength;
+}
+
+void Pax::WriteMetaData()
+{
+	if (!m_sFilePath.empty())
+	{
+		ofstream meta_out;
+		meta_out.open(string(m_sFilePath + m_sMetaSuffix).c_str(), ios::trunc);
+		meta_out << "pax\n";
+		meta_out.close();
+	}
+}
@@ -0,0 +1,135 @@
+#ifndef PAX_H
+#define PAX_H
+
+#include <vector>
+#include "GenericDBFile.h"
+#include "ReadAhead.h"
+#include "BulkLoader.h"
+
+// in a compressed file, a minipage may be encoded; its width is then
+//  - PAX_FOR_INTS for 4 byte values, taken as ints: the smallest of them,
+//    the number of bits b per value, then value - smallest in b bits each
+//  - PAX_DICTIONARY for at most PAX_DICTIONARY_SIZE different values:
+//    their number, their nValues + 1 offsets and the values, then the
+//    number of the value of every record, in one byte
+#define PAX_FOR_INTS -1
+#define PAX_DICTIONARY -2
+#define PAX_DICTIONARY_SIZE 256
+
+// one column of a page, as a scan sees it: the values of a fixed width
+// column are back to back, the others have an offset each
+struct PaxColumn
+{
+	int width;		// bytes per value, 0 if they vary
+	int *offsets;	// nRecs + 1 offsets into data, if width is 0
+	char *data;
+};
+
+// PAX (Partition Attributes Across) file: a page holds the same records a
+// heap page would, but stored column by column, so that a scan only
+// touches the attributes it needs. Every page holds Records:
+//  - the first one is the page header, two Ints: the number of records
+//    and the number of attributes of each of them
+//  - then one minipage per attribute: the length, the width of the values,
+//    then either the values back to back (width > 0) or nRecs + 1 offsets
+//    followed by the values (width 0, for values of different lengths)
+// The minipages are not Records in the Record.h sense, only their length
+// is read by Page. A value is kept as the bytes it takes in a Record, so
+// the file does not need the schema, and records are rebuilt byte for byte.
+// In a compressed file (see File) minipages are encoded when it makes them
+// smaller, before File packs the whole page.
+// GetNext rebuilds the classic Record layout; after SetProjection, the
+// attributes that are not needed are left zeroed (0, 0.0 or "")
+// The pages of the file are still read whole: PAX saves the cost of going
+// through the attributes that are not needed, not I/O
+class Pax : public GenericDBFile
+{
+	private:
+		File *m_pFile;
+		ReadAhead *m_pReadAhead;
+		string m_sFilePath;
+		string m_sMetaSuffix;
+		bool m_bReadOnly;
+
+		// page being filled by Add, one buffer per attribute
+		int m_nOutPage;					// where it goes in the file
+		int m_nOutRecs;
+		int m_nOutAtts;
+		vector< vector<char> > m_vOutData;
+		vector< vector<int> > m_vOutEnds;	// end of every value in its buffer
+		vector<int> m_vOutWidths;		// -1 for no value yet, 0 if they vary
+		bool m_bOutDirty;				// not written since the last Add
+
+		// scan state
+		Page *m_pPage;
+		int m_nCurrPage;				// next page to read
+		int m_nCurrRec;					// next record of m_pPage
+		int m_nPageRecs;
+		vector<PaxColumn> m_vCols;		// views on the minipages of m_pPage
+		vector< vector<char> > m_vColBufs;	// the encoded ones, decoded
+
+		// the records GetNext rebuilt from m_pPage; they are handed out as
+		// views, valid until the next page is read, as those of a heap are
+		vector<char> m_vRecBuf;
+		int m_nRecBufUsed;
+
+		// attributes GetNext fills in, every one if m_bProjection is false
+		bool m_bProjection;
+		vector<bool> m_vNeeded;
+
+		// state of GetNext(CNF), kept until MoveFirst
+		bool m_bQueryStarted;
+		vector<bool> m_vCnfAtts;		// attributes the CNF looks at
+		bool m_bCnfCoversNeeded;		// a matching record is complete
+
+		// m_vNeeded and m_vCnfAtts for the attributes of m_pPage, one flag
+		// each, so that MakeRecord does not go through vector<bool>
+		vector<char> m_vPageNeeded;
+		vector<char> m_vPageCnfAtts;
+
+		// Private functions
+		void WriteMetaData();
+		int GetNumPages();
+
+		// bytes the page being filled takes on disk, with one more record
+		// whose attributes take pLens bytes each (NULL for none)
+		int GetOutPageBytes(vector<int> *pLens);
+
+		void ClearOutPage(int nAtts);
+		void WriteOutPage();
+
+		// minipage of attribute nAtt of the page being filled, in a new
+		// buffer that starts with its length
+		char* MakeMinipage(int nAtt);
+		void ReadLastPage();
+
+		// reads page nPage of the file into m_pPage and m_vCols
+		void ReadPage(int nPage);
+		void SetPageFlags(vector<bool> &vAtts, vector<char> &vFlags);
+
+		// rebuilds record nRec of m_pPage in m_vRecBuf, fetchme is a view
+		// on it; only the attributes flagged in pWhich are filled in, all
+		// of them if it is NULL. The next call overwrites it unless bKeep
+		void MakeRecord(int nRec, const char *pWhich, bool bKeep, Record &fetchme);
+
+	public:
+		Pax();
+		~Pax();
+
+		int Create (char *name, void *startup, int pageSize = PAGE_SIZE, int compression = COMPRESS_NONE);
+		int Open (char *name, FileOpenMode mode = APPEND);
+		int Close ();
+		void Load (Schema &mySchema, char *loadMe);
+		void MoveFirst();
+		void Add (Record &addMe);
+		int GetNext (Record &fetchMe);
+
+		// the CNF is applied to the records rebuilt with only the attributes
+		// it looks at, the other ones are added for those that match
+		int GetNext (Record &fetchMe, CNF &applyMe, Record &literal);
+
+		void SetProjection (int *keepMe, int numAttsToKeep);
+		int GetPageSize () { return m_pFile->GetPageSize(); }
+};
+
+#endif
@@ -5,6 +5,18 @@ using namespace std;
 // Initialize static map
 map<int, Pipe*> QueryPlanNode::m_mPipes;
 
+int QueryPlanNode::GetPageSize()
+{
+	if (m_nPageSize > 0)
+		return m_nPageSize;
+	int nPageSize = 0;
+	if (this->left)
+		nPageSize = max(nPageSize, this->left->GetPageSize());
+	if (this->right)
+		nPageSize = max(nPageSize, this->right->GetPageSize());
+	return nPageSize > 0 ? nPageSize : PAGE_SIZE;
+}
+
 // -------------------------------------- select pipe ------------------
 void Node_SelectPipe::PrintNode()
 {
@@ -60,6 +72,13 @@ void Node_SelectFile::PrintNode()
     cout << "\n*** Select File Operation ***";
     cout << "\nOutput pipe ID: " << m_nOutPipe;
     cout << "\nInput filename: " << m_sInFileName.c_str();
+    cout << "\nAccess path: " << (m_eAccess == RANDOM_ACCESS ? "index lookup (if indexed)" : "full scan");
+    if (!m_vProjection.empty())
+    {
+        cout << "\nAttributes needed:";
+        for (int i = 0; i < m_vProjection.size(); i++)
+            cout << " " << m_vProjection[i];
+    }
     cout << "\nSelect CNF : ";
     if (m_pCNF != NULL)
         m_pCNF->Print();
@@ -83,7 +102,13 @@ void Node_SelectFile::ExecuteNode()
 {
         //create a DBFile from input file path provided
         DBFile * pFile = new DBFile;
-        pFile->Open(const_cast<char*>(m_sInFileName.c_str()));
+        // the scan only reads, so map the file instead of going through read()
+        pFile->Open(const_cast<char*>(m_sInFileName.c_str()), READ_ONLY);
+        pFile->SetAccessPattern(m_eAccess);
+        m_nPageSize = pFile->GetPageSize();
+        // a column store only reads what the query needs
+        if (!m_vProjection.empty())
+            pFile->SetProjection(&m_vProjection[0], m_vProjection.size());
 
 		#ifdef DEBUG_QUERY_NODE
         cout << "\n In ExecuteNode selectFile for " << m_sInFileName.c_str() << endl;
@@ -197,6 +222,7 @@ void Node_Join::ExecuteNode()
 
         Join J; 
         J.Use_n_Pages(QUERY_USE_PAGES);
+        J.Use_Page_Size(GetPageSize());
         if (m_pCNF != NULL && m_pLiteral != NULL)
         {
             J.Run(*(QueryPlanNode::m_mPipes[m_nInPipe]), *(QueryPlanNode::m_mPipes[m_nRightInPipe]), 
@@ -250,6 +276,7 @@ void Node_GroupBy::ExecuteNode()
 
 	GroupBy G;        
     G.Use_n_Pages(QUERY_USE_PAGES);
+    G.Use_Page_Size(GetPageSize());
     if (m_pFunc != NULL && m_pOM != NULL)
     {
 		G.Run(*(QueryPlanNode::m_mPipes[m_nInPipe]), *(QueryPlanNode::m_mPipes[m_nOutPipe]), *m_pOM, *m_pFunc);
@@ -370,6 +397,7 @@ void Node_Distinct::ExecuteNode()
 
     DuplicateRemoval DR;
     DR.Use_n_Pages(QUERY_USE_PAGES);
+    DR.Use_Page_Size(GetPageSize());
     if (m_pSchema != NULL)
     {
         DR.Run(*(QueryPlanNode::m_mPipes[m_nInPipe]), *(QueryPlanNode::m_mPipes[m_nOutPipe]), *m_pSchema);
@@ -399,6 +427,8 @@ void Node_WriteOut::PrintNode()
         cout << "\n*** WriteOut Operation ***";
         cout << "\nInput pipe ID: " << m_nInPipe;
         cout << "\nOutput file: " << m_sOutFileName;
+        if (m_bExport)
+            cout << " (export file)";
         cout << endl << endl;
 
         if (this->right != NULL)
@@ -421,7 +451,24 @@ void Node_WriteOut::ExecuteNode()
     #endif
 
 	WriteOut W;
-    if (m_pSchema != NULL && !m_sOutFileName.empty())
+    if (m_pSchema != NULL && !m_sOutFileName.empty() && m_bExport)
+    {
+		int count = 0;
+		ExportFile out;
+		if (!out.Create(m_sOutFileName.c_str(), *m_pSchema))
+		{
+			cerr << "BAD: can not write the export file " << m_sOutFileName << "\n";
+			exit(1);
+		}
+		W.Run(*(QueryPlanNode::m_mPipes[m_nInPipe]), &out, &count);
+		W.WaitUntilDone();
+		if (!out.Close())
+		{
+			cerr << "BAD: can not write the export file " << m_sOutFileName << "\n";
+			exit(1);
+		}
+    }
+    else if (m_pSchema != NULL && !m_sOutFileName.empty())
     {
 		int count = 0;
 		FILE * pFILE = fopen((char*)m_sOutFileName.c_str(), "w");
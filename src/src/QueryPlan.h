@@ -10,10 +10,15 @@
 #include <string>
 #include <iostream>
 #include <map>
+#include <algorithm>
+#include <vector>
 
 //#define DEBUG_QUERY_NODE 1
 #define QUERY_PIPE_SIZE 100
 #define QUERY_USE_PAGES 100
+// a selection estimated to keep at most this share of a table uses its
+// index (if it has one), a less selective one scans the whole file
+#define INDEX_SELECTIVITY 0.1
 
 using namespace std;
 
@@ -23,6 +28,7 @@ public:
 	// common members
 	int m_nInPipe, m_nOutPipe;
 	string m_sInFileName, m_sOutFileName;
+	int m_nPageSize;	// of the file a Node_SelectFile read, 0 for other nodes
     static map<int, Pipe*> m_mPipes;
 
 	// left and right children (tree structure)
@@ -30,9 +36,13 @@ public:
 	QueryPlanNode * right;
 
 	QueryPlanNode() : m_nInPipe(-1), m_nOutPipe(-1), m_sInFileName(), m_sOutFileName(),
-					  left(NULL), right(NULL)
+					  m_nPageSize(0), left(NULL), right(NULL)
 	{}
 
+	// the largest page size of the files read below the node, PAGE_SIZE
+	// if there are none; known once ExecutePostOrder ran the children
+	int GetPageSize();
+
 	// Will be in-order traversal
 	virtual void PrintNode() {}
 	// Will be post order traversal
@@ -85,13 +95,19 @@ class Node_SelectFile : public QueryPlanNode
 public:
 	CNF* m_pCNF;
     Record * m_pLiteral;
+    AccessPattern m_eAccess;	// RANDOM_ACCESS if the selection is selective
+    vector<int> m_vProjection;	// attributes the query needs, empty for all of them
 
-	Node_SelectFile(string inFile, int out, CNF* pCNF, Record * pLit) 
+	Node_SelectFile(string inFile, int out, CNF* pCNF, Record * pLit,
+					AccessPattern eAccess = RANDOM_ACCESS,
+					const vector<int> &vProjection = vector<int>()) 
     {
 		m_sInFileName = inFile;
 		m_nOutPipe = out;
 		m_pCNF = pCNF;
 		m_pLiteral = pLit;
+		m_eAccess = eAccess;
+		m_vProjection = vProjection;
         QueryPlanNode::m_mPipes[m_nOutPipe] = new Pipe(QUERY_PIPE_SIZE);
 	}
 
@@ -309,12 +325,14 @@ class Node_WriteOut : public QueryPlanNode
 {
 public:
 	Schema * m_pSchema;
+	bool m_bExport;		// the file is an export file, not text (see ExportFile)
 
-    Node_WriteOut(int ip, string outFile, Schema * pSch)
+    Node_WriteOut(int ip, string outFile, Schema * pSch, bool bExport = false)
     {
 		m_nInPipe = ip;
 		m_sOutFileName = outFile;
 		m_pSchema = pSch;
+		m_bExport = bExport;
 	}
 
 	~Node_WriteOut()
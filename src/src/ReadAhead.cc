@@ -0,0 +1,121 @@
+#include "ReadAhead.h"
+
+#include <algorithm>
+
+ReadAhead::ReadAhead(File *pFile, int nWindow) : m_pFile(pFile), m_nWindow(nWindow),
+	m_bRunning(false), m_bStop(false), m_qPages(), m_sIssued()
+{
+	pthread_mutex_init(&m_mutex, NULL);
+	pthread_cond_init(&m_cond, NULL);
+}
+
+ReadAhead::~ReadAhead()
+{
+	Stop();
+	pthread_mutex_destroy(&m_mutex);
+	pthread_cond_destroy(&m_cond);
+}
+
+void ReadAhead::SetWindow(int nWindow)
+{
+	if (nWindow < 0)
+		nWindow = 0;
+	if (nWindow == 0)
+		Stop();
+	m_nWindow = nWindow;
+}
+
+void ReadAhead::Advance(off_t whichPage, off_t lastPage)
+{
+	if (m_nWindow == 0)
+		return;
+
+	// most of the time the page at the far end of the window is the only
+	// new one; if it is already in memory there is nothing to do, and
+	// waking the thread up would cost more than it saves
+	off_t farPage = min(whichPage + m_nWindow, lastPage);
+	if (farPage <= whichPage || m_pFile->IsInMemory(farPage))
+		return;
+
+	pthread_mutex_lock(&m_mutex);
+
+	if (!m_bRunning)
+	{
+		m_bStop = false;
+		if (pthread_create(&m_thread, NULL, &PrefetchPagesHelper, (void*)this) != 0)
+		{
+			// no thread, no read-ahead: the reader simply waits for every page
+			m_nWindow = 0;
+			pthread_mutex_unlock(&m_mutex);
+			return;
+		}
+		m_bRunning = true;
+	}
+
+	bool bQueued = false;
+	for (off_t page = whichPage + 1; page <= whichPage + m_nWindow && page <= lastPage; page++)
+	{
+		if (m_sIssued.insert(page).second)
+		{
+			m_qPages.push_back(page);
+			bQueued = true;
+		}
+	}
+	if (bQueued)
+		pthread_cond_signal(&m_cond);
+
+	pthread_mutex_unlock(&m_mutex);
+}
+
+void ReadAhead::Reset()
+{
+	pthread_mutex_lock(&m_mutex);
+	m_qPages.clear();
+	m_sIssued.clear();
+	pthread_mutex_unlock(&m_mutex);
+}
+
+void ReadAhead::Stop()
+{
+	pthread_mutex_lock(&m_mutex);
+	if (!m_bRunning)
+	{
+		pthread_mutex_unlock(&m_mutex);
+		return;
+	}
+	m_bStop = true;
+	m_qPages.clear();
+	m_sIssued.clear();
+	pthread_cond_signal(&m_cond);
+	pthread_mutex_unlock(&m_mutex);
+
+	pthread_join(m_thread, NULL);
+	m_bRunning = false;
+}
+
+void* ReadAhead::PrefetchPagesHelper(void* context)
+{
+	return ((ReadAhead *)context)->PrefetchPages();
+}
+
+void* ReadAhead::PrefetchPages()
+{
+	pthread_mutex_lock(&m_mutex);
+	while (true)
+	{
+		while (m_qPages.empty() && !m_bStop)
+			pthread_cond_wait(&m_cond, &m_mutex);
+		if (m_bStop)
+			break;
+
+		off_t page = m_qPages.front();
+		m_qPages.pop_front();
+
+		// do the I/O without holding up the reader
+		pthread_mutex_unlock(&m_mutex);
+		m_pFile->Prefetch(page);
+		pthread_mutex_lock(&m_mutex);
+	}
+	pthread_mutex_unlock(&m_mutex);
+	return NULL;
+}
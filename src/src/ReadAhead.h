@@ -0,0 +1,55 @@
+#ifndef READ_AHEAD_H
+#define READ_AHEAD_H
+
+#include <pthread.h>
+#include <sys/types.h>
+#include <deque>
+#include <set>
+#include "Defs.h"
+#include "File.h"
+
+using namespace std;
+
+// Background prefetcher for one File. A reader tells it which page it just
+// got (Advance) and the prefetch thread brings the next m_nWindow pages into
+// memory (through File::Prefetch), so the disk works while the CPU goes
+// through the current page. The thread is only started on the first Advance.
+// Several readers of the same file (eg the runs of a BigQ merge) can share it
+class ReadAhead
+{
+private:
+	File *m_pFile;
+	int m_nWindow;
+
+	pthread_t m_thread;
+	pthread_mutex_t m_mutex;
+	pthread_cond_t m_cond;
+	bool m_bRunning;
+	bool m_bStop;
+
+	deque<off_t> m_qPages;	// pages waiting to be prefetched
+	set<off_t> m_sIssued;	// pages queued since the last Reset
+
+	static void* PrefetchPagesHelper(void*);
+	void* PrefetchPages();
+
+public:
+	ReadAhead(File *pFile, int nWindow = READ_AHEAD_PAGES);
+	~ReadAhead();
+
+	// number of pages kept in flight ahead of the reader, 0 = disabled
+	void SetWindow(int nWindow);
+	int GetWindow() { return m_nWindow; }
+
+	// reader just got "whichPage"; queue the pages following it,
+	// but not beyond "lastPage"
+	void Advance(off_t whichPage, off_t lastPage);
+
+	// reader went back (eg MoveFirst); forget what was queued so far
+	void Reset();
+
+	// drop pending pages and stop the thread; it is restarted if needed
+	void Stop();
+};
+
+#endif
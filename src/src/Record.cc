@@ -1,4 +1,5 @@
 #include "Record.h"
+#include "TextParser.h"
 
 #include <string.h>
 #include <stdio.h>
@@ -6,146 +7,99 @@
 #include <stdlib.h>
 
 
-Record :: Record () {
-	bits = NULL;
+bool Record :: HasNumAtts (char *bits, int nAtts) {
+	int nHeader = sizeof (int) * (nAtts + 1);
+	return ATT_OFFSET (bits, 0) == nHeader || ATT_OFFSET (bits, 0) == ((nHeader + 7) & ~7);
 }
 
-Record :: ~Record () {
-	if (bits != NULL) {
-		delete [] bits;
+unsigned long long Record :: HashAtt (int whichAtt, Type type) {
+	char *att = bits + ATT_OFFSET (bits, whichAtt);
+	const unsigned char *p = (const unsigned char *) att;
+	int nLen;
+	double dVal;
+
+	if (type == Int) {
+		nLen = sizeof (int);
+	} else if (type == Double) {
+		// 0.0 and -0.0 are equal, they must hash the same
+		dVal = *((double *) att);
+		if (dVal == 0)
+			dVal = 0;
+		p = (const unsigned char *) &dVal;
+		nLen = sizeof (double);
+	} else {
+		nLen = strlen (att);
 	}
-	bits = NULL;
-
-}
-
 
-int Record :: ComposeRecord (Schema *mySchema, const char *src) {
-
-	// this is temporary storage
-	char *space = new (std::nothrow) char[PAGE_SIZE];
-	if (space == NULL)
-	{
-		cout << "ERROR : Not enough memory. EXIT !!!\n";
-		exit(1);
+	unsigned long long nHash = 14695981039346656037ull;
+	for (int i = 0; i < nLen; i++) {
+		nHash ^= p[i];
+		nHash *= 1099511628211ull;
 	}
 
-	char *recSpace = new (std::nothrow) char[PAGE_SIZE];
-	if (recSpace == NULL)
-	{
-		cout << "ERROR : Not enough memory. EXIT !!!\n";
-		exit(1);
-	}
+	// FNV leaves the high bits of short keys poorly mixed
+	nHash ^= nHash >> 33;
+	nHash *= 0xff51afd7ed558ccdull;
+	nHash ^= nHash >> 33;
+	nHash *= 0xc4ceb9fe1a85ec53ull;
+	nHash ^= nHash >> 33;
+	return nHash;
+}
 
-	// clear out the present record
-	if (bits != NULL) 
-		delete [] bits;
+Record :: Record () {
 	bits = NULL;
+	ownsBits = true;
+}
 
-	int n = mySchema->GetNumAtts();
-	Attribute *atts = mySchema->GetAtts();
-
-	// this is the current position (int bytes) in the binary
-	// representation of the record that we are dealing with
-	int currentPosInRec = sizeof (int) * (n + 1);
-
-	// loop through all of the attributes
-	int cursor = 0;
-	for (int i = 0; i < n; i++) {
-		
-		// first we suck in the next attribute value
-		int len = 0;
-		while (1) {
-			int nextChar = src[cursor++];
-			if (nextChar == '|')
-				break;
-			else if (nextChar == '\0') {
-				delete [] space;
-				delete [] recSpace;
-				return 0;
-			}
-
-			space[len] = nextChar;
-			len++;
-		}
-
-		// set up the pointer to the current attribute in the record
-		((int *) recSpace)[i + 1] = currentPosInRec;
-
-		// null terminate the string
-		space[len] = 0;
-		len++;
-
-		// then we convert the data to the correct binary representation
-		if (atts[i].myType == Int) {
-			*((int *) &(recSpace[currentPosInRec])) = atoi (space);	
-			currentPosInRec += sizeof (int);
+Record :: ~Record () {
+	FreeBits ();
+}
 
-		} else if (atts[i].myType == Double) {
 
-			// make sure that we are starting at a double-aligned position;
-			// if not, then we put some extra space in there
-			while (currentPosInRec % sizeof(double) != 0) {
-				currentPosInRec += sizeof (int);
-				((int *) recSpace)[i + 1] = currentPosInRec;
-			}
-
-			*((double *) &(recSpace[currentPosInRec])) = atof (space);
-			currentPosInRec += sizeof (double);
+void Record :: FreeBits () {
+	if (bits != NULL && ownsBits) {
+		RecordMemory::Free (bits);
+	}
+	bits = NULL;
+	ownsBits = true;
+}
 
-		} else if (atts[i].myType == String) {
 
-			// align things to the size of an integer if needed
-			if (len % sizeof (int) != 0) {
-				len += sizeof (int) - (len % sizeof (int));
-			}
+int Record :: ComposeRecord (Schema *mySchema, const char *src) {
 
-			strcpy (&(recSpace[currentPosInRec]), space); 
-			currentPosInRec += len;
+	// this is temporary storage, taken again from the slabs of
+	// RecordMemory by the next record
+	char *recSpace = RecordMemory::Alloc (PAGE_SIZE);
 
-		} 
-		
+	// clear out the present record
+	FreeBits ();
+
+	TextParser parser (*mySchema);
+	TextScanner text (src, src + strlen (src));
+	int len = parser.Parse (text, recSpace);
+	if (len == 0) {
+		RecordMemory::Free (recSpace);
+		return 0;
 	}
 
-	// the last thing is to set up the pointer to just past the end of the reocrd
-	((int *) recSpace)[0] = currentPosInRec;
-
 	// and copy over the bits
-	bits = new (std::nothrow) char[currentPosInRec];
-	if (bits == NULL)
-	{
-		cout << "ERROR : Not enough memory. EXIT !!!\n";
-		exit(1);
-	}
+	bits = RecordMemory::Alloc (len);
+	memcpy (bits, recSpace, len);
 
-	memcpy (bits, recSpace, currentPosInRec);	
-
-	delete [] space;
-	delete [] recSpace;
+	RecordMemory::Free (recSpace);
 
 	return 1;
 }
 
 int Record :: SuckNextRecord (Schema *mySchema, FILE *textFile) {
 
-	// this is temporary storage
-	char *space = new (std::nothrow) char[PAGE_SIZE];
-	if (space == NULL)
-	{
-		cout << "ERROR : Not enough memory. EXIT !!!\n";
-		exit(1);
-	}
-
-	char *recSpace = new (std::nothrow) char[PAGE_SIZE];
-	if (recSpace == NULL)
-	{
-		cout << "ERROR : Not enough memory. EXIT !!!\n";
-		exit(1);
-	}
+	// this is temporary storage, taken again from the slabs of
+	// RecordMemory by the next record
+	char *space = RecordMemory::Alloc (PAGE_SIZE);
+	char *recSpace = RecordMemory::Alloc (PAGE_SIZE);
 
 	// clear out the present record
-	if (bits != NULL) 
-		delete [] bits;
-	bits = NULL;
+	FreeBits ();
 
 	int n = mySchema->GetNumAtts();
 	Attribute *atts = mySchema->GetAtts();
@@ -164,8 +118,8 @@ int Record :: SuckNextRecord (Schema *mySchema, FILE *textFile) {
 			if (nextChar == '|')
 				break;
 			else if (nextChar == EOF) {
-				delete [] space;
-				delete [] recSpace;
+				RecordMemory::Free (space);
+				RecordMemory::Free (recSpace);
 				return 0;
 			}
 
@@ -182,7 +136,7 @@ int Record :: SuckNextRecord (Schema *mySchema, FILE *textFile) {
 
 		// then we convert the data to the correct binary representation
 		if (atts[i].myType == Int) {
-			*((int *) &(recSpace[currentPosInRec])) = atoi (space);	
+			*((int *) &(recSpace[currentPosInRec])) = TextParser::ParseInt (space, space + len);
 			currentPosInRec += sizeof (int);
 
 		} else if (atts[i].myType == Double) {
@@ -190,11 +144,12 @@ int Record :: SuckNextRecord (Schema *mySchema, FILE *textFile) {
 			// make sure that we are starting at a double-aligned position;
 			// if not, then we put some extra space in there
 			while (currentPosInRec % sizeof(double) != 0) {
+				*((int *) &(recSpace[currentPosInRec])) = 0;
 				currentPosInRec += sizeof (int);
 				((int *) recSpace)[i + 1] = currentPosInRec;
 			}
 
-			*((double *) &(recSpace[currentPosInRec])) = atof (space);
+			*((double *) &(recSpace[currentPosInRec])) = TextParser::ParseDouble (space, space + len);
 			currentPosInRec += sizeof (double);
 
 		} else if (atts[i].myType == String) {
@@ -204,6 +159,9 @@ int Record :: SuckNextRecord (Schema *mySchema, FILE *textFile) {
 				len += sizeof (int) - (len % sizeof (int));
 			}
 
+			// the padding is zeroed, so that equal records are equal bytes
+			// (and pack well, see File)
+			memset (&(recSpace[currentPosInRec]), 0, len);
 			strcpy (&(recSpace[currentPosInRec]), space); 
 			currentPosInRec += len;
 
@@ -215,27 +173,39 @@ int Record :: SuckNextRecord (Schema *mySchema, FILE *textFile) {
 	((int *) recSpace)[0] = currentPosInRec;
 
 	// and copy over the bits
-	bits = new (std::nothrow) char[currentPosInRec];
-	if (bits == NULL)
-	{
-		cout << "ERROR : Not enough memory. EXIT !!!\n";
-		exit(1);
-	}
-
+	bits = RecordMemory::Alloc (currentPosInRec);
 	memcpy (bits, recSpace, currentPosInRec);	
 
-	delete [] space;
-	delete [] recSpace;
+	RecordMemory::Free (space);
+	RecordMemory::Free (recSpace);
 
 	return 1;
 }
 
 
+int Record :: SuckNextRecord (TextParser &parser, TextScanner &text, char *space) {
+
+	// clear out the present record
+	FreeBits ();
+
+	if (!parser.Parse (text, space))
+		return 0;
+	SetView (space);
+	return 1;
+}
+
+
 void Record :: SetBits (char *bits) {
-	delete [] this->bits;
+	FreeBits ();
 	this->bits = bits;
 }
 
+void Record :: SetView (char *bits) {
+	FreeBits ();
+	this->bits = bits;
+	ownsBits = false;
+}
+
 char* Record :: GetBits (void) {
 	return bits;
 }
@@ -243,14 +213,9 @@ char* Record :: GetBits (void) {
 
 void Record :: CopyBits(char *bits, int b_len) {
 
-	delete [] this->bits;
+	FreeBits ();
 
-	this->bits = new (std::nothrow) char[b_len];
-	if (this->bits == NULL)
-	{
-		cout << "ERROR : Not enough memory. EXIT !!!\n";
-		exit(1);
-	}
+	this->bits = RecordMemory::Alloc (b_len);
 
 	memcpy (this->bits, bits, b_len);
 	
@@ -258,7 +223,18 @@ void Record :: CopyBits(char *bits, int b_len) {
 
 
 void Record :: Consume (Record *fromMe) {
-	delete [] bits;
+	if (fromMe == this)
+		return;
+
+	// a view has to be copied out, the page it points into will be reused
+	if (!fromMe->ownsBits && fromMe->bits != NULL) {
+		CopyBits (fromMe->bits, ((int *) fromMe->bits)[0]);
+		fromMe->bits = NULL;
+		fromMe->ownsBits = true;
+		return;
+	}
+
+	FreeBits ();
 	bits = fromMe->bits;
 	fromMe->bits = NULL;
 
@@ -267,13 +243,13 @@ void Record :: Consume (Record *fromMe) {
 
 void Record :: Copy (Record *copyMe) {
 	// this is a deep copy, so allocate the bits and move them over!
-	delete [] bits;
-	bits = new (std::nothrow) char[((int *) copyMe->bits)[0]];
-	if (bits == NULL)
-	{
-		cout << "ERROR : Not enough memory. EXIT !!!\n";
-		exit(1);
+	if (copyMe == this) {
+		if (!ownsBits)
+			CopyBits (copyMe->bits, ((int *) copyMe->bits)[0]);
+		return;
 	}
+	FreeBits ();
+	bits = RecordMemory::Alloc (((int *) copyMe->bits)[0]);
 
 	memcpy (bits, copyMe->bits, ((int *) copyMe->bits)[0]);
 
@@ -295,12 +271,7 @@ void Record :: Project (int *attsToKeep, int numAttsToKeep, int numAttsNow) {
 	}
 
 	// now, allocate the new bits
-	char *newBits = new (std::nothrow) char[totSpace];
-	if (newBits == NULL)
-	{
-		cout << "ERROR : Not enough memory. EXIT !!!\n";
-		exit(1);
-	}
+	char *newBits = RecordMemory::Alloc (totSpace);
 
 	// record the total length of the record
 	*((int *) newBits) = totSpace;
@@ -332,7 +303,7 @@ void Record :: Project (int *attsToKeep, int numAttsToKeep, int numAttsNow) {
 	}
 
 	// kill the old bits
-	delete [] bits;
+	FreeBits ();
 
 	// and attach the new ones
 	bits = newBits;
@@ -340,10 +311,9 @@ void Record :: Project (int *attsToKeep, int numAttsToKeep, int numAttsNow) {
 }
 
 
-// consumes right record and leaves the left record as it is
+// leaves both records as they are
 void Record :: MergeRecords (Record *left, Record *right, int numAttsLeft, int numAttsRight, int *attsToKeep, int numAttsToKeep, int startOfRight) {
-	delete [] bits;
-	bits = NULL;
+	FreeBits ();
 
 	// if one of the records is empty, new record is non-empty record
 	if(numAttsLeft == 0 ) {
@@ -377,12 +347,7 @@ void Record :: MergeRecords (Record *left, Record *right, int numAttsLeft, int n
 	}
 
 	// now, allocate the new bits
-	bits = new (std::nothrow) char[totSpace+1];
-	if (bits == NULL)
-	{
-		cout << "ERROR : Not enough memory. EXIT !!!\n";
-		exit(1);
-	}
+	bits = RecordMemory::Alloc (totSpace+1);
 
 	// record the total length of the record
 	*((int *) bits) = totSpace;
@@ -13,6 +13,10 @@
 #include "File.h"
 #include "Comparison.h"
 #include "ComparisonEngine.h"
+#include "RecordMemory.h"
+
+class TextParser;
+class TextScanner;
 
 
 
@@ -21,24 +25,42 @@
 //	2) Next sizeof(int) bytes: byte offset to the start of the first att
 //	3) Byte offset to the start of the att in position numAtts
 //	4) Bits encoding the record's data
+// A record either owns its bits, or is a view on bits owned by somebody else
+// (a Page hands out views from GetFirst). A view is read-only; it is turned
+// into an owned copy as soon as the record is consumed by someone else.
+// The bits a record owns come from RecordMemory
+
+// where attribute whichAtt starts in the bits of a record, from its header
+#define ATT_OFFSET(bits, whichAtt) (((int *) (bits))[(whichAtt) + 1])
 
 class Record {
 
 friend class ComparisonEngine;
 friend class Page;
+friend class Pax;
+friend class DictionarySet;
+friend class RecordArena;
+friend class RecordLayout;
 
 private:
+	bool ownsBits;		// false if bits points into someone else's buffer
+
 	char* GetBits ();
 	void SetBits (char *bits);
+	void SetView (char *bits);
 	void CopyBits(char *bits, int b_len);
 
+	// release the bits, if they are ours
+	void FreeBits ();
+
 public:
 	char *bits;
 	Record ();
 	~Record();
 
 	// suck the contents of the record fromMe into this; note that after
-	// this call, fromMe will no longer have anything inside of it
+	// this call, fromMe will no longer have anything inside of it. If fromMe
+	// is a view, the bits are copied so that this record owns them
 	void Consume (Record *fromMe);
 
 	// make a copy of the record fromMe; note that this is far more 
@@ -46,11 +68,30 @@ public:
 	// only a pointer operation
 	void Copy (Record *copyMe);
 
+	// true if the record is a view on bits that it does not own
+	bool IsView () { return bits != NULL && !ownsBits; }
+
+	// true if the bits have nAtts attributes: the first one comes right
+	// after the header, or after one more int if it is a double
+	static bool HasNumAtts (char *bits, int nAtts);
+
+	// value of Int attribute whichAtt
+	int GetIntAtt (int whichAtt) { return *((int *) (bits + ATT_OFFSET (bits, whichAtt))); }
+
+	// 64-bit hash of attribute whichAtt, of the given type; equal values
+	// hash the same, so 0.0 and -0.0 do too
+	unsigned long long HashAtt (int whichAtt, Type type);
+
 	// reads the next record from a pointer to a text file; also requires
 	// that the schema be given; returns a 0 if there is no data left or
 	// if there is an error and returns a 1 otherwise
 	int SuckNextRecord (Schema *mySchema, FILE *textFile);
 
+	// same, from the text in memory the scanner goes through, which is
+	// left at the start of the next line (see TextParser). The record is
+	// laid out in space, which holds PAGE_SIZE bytes, and is a view on it
+	int SuckNextRecord (TextParser &parser, TextScanner &text, char *space);
+
 	int ComposeRecord (Schema *mySchema, const char *src);
 
 	// this projects away various attributes... 
@@ -60,7 +101,7 @@ public:
 	void Project (int *attsToKeep, int numAttsToKeep, int numAttsNow);
 
 	// takes two input records and creates a new record by concatenating them;
-	// this is useful for a join operation
+	// this is useful for a join operation. Neither of them is changed
 	// attsToKeep[] = {0, 1, 2, 0, 2, 4} --gets 0,1,2 records from left 0, 2, 4 recs from right and startOfRight=3
 	// startOfRight is the index position in attsToKeep for the first att from right rec
 	void MergeRecords (Record *left, Record *right, int numAttsLeft, 
@@ -0,0 +1,234 @@
+#include <string.h>
+#include <stdlib.h>
+#include <fstream>
+#include <sstream>
+#include "RecordLayout.h"
+
+RecordLayout::RecordLayout() : m_vTypes(), m_vPos(), m_nStringsAt(0), m_nStrings(0), m_nDoubles(0)
+{}
+
+void RecordLayout::Clear()
+{
+	m_vTypes.clear();
+	m_vPos.clear();
+	m_nStringsAt = 0;
+	m_nStrings = 0;
+	m_nDoubles = 0;
+}
+
+void RecordLayout::MakePositions()
+{
+	int nAtts = m_vTypes.size();
+	m_vPos.resize(nAtts);
+	m_nStringsAt = sizeof(int);
+	m_nStrings = 0;
+	m_nDoubles = 0;
+	for (int i = 0; i < nAtts; i++)
+	{
+		if (m_vTypes[i] == String)
+		{
+			m_vPos[i] = m_nStrings++;
+			continue;
+		}
+		m_vPos[i] = m_nStringsAt;
+		if (m_vTypes[i] == Double)
+		{
+			m_nStringsAt += sizeof(double);
+			m_nDoubles++;
+		}
+		else
+			m_nStringsAt += sizeof(int);
+	}
+}
+
+void RecordLayout::Open(const string &binPath)
+{
+	Clear();
+	ifstream meta_in;
+	meta_in.open((binPath + ".meta.data").c_str());
+	string line;
+	while (getline(meta_in, line))
+	{
+		stringstream ss(line);
+		string word, sTypes;
+		int nFormat;
+		if (!(ss >> word) || word.compare("format") != 0 || !(ss >> nFormat))
+			continue;
+		if (nFormat != RECORD_FORMAT_V2 || !(ss >> sTypes))
+		{
+			cerr << "BAD: " << binPath << " has records of an unknown format\n";
+			exit(1);
+		}
+		for (int i = 0; i < sTypes.size(); i++)
+		{
+			if (sTypes[i] == 'I')
+				m_vTypes.push_back(Int);
+			else if (sTypes[i] == 'D')
+				m_vTypes.push_back(Double);
+			else
+				m_vTypes.push_back(String);
+		}
+	}
+	MakePositions();
+}
+
+void RecordLayout::SetTypes(Schema &mySchema)
+{
+	Clear();
+	Attribute *atts = mySchema.GetAtts();
+	for (int i = 0; i < mySchema.GetNumAtts(); i++)
+		m_vTypes.push_back(atts[i].myType);
+	MakePositions();
+}
+
+void RecordLayout::Write(const string &binPath)
+{
+	string sTypes;
+	for (int i = 0; i < m_vTypes.size(); i++)
+		sTypes += (m_vTypes[i] == Int) ? 'I' : (m_vTypes[i] == Double) ? 'D' : 'S';
+
+	ofstream meta_out;
+	meta_out.open((binPath + ".meta.data").c_str(), ios::app);
+	meta_out << "\nformat " << RECORD_FORMAT_V2 << " " << sTypes << "\n";
+	meta_out.close();
+}
+
+void RecordLayout::Encode(Record &rec)
+{
+	char *src = rec.bits;
+	int nAtts = m_vTypes.size();
+	if (!Record::HasNumAtts(src, nAtts))
+	{
+		cerr << "BAD: a record of some other schema in a file of records of "
+			 << nAtts << " attributes\n";
+		exit(1);
+	}
+
+	int nLen = m_nStringsAt;
+	for (int i = 0; i < nAtts; i++)
+	{
+		if (m_vTypes[i] == String)
+			nLen += sizeof(unsigned short) + strlen(src + ATT_OFFSET(src, i));
+	}
+	// too long, it stays as it is
+	if (nLen > RECORD_V2_MAX_LENGTH)
+		return;
+
+	char *bits = RecordMemory::Alloc(nLen);
+	((int *) bits)[0] = nLen;
+	char *str = bits + m_nStringsAt;
+	for (int i = 0; i < nAtts; i++)
+	{
+		char *value = src + ATT_OFFSET(src, i);
+		if (m_vTypes[i] == Int)
+			memcpy(bits + m_vPos[i], value, sizeof(int));
+		else if (m_vTypes[i] == Double)
+			memcpy(bits + m_vPos[i], value, sizeof(double));
+		else
+		{
+			unsigned short nChars = strlen(value);
+			memcpy(str, &nChars, sizeof(unsigned short));
+			memcpy(str + sizeof(unsigned short), value, nChars);
+			str += sizeof(unsigned short) + nChars;
+		}
+	}
+	rec.SetBits(bits);
+}
+
+// the layout of SuckNextRecord: ints, and strings padded to an int,
+// back to back, and doubles double aligned
+int RecordLayout::Convert(char *src, char *dst)
+{
+	int nStored = ((int *) src)[0];
+	if (nStored > RECORD_V2_MAX_LENGTH)
+	{
+		memcpy(dst, src, nStored);
+		return nStored;
+	}
+
+	int nAtts = m_vTypes.size();
+	int pos = sizeof(int) * (nAtts + 1);
+	char *str = src + m_nStringsAt;
+	for (int i = 0; i < nAtts; i++)
+	{
+		ATT_OFFSET(dst, i) = pos;
+		if (m_vTypes[i] == Int)
+		{
+			memcpy(dst + pos, src + m_vPos[i], sizeof(int));
+			pos += sizeof(int);
+		}
+		else if (m_vTypes[i] == Double)
+		{
+			while (pos % sizeof(double) != 0)
+			{
+				*((int *) (dst + pos)) = 0;
+				pos += sizeof(int);
+				ATT_OFFSET(dst, i) = pos;
+			}
+			memcpy(dst + pos, src + m_vPos[i], sizeof(double));
+			pos += sizeof(double);
+		}
+		else
+		{
+			unsigned short nChars;
+			memcpy(&nChars, str, sizeof(unsigned short));
+			str += sizeof(unsigned short);
+			int len = (nChars + 1 + sizeof(int) - 1) & ~(sizeof(int) - 1);
+			memcpy(dst + pos, str, nChars);
+			memset(dst + pos + nChars, 0, len - nChars);
+			str += nChars;
+			pos += len;
+		}
+	}
+	((int *) dst)[0] = pos;
+	return pos;
+}
+
+void RecordLayout::Decode(Record &stored, Record &rec)
+{
+	char *bits = RecordMemory::Alloc(((int *) stored.bits)[0] + GetMaxGrowth());
+	Convert(stored.bits, bits);
+	rec.SetBits(bits);
+}
+
+int RecordLayout::Decode(Record &stored, char *dst, Record &rec)
+{
+	int len = Convert(stored.bits, dst);
+	rec.SetView(dst);
+	return len;
+}
+
+// the offsets, an int before every double, and the NUL and the padding
+// of every string instead of its 16 bit length
+int RecordLayout::GetMaxGrowth()
+{
+	return sizeof(int) * (m_vTypes.size() + m_nDoubles) + 2 * m_nStrings;
+}
+
+char* RecordLayout::GetAtt(char *stored, int whichAtt, int &nLength)
+{
+	char *value;
+	if (((int *) stored)[0] > RECORD_V2_MAX_LENGTH)
+	{
+		value = stored + ATT_OFFSET(stored, whichAtt);
+		nLength = (m_vTypes[whichAtt] == String) ? strlen(value) : 0;
+		return value;
+	}
+
+	nLength = 0;
+	if (m_vTypes[whichAtt] != String)
+		return stored + m_vPos[whichAtt];
+
+	// the strings before it have to be stepped over
+	value = stored + m_nStringsAt;
+	unsigned short nChars;
+	for (int i = 0; i <= m_vPos[whichAtt]; i++)
+	{
+		memcpy(&nChars, value, sizeof(unsigned short));
+		value += sizeof(unsigned short);
+		if (i < m_vPos[whichAtt])
+			value += nChars;
+	}
+	nLength = nChars;
+	return value;
+}
@@ -0,0 +1,80 @@
+#ifndef RECORD_LAYOUT_H
+#define RECORD_LAYOUT_H
+
+#include <string>
+#include <vector>
+#include "Defs.h"
+#include "Record.h"
+#include "Schema.h"
+
+using namespace std;
+
+// longest record RECORD_FORMAT_V2 can hold, lengths of strings are kept
+// in 16 bits
+#define RECORD_V2_MAX_LENGTH 65535
+
+// The compact layout (RECORD_FORMAT_V2) of the records of a heap file,
+// given by the types of their attributes, which the .meta.data of the
+// file lists in a "format 2 <types>" line, e.g. "format 2 IIDS".
+// A record of Record.h spends 4 bytes per attribute on its offset, pads
+// doubles to 8 bytes and strings, with their NUL, to 4. A compact record
+// has no offsets:
+//  - its length, an int, as every record a Page holds
+//  - the Int and Double values, 4 and 8 bytes, back to back and not
+//    aligned: every one of them is at the same place in every record
+//  - every String value as its length in 16 bits, then its characters
+// so that a record with no String attribute is nothing but its values.
+// A record whose compact form would be longer than RECORD_V2_MAX_LENGTH
+// is stored as it is; its length tells it apart.
+// FileUtil encodes the records it is given and decodes those it hands
+// out; ComparisonEngine applies a CNF to the compact records directly
+class RecordLayout
+{
+	private:
+		vector<Type> m_vTypes;
+		vector<int> m_vPos;		// of an Int or a Double: where it is in a record,
+								// of a String: how many String attributes come first
+		int m_nStringsAt;		// where the strings start, after the fixed values
+		int m_nStrings;
+		int m_nDoubles;
+
+		void MakePositions();
+
+		// lays out the compact record src in the layout of Record in dst;
+		// returns its length
+		int Convert(char *src, char *dst);
+
+	public:
+		RecordLayout();
+		~RecordLayout() {}
+
+		// reads the layout of the base file binPath, empty if its records
+		// are stored in the layout of Record
+		void Open(const string &binPath);
+
+		// for CREATE TABLE: the layout of records of the schema, which
+		// Write adds to the .meta.data of the base file
+		void SetTypes(Schema &mySchema);
+		void Write(const string &binPath);
+
+		void Clear();
+		bool IsEmpty() { return m_vTypes.empty(); }
+
+		// the record, of Record.h, becomes its compact form
+		void Encode(Record &rec);
+
+		// the record a compact one stands for, in rec, which owns its bits
+		void Decode(Record &stored, Record &rec);
+
+		// same, laid out in dst, which must hold the stored record and
+		// GetMaxGrowth() more bytes; rec is a view on it. Returns its length
+		int Decode(Record &stored, char *dst, Record &rec);
+		int GetMaxGrowth();
+
+		// where attribute whichAtt of the stored record is; nLength gets the
+		// number of characters of a string, without the NUL a record of
+		// Record.h has (the one of the compact form has none)
+		char* GetAtt(char *stored, int whichAtt, int &nLength);
+};
+
+#endif
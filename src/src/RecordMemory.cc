@@ -0,0 +1,315 @@
+#include "RecordMemory.h"
+#include "Record.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+
+// bytes before the block handed out, the first int is the class
+#define SLAB_HEADER 8
+
+// class of the blocks too large for a slab
+#define SLAB_LARGE -1
+
+pthread_once_t RecordMemory::m_keyOnce = PTHREAD_ONCE_INIT;
+pthread_key_t RecordMemory::m_cacheKey;
+pthread_mutex_t RecordMemory::m_depotMutex = PTHREAD_MUTEX_INITIALIZER;
+SlabList RecordMemory::m_vDepot[RECORD_SLAB_CLASSES];
+long RecordMemory::m_nDepotBytes = 0;
+RecordMemoryStats RecordMemory::m_retiredStats;
+RecordMemory::ThreadCache *RecordMemory::m_pThreads = NULL;
+
+// a free block links to the next one of its list; the first block of a
+// batch in the depot also links to the next batch and has its length
+static inline char*& NextBlock(char *p) { return ((char **) p)[0]; }
+static inline char*& NextBatch(char *p) { return ((char **) p)[1]; }
+static inline long& BatchCount(char *p) { return ((long *) p)[2]; }
+
+void RecordMemoryStats::Add(const RecordMemoryStats &other)
+{
+	nAllocs += other.nAllocs;
+	nCached += other.nCached;
+	nHeapAllocs += other.nHeapAllocs;
+	nFrees += other.nFrees;
+	nArenaAllocs += other.nArenaAllocs;
+	nArenaResets += other.nArenaResets;
+}
+
+void RecordMemory::MakeKey()
+{
+	pthread_key_create(&m_cacheKey, &ReleaseCache);
+}
+
+// the cache of the calling thread; the key only gets it released
+static __thread void *t_pCache = NULL;
+
+RecordMemory::ThreadCache* RecordMemory::GetCache()
+{
+	if (t_pCache != NULL)
+		return (ThreadCache *) t_pCache;
+
+	pthread_once(&m_keyOnce, &MakeKey);
+	ThreadCache *pCache = new (std::nothrow) ThreadCache;
+	if (pCache == NULL)
+	{
+		cout << "ERROR : Not enough memory. EXIT !!!\n";
+		exit(1);
+	}
+	pthread_setspecific(m_cacheKey, pCache);
+	t_pCache = pCache;
+
+	pthread_mutex_lock(&m_depotMutex);
+	pCache->pPrev = NULL;
+	pCache->pNext = m_pThreads;
+	if (m_pThreads != NULL)
+		m_pThreads->pPrev = pCache;
+	m_pThreads = pCache;
+	pthread_mutex_unlock(&m_depotMutex);
+	return pCache;
+}
+
+// called as a thread exits: its free blocks go to the depot
+void RecordMemory::ReleaseCache(void *p)
+{
+	ThreadCache *pCache = (ThreadCache *) p;
+	t_pCache = NULL;
+	for (int c = 0; c < RECORD_SLAB_CLASSES; c++)
+	{
+		while (pCache->vLists[c].nCount > 0)
+			PutBatch(pCache, c);
+	}
+
+	pthread_mutex_lock(&m_depotMutex);
+	m_retiredStats.Add(pCache->stats);
+	if (pCache->pPrev != NULL)
+		pCache->pPrev->pNext = pCache->pNext;
+	else
+		m_pThreads = pCache->pNext;
+	if (pCache->pNext != NULL)
+		pCache->pNext->pPrev = pCache->pPrev;
+	pthread_mutex_unlock(&m_depotMutex);
+	delete pCache;
+}
+
+// 64 bytes, then 2^k + j * 2^(k-2) for j = 1..4 from k = 6 on
+int RecordMemory::GetClass(int nLength)
+{
+	if (nLength <= RECORD_SLAB_MIN)
+		return 0;
+	if (nLength > PAGE_SIZE)
+		return SLAB_LARGE;
+
+	// 2^k < nLength <= 2^(k+1)
+	int k = 31 - __builtin_clz(nLength - 1);
+	int nStep = 1 << (k - 2);
+	int j = (nLength - (1 << k) + nStep - 1) / nStep;
+	int nClass = 1 + (k - 6) * 4 + (j - 1);
+	return nClass < RECORD_SLAB_CLASSES ? nClass : SLAB_LARGE;
+}
+
+int RecordMemory::GetClassSize(int nClass)
+{
+	if (nClass == 0)
+		return RECORD_SLAB_MIN;
+	int k = 6 + (nClass - 1) / 4;
+	int j = (nClass - 1) % 4 + 1;
+	return (1 << k) + j * (1 << (k - 2));
+}
+
+void RecordMemory::PutBatch(ThreadCache *pCache, int nClass)
+{
+	// the first half of the list goes, half of the blocks are kept
+	SlabList &list = pCache->vLists[nClass];
+	int nMove = (list.nCount + 1) / 2;
+	char *pFirst = list.pHead;
+	char *pLast = pFirst;
+	for (int i = 1; i < nMove; i++)
+		pLast = NextBlock(pLast);
+	list.pHead = NextBlock(pLast);
+	list.nCount -= nMove;
+	NextBlock(pLast) = NULL;
+
+	long nBytes = (long) nMove * (GetClassSize(nClass) + SLAB_HEADER);
+	pthread_mutex_lock(&m_depotMutex);
+	bool bKeep = m_nDepotBytes + nBytes <= RECORD_SLAB_DEPOT_BYTES;
+	if (bKeep)
+	{
+		BatchCount(pFirst) = nMove;
+		NextBatch(pFirst) = m_vDepot[nClass].pHead;
+		m_vDepot[nClass].pHead = pFirst;
+		m_vDepot[nClass].nCount++;
+		m_nDepotBytes += nBytes;
+	}
+	pthread_mutex_unlock(&m_depotMutex);
+
+	if (!bKeep)
+	{
+		SlabList batch;
+		batch.pHead = pFirst;
+		batch.nCount = nMove;
+		FreeList(batch);
+	}
+}
+
+bool RecordMemory::GetBatch(ThreadCache *pCache, int nClass)
+{
+	pthread_mutex_lock(&m_depotMutex);
+	char *pFirst = m_vDepot[nClass].pHead;
+	if (pFirst != NULL)
+	{
+		m_vDepot[nClass].pHead = NextBatch(pFirst);
+		m_vDepot[nClass].nCount--;
+		m_nDepotBytes -= BatchCount(pFirst) * (GetClassSize(nClass) + SLAB_HEADER);
+	}
+	pthread_mutex_unlock(&m_depotMutex);
+
+	if (pFirst == NULL)
+		return false;
+	// the list is empty when a batch is asked for
+	SlabList &list = pCache->vLists[nClass];
+	list.pHead = pFirst;
+	list.nCount = BatchCount(pFirst);
+	return true;
+}
+
+void RecordMemory::FreeList(SlabList &list)
+{
+	while (list.pHead != NULL)
+	{
+		char *p = list.pHead;
+		list.pHead = NextBlock(p);
+		delete [] (p - SLAB_HEADER);
+	}
+	list.nCount = 0;
+}
+
+char* RecordMemory::Alloc(int nLength)
+{
+	ThreadCache *pCache = GetCache();
+	pCache->stats.nAllocs++;
+
+	int nClass = GetClass(nLength);
+	if (nClass != SLAB_LARGE)
+	{
+		SlabList &list = pCache->vLists[nClass];
+		if (list.nCount > 0 || GetBatch(pCache, nClass))
+		{
+			char *p = list.pHead;
+			list.pHead = NextBlock(p);
+			list.nCount--;
+			pCache->stats.nCached++;
+			return p;
+		}
+		nLength = GetClassSize(nClass);
+	}
+
+	char *pBlock = new (std::nothrow) char[nLength + SLAB_HEADER];
+	if (pBlock == NULL)
+	{
+		cout << "ERROR : Not enough memory. EXIT !!!\n";
+		exit(1);
+	}
+	pCache->stats.nHeapAllocs++;
+	((int *) pBlock)[0] = nClass;
+	return pBlock + SLAB_HEADER;
+}
+
+void RecordMemory::Free(char *bits)
+{
+	if (bits == NULL)
+		return;
+
+	ThreadCache *pCache = GetCache();
+	pCache->stats.nFrees++;
+
+	int nClass = ((int *) (bits - SLAB_HEADER))[0];
+	if (nClass == SLAB_LARGE)
+	{
+		delete [] (bits - SLAB_HEADER);
+		return;
+	}
+
+	SlabList &list = pCache->vLists[nClass];
+	NextBlock(bits) = list.pHead;
+	list.pHead = bits;
+	list.nCount++;
+
+	int nLimit = RECORD_SLAB_CACHE_BYTES / GetClassSize(nClass);
+	if (list.nCount > max(nLimit, 4))
+		PutBatch(pCache, nClass);
+}
+
+void RecordMemory::GetStats(RecordMemoryStats &stats)
+{
+	pthread_mutex_lock(&m_depotMutex);
+	stats = m_retiredStats;
+	for (ThreadCache *p = m_pThreads; p != NULL; p = p->pNext)
+		stats.Add(p->stats);
+	pthread_mutex_unlock(&m_depotMutex);
+}
+
+void RecordMemory::PrintStats(ostream &out)
+{
+	RecordMemoryStats stats;
+	GetStats(stats);
+	if (stats.nAllocs > 0)
+		out << "Record memory: " << stats.nAllocs << " blocks, "
+			<< stats.nHeapAllocs << " of them from the heap; "
+			<< stats.nArenaAllocs << " records in arenas, reset "
+			<< stats.nArenaResets << " times\n";
+}
+
+
+RecordArena::RecordArena() : m_vBlocks(), m_nBlock(0), m_nUsed(0), m_vLarge()
+{
+}
+
+RecordArena::~RecordArena()
+{
+	Reset();
+	for (int i = 0; i < m_vBlocks.size(); i++)
+		RecordMemory::Free(m_vBlocks[i]);
+}
+
+char* RecordArena::Alloc(int nLength)
+{
+	RecordMemory::GetCache()->stats.nArenaAllocs++;
+
+	// keep doubles aligned
+	nLength = (nLength + 7) & ~7;
+	if (nLength > RECORD_ARENA_BLOCK)
+	{
+		m_vLarge.push_back(RecordMemory::Alloc(nLength));
+		return m_vLarge.back();
+	}
+
+	if (m_nBlock < m_vBlocks.size() && m_nUsed + nLength > RECORD_ARENA_BLOCK)
+	{
+		m_nBlock++;
+		m_nUsed = 0;
+	}
+	if (m_nBlock == m_vBlocks.size())
+		m_vBlocks.push_back(RecordMemory::Alloc(RECORD_ARENA_BLOCK));
+
+	char *p = m_vBlocks[m_nBlock] + m_nUsed;
+	m_nUsed += nLength;
+	return p;
+}
+
+void RecordArena::Copy(Record &fromMe, Record &rec)
+{
+	int nLength = ((int *) fromMe.bits)[0];
+	char *bits = Alloc(nLength);
+	memcpy(bits, fromMe.bits, nLength);
+	rec.SetView(bits);
+}
+
+void RecordArena::Reset()
+{
+	RecordMemory::GetCache()->stats.nArenaResets++;
+	for (int i = 0; i < m_vLarge.size(); i++)
+		RecordMemory::Free(m_vLarge[i]);
+	m_vLarge.clear();
+	m_nBlock = 0;
+	m_nUsed = 0;
+}
@@ -0,0 +1,141 @@
+#ifndef RECORD_MEMORY_H
+#define RECORD_MEMORY_H
+
+#include <pthread.h>
+#include <vector>
+#include <iostream>
+#include "Defs.h"
+
+using namespace std;
+
+class Record;
+
+// size classes of the slabs: 64 bytes, then four classes between every
+// power of 2 and the next one, up to PAGE_SIZE; larger blocks come from
+// the heap every time
+#define RECORD_SLAB_MIN 64
+#define RECORD_SLAB_CLASSES 45
+
+// bytes of free blocks a thread keeps of every class; past it, half of
+// them go to the depot shared by the threads
+#define RECORD_SLAB_CACHE_BYTES 262144
+
+// bytes of free blocks the depot keeps, the others go back to the heap
+#define RECORD_SLAB_DEPOT_BYTES 16777216
+
+// bytes of the blocks a RecordArena carves records out of
+#define RECORD_ARENA_BLOCK PAGE_SIZE
+
+// free blocks of one class
+struct SlabList
+{
+	char *pHead;	// linked through their first bytes
+	int nCount;
+
+	SlabList() : pHead(NULL), nCount(0) {}
+};
+
+// what a thread did, see RecordMemory::PrintStats
+struct RecordMemoryStats
+{
+	unsigned long nAllocs;			// blocks handed out
+	unsigned long nCached;			// of them, reused from the thread
+	unsigned long nHeapAllocs;		// of them, new from the heap
+	unsigned long nFrees;
+	unsigned long nArenaAllocs;		// records copied into an arena
+	unsigned long nArenaResets;
+
+	RecordMemoryStats() : nAllocs(0), nCached(0), nHeapAllocs(0), nFrees(0),
+		nArenaAllocs(0), nArenaResets(0) {}
+	void Add(const RecordMemoryStats &other);
+};
+
+// Allocator of the bits of records, and of buffers the size of a page.
+// Records come and go by the million in a load, a sort or a join, each of
+// them with a malloc and a free; blocks freed here are kept in slabs of
+// the same size class and handed out again. Every thread has its own free
+// lists, so the hot path takes no lock; since the records that go through
+// a pipe are allocated by one thread and freed by another, free blocks
+// move between threads in batches through a depot.
+// A block starts with 8 bytes that give its class, so that doubles in the
+// record stay aligned. Bits given to a Record must come from Alloc, as
+// the Record gives them back with Free
+class RecordMemory
+{
+	friend class RecordArena;
+
+	private:
+		// free lists and statistics of a thread, linked with those of the
+		// other live threads
+		struct ThreadCache
+		{
+			SlabList vLists[RECORD_SLAB_CLASSES];
+			RecordMemoryStats stats;
+			ThreadCache *pPrev, *pNext;
+		};
+
+		static pthread_once_t m_keyOnce;
+		static pthread_key_t m_cacheKey;
+
+		// batches of free blocks handed back by threads, linked through
+		// their first blocks, and the statistics of the threads that are
+		// gone. Nothing here has a destructor, records may still be freed
+		// by the destructors of static objects
+		static pthread_mutex_t m_depotMutex;
+		static SlabList m_vDepot[RECORD_SLAB_CLASSES];
+		static long m_nDepotBytes;
+		static RecordMemoryStats m_retiredStats;
+		static ThreadCache *m_pThreads;
+
+		static void MakeKey();
+		static void ReleaseCache(void *pCache);
+		static ThreadCache* GetCache();
+
+		static int GetClass(int nLength);
+		static int GetClassSize(int nClass);
+
+		// a batch of half of the blocks of a list that got too long goes
+		// to the depot, an empty list takes a batch from it
+		static void PutBatch(ThreadCache *pCache, int nClass);
+		static bool GetBatch(ThreadCache *pCache, int nClass);
+		static void FreeList(SlabList &list);
+
+	public:
+		// nLength bytes, aligned for a double
+		static char* Alloc(int nLength);
+
+		// a block from Alloc, NULL does nothing
+		static void Free(char *bits);
+
+		// of every thread so far
+		static void GetStats(RecordMemoryStats &stats);
+		static void PrintStats(ostream &out);
+};
+
+// Records that live and die together, such as those of a sorted run, are
+// copied one after the other into blocks of RECORD_ARENA_BLOCK bytes, and
+// freed all at once by Reset; the blocks are kept for the next ones.
+// The records are views (see Record) on the arena, valid until Reset.
+// An arena is used by one thread at a time
+class RecordArena
+{
+	private:
+		vector<char*> m_vBlocks;
+		int m_nBlock;		// block being filled
+		int m_nUsed;		// bytes of it taken
+		vector<char*> m_vLarge;		// records larger than a block, one each
+
+	public:
+		RecordArena();
+		~RecordArena();
+
+		// nLength bytes, aligned for a double, until Reset
+		char* Alloc(int nLength);
+
+		// rec becomes a view on a copy of the bits of fromMe
+		void Copy(Record &fromMe, Record &rec);
+
+		void Reset();
+};
+
+#endif
@@ -102,7 +102,7 @@ void Join::Run(Pipe& inPipeL, Pipe& inPipeR, Pipe& outPipe, CNF& selOp, Record&
         exit(1);
     }
 
-    pthread_create(&m_thread, NULL, DoOperation, (void*)new Params(&inPipeL, &inPipeR, &outPipe, &selOp, &literal));
+    pthread_create(&m_thread, NULL, DoOperation, (void*)new Params(&inPipeL, &inPipeR, &outPipe, &selOp, &literal, m_nPageSize));
 }
 
 void* Join::DoOperation(void* p)
@@ -127,8 +127,10 @@ void* Join::DoOperation(void* p)
     {
         const int pipeSize = 100;
         Pipe outL(pipeSize), outR(pipeSize);
-        BigQ bigqL(*(param->inputPipeL), outL, omL, m_nRunLen);
-        BigQ bigR(*(param->inputPipeR), outR, omR, m_nRunLen);
+        BigQ bigqL(*(param->inputPipeL), outL, omL, m_nRunLen, param->pageSize,
+                   COMPRESS_NONE, SORTED_RUNS, -1, "join left");
+        BigQ bigR(*(param->inputPipeR), outR, omR, m_nRunLen, param->pageSize,
+                  COMPRESS_NONE, SORTED_RUNS, -1, "join right");
         Record leftRec, rightRec;
 
         /*new logic
@@ -152,7 +154,7 @@ void* Join::DoOperation(void* p)
             if(left_fetched)
             {
                 Record* copy = new Record();
-                copy->Copy(&leftRec);
+                copy->Consume(&leftRec);
                 recsFromLeftPipe.push_back(copy);
                 newRec = copy;
                 left_fetched = false;
@@ -163,14 +165,16 @@ void* Join::DoOperation(void* p)
 #ifdef _RELOP_DEBUG
                 lFetchCount++;
 #endif
+                // the pool takes the bits of the record, no copy is made
                 Record* copy = new Record();
-                copy->Copy(&leftRec);
+                copy->Consume(&leftRec);
                 prvsRec = newRec;
                 newRec = copy;
                 if((prvsRec == NULL) || (prvsRec && ce.Compare(prvsRec, newRec, &omL) == 0))
                     recsFromLeftPipe.push_back(copy);
                 else
                 {
+                    leftRec.Consume(copy);
                     delete copy;
                     copy = NULL;
                     left_fetched = true;  //we still hold 1 already fetched record in leftRec
@@ -192,7 +196,7 @@ void* Join::DoOperation(void* p)
             if(right_fetched)
             {
                 Record* copy = new Record();
-                copy->Copy(&rightRec);
+                copy->Consume(&rightRec);
                 recsFromRightPipe.push_back(copy);
                 newRec = copy;
                 right_fetched = false;
@@ -203,13 +207,14 @@ void* Join::DoOperation(void* p)
                 rFetchCount++;
 #endif
                 Record* copy = new Record();
-                copy->Copy(&rightRec);
+                copy->Consume(&rightRec);
                 prvsRec = newRec;
                 newRec = copy;
                 if((prvsRec == NULL) || (prvsRec && ce.Compare(prvsRec, newRec, &omR) == 0))
                     recsFromRightPipe.push_back(copy);
                 else
                 {
+                    rightRec.Consume(copy);
                     delete copy;
                     copy = NULL;
                     right_fetched = true;
@@ -262,10 +267,9 @@ void* Join::DoOperation(void* p)
                             // see if CNF accepts the records
                             if (ce.Compare(recsFromLeftPipe.at(i), recsFromRightPipe.at(j), param->literalRec, param->selectOp) == 1)
                             {
-                                Record copyRec;
-                                copyRec.Copy(recsFromRightPipe.at(j));
-                                // all is good, now merge left+right
-	                        joinResult.MergeRecords(recsFromLeftPipe.at(i), &copyRec, left_tot, right_tot,
+                                // all is good, now merge left+right; MergeRecords
+                                // only reads the right record, it needs no copy
+	                        joinResult.MergeRecords(recsFromLeftPipe.at(i), recsFromRightPipe.at(j), left_tot, right_tot,
 							attsToKeep, numAttsToKeep, left_tot);
                                 param->outputPipe->Insert(&joinResult);
 #ifdef _RELOP_DEBUG
@@ -308,6 +312,7 @@ void* Join::DoOperation(void* p)
         Record rec, *copy_rec_left = NULL, *copy_rec_right = NULL;
         int numPagesUsedUp = 0;
         Page currentPage;
+        currentPage.SetPageSize(param->pageSize);
         // initialize variables
         bool bJoinSchCreated = false, bRightFileCreated = false, bLeftFileOver = true;
         int left_tot, right_tot, numAttsToKeep;
@@ -356,7 +361,7 @@ void* Join::DoOperation(void* p)
 		if (bLeftFileOver == false && bRightFileCreated == false)
 		{
 			bRightFileCreated = true;
-			rightDBFile.Create((char*)"right_file.data", heap, NULL);
+			rightDBFile.Create((char*)"right_file.data", heap, NULL, param->pageSize);
 			while (param->inputPipeR->Remove(&rec))
 				rightDBFile.Add(rec);
 			rightDBFile.Close();
@@ -406,7 +411,7 @@ void* Join::DoOperation(void* p)
 			// if bRightFileCreated = true, that means we need to fetch 
 			// records from rightDBFile (only 1 page) and populate right_vec
 			if (bRightFileCreated)
-				bRightFileOver = PopulateVec(rightDBFile, right_vec);
+				bRightFileOver = PopulateVec(rightDBFile, right_vec, param->pageSize);
 
             // make join-schema for joint record
             if (!bJoinSchCreated && left_vec.size() > 0 && right_vec.size() > 0)
@@ -434,10 +439,8 @@ void* Join::DoOperation(void* p)
                     // see if CNF satisfies
                     if (ce.Compare(left_vec.at(i), right_vec.at(j), param->literalRec, param->selectOp) == 1)
                     {
-                        Record copyRec;
-                        copyRec.Copy(right_vec.at(j));
 	                // merge left and right records
-    	                joinResult.MergeRecords(left_vec.at(i), &copyRec,
+    	                joinResult.MergeRecords(left_vec.at(i), right_vec.at(j),
                             	                left_tot, right_tot, attsToKeep, numAttsToKeep, left_tot);
                         param->outputPipe->Insert(&joinResult);
 					}
@@ -481,9 +484,10 @@ void* Join::DoOperation(void* p)
 
 // Populate vector with 1 page worth of data from DBFile
 // return true if file is over
-bool Join::PopulateVec(DBFile &rightDBFile, vector<Record*> &v)
+bool Join::PopulateVec(DBFile &rightDBFile, vector<Record*> &v, int nPageSize)
 {
 	Page currentPage;
+	currentPage.SetPageSize(nPageSize);
 	Record rec;
 	bool bPageFull;
 	do
@@ -528,6 +532,16 @@ void Join::Use_n_Pages (int runlen)
     m_nRunLen = runlen/2;
 }
 
+void Join::Use_Page_Size (int n)
+{
+    if (!File::IsValidPageSize(n))
+    {
+        cerr << "\nError! Join::Use_Page_Size : invalid page size " << n << "\n";
+        exit(1);
+    }
+    m_nPageSize = n;
+}
+
 //--------------- Project ------------------
 /* Input: inPipe = fetch input records from here
  *	      outPipe = push project output here
@@ -589,11 +603,32 @@ void WriteOut::Run (Pipe &inPipe, FILE *outFile, Schema &mySchema, int *count)
 	return;
 }
 
+void WriteOut::Run (Pipe &inPipe, ExportFile *outFile, int *count)
+{
+	Params *param = new Params(&inPipe, NULL, NULL, count);
+	param->pExport = outFile;
+	pthread_create(&m_thread, NULL, &DoOperation, (void*) param);
+}
+
 void * WriteOut::DoOperation(void * p)
 {
 	Params* param = (Params*)p;
 	Record rec;
 	int count = 0;	
+
+	// no text to make, the records fill the pages of the export file
+	if (param->pExport != NULL)
+	{
+		while (param->inputPipe->Remove(&rec))
+		{
+			count++;
+			param->pExport->Add(rec);
+		}
+		if (param->pCount != NULL)
+			*param->pCount = count;
+		delete param;
+		return NULL;
+	}
 	// While records are coming from inPipe, 
 	// Write out the attributes in text form in outFile
 	while(param->inputPipe->Remove(&rec))
@@ -748,7 +783,7 @@ void DuplicateRemoval::Run(Pipe &inPipe, Pipe &outPipe, Schema &mySchema)
 	}
     // Create thread to do the project operation
     pthread_create(&m_thread, NULL, &DoOperation,
-                   (void*) new Params(&inPipe, &outPipe, &mySchema));
+                   (void*) new Params(&inPipe, &outPipe, &mySchema, m_nPageSize));
     return;
 }
 
@@ -773,7 +808,8 @@ void * DuplicateRemoval::DoOperation(void * p)
 	// create local outPipe
 	Pipe localOutPipe(pipeSize);
 	// start bigQ
-   	BigQ B(*(param->inputPipe), localOutPipe, sortOrder, m_nRunLen);
+   	BigQ B(*(param->inputPipe), localOutPipe, sortOrder, m_nRunLen, param->pageSize,
+   	       COMPRESS_NONE, SORTED_RUNS, -1, "distinct");
 
 	bool bLastSeenRecSet = false;
 	ComparisonEngine ce;
@@ -815,6 +851,16 @@ void DuplicateRemoval::Use_n_Pages(int n)
 	m_nRunLen = n;
 }
 
+void DuplicateRemoval::Use_Page_Size(int n)
+{
+	if (!File::IsValidPageSize(n))
+	{
+		cerr << "\nError! DuplicateRemoval::Use_Page_Size : invalid page size " << n << "\n";
+		exit(1);
+	}
+	m_nPageSize = n;
+}
+
 void DuplicateRemoval::WaitUntilDone()
 {
     // Block until thread is done
@@ -828,9 +874,19 @@ void GroupBy::Use_n_Pages(int n)
     m_nRunLen = n;
 }
 
+void GroupBy::Use_Page_Size(int n)
+{
+    if (!File::IsValidPageSize(n))
+    {
+        cerr << "\nError! GroupBy::Use_Page_Size : invalid page size " << n << "\n";
+        exit(1);
+    }
+    m_nPageSize = n;
+}
+
 void GroupBy::Run(Pipe& inPipe, Pipe& outPipe, OrderMaker& groupAtts, Function& computeMe)
 {
-    pthread_create(&m_thread, NULL, DoOperation, (void*)new Params(&inPipe, &outPipe, &groupAtts, &computeMe, m_nRunLen));
+    pthread_create(&m_thread, NULL, DoOperation, (void*)new Params(&inPipe, &outPipe, &groupAtts, &computeMe, m_nRunLen, m_nPageSize));
 }
 
 void GroupBy::WaitUntilDone()
@@ -844,7 +900,8 @@ void* GroupBy::DoOperation(void* p)
     //create a local outputPipe and a BigQ and an feed it with current inputPipe
     const int pipeSize = 100;
     Pipe localOutPipe(pipeSize);
-    BigQ localBigQ(*(param->inputPipe), localOutPipe, *(param->groupAttributes), param->runLen);
+    BigQ localBigQ(*(param->inputPipe), localOutPipe, *(param->groupAttributes), param->runLen, param->pageSize,
+                   COMPRESS_NONE, SORTED_RUNS, -1, "group by");
     Record rec;
     Record *currentGroupRecord = new Record();
     bool currentGroupActive = false;
@@ -887,7 +944,7 @@ void* GroupBy::DoOperation(void* p)
             int ival = 0; double dval = 0;
             param->computeMeFunction->Apply(rec, ival, dval);
             sum += (ival + dval);
-            delete rec.bits;
+            RecordMemory::Free(rec.bits);
             rec.bits = NULL;
 			#ifdef _RELOP_DEBUG
             recordsInAGroup++;
@@ -944,7 +1001,7 @@ void* GroupBy::DoOperation(void* p)
                 int ival = 0; double dval = 0;
                 param->computeMeFunction->Apply(rec, ival, dval);
                 sum = (ival + dval);    //not += here coz we are re-initializing sum
-                delete rec.bits;
+                RecordMemory::Free(rec.bits);
                 rec.bits = NULL;
             }
 
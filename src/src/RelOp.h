@@ -6,6 +6,7 @@
 #include "DBFile.h"
 #include "Record.h"
 #include "Function.h"
+#include "ExportFile.h"
 #include <fstream>
 #include <vector>
 
@@ -108,29 +109,37 @@ class Join : public RelationalOp
     private:
         pthread_t m_thread;
         static int m_nRunLen;
+        int m_nPageSize;            // size of the pages counted by m_nRunLen
         struct Params
         {
             Pipe *outputPipe, *inputPipeL, *inputPipeR;
             CNF *selectOp;
             Record *literalRec;
+            int pageSize;
 
-            Params(Pipe *inPipeL, Pipe *inPipeR, Pipe *outPipe, CNF *selOp, Record *literal)
+            Params(Pipe *inPipeL, Pipe *inPipeR, Pipe *outPipe, CNF *selOp, Record *literal,
+                   int nPageSize)
             {
                 inputPipeL = inPipeL;
                 inputPipeR = inPipeR;
                 outputPipe = outPipe;
                 selectOp = selOp;
                 literalRec = literal;
+                pageSize = nPageSize;
             }
         };
         static void* DoOperation(void*);
 		static void ClearAndDestroy(vector<Record *> &v);
-		static bool PopulateVec(DBFile &file, vector<Record *> &v);
+		static bool PopulateVec(DBFile &file, vector<Record *> &v, int nPageSize);
 
     public:
+	Join() : m_nPageSize(PAGE_SIZE) {}
 	void Run (Pipe &inPipeL, Pipe &inPipeR, Pipe &outPipe, CNF &selOp, Record &literal);
 	void WaitUntilDone ();
 	void Use_n_Pages (int n);
+	// size of the pages given by Use_n_Pages (PAGE_SIZE by default), used
+	// for the BigQs, the block nested loop blocks and the spill file
+	void Use_Page_Size (int n);
 };
 
 class DuplicateRemoval : public RelationalOp 
@@ -138,24 +147,31 @@ class DuplicateRemoval : public RelationalOp
     private:
         pthread_t m_thread;
 		static int m_nRunLen;		// needed by BigQ, set using Use_n_Pages(n)
+		int m_nPageSize;			// size of the pages counted by m_nRunLen
         struct Params
         {
             Pipe *inputPipe, *outputPipe;
 			Schema *pSchema;
+			int pageSize;
 
-            Params(Pipe *inPipe, Pipe *outPipe, Schema *mySchema)
+            Params(Pipe *inPipe, Pipe *outPipe, Schema *mySchema, int nPageSize)
             {
                 inputPipe = inPipe;
                 outputPipe = outPipe;
 				pSchema = mySchema;
+				pageSize = nPageSize;
             }
         };
         static void* DoOperation(void*);
 
 	public:
+	DuplicateRemoval() : m_nPageSize(PAGE_SIZE) {}
 	void Run (Pipe &inPipe, Pipe &outPipe, Schema &mySchema);
 	void WaitUntilDone ();
 	void Use_n_Pages (int n);
+	// size of the pages given by Use_n_Pages (PAGE_SIZE by default), used
+	// for the BigQ
+	void Use_Page_Size (int n);
 };
 
 class Sum : public RelationalOp 
@@ -186,28 +202,36 @@ class GroupBy : public RelationalOp {
     private:
         pthread_t m_thread;
         int m_nRunLen;
+        int m_nPageSize;            // size of the pages counted by m_nRunLen
         struct Params
         {
             Pipe *outputPipe, *inputPipe;
             OrderMaker *groupAttributes;
             Function *computeMeFunction;
             int runLen;
+            int pageSize;
 
-            Params(Pipe *inPipe, Pipe *outPipe, OrderMaker *groupAtts, Function *computeMe, int runlen)
+            Params(Pipe *inPipe, Pipe *outPipe, OrderMaker *groupAtts, Function *computeMe, int runlen,
+                   int nPageSize)
             {
                 inputPipe = inPipe;
                 outputPipe = outPipe;
                 groupAttributes = groupAtts;
                 computeMeFunction = computeMe;
                 runLen = runlen;
+                pageSize = nPageSize;
             }
         };
         static void* DoOperation(void*);
 
     public:
+	GroupBy() : m_nPageSize(PAGE_SIZE) {}
 	void Run (Pipe &inPipe, Pipe &outPipe, OrderMaker &groupAtts, Function &computeMe);
 	void WaitUntilDone ();
 	void Use_n_Pages (int n);
+	// size of the pages given by Use_n_Pages (PAGE_SIZE by default), used
+	// for the BigQ
+	void Use_Page_Size (int n);
 };
 
 class WriteOut : public RelationalOp 
@@ -219,6 +243,7 @@ class WriteOut : public RelationalOp
             Pipe *inputPipe;
 			Schema *pSchema;
 			FILE *pFILE;
+			ExportFile *pExport;	// NULL if the records are written as text
 			int *pCount;
 
             Params(Pipe *inPipe, Schema *pMySchema, FILE *outFile, int *cnt = NULL)
@@ -226,6 +251,7 @@ class WriteOut : public RelationalOp
                 inputPipe = inPipe;
 				pSchema = pMySchema;
 				pFILE = outFile;
+				pExport = NULL;
 				pCount = cnt;
             }
         };
@@ -233,6 +259,8 @@ class WriteOut : public RelationalOp
 
 	public:
 	void Run (Pipe &inPipe, FILE *outFile, Schema &mySchema, int *cnt);
+	// the records go to an export file, created already, as they are
+	void Run (Pipe &inPipe, ExportFile *outFile, int *cnt);
 	void WaitUntilDone ();
 	void Use_n_Pages (int n) { }
 };
@@ -4,6 +4,22 @@
 #include <stdlib.h>
 #include <iostream>
 
+const char* TypeToString (Type type) {
+	if (type == Int)
+		return "Int";
+	else if (type == Double)
+		return "Double";
+	return "String";
+}
+
+Type TypeFromString (const std::string &type) {
+	if (type.compare ("Int") == 0)
+		return Int;
+	else if (type.compare ("Double") == 0)
+		return Double;
+	return String;
+}
+
 int Schema :: Find (char *attName) {
 
 	for (int i = 0; i < numAtts; i++) {
@@ -3,6 +3,7 @@
 #define SCHEMA_H
 
 #include <stdio.h>
+#include <string>
 #include "Record.h"
 #include "Schema.h"
 #include "File.h"
@@ -19,6 +20,11 @@ struct Attribute {
 	Type myType;
 };
 
+// the name of a type in the catalog and the metadata files, and back;
+// a name that is neither Int nor Double is a String
+const char* TypeToString (Type type);
+Type TypeFromString (const std::string &type);
+
 class OrderMaker;
 class Schema {
 
@@ -1,29 +1,74 @@
+#include <algorithm>
 #include "Sorted.h"
 
-Sorted::Sorted() : m_pSortInfo(NULL), m_bReadingMode(true), m_pBigQ(NULL),
+// what the compaction thread merges, and what it made
+struct Compaction
+{
+	vector<string> vInputs;		// the file, then the runs, oldest first
+	int nRuns;					// of the runs
+	string sOutput;
+	int nPageSize;
+	int nCompression;
+	OrderMaker order;
+	FenceIndex fences;			// of the output
+	vector<int> vIndexAtts;		// indexes of the output, named after it
+	vector<Type> vIndexTypes;
+	ZoneMap zones;				// of the output
+	long nRecords;				// ... and its records
+
+	pthread_mutex_t mutex;
+	bool bDone;					// under the mutex
+};
+
+Sorted::Sorted() : m_pSortInfo(NULL), m_bReadingMode(true), m_pBigQ(NULL), m_nAdded(0),
 				   m_sMetaSuffix(".meta.data"), m_bPageFetched(false),
-				   m_pQueryOrderMaker(NULL), m_bMatchingPageFound(false),
-				   m_bQueryOMCreated(false)
+				   m_bSortSearch(false), m_bMatchingPageFound(false),
+				   m_bQueryOMCreated(false), m_eAccess(RANDOM_ACCESS),
+				   m_bScanStarted(false), m_bIndexScan(false),
+				   m_bMergeStarted(false), m_pCompaction(NULL)
 {
 	m_pFile = new FileUtil();
+	m_pIndexes = new IndexSet(m_pFile);
+	m_pZoneMap = new ZoneMap();
+	m_pFences = new FenceIndex();
+	m_pDeltas = new DeltaRuns();
 	m_pINPipe = new Pipe(PIPE_SIZE);
 	m_pOUTPipe = new Pipe(PIPE_SIZE);
 }
 
 Sorted::~Sorted()
 {
+	FinishCompaction(true);
+	ClearHeads();
+
+	delete m_pDeltas;
+	m_pDeltas = NULL;
+
+	delete m_pIndexes;
+	m_pIndexes = NULL;
+
+	delete m_pZoneMap;
+	m_pZoneMap = NULL;
+
+	delete m_pFences;
+	m_pFences = NULL;
+
 	delete m_pFile;
     m_pFile = NULL;
 
 	delete m_pBigQ;
 	m_pBigQ = NULL;
 
+	delete m_pINPipe;
+	delete m_pOUTPipe;
+	m_pINPipe = m_pOUTPipe = NULL;
+
 	m_bQueryOMCreated = false;
 }
 
-int Sorted::Create(char *f_path, void *sortInfo)
+int Sorted::Create(char *f_path, void *sortInfo, int pageSize, int compression)
 {
-    m_pFile->Create(f_path);
+    m_pFile->Create(f_path, pageSize, compression);
 
 	if (sortInfo == NULL)
 	{
@@ -31,6 +76,11 @@ int Sorted::Create(char *f_path, void *sortInfo)
 		return RET_FAILURE;
 	}
 	m_pSortInfo = (SortInfo*)sortInfo;
+	m_pZoneMap->Clear(true);
+	m_pFences->SetOrder(*(m_pSortInfo->myOrder));
+	m_pFences->Clear();
+	m_pDeltas->Clear();
+	m_pDeltas->SetFile(f_path, m_pSortInfo->myOrder, pageSize, compression);
 	WriteMetaData();
 	#ifdef _DEBUG
     m_pSortInfo->myOrder->Print();
@@ -38,7 +88,7 @@ int Sorted::Create(char *f_path, void *sortInfo)
 	return RET_SUCCESS;
 }
 
-int Sorted::Open(char *fname)
+int Sorted::Open(char *fname, FileOpenMode mode)
 {
     //read metadata here
     ifstream meta_in;
@@ -64,45 +114,70 @@ int Sorted::Open(char *fname)
     	        m_pSortInfo->myOrder->whichTypes[i] = String;
 	    }
 	}
-    return m_pFile->Open(fname);
+    int ret = m_pFile->Open(fname, mode);
+    if (ret == RET_SUCCESS)
+    {
+        m_pIndexes->Open(fname, mode);
+        m_pZoneMap->Read(string(fname) + m_sMetaSuffix);
+        m_pFences->SetOrder(*(m_pSortInfo->myOrder));
+        m_pFences->Read(string(fname) + m_sMetaSuffix);
+        m_pDeltas->SetFile(fname, m_pSortInfo->myOrder, m_pFile->GetPageSize(),
+                           m_pFile->GetCompression());
+        m_pDeltas->Read(string(fname) + m_sMetaSuffix);
+    }
+    m_bScanStarted = false;
+    m_bIndexScan = false;
+    return ret;
 }
 
 // returns 1 if successfully closed the file, 0 otherwise
 int Sorted::Close()
 {
 	m_bQueryOMCreated = false;
-	MergeBigQToSortedFile();
+	FlushBigQ();
+	FinishCompaction(true);
+	ClearHeads();
+	m_pIndexes->Close();
+	if (m_pZoneMap->IsDirty())
+		m_pZoneMap->Write(m_pFile->GetBinFilePath() + m_sMetaSuffix);
+	if (m_pFences->IsDirty())
+		m_pFences->Write(m_pFile->GetBinFilePath() + m_sMetaSuffix);
     return m_pFile->Close();
 }
 
 /* Load function bulk loads the Sorted instance from a text file, appending
- * new data to it using the SuckNextRecord function from Record.h. The character
- * string passed to Load is the name of the data file to bulk load.
+ * new data to it with a BulkLoader, which parses the file into pages. The
+ * character string passed to Load is the name of the data file to bulk load.
  */
 void Sorted::Load (Schema &mySchema, char *loadMe)
 {
     EventLogger *el = EventLogger::getEventLogger();
 	m_bQueryOMCreated = false;
 
-    FILE *fileToLoad = fopen(loadMe, "r");
-    if (!fileToLoad)
+    BulkLoader loader;
+    if (!loader.Open(loadMe, mySchema))
     {
 		el->writeLog("Can't open file name :" + string(loadMe));
 		return;
     }
 
+    // the merge builds the zone maps, once they know the schema
+    m_pZoneMap->SetTypes(mySchema);
+
     /* Logic :
-     * first read the record from the file using suckNextRecord()
-     * then add this record to page using Add() function
+     * the records of the pages of the loader go to the BigQ with Add()
      */
 
+    Page *pPage;
     Record aRecord;
-    while(aRecord.SuckNextRecord(&mySchema, fileToLoad))
-        Add(aRecord);
-
-    fclose(fileToLoad);
+    while ((pPage = loader.GetNextPage()) != NULL)
+    {
+        while (pPage->GetFirst(&aRecord))
+            Add(aRecord);
+    }
+    loader.Close();
 
-	MergeBigQToSortedFile();
+	FlushBigQ();
 }
 
 void Sorted::Add (Record &rec)
@@ -115,10 +190,63 @@ void Sorted::Add (Record &rec)
 
 	// push rec to IN-pipe
 	m_pINPipe->Insert(&rec);
+	m_nAdded++;
 
 	// if !BigQ, instantiate BigQ(IN-pipe, OUT-pipe, ordermaker, runlen)
 	if (!m_pBigQ)
-		m_pBigQ = new BigQ(*m_pINPipe, *m_pOUTPipe, *(m_pSortInfo->myOrder), m_pSortInfo->runLength);
+		m_pBigQ = new BigQ(*m_pINPipe, *m_pOUTPipe, *(m_pSortInfo->myOrder), m_pSortInfo->runLength,
+						   m_pFile->GetPageSize(), m_pFile->GetCompression(), SORTED_RUNS, -1, "sorted file");
+}
+
+void Sorted::FlushBigQ()
+{
+	m_bQueryOMCreated = false;
+
+	// Check if there's anything to flush
+	if (!m_pBigQ)
+		return;
+
+	// a compaction that is done goes in first, the runs it merged
+	// are not merged again
+	FinishCompaction(false);
+
+	// many records next to the file are merged into it right away,
+	// a run would cost as much as the merge
+	if (m_pCompaction == NULL && m_pDeltas->GetCount() == 0 &&
+		m_nAdded * DELTA_SIZE_RATIO >= m_pDeltas->GetBaseRecords())
+	{
+		MergeBigQToSortedFile();
+		return;
+	}
+
+	// the runs a compaction is reading stay as they are
+	m_pINPipe->ShutDown();
+	m_pDeltas->AddRun(*m_pOUTPipe, m_pCompaction ? m_pCompaction->nRuns : 0);
+	m_pDeltas->Write(m_pFile->GetBinFilePath() + m_sMetaSuffix);
+	NewBatch();
+
+	// the scans start over, with the new run
+	ClearHeads();
+	m_pFile->MoveFirst();
+	m_bSortSearch = false;
+	m_bMatchingPageFound = false;
+	m_bScanStarted = false;
+	m_bIndexScan = false;
+
+	if (m_pCompaction == NULL && m_pDeltas->NeedCompaction())
+		StartCompaction();
+}
+
+void Sorted::NewBatch()
+{
+	// a pipe that was shut down can not take records again
+	delete m_pBigQ;
+	m_pBigQ = NULL;
+	delete m_pINPipe;
+	delete m_pOUTPipe;
+	m_pINPipe = new Pipe(PIPE_SIZE);
+	m_pOUTPipe = new Pipe(PIPE_SIZE);
+	m_nAdded = 0;
 }
 
 void Sorted::MergeBigQToSortedFile()
@@ -139,10 +267,23 @@ void Sorted::MergeBigQToSortedFile()
 	FileUtil tmpFile;
 
     string tmpFileName = "tmpFile" + getusec();    //time(NULL) returns time_t in seconds since 1970
-	tmpFile.Create(const_cast<char*>(tmpFileName.c_str()));
+	tmpFile.Create(const_cast<char*>(tmpFileName.c_str()), m_pFile->GetPageSize(),
+				   m_pFile->GetCompression());
+
+	// the indexes and zone maps of tmpFile are made along with it, and
+	// take the place of the old ones with it
+	vector<int> vIndexAtts;
+	vector<Type> vIndexTypes;
+	IndexSet::GetIndexList(m_pFile->GetBinFilePath(), vIndexAtts, vIndexTypes);
+	IndexSet newIndexes(&tmpFile);
+	newIndexes.Create(tmpFileName, vIndexAtts, vIndexTypes);
+	ZoneMap newZones = *m_pZoneMap;
+	newZones.Clear(false);
 
 	m_pFile->MoveFirst();
+	m_pFences->Clear();
 	int fetchedFromPipe = 0, fetchedFromFile = 0;
+	long nRecords = 0;
 
     //if file on disk is empty (initially it will be) then don't fetch anything
     if(m_pFile->GetFileLength() == 0)
@@ -165,13 +306,13 @@ void Sorted::MergeBigQToSortedFile()
 		{
 			if (ce.Compare(pRecFromPipe, pRecFromFile, m_pSortInfo->myOrder) < 0)
 			{
-				tmpFile.Add(*pRecFromPipe);
+				AddMerged(tmpFile, *pRecFromPipe, nRecords, newIndexes, newZones);
 				delete pRecFromPipe;
 				pRecFromPipe = NULL;
 			}
 			else
 			{
-				tmpFile.Add(*pRecFromFile);
+				AddMerged(tmpFile, *pRecFromFile, nRecords, newIndexes, newZones);
 				delete pRecFromFile;
 				pRecFromFile = NULL;
 			}
@@ -180,22 +321,23 @@ void Sorted::MergeBigQToSortedFile()
     while (fetchedFromPipe && fetchedFromFile);
 
     if(fetchedFromFile != 0)
-        tmpFile.Add(*pRecFromFile);
+        AddMerged(tmpFile, *pRecFromFile, nRecords, newIndexes, newZones);
     if(fetchedFromPipe != 0)
-        tmpFile.Add(*pRecFromPipe);
+        AddMerged(tmpFile, *pRecFromPipe, nRecords, newIndexes, newZones);
 
 
 	Record rec;
 	while (m_pOUTPipe->Remove(&rec))
 	{
-		tmpFile.Add(rec);
+		AddMerged(tmpFile, rec, nRecords, newIndexes, newZones);
 	}
 	while (m_pFile->GetFileLength() != 0 && m_pFile->GetNext(rec))
 	{
-		tmpFile.Add(rec);
+		AddMerged(tmpFile, rec, nRecords, newIndexes, newZones);
         }
 
 	tmpFile.Close();
+	newIndexes.Close();
 
 	// if tmpFile is not empty, then delete old file
 	// and rename tmpFile to old file's name
@@ -208,23 +350,57 @@ void Sorted::MergeBigQToSortedFile()
 		// rename tmp file to original old name
         if(rename(tmpFileName.c_str(), m_pFile->GetBinFilePath().c_str()) != 0)
         	perror("error in renaming temp file");
+
+		// read the merged file from now on, with its indexes and zone maps
+		string sBinFile = m_pFile->GetBinFilePath();
+		m_pFile->Close();
+		m_pFile->Open(const_cast<char*>(sBinFile.c_str()));
+		m_pFile->MoveFirst();
+		m_pIndexes->Close();
+		IndexSet::Rename(tmpFileName, sBinFile, vIndexAtts);
+		m_pIndexes->Open(sBinFile);
+		*m_pZoneMap = newZones;
+		m_pDeltas->SetBaseRecords(nRecords);
+		m_pDeltas->Write(sBinFile + m_sMetaSuffix);
 	}
+	else
+		IndexSet::Remove(tmpFileName, vIndexAtts);
 
 	// delete BigQ
-	delete m_pBigQ;
-	m_pBigQ = NULL;
+	NewBatch();
 
 	// invalidate the old query-order-maker
-	m_pQueryOrderMaker = NULL;
+	m_bSortSearch = false;
 	m_bMatchingPageFound = false;
+	m_bScanStarted = false;
+	m_bIndexScan = false;
+}
+
+void Sorted::AddMerged(FileUtil &merged, Record &rec, long &nRecords,
+					   IndexSet &indexes, ZoneMap &zones)
+{
+	merged.Add(rec);
+	nRecords++;
+
+	// the records come in order, the first one of a page and the
+	// last one so far are its fences
+	m_pFences->AddLast(merged);
+	indexes.InsertLast();
+	zones.AddLast(merged);
 }
 
 void Sorted::MoveFirst ()
 {
 	m_bQueryOMCreated = false;
+
+	// no scan is going on, a compaction that is done can go in
+	FinishCompaction(false);
+	ClearHeads();
 	m_pFile->MoveFirst();
-	m_pQueryOrderMaker = NULL;
+	m_bSortSearch = false;
 	m_bMatchingPageFound = false;
+	m_bScanStarted = false;
+	m_bIndexScan = false;
 }
 
 // Function to fetch the next record in the file in "fetchme"
@@ -237,11 +413,14 @@ int Sorted::GetNext (Record &fetchme)
 	if (!m_bReadingMode)
 	{
 		m_bReadingMode = true;
-		MergeBigQToSortedFile();
+		FlushBigQ();
 	}
 
 	// Now we can start reading
 	m_bPageFetched = true;
+	m_bScanStarted = true;
+	if (m_pDeltas->GetCount() > 0)
+		return GetNextMerged(fetchme, NULL, NULL);
 	return m_pFile->GetNext(fetchme);
 }
 
@@ -254,64 +433,85 @@ int Sorted::GetNext (Record &fetchme, CNF &cnf, Record &literal)
      *
      * Prepare "query" OrderMaker from applyMe (CNF) -
      * If the attribute used in Sorted file's order maker is also present in CNF, append to "query" OrderMaker
-     * else - stop making "query" OrderMaker */
+     * else - stop making "query" OrderMaker
+     * A < or > on the attribute of the sort after it bounds it further, see MakeSearchOrders */
 
     // If mode is not reading i.e. it is writing mode currently
     // merge differential data to already sorted file
     if (!m_bReadingMode)
     {
         m_bReadingMode = true;
-        MergeBigQToSortedFile();
+        FlushBigQ();
     }
 
-	if (m_bPageFetched == false)
-	{
-		m_pFile->SetCurrentPage(0);
-		m_bPageFetched = true;
-	}
-
 	// Make query-order-maker only if it is not already made
 	if (m_bQueryOMCreated == false)
 	{
-		#ifdef _DEBUG
-	    //m_pSortInfo->myOrder->Print();
-		#endif
-
-        m_pQueryOrderMaker = cnf.GetMatchingOrder(*(m_pSortInfo->myOrder));
+		m_bSortSearch = MakeSearchOrders(cnf);
 		m_bQueryOMCreated = true;
 
-
 		#ifdef _Sorted_DEBUG
-        if (m_pQueryOrderMaker != NULL)
-            m_pQueryOrderMaker->Print();
-        else
-            cout<<"NULL query order maker"<<endl;
+		if (m_bSortSearch)
+		{
+			m_LowOrder.Print();
+			m_HighOrder.Print();
+		}
+		else
+			cout<<"NULL query order maker"<<endl;
 		#endif
 	}
 
+	if (m_pDeltas->GetCount() > 0)
+		return GetNextMerged(fetchme, &cnf, &literal);
+	return GetNextBase(fetchme, cnf, literal);
+}
+
+int Sorted::GetNextBase (Record &fetchme, CNF &cnf, Record &literal)
+{
+	// the index and the zone maps can only help a scan from the start
+	if (!m_bScanStarted)
+	{
+		m_bScanStarted = true;
+		m_bIndexScan = (m_eAccess == RANDOM_ACCESS && m_pIndexes->StartScan(cnf, literal));
+
+		// the search on the sort order has its own way through the file
+		int nPages = max(m_pFile->GetFileLength() - 1, 0);
+		if (!m_bIndexScan && !m_bSortSearch &&
+			m_pZoneMap->GetPagesToRead(cnf, literal, nPages, m_vPageFilter) > 0)
+		{
+			m_pFile->MoveFirst();
+			m_pFile->SetPageFilter(&m_vPageFilter);
+			m_bPageFetched = true;
+		}
+	}
+	if (m_bIndexScan)
+		return m_pIndexes->GetNext(fetchme, cnf, literal);
+
+	if (m_bPageFetched == false)
+	{
+		m_pFile->SetCurrentPage(0);
+		m_bPageFetched = true;
+	}
 
     /* find the first matching record -
-     * If query OrderMaker is empty, first record (from current pointer or from the beginning) is the matching record.
-     * if query OrderMaker is not empty, perform binary search on file (from the current pointer) to find out a record -
-     * which is equal to the literal (Record) using "query" OrderMaker and CNF (probably using only "query" OrderMaker)
+     * If the sort order does not bound the records that can match, every
+     * record (from current pointer or from the beginning) is tried.
+     * Otherwise the fence keys give the first page that can have a record
+     * that is not before the lower bound (m_LowOrder), and the last page
+     * that can have one that is not after the upper bound (m_HighOrder) -
 
      * returning apropriate value -
-     * if no matching record found, return 0
-     * if there is a possible matching record - start scanning the file matching every record found one by one.
-     * First evaluate the record on "query" OrderMaker, then evaluate the CNF instance.
-     * if the query OrderMaker doesn't accept the record, return 0
-     * if query OrderMaker does accept it, match it with CNF
-     * if CNF accepts, return the record.
-     * if CNF doesn't accept, move on to next record.
-     * repeat 1-2 until EOF.
-     * if it's EOF, return 0.
-     * Keep the value of "query" OrderMaker and current pointer safe until user performs "MoveFirst" or some write operation.
+     * if no page can have a matching record, return 0
+     * otherwise the records before the lower bound are skipped, then every
+     * record is matched with the CNF, until one is after the upper bound
+     * or it's EOF; then return 0.
+     * Keep the search orders and current pointer safe until user performs "MoveFirst" or some write operation.
      */
 
-	if (!m_pQueryOrderMaker)
+	ComparisonEngine compEngine;
+	if (!m_bSortSearch)
 	{
-	    ComparisonEngine compEngine;
-		while (GetNext(fetchme))
+		while (m_pFile->GetNext(fetchme))
 	    {
     	    if (compEngine.Compare(&fetchme, &literal, &cnf))
         	    return RET_SUCCESS;
@@ -319,150 +519,301 @@ int Sorted::GetNext (Record &fetchme, CNF &cnf, Record &literal)
 		//if control is here then no matching record was found
 	    return RET_FAILURE;
 	}
-	else
-	{
-        ComparisonEngine compEngine;
 
-		// Binary search must be done once per query-order-maker
-		if (m_bMatchingPageFound == false)
-		{
-			m_bMatchingPageFound = true;
-			LoadMatchingPage(literal);
-			// find the page where query-order-maker first matches (using binary search)
-            bool foundMatchingRec = false;
-            while(m_pFile->GetNext(fetchme, true))
-            {
-                // match with queryOM, until we find a matching record
-                if (compEngine.Compare(&literal, m_pQueryOrderMaker, &fetchme, m_pSortInfo->myOrder) == 0)
-                {
-                    if (compEngine.Compare(&fetchme, &literal, &cnf))
-                        return RET_SUCCESS;
-                    foundMatchingRec = true;
-                    break;
-                }
-            }
-            if(!foundMatchingRec)
-                return RET_FAILURE;
-		}
+	int ret;
+	// the page search is done once per query
+	if (m_bMatchingPageFound == false)
+	{
+		m_bMatchingPageFound = true;
+		if (LoadMatchingPage(literal) == -1)
+			return RET_FAILURE;
+
+		// the page can start with records before the lower bound,
+		// and they can go on in the next pages
+		while ((ret = m_pFile->GetNext(fetchme)) && m_LowOrder.numAtts > 0 &&
+			   compEngine.Compare(&literal, &m_LowOrder, &fetchme, m_pSortInfo->myOrder) > 0)
+			;
+	}
+	else
+		ret = m_pFile->GetNext(fetchme);
 
-		while(true)
-        {
-        	if(GetNext(fetchme))
-            {
-            	// match with queryOM, if matches, compare with CNF
-                if (compEngine.Compare(&literal, m_pQueryOrderMaker, &fetchme, m_pSortInfo->myOrder) == 0)
-                {
-                	if (compEngine.Compare(&fetchme, &literal, &cnf))
-                    	return RET_SUCCESS; 
-					// otherwise CNF didn't match, try next record
-                }
-                else
-                {
-                	//if queryOM doesn't match, stop searching, return false
-                    return RET_FAILURE;
-                }
-			}
-            else
-            	return RET_FAILURE;
-		}
+	while (ret)
+	{
+		// past the upper bound nothing can match
+		if (m_HighOrder.numAtts > 0 &&
+			compEngine.Compare(&literal, &m_HighOrder, &fetchme, m_pSortInfo->myOrder) < 0)
+			return RET_FAILURE;
+		if (compEngine.Compare(&fetchme, &literal, &cnf))
+			return RET_SUCCESS;
+		ret = m_pFile->GetNext(fetchme);
 	}
 
     //if control is here then no matching record was found
     return RET_FAILURE;
 }
 
-int Sorted::LoadMatchingPage(Record &literal)
+int Sorted::GetNextMerged(Record &fetchme, CNF *pCnf, Record *pLiteral)
 {
-	// copy the position of current pointer in the file
-    // m_nCurrPage and m_pPage should be saved
-    Page OldPage;
-    int nOldPageNumber;
-    m_pFile->SaveFileState(OldPage, nOldPageNumber);
-
-	// nOldPageNumber (FileIUtil::m_nCurrPage) points to the page after the one thats in memory
-    int low = nOldPageNumber - 1;	
-    int high = m_pFile->GetFileLength()-2;
-    int foundPage = BinarySearch(low, high, literal, nOldPageNumber-1);
-
-    if (foundPage == -1)    // nothing found
-    {
-        // put file in old state, as binary search might have changed it
-        m_pFile->RestoreFileState(OldPage, nOldPageNumber);
-        return foundPage;
-    }
-	else
+	if (!m_bMergeStarted)
 	{
-		if (foundPage > 0)
+		m_bMergeStarted = true;
+		m_pDeltas->MoveFirst();
+		m_vHeads.resize(1 + m_pDeltas->GetCount(), (Record*) NULL);
+		for (int i = 0; i < m_vHeads.size(); i++)
 		{
-			// fetch that page
-			m_pFile->SetCurrentPage(foundPage);
-
-			// if foundPage is the same as oldPage in memory
-			// just return and continue with that page
-			if (foundPage == (nOldPageNumber-1))
+			m_vHeads[i] = new Record();
+			if (!GetNextFrom(i, *m_vHeads[i], pCnf, pLiteral))
 			{
-				m_pFile->RestoreFileState(OldPage, nOldPageNumber);
-				return foundPage;
+				delete m_vHeads[i];
+				m_vHeads[i] = NULL;
 			}
+		}
+	}
 
-			// otherwise, pages before "foundPage" might also have a matching record
-			// So keep going back by one page, till the 1st rec doesn't match
-			// and set foundPage = the first page where rec doesn't match
-			Record rec;
-		    ComparisonEngine compEngine;
+	// the first of the smallest records: the file, then the older runs
+	ComparisonEngine compEngine;
+	int nMin = -1;
+	for (int i = 0; i < m_vHeads.size(); i++)
+	{
+		if (m_vHeads[i] &&
+			(nMin == -1 || compEngine.Compare(m_vHeads[i], m_vHeads[nMin], m_pSortInfo->myOrder) < 0))
+			nMin = i;
+	}
+	if (nMin == -1)
+		return RET_FAILURE;
 
-			int pageNum = foundPage;
-			while (pageNum > 0)
-			{
-				// if record fetched but it is not less than literal, stop going to prev page
-				if (GetNext(rec) && compEngine.Compare(&literal, m_pQueryOrderMaker, &rec, m_pSortInfo->myOrder) > 0)
-					break;
-
-				// if 1st rec matches, goto prev page and check with 1st rec again
-                pageNum--;
-				if (pageNum == (nOldPageNumber-1))
-    	            m_pFile->RestoreFileState(OldPage, nOldPageNumber);
-				else // fetch that page
-					m_pFile->SetCurrentPage(pageNum);
-			}
-			foundPage = pageNum;
+	fetchme.Consume(m_vHeads[nMin]);
+	if (!GetNextFrom(nMin, *m_vHeads[nMin], pCnf, pLiteral))
+	{
+		delete m_vHeads[nMin];
+		m_vHeads[nMin] = NULL;
+	}
+	return RET_SUCCESS;
+}
+
+int Sorted::GetNextFrom(int nSource, Record &fetchme, CNF *pCnf, Record *pLiteral)
+{
+	if (nSource == 0)
+		return pCnf ? GetNextBase(fetchme, *pCnf, *pLiteral) : m_pFile->GetNext(fetchme);
+
+	// the runs are small, they are read from the start
+	FileUtil *pRun = m_pDeltas->GetRun(nSource - 1);
+	ComparisonEngine compEngine;
+	while (pRun->GetNext(fetchme))
+	{
+		if (pCnf == NULL)
+			return RET_SUCCESS;
+		// past the upper bound nothing can match
+		if (m_bSortSearch && m_HighOrder.numAtts > 0 &&
+			compEngine.Compare(pLiteral, &m_HighOrder, &fetchme, m_pSortInfo->myOrder) < 0)
+			return RET_FAILURE;
+		if (compEngine.Compare(&fetchme, pLiteral, pCnf))
+			return RET_SUCCESS;
+	}
+	return RET_FAILURE;
+}
+
+void Sorted::ClearHeads()
+{
+	for (int i = 0; i < m_vHeads.size(); i++)
+		delete m_vHeads[i];
+	m_vHeads.clear();
+	m_bMergeStarted = false;
+}
+
+void Sorted::StartCompaction()
+{
+	m_pCompaction = new Compaction();
+	Compaction &job = *m_pCompaction;
+	job.vInputs.push_back(m_pFile->GetBinFilePath());
+	for (int i = 0; i < m_pDeltas->GetCount(); i++)
+		job.vInputs.push_back(m_pDeltas->GetPath(i));
+	job.nRuns = m_pDeltas->GetCount();
+	job.sOutput = "tmpFile" + getusec();
+	job.nPageSize = m_pFile->GetPageSize();
+	job.nCompression = m_pFile->GetCompression();
+	job.order = *(m_pSortInfo->myOrder);
+	job.fences.SetOrder(job.order);
+	job.fences.Clear();
+	IndexSet::GetIndexList(m_pFile->GetBinFilePath(), job.vIndexAtts, job.vIndexTypes);
+	job.zones = *m_pZoneMap;
+	job.zones.Clear(false);
+	job.nRecords = 0;
+	pthread_mutex_init(&job.mutex, NULL);
+	job.bDone = false;
+
+	if (pthread_create(&m_compactThread, NULL, &CompactHelper, (void*)m_pCompaction) != 0)
+	{
+		cerr << "BAD: the compaction thread of " << m_pFile->GetBinFilePath() << " can not be started\n";
+		exit(1);
+	}
+}
+
+void* Sorted::CompactHelper(void *context)
+{
+	Compaction &job = *((Compaction*) context);
+
+	// files of its own, the sorted file goes on reading its own
+	vector<FileUtil*> vIn;
+	for (int i = 0; i < job.vInputs.size(); i++)
+	{
+		FileUtil *pIn = new FileUtil();
+		if (pIn->Open(const_cast<char*>(job.vInputs[i].c_str()), READ_ONLY) != RET_SUCCESS)
+		{
+			cerr << "BAD: " << job.vInputs[i] << " can not be opened for the compaction\n";
+			exit(1);
 		}
+		vIn.push_back(pIn);
+	}
 
-		return foundPage;
+	// the indexes and zone maps of the output are made here as well, so
+	// that the sorted file only has to swap them in
+	FileUtil out;
+	out.Create(const_cast<char*>(job.sOutput.c_str()), job.nPageSize, job.nCompression);
+	IndexSet indexes(&out);
+	indexes.Create(job.sOutput, job.vIndexAtts, job.vIndexTypes);
+	long nRecords = DeltaRuns::Merge(vIn, job.order, out, &job.fences, &indexes, &job.zones);
+	out.Close();
+	indexes.Close();
+
+	for (int i = 0; i < vIn.size(); i++)
+	{
+		vIn[i]->Close();
+		delete vIn[i];
 	}
+
+	pthread_mutex_lock(&job.mutex);
+	job.nRecords = nRecords;
+	job.bDone = true;
+	pthread_mutex_unlock(&job.mutex);
+	return NULL;
 }
 
-int Sorted::BinarySearch(int low, int high, Record &literal, int oldCurPageNum)
+void Sorted::FinishCompaction(bool bWait)
 {
-	// if there is only one page, then return that page
-	if (low == high)
-		return low;
+	if (m_pCompaction == NULL)
+		return;
+
+	pthread_mutex_lock(&m_pCompaction->mutex);
+	bool bDone = m_pCompaction->bDone;
+	pthread_mutex_unlock(&m_pCompaction->mutex);
+	if (!bDone && !bWait)
+		return;
+	pthread_join(m_compactThread, NULL);
+
+	// the merged file takes the place of the file, and of the runs in it
+	ClearHeads();
+	string sBinFile = m_pFile->GetBinFilePath();
+	m_pFile->Close();
+	if (remove(sBinFile.c_str()) != 0)
+		perror("error in removing old file");
+	if (rename(m_pCompaction->sOutput.c_str(), sBinFile.c_str()) != 0)
+		perror("error in renaming temp file");
+	m_pFile->Open(const_cast<char*>(sBinFile.c_str()));
+	m_pFile->MoveFirst();
 
-	// error condition, should never reach here
-	if (low > high)
-		return -1;
+	// the records moved, the compaction made the indexes and zone maps
+	// of the merged file
+	*m_pFences = m_pCompaction->fences;
+	m_pIndexes->Close();
+	IndexSet::Rename(m_pCompaction->sOutput, sBinFile, m_pCompaction->vIndexAtts);
+	m_pIndexes->Open(sBinFile);
+	*m_pZoneMap = m_pCompaction->zones;
+	m_pDeltas->DropOldest(m_pCompaction->nRuns);
+	m_pDeltas->SetBaseRecords(m_pCompaction->nRecords);
+	m_pDeltas->Write(sBinFile + m_sMetaSuffix);
+
+	pthread_mutex_destroy(&m_pCompaction->mutex);
+	delete m_pCompaction;
+	m_pCompaction = NULL;
 
-	Record rec;
-	ComparisonEngine compEngine;
-	int mid = (low + high)/2;
-	m_pFile->SetCurrentPage(mid); // fetch mid-page in memory
+	m_bQueryOMCreated = false;
+	m_bSortSearch = false;
+	m_bMatchingPageFound = false;
+	m_bScanStarted = false;
+	m_bIndexScan = false;
+}
+
+bool Sorted::MakeSearchOrders(CNF &cnf)
+{
+	OrderMaker *pSortOrder = m_pSortInfo->myOrder;
+	m_LowOrder.numAtts = 0;
+	m_HighOrder.numAtts = 0;
 
-	if (GetNext(rec))
+	// the equalities bound both ends
+	OrderMaker *pEquals = cnf.GetMatchingOrder(*pSortOrder);
+	if (pEquals != NULL)
 	{
-		if (compEngine.Compare(&literal, m_pQueryOrderMaker, &rec, m_pSortInfo->myOrder) == 0)
-			return mid;
-		// if record is greater than what we need, search in top half
-		else if (compEngine.Compare(&literal, m_pQueryOrderMaker, &rec, m_pSortInfo->myOrder) < 0)
+		m_LowOrder = *pEquals;
+		m_HighOrder = *pEquals;
+		delete pEquals;
+	}
+
+	// then a range on the attribute of the sort after them
+	int nNext = m_LowOrder.numAtts;
+	if (nNext < pSortOrder->numAtts)
+	{
+		int nLow, nHigh;
+		cnf.GetRangeBounds(pSortOrder->whichAtts[nNext], nLow, nHigh);
+		if (nLow != -1)
 		{
-			if (low == mid)
-		        return mid;
-			else
-				return BinarySearch(low, mid-1, literal, oldCurPageNum);
-		}		
-		else // if record is smaller than what we need, search in bottom half
-			return BinarySearch(mid+1, high, literal, oldCurPageNum);	
+			m_LowOrder.whichAtts[nNext] = nLow;
+			m_LowOrder.whichTypes[nNext] = pSortOrder->whichTypes[nNext];
+			m_LowOrder.numAtts++;
+		}
+		if (nHigh != -1)
+		{
+			m_HighOrder.whichAtts[nNext] = nHigh;
+			m_HighOrder.whichTypes[nNext] = pSortOrder->whichTypes[nNext];
+			m_HighOrder.numAtts++;
+		}
 	}
-	return -1;
+	return m_LowOrder.numAtts > 0 || m_HighOrder.numAtts > 0;
+}
+
+int Sorted::LoadMatchingPage(Record &literal)
+{
+	// the current page is the one after the page that is in memory,
+	// the search does not go back before it
+	int nOldPageNumber = m_pFile->GetCurrentPage();
+	int nFrom = max(nOldPageNumber - 1, 0);
+
+	// files merged before there were fence keys get them now
+	int nPages = max(m_pFile->GetFileLength() - 1, 0);
+	if (!m_pFences->Covers(nPages))
+		m_pFences->Build(m_pFile->GetBinFilePath());
+	if (!m_pFences->Covers(nPages))
+		return nFrom;
+
+	int foundPage = nFrom;
+	if (m_LowOrder.numAtts > 0)
+		foundPage = m_pFences->FindFirstPage(literal, m_LowOrder, nFrom);
+	if (foundPage == -1)
+		return foundPage;
+
+	// no page after the last one with a record that is not after the
+	// upper bound can match, the scan stops there
+	if (m_HighOrder.numAtts > 0)
+	{
+		int lastPage = m_pFences->FindLastPage(literal, m_HighOrder);
+		if (lastPage < foundPage)
+			return -1;
+		m_pFile->SetLastPage(lastPage);
+	}
+
+	// the page in memory may be the one
+	if (foundPage == nOldPageNumber - 1)
+		return foundPage;
+
+	// one read, the scan goes on from there
+	m_pFile->SetAccessPattern(RANDOM_ACCESS);
+	m_pFile->SetCurrentPage(foundPage);
+	return foundPage;
+}
+
+void Sorted::SetAccessPattern (AccessPattern pattern)
+{
+	m_eAccess = pattern;
 }
 
 // Create <table_name>.meta.data file
@@ -2,10 +2,16 @@
 #define SORTED_H
 
 #include <cstdio>
+#include <pthread.h>
 #include <sys/time.h>
 #include "GenericDBFile.h"
 #include "Pipe.h"
 #include "BigQ.h"
+#include "HashIndex.h"
+#include "ZoneMap.h"
+#include "FenceIndex.h"
+#include "DeltaRuns.h"
+#include "BulkLoader.h"
 #define PIPE_SIZE 100
 
 struct SortInfo
@@ -14,6 +20,9 @@ struct SortInfo
 	int runLength;
 };
 
+// a merge of the file with its oldest delta runs, see Sorted.cc
+struct Compaction;
+
 class Sorted : public GenericDBFile
 {
 	private:
@@ -21,22 +30,69 @@ class Sorted : public GenericDBFile
 		bool m_bReadingMode;
 		BigQ *m_pBigQ;
 		FileUtil *m_pFile;
+		IndexSet *m_pIndexes;	// secondary indexes, made by the merge
+		ZoneMap *m_pZoneMap;	// per page ranges, made by the merge
+		FenceIndex *m_pFences;	// per page first and last keys, made by the merge
+		DeltaRuns *m_pDeltas;	// records added since the last merge, in sorted runs
+		long m_nAdded;			// records given to the BigQ
 		Pipe *m_pINPipe, *m_pOUTPipe;
         string m_sMetaSuffix;
 		// variables for GetNext(CNF)
 		bool m_bPageFetched;
-		OrderMaker *m_pQueryOrderMaker;
+		// the equality prefix of the sort order the CNF has, followed by
+		// a lower or an upper bound on the next attribute of the sort
+		OrderMaker m_LowOrder, m_HighOrder;
+		bool m_bSortSearch;		// one of them has an attribute
 		bool m_bMatchingPageFound;
 		bool m_bQueryOMCreated;
+		AccessPattern m_eAccess;
+		bool m_bScanStarted;
+		bool m_bIndexScan;		// records come from an index lookup
+		vector<bool> m_vPageFilter;	// pages the zone maps let through
+
+		// GetNext with delta runs merges the file with them: the next
+		// record of the file ([0]) and of every run, NULL once it has none
+		vector<Record*> m_vHeads;
+		bool m_bMergeStarted;
+
+		// the compaction thread, if there is one that was not joined yet
+		Compaction *m_pCompaction;
+		pthread_t m_compactThread;
 
 		// Private functions
 		void WriteMetaData();
+
+		// the records of the BigQ go into a new delta run, or straight
+		// into the file if they are many next to it
+		void FlushBigQ();
 		void MergeBigQToSortedFile();
+		// adds the record to the merged file, and to its fences, indexes
+		// and zone maps
+		void AddMerged(FileUtil &merged, Record &rec, long &nRecords,
+					   IndexSet &indexes, ZoneMap &zones);
+		// a BigQ for the next records, with pipes of its own
+		void NewBatch();
+
+		// merges the file with the delta runs in the background; the merged
+		// file takes the place of the file at the next MoveFirst, flush or
+		// Close (FinishCompaction), while the scans read the old one
+		void StartCompaction();
+		static void* CompactHelper(void*);
+		void FinishCompaction(bool bWait);
+
+		// the file is merged with the delta runs
+		int GetNextMerged(Record &fetchme, CNF *pCnf, Record *pLiteral);
+		int GetNextFrom(int nSource, Record &fetchme, CNF *pCnf, Record *pLiteral);
+		void ClearHeads();
+		// GetNext(CNF) of the file without the delta runs
+		int GetNextBase(Record &fetchme, CNF &cnf, Record &literal);
         string getusec();
 
 		// Functions for GetNext(CNF)
 		int LoadMatchingPage(Record&);
-		int BinarySearch(int low, int high, Record&, int oldPagenum);	
+		// sets m_LowOrder and m_HighOrder, false if the sort order
+		// does not bound the records that can match
+		bool MakeSearchOrders(CNF &cnf);
 
 	public:
 		Sorted();
@@ -44,33 +100,47 @@ class Sorted : public GenericDBFile
 
 		// name = location of the file
 		// return value: 1 on success, 0 on failure
-		int Create (char *name,  void *startup);
+		int Create (char *name,  void *startup, int pageSize = PAGE_SIZE, int compression = COMPRESS_NONE);
 
 		// This function assumes that the DBFile already exists
 		// and has previously been created and then closed.
-		int Open (char *name);
+		int Open (char *name, FileOpenMode mode = APPEND);
 
 		// Closes the file.
 		// The return value is a 1 on success and a zero on failure
 		int Close ();
 
 		// Bulk loads the DBFile instance from a text file,
-		// appending new data to it using the SuckNextRecord function from Record.h
+		// appending new data to it with a BulkLoader (see BulkLoader.h)
 		// loadMe is the name of the data file to bulk load.
 		void Load (Schema &mySchema, char *loadMe);
 
 		// Forces the pointer to correspond to the first record in the file
 		void MoveFirst();
 
-		// Add new record to the end of the file
+		// Add new record to the file; the records added go into a sorted
+		// delta run once the file is read or closed (see DeltaRuns)
 		// Note: addMe is consumed by this function and cannot be used again
 		void Add (Record &addMe);
 
-		// Fetch next record (relative to p_currPtr) into fetchMe
+		// Fetch next record (relative to p_currPtr) into fetchMe; the
+		// records of the delta runs come in sort order with those of the file
 		int GetNext (Record &fetchMe);
 
-		// Applies CNF and then fetches the next record
+		// Applies CNF and then fetches the next record. If the scan has
+		// not started yet and the CNF has an equality on an indexed
+		// attribute, only the records the index gives are fetched. An
+		// equality on a prefix of the sort order, and a < or > on the
+		// attribute of the sort after it, start the scan on the page the
+		// fence keys give and end it after the last record that can
+		// match; a scan that can not do that does not read the pages the
+		// zone maps rule out
 		int GetNext (Record &fetchMe, CNF &applyMe, Record &literal);
+
+		// SEQUENTIAL_ACCESS: the predicates are not selective,
+		// GetNext(CNF) scans the file instead of using an index
+		void SetAccessPattern (AccessPattern pattern);
+		int GetPageSize () { return m_pFile->GetPageSize(); }
 };
 
 #endif
@@ -0,0 +1,323 @@
+#include "TextParser.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <iostream>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD
+#endif
+
+// bit i of the mask: p[i] is c or a newline, for the nBytes (<= 64) from p
+static uint64_t ScanScalar(const char *p, int nBytes, char c)
+{
+	uint64_t mask = 0;
+	for (int i = 0; i < nBytes; i++)
+	{
+		if (p[i] == c || p[i] == '\n')
+			mask |= (uint64_t) 1 << i;
+	}
+	return mask;
+}
+
+static uint64_t ScanWindowScalar(const char *p, char c)
+{
+	return ScanScalar(p, 64, c);
+}
+
+#ifdef HAVE_X86_SIMD
+__attribute__((target("sse2")))
+static uint64_t ScanWindowSSE2(const char *p, char c)
+{
+	__m128i delimiter = _mm_set1_epi8(c);
+	__m128i newline = _mm_set1_epi8('\n');
+	uint64_t mask = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i *) (p + 16 * i));
+		__m128i hit = _mm_or_si128(_mm_cmpeq_epi8(v, delimiter), _mm_cmpeq_epi8(v, newline));
+		mask |= (uint64_t) (unsigned int) _mm_movemask_epi8(hit) << (16 * i);
+	}
+	return mask;
+}
+
+__attribute__((target("avx2")))
+static uint64_t ScanWindowAVX2(const char *p, char c)
+{
+	__m256i delimiter = _mm256_set1_epi8(c);
+	__m256i newline = _mm256_set1_epi8('\n');
+	__m256i lo = _mm256_loadu_si256((const __m256i *) p);
+	__m256i hi = _mm256_loadu_si256((const __m256i *) (p + 32));
+	__m256i hitLo = _mm256_or_si256(_mm256_cmpeq_epi8(lo, delimiter), _mm256_cmpeq_epi8(lo, newline));
+	__m256i hitHi = _mm256_or_si256(_mm256_cmpeq_epi8(hi, delimiter), _mm256_cmpeq_epi8(hi, newline));
+	return (uint64_t) (unsigned int) _mm256_movemask_epi8(hitLo) |
+		   (uint64_t) (unsigned int) _mm256_movemask_epi8(hitHi) << 32;
+}
+#endif
+
+typedef uint64_t (*ScanWindowFunc)(const char *p, char c);
+
+static const char *s_sInstructionSet = "scalar";
+
+static ScanWindowFunc ChooseScanWindow()
+{
+#ifdef HAVE_X86_SIMD
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+	{
+		s_sInstructionSet = "AVX2";
+		return &ScanWindowAVX2;
+	}
+	if (__builtin_cpu_supports("sse2"))
+	{
+		s_sInstructionSet = "SSE2";
+		return &ScanWindowSSE2;
+	}
+#endif
+	return &ScanWindowScalar;
+}
+
+// chosen once, before main
+static ScanWindowFunc s_pScanWindow = ChooseScanWindow();
+
+TextScanner::TextScanner(const char *begin, const char *end, char cDelimiter) :
+	m_pPos(begin), m_pEnd(end), m_pWindow(begin), m_nMask(0), m_cDelimiter(cDelimiter)
+{
+	Scan(begin);
+}
+
+void TextScanner::Scan(const char *pWindow)
+{
+	m_pWindow = pWindow;
+	// the end of the text is not read past
+	if (m_pEnd - pWindow >= 64)
+		m_nMask = (*s_pScanWindow)(pWindow, m_cDelimiter);
+	else if (m_pEnd > pWindow)
+		m_nMask = ScanScalar(pWindow, m_pEnd - pWindow, m_cDelimiter);
+	else
+		m_nMask = 0;
+}
+
+const char* TextScanner::GetInstructionSet()
+{
+	return s_sInstructionSet;
+}
+
+
+// 10^0 to 10^22, all of them exact doubles
+static const double s_vPow10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// what isspace says in the "C" locale
+static inline bool IsSpace(char c)
+{
+	return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static inline bool IsDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+TextParser::TextParser(Schema &mySchema, char cDelimiter) : m_vTypes(), m_cDelimiter(cDelimiter)
+{
+	Attribute *atts = mySchema.GetAtts();
+	for (int i = 0; i < mySchema.GetNumAtts(); i++)
+		m_vTypes.push_back(atts[i].myType);
+}
+
+int TextParser::Parse(TextScanner &text, char *space)
+{
+	int n = m_vTypes.size();
+
+	// this is the current position (int bytes) in the binary
+	// representation of the record that we are dealing with
+	int currentPosInRec = sizeof (int) * (n + 1);
+
+	for (int i = 0; i < n; i++)
+	{
+		// a newline in a value is part of it, as with SuckNextRecord
+		const char *value = text.GetPos();
+		const char *bar;
+		do
+			bar = text.Next();
+		while (bar != NULL && *bar != m_cDelimiter);
+		if (bar == NULL)
+			return 0;
+		int len = bar - value;
+
+		// room for the value, its NUL and its padding
+		if (currentPosInRec + len + 2 * sizeof (double) > PAGE_SIZE)
+		{
+			cerr << "BAD: a record of the text is larger than a page\n";
+			exit(1);
+		}
+
+		((int *) space)[i + 1] = currentPosInRec;
+
+		if (m_vTypes[i] == Int)
+		{
+			*((int *) &(space[currentPosInRec])) = ParseInt(value, bar);
+			currentPosInRec += sizeof (int);
+		}
+		else if (m_vTypes[i] == Double)
+		{
+			// make sure that we are starting at a double-aligned position
+			while (currentPosInRec % sizeof (double) != 0)
+			{
+				*((int *) &(space[currentPosInRec])) = 0;
+				currentPosInRec += sizeof (int);
+				((int *) space)[i + 1] = currentPosInRec;
+			}
+			*((double *) &(space[currentPosInRec])) = ParseDouble(value, bar);
+			currentPosInRec += sizeof (double);
+		}
+		else
+		{
+			// with its NUL, and aligned to the size of an integer
+			int nPadded = (len + sizeof (int)) & ~(sizeof (int) - 1);
+			memcpy(&(space[currentPosInRec]), value, len);
+			memset(&(space[currentPosInRec + len]), 0, nPadded - len);
+			currentPosInRec += nPadded;
+		}
+	}
+
+	// whatever follows the last value on the line is not part of it
+	const char *eol;
+	do
+		eol = text.Next();
+	while (eol != NULL && *eol != '\n');
+
+	((int *) space)[0] = currentPosInRec;
+	return currentPosInRec;
+}
+
+int TextParser::ParseInt(const char *value, const char *end)
+{
+	const char *p = value;
+	while (p < end && IsSpace(*p))
+		p++;
+	bool bNegative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+		bNegative = (*p++ == '-');
+
+	// atoi is strtol, which stops at the largest long
+	unsigned long nLimit = bNegative ? (unsigned long) LONG_MAX + 1 : (unsigned long) LONG_MAX;
+	unsigned long n = 0;
+	for (; p < end && IsDigit(*p); p++)
+	{
+		unsigned long d = *p - '0';
+		n = (n > (nLimit - d) / 10) ? nLimit : n * 10 + d;
+	}
+	return (int) (bNegative ? (long) (0 - n) : (long) n);
+}
+
+// strtod wants the value to end with a NUL
+static double ParseDoubleSlow(const char *value, const char *end)
+{
+	char buf[64];
+	int len = end - value;
+	if (len < sizeof(buf))
+	{
+		memcpy(buf, value, len);
+		buf[len] = 0;
+		return strtod(buf, NULL);
+	}
+	string s(value, len);
+	return strtod(s.c_str(), NULL);
+}
+
+double TextParser::ParseDouble(const char *value, const char *end)
+{
+	const char *p = value;
+	while (p < end && IsSpace(*p))
+		p++;
+	bool bNegative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+		bNegative = (*p++ == '-');
+
+	// the first 19 significant digits, and the power of 10 they are
+	// multiplied by; bExact is false if a digit that is not 0 is left out
+	uint64_t nMantissa = 0;
+	int nDigits = 0;
+	int nExp10 = 0;
+	bool bExact = true;
+	bool bAny = false;
+	const char *pFirst = p;
+	for (; p < end && IsDigit(*p); p++)
+	{
+		bAny = true;
+		if (nDigits < 19)
+		{
+			nMantissa = nMantissa * 10 + (*p - '0');
+			if (nMantissa != 0)
+				nDigits++;
+		}
+		else
+		{
+			nExp10++;
+			bExact = bExact && *p == '0';
+		}
+	}
+
+	// hexadecimal, as strtod reads it
+	if (p < end && (*p == 'x' || *p == 'X') && p == pFirst + 1 && *pFirst == '0')
+		return ParseDoubleSlow(value, end);
+
+	if (p < end && *p == '.')
+	{
+		for (p++; p < end && IsDigit(*p); p++)
+		{
+			bAny = true;
+			if (nDigits < 19)
+			{
+				nMantissa = nMantissa * 10 + (*p - '0');
+				if (nMantissa != 0)
+					nDigits++;
+				nExp10--;
+			}
+			else
+				bExact = bExact && *p == '0';
+		}
+	}
+
+	// inf, nan and the like
+	if (!bAny)
+		return ParseDoubleSlow(value, end);
+
+	// an exponent, if digits follow the 'e'
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		const char *q = p + 1;
+		bool bNegativeExp = false;
+		if (q < end && (*q == '-' || *q == '+'))
+			bNegativeExp = (*q++ == '-');
+		if (q < end && IsDigit(*q))
+		{
+			int nExp = 0;
+			for (; q < end && IsDigit(*q); q++)
+			{
+				if (nExp < 100000)
+					nExp = nExp * 10 + (*q - '0');
+			}
+			nExp10 += bNegativeExp ? -nExp : nExp;
+		}
+	}
+
+	double d;
+	if (nMantissa == 0)
+		d = 0;
+	else if (bExact && nMantissa <= ((uint64_t) 1 << 53) && nExp10 >= -22 && nExp10 <= 22)
+	{
+		d = (double) nMantissa;
+		d = (nExp10 < 0) ? d / s_vPow10[-nExp10] : d * s_vPow10[nExp10];
+	}
+	else
+		return ParseDoubleSlow(value, end);
+	return bNegative ? -d : d;
+}
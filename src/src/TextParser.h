@@ -0,0 +1,87 @@
+#ifndef TEXT_PARSER_H
+#define TEXT_PARSER_H
+
+#include <stdint.h>
+#include <vector>
+#include "Defs.h"
+#include "Schema.h"
+
+using namespace std;
+
+// Finds the delimiters and the newlines of a text in memory, 64 bytes at
+// a time: a window of the text is compared with both characters with
+// SSE2 or AVX2, whichever the processor has (chosen at run time, plain
+// C++ elsewhere), and the positions found are kept in a bit mask that
+// Next hands out one by one
+class TextScanner
+{
+	private:
+		const char *m_pPos;			// first character not handed out
+		const char *m_pEnd;
+		const char *m_pWindow;		// the 64 bytes m_nMask tells about
+		uint64_t m_nMask;			// bit i: m_pWindow[i] is to be handed out
+		char m_cDelimiter;
+
+		// the mask of the window that starts at pWindow
+		void Scan(const char *pWindow);
+
+	public:
+		TextScanner(const char *begin, const char *end, char cDelimiter = '|');
+
+		// the next delimiter or newline, NULL at the end of the text
+		inline const char* Next()
+		{
+			while (m_nMask == 0)
+			{
+				if (m_pWindow + 64 >= m_pEnd)
+				{
+					m_pPos = m_pEnd;
+					return NULL;
+				}
+				Scan(m_pWindow + 64);
+			}
+			const char *found = m_pWindow + __builtin_ctzll(m_nMask);
+			m_nMask &= m_nMask - 1;
+			m_pPos = found + 1;
+			return found;
+		}
+
+		// where the text Next did not get to starts
+		const char* GetPos() { return m_pPos; }
+		const char* GetEnd() { return m_pEnd; }
+		bool AtEnd() { return m_pPos >= m_pEnd; }
+
+		// the name of the instructions Scan uses
+		static const char* GetInstructionSet();
+};
+
+// Lays out the records of a text, as SuckNextRecord reads them: every
+// value is followed by the delimiter, and whatever comes after the last
+// one up to the newline is left out. Ints and doubles are converted with
+// ParseInt and ParseDouble, which do what atoi and atof do, without the
+// locale and much faster. A parser can be shared by threads
+class TextParser
+{
+	private:
+		vector<Type> m_vTypes;
+		char m_cDelimiter;
+
+	public:
+		TextParser(Schema &mySchema, char cDelimiter = '|');
+
+		// the record of the text at the scanner, laid out in space, which
+		// holds PAGE_SIZE bytes; the scanner goes to the next line.
+		// Returns the length of the record, 0 if the text ends before it does
+		int Parse(TextScanner &text, char *space);
+
+		// the number at value, which ends at end or before
+		static int ParseInt(const char *value, const char *end);
+
+		// the double at value, correctly rounded: when its digits make an
+		// integer of at most 2^53 and the power of 10 is at most 22, both
+		// are exact doubles and one multiplication or division rounds them;
+		// the other values go to strtod
+		static double ParseDouble(const char *value, const char *end);
+};
+
+#endif
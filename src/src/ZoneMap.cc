@@ -0,0 +1,304 @@
+#include <string.h>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include "ZoneMap.h"
+#include "FileUtil.h"
+
+pthread_mutex_t ZoneMap::m_statsMutex = PTHREAD_MUTEX_INITIALIZER;
+unsigned long ZoneMap::m_nPagesChecked = 0;
+unsigned long ZoneMap::m_nPagesSkipped = 0;
+
+ZoneMap::ZoneMap() : m_bDirty(false)
+{}
+
+bool ZoneMap::SetTypes(Schema &schema)
+{
+	if (!m_vTypes.empty())
+		return false;
+
+	Attribute *atts = schema.GetAtts();
+	for (int i = 0; i < schema.GetNumAtts(); i++)
+		m_vTypes.push_back(atts[i].myType);
+	m_bDirty = true;
+	return true;
+}
+
+void ZoneMap::Clear(bool bTypes)
+{
+	m_vPages.clear();
+	if (bTypes)
+		m_vTypes.clear();
+	m_bDirty = true;
+}
+
+void ZoneMap::MarkUnknown(int nPages)
+{
+	if (nPages > m_vPages.size())
+		m_vPages.resize(nPages);
+	for (int p = 0; p < nPages; p++)
+		m_vPages[p].nRecs = -1;
+	m_bDirty = true;
+}
+
+void ZoneMap::Read(const string &metaPath)
+{
+	m_vTypes.clear();
+	m_vPages.clear();
+	m_bDirty = false;
+
+	ifstream meta_in;
+	meta_in.open(metaPath.c_str());
+	string line;
+	while (getline(meta_in, line))
+	{
+		istringstream ss(line);
+		string word;
+		ss >> word;
+		if (word.compare("zonemap") == 0)
+		{
+			int nAtts = 0;
+			string type;
+			ss >> nAtts;
+			for (int i = 0; i < nAtts && ss >> type; i++)
+				m_vTypes.push_back(TypeFromString(type));
+		}
+		else if (word.compare("zone") == 0 && !m_vTypes.empty())
+		{
+			int nPage = -1;
+			ss >> nPage;
+			if (nPage < 0)
+				continue;
+			if (nPage >= m_vPages.size())
+				m_vPages.resize(nPage + 1);
+
+			PageZone &zone = m_vPages[nPage];
+			ss >> zone.nRecs;
+			zone.vAtts.resize(m_vTypes.size());
+			for (int i = 0; i < m_vTypes.size(); i++)
+			{
+				ReadValue(ss, m_vTypes[i], zone.vAtts[i].dMin, zone.vAtts[i].sMin);
+				ReadValue(ss, m_vTypes[i], zone.vAtts[i].dMax, zone.vAtts[i].sMax);
+			}
+			if (!ss)
+				zone.nRecs = 0;		// cut short, do not trust it
+		}
+	}
+}
+
+void ZoneMap::Write(const string &metaPath)
+{
+	// keep everything but the zone maps
+	vector<string> vLines;
+	ifstream meta_in;
+	meta_in.open(metaPath.c_str());
+	string line;
+	while (getline(meta_in, line))
+	{
+		if (line.compare(0, 5, "zone ") != 0 && line.compare(0, 8, "zonemap ") != 0)
+			vLines.push_back(line);
+	}
+	meta_in.close();
+
+	ofstream meta_out;
+	meta_out.open(metaPath.c_str(), ios::trunc);
+	for (int i = 0; i < vLines.size(); i++)
+		meta_out << vLines[i] << "\n";
+
+	if (!m_vTypes.empty())
+	{
+		meta_out << "zonemap " << m_vTypes.size();
+		for (int i = 0; i < m_vTypes.size(); i++)
+			meta_out << " " << TypeToString(m_vTypes[i]);
+		meta_out << "\n";
+
+		// doubles have to come back exactly as they went out
+		meta_out << setprecision(17);
+		for (int p = 0; p < m_vPages.size(); p++)
+		{
+			PageZone &zone = m_vPages[p];
+			if (zone.nRecs <= 0)
+				continue;
+			meta_out << "zone " << p << " " << zone.nRecs;
+			for (int i = 0; i < m_vTypes.size(); i++)
+			{
+				WriteValue(meta_out, m_vTypes[i], zone.vAtts[i].dMin, zone.vAtts[i].sMin);
+				WriteValue(meta_out, m_vTypes[i], zone.vAtts[i].dMax, zone.vAtts[i].sMax);
+			}
+			meta_out << "\n";
+		}
+	}
+	meta_out.close();
+	m_bDirty = false;
+}
+
+void ZoneMap::Add(Record &rec, int nPage)
+{
+	if (m_vTypes.empty())
+		return;
+
+	if (nPage >= m_vPages.size())
+		m_vPages.resize(nPage + 1);
+	PageZone &zone = m_vPages[nPage];
+	if (zone.nRecs < 0)
+		return;
+
+	// a record of some other schema, the page can not be summarized
+	char *bits = rec.bits;
+	int nAtts = ((int *) bits)[1] / sizeof(int) - 1;
+	if (nAtts != m_vTypes.size())
+	{
+		zone.nRecs = -1;
+		m_bDirty = true;
+		return;
+	}
+
+	bool bFirst = (zone.nRecs == 0);
+	zone.nRecs++;
+	zone.vAtts.resize(nAtts);
+	m_bDirty = true;
+
+	for (int i = 0; i < nAtts; i++)
+	{
+		char *att = bits + ((int *) bits)[i + 1];
+		AttZone &az = zone.vAtts[i];
+		if (m_vTypes[i] == String)
+		{
+			if (bFirst || strcmp(att, az.sMin.c_str()) < 0)
+				az.sMin = att;
+			if (bFirst || strcmp(att, az.sMax.c_str()) > 0)
+				az.sMax = att;
+		}
+		else
+		{
+			double dVal = (m_vTypes[i] == Int) ? *((int *) att) : *((double *) att);
+			if (bFirst || dVal < az.dMin)
+				az.dMin = dVal;
+			if (bFirst || dVal > az.dMax)
+				az.dMax = dVal;
+		}
+	}
+}
+
+void ZoneMap::AddLast(FileUtil &file)
+{
+	Record lastRec;
+	int nPage, nSlot;
+	if (!m_vTypes.empty() && file.GetLastAdded(lastRec, nPage, nSlot))
+		Add(lastRec, nPage);
+}
+
+void ZoneMap::Build(const string &binPath)
+{
+	m_vPages.clear();
+	m_bDirty = true;
+	if (m_vTypes.empty())
+		return;
+
+	RecordScan scan;
+	scan.Open(binPath);
+	Record rec;
+	int nPage, nSlot;
+	while (scan.GetNext(rec, nPage, nSlot))
+		Add(rec, nPage);
+	scan.Close();
+}
+
+bool ZoneMap::MayHold(Comparison &c, PageZone &zone, Record &literal)
+{
+	// only attribute vs literal comparisons can be ruled out
+	int nAtt, nLit;
+	CompOperator op;
+	if (!c.GetAttOpLiteral(nAtt, nLit, op))
+		return true;
+
+	if (nAtt >= m_vTypes.size() || m_vTypes[nAtt] != c.attType)
+		return true;
+
+	AttZone &az = zone.vAtts[nAtt];
+	char *lit = literal.bits + ((int *) literal.bits)[nLit + 1];
+	if (c.attType == String)
+	{
+		if (op == Equals)
+			return strcmp(lit, az.sMin.c_str()) >= 0 && strcmp(lit, az.sMax.c_str()) <= 0;
+		else if (op == LessThan)
+			return strcmp(az.sMin.c_str(), lit) < 0;
+		else
+			return strcmp(az.sMax.c_str(), lit) > 0;
+	}
+
+	double dLit = (c.attType == Int) ? *((int *) lit) : *((double *) lit);
+	if (op == Equals)
+		return dLit >= az.dMin && dLit <= az.dMax;
+	else if (op == LessThan)
+		return az.dMin < dLit;
+	else
+		return az.dMax > dLit;
+}
+
+int ZoneMap::GetPagesToRead(CNF &cnf, Record &literal, int nPages, vector<bool> &vRead)
+{
+	vRead.assign(nPages, true);
+	if (m_vTypes.empty())
+		return 0;
+
+	int nSkipped = 0;
+	for (int p = 0; p < nPages && p < m_vPages.size(); p++)
+	{
+		PageZone &zone = m_vPages[p];
+		if (zone.nRecs <= 0)
+			continue;
+
+		// the page can go if one of the AND clauses has no
+		// comparison that can hold on it
+		for (int i = 0; i < cnf.numAnds && vRead[p]; i++)
+		{
+			bool bMayHold = false;
+			for (int j = 0; j < cnf.orLens[i] && !bMayHold; j++)
+				bMayHold = MayHold(cnf.orList[i][j], zone, literal);
+			if (!bMayHold)
+			{
+				vRead[p] = false;
+				nSkipped++;
+			}
+		}
+	}
+
+	pthread_mutex_lock(&m_statsMutex);
+	m_nPagesChecked += nPages;
+	m_nPagesSkipped += nSkipped;
+	pthread_mutex_unlock(&m_statsMutex);
+	return nSkipped;
+}
+
+void ZoneMap::WriteValue(ostream &out, Type type, double dVal, const string &sVal)
+{
+	if (type == String)
+		out << " " << sVal.size() << ":" << sVal;
+	else
+		out << " " << dVal;
+}
+
+void ZoneMap::ReadValue(istream &in, Type type, double &dVal, string &sVal)
+{
+	if (type == String)
+	{
+		int nLen = 0;
+		in >> nLen;
+		in.get();	// the ':'
+		sVal.resize(nLen);
+		if (nLen > 0)
+			in.read(&sVal[0], nLen);
+	}
+	else
+		in >> dVal;
+}
+
+void ZoneMap::PrintStats(ostream &out)
+{
+	pthread_mutex_lock(&m_statsMutex);
+	if (m_nPagesChecked > 0)
+		out << "Zone maps: " << m_nPagesSkipped << " of " << m_nPagesChecked
+			<< " pages skipped\n";
+	pthread_mutex_unlock(&m_statsMutex);
+}
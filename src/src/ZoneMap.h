@@ -0,0 +1,102 @@
+#ifndef ZONE_MAP_H
+#define ZONE_MAP_H
+
+#include <pthread.h>
+#include <string>
+#include <vector>
+#include <iostream>
+#include "Defs.h"
+#include "Record.h"
+#include "Schema.h"
+#include "Comparison.h"
+
+using namespace std;
+
+class FileUtil;
+
+// smallest and largest value of one attribute on a page; Int and Double
+// values are kept in the doubles, String values in the strings
+struct AttZone
+{
+	double dMin, dMax;
+	string sMin, sMax;
+};
+
+// summary of one page of a file; nRecs = 0 if the page has no records,
+// -1 if some of them could not be summarized: the page is always read
+struct PageZone
+{
+	int nRecs;
+	vector<AttZone> vAtts;
+
+	PageZone() : nRecs(0) {}
+};
+
+// Zone maps of a heap or sorted file: for every data page, the number of
+// records on it and the range of each of their attributes. A scan with a
+// CNF does not read the pages on which one of the AND clauses can not hold.
+// The attribute types come from the schema given to Load; the zone maps
+// are kept in the .meta.data file of the table, as a line
+//   zonemap <number of attributes> <type>...
+// followed by one line per page
+//   zone <page> <records> <min> <max> <min> <max>...
+// where a String is written as <length>:<characters>
+class ZoneMap
+{
+	private:
+		vector<Type> m_vTypes;		// empty until the schema is known
+		vector<PageZone> m_vPages;
+		bool m_bDirty;				// changed since Read
+
+		// process wide statistics, printed after a query
+		static pthread_mutex_t m_statsMutex;
+		static unsigned long m_nPagesChecked;
+		static unsigned long m_nPagesSkipped;
+
+		// false if comparison "c" can not hold for any record of the page
+		bool MayHold(Comparison &c, PageZone &zone, Record &literal);
+
+	public:
+		ZoneMap();
+		~ZoneMap() {}
+
+		// takes the attribute types from the schema, if they are not
+		// known yet; returns true if they were not
+		bool SetTypes(Schema &schema);
+		bool HasTypes() { return !m_vTypes.empty(); }
+		bool IsDirty() { return m_bDirty; }
+
+		// forgets about every page, and the types as well if bTypes
+		void Clear(bool bTypes);
+
+		// the pages below nPages hold records that were added before the
+		// types were known: they are always read
+		void MarkUnknown(int nPages);
+
+		// reads the zone maps from, or writes them to, the .meta.data file
+		// metaPath; Write keeps the other lines of the file as they are
+		void Read(const string &metaPath);
+		void Write(const string &metaPath);
+
+		// widens the zone of page nPage so that it covers "rec"
+		void Add(Record &rec, int nPage);
+
+		// Add for the record "file" got last, while it is being written
+		void AddLast(FileUtil &file);
+
+		// zone maps of every page of the file binPath, from scratch
+		void Build(const string &binPath);
+
+		// fills vRead with the pages of a file of nPages pages that a scan
+		// with the CNF has to read; returns the number of pages skipped
+		int GetPagesToRead(CNF &cnf, Record &literal, int nPages, vector<bool> &vRead);
+
+		static void PrintStats(ostream &out);
+
+		// a value of the metadata file: a String as <length>:<characters>,
+		// since it may hold blanks, Int and Double as numbers
+		static void WriteValue(ostream &out, Type type, double dVal, const string &sVal);
+		static void ReadValue(istream &in, Type type, double &dVal, string &sVal);
+};
+
+#endif
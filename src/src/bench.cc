@@ -0,0 +1,528 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+#include <vector>
+#include <pthread.h>
+#include "DBFile.h"
+#include "BigQ.h"
+#include "RecordLayout.h"
+
+// make sure that the file path/dir information below is correct
+char dbfile_dir[100] = ""; // dir where the benchmark files are created
+char tpch_dir[100] = "/cise/tmp/dbi_sp11/DATA/1G/"; // dir where dbgen tpch files (extension *.tbl) can be found
+char catalog_path[100] = "catalog"; // full path of the catalog file
+char partsupp[] = "partsupp";
+
+using namespace std;
+
+// Benchmarks of the storage and sort paths, on partsupp. The larger the
+// partsupp.tbl of the tpch dir, the more they mean. No parser is needed.
+//
+// usage: bench.out <benchmark> [tpch dir/] [dbfile dir/]
+//
+//   psize      loads, scans, sorts and looks partsupp up at every page size
+//   compress   sizes, loads and scans of every file type, with and without
+//              page compression
+//   sort       sorts partsupp with a BigQ, on 0 to 4 sorter threads and by
+//              replacement selection
+//   merge      merges of 8 to 512 runs by a BigQ
+//   compact    size, load and scans of heaps of records of Record.h and
+//              of RECORD_FORMAT_V2
+//   scan       warm heap scans handing out record views, against the same
+//              scans copying every record as the pages used to
+
+Schema *schema;
+
+double Now ()
+{
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+// drops the pages of the file from the OS cache, so that a scan reads them
+void DropCache (const char *path)
+{
+	int fd = open (path, O_RDONLY);
+	if (fd < 0)
+		return;
+	fdatasync (fd);
+	posix_fadvise (fd, 0, 0, POSIX_FADV_DONTNEED);
+	close (fd);
+}
+
+long GetFileSize (const char *path)
+{
+	struct stat fileStat;
+	return stat (path, &fileStat) == 0 ? fileStat.st_size : 0;
+}
+
+int GetInt (Record &rec, int whichAtt)
+{
+	char *bits = rec.bits;
+	return *((int *) &(bits[((int *) bits)[whichAtt + 1]]));
+}
+
+void GetPath (char *path, const char *name, const char *ext)
+{
+	sprintf (path, "%s%s%s", dbfile_dir, name, ext);
+}
+
+// the CNF of whichAtt = value, from the parse tree the parser would make
+void GetEqualsCnf (int whichAtt, int value, CNF &cnf, Record &literal)
+{
+	char sValue[16];
+	sprintf (sValue, "%d", value);
+	Operand name = {NAME, schema->GetAtts ()[whichAtt].name};
+	Operand literalValue = {INT, sValue};
+	ComparisonOp op = {EQUALS, &name, &literalValue};
+	OrList orList = {&op, NULL};
+	AndList andList = {&orList, NULL};
+	cnf.GrowFromParseTree (&andList, schema, literal);
+}
+
+// every page size, the sort of the sorted files keeping to the same
+// memory: load and cold scan of a heap, load of a sorted file, and
+// lookups of the sorted file on its sort key
+void BenchPageSizes ()
+{
+	char tbl_path[200], path[200];
+	sprintf (tbl_path, "%spartsupp.tbl", tpch_dir);
+	const int nSortMemory = 1 << 20;
+	const int nLookups = 1000;
+
+	OrderMaker byPartKey;
+	byPartKey.numAtts = 1;
+	byPartKey.whichAtts[0] = 0;
+	byPartKey.whichTypes[0] = Int;
+
+	cout << " page size   heap load   cold scan   sorted load   " << nLookups << " lookups\n";
+	for (int pageSize = MIN_PAGE_SIZE; pageSize <= PAGE_SIZE; pageSize *= 2)
+	{
+		DBFile dbfile;
+		GetPath (path, "bench_heap", ".bin");
+		double dStart = Now ();
+		dbfile.Create (path, heap, NULL, pageSize);
+		dbfile.Load (*schema, tbl_path);
+		dbfile.Close ();
+		double dLoad = Now () - dStart;
+
+		dbfile.Open (path, READ_ONLY);
+		DropCache (path);
+		dStart = Now ();
+		dbfile.MoveFirst ();
+		Record temp;
+		long nScanned = 0;
+		int nMaxKey = 1;
+		while (dbfile.GetNext (temp) == 1)
+		{
+			nMaxKey = max (nMaxKey, GetInt (temp, 0));
+			nScanned++;
+		}
+		double dScan = Now () - dStart;
+		dbfile.Close ();
+
+		SortInfo sortInfo = {&byPartKey, max (nSortMemory / pageSize, 3)};
+		GetPath (path, "bench_sorted", ".bin");
+		dStart = Now ();
+		dbfile.Create (path, sorted, &sortInfo, pageSize);
+		dbfile.Load (*schema, tbl_path);
+		dbfile.Close ();
+		double dSort = Now () - dStart;
+
+		dbfile.Open (path, READ_ONLY);
+		DropCache (path);
+		dStart = Now ();
+		long nFound = 0;
+		for (int i = 0; i < nLookups; i++)
+		{
+			CNF cnf;
+			Record literal;
+			GetEqualsCnf (0, 1 + (int) ((long) i * 7919 % nMaxKey), cnf, literal);
+			dbfile.MoveFirst ();
+			while (dbfile.GetNext (temp, cnf, literal) == 1)
+				nFound++;
+		}
+		double dLookups = Now () - dStart;
+		dbfile.Close ();
+
+		printf (" %9d %10.3fs %10.3fs %12.3fs %11.3fs   (%ld recs, %ld found)\n", pageSize,
+				dLoad, dScan, dSort, dLookups, nScanned, nFound);
+	}
+}
+
+// every file type, with and without COMPRESS_LZ: size on disk, load,
+// and scans with the file in the OS cache and not
+void BenchCompression ()
+{
+	char tbl_path[200], path[200];
+	sprintf (tbl_path, "%spartsupp.tbl", tpch_dir);
+
+	OrderMaker byPartKey;
+	byPartKey.numAtts = 1;
+	byPartKey.whichAtts[0] = 0;
+	byPartKey.whichTypes[0] = Int;
+	SortInfo sortInfo = {&byPartKey, 64};
+
+	fType types[] = {heap, sorted, pax, tree};
+	const char *names[] = {"heap", "sorted", "pax", "tree"};
+	cout << " file     pages          size        load   cold scan   warm scan\n";
+	for (int t = 0; t < 4; t++)
+	{
+		for (int compression = COMPRESS_NONE; compression <= COMPRESS_LZ; compression++)
+		{
+			DBFile dbfile;
+			GetPath (path, "bench_compress", ".bin");
+			double dStart = Now ();
+			dbfile.Create (path, types[t], (types[t] == heap || types[t] == pax) ? NULL : &sortInfo,
+						   PAGE_SIZE, compression);
+			dbfile.Load (*schema, tbl_path);
+			dbfile.Close ();
+			double dLoad = Now () - dStart;
+
+			double dScans[2];
+			long nScanned = 0;
+			Record temp;
+			dbfile.Open (path, READ_ONLY);
+			DropCache (path);
+			for (int i = 0; i < 2; i++)
+			{
+				dStart = Now ();
+				dbfile.MoveFirst ();
+				nScanned = 0;
+				while (dbfile.GetNext (temp) == 1)
+					nScanned++;
+				dScans[i] = Now () - dStart;
+			}
+			dbfile.Close ();
+
+			printf (" %-8s %-6s %12ldB %10.3fs %10.3fs %10.3fs   (%ld recs)\n", names[t],
+					compression == COMPRESS_LZ ? "lz" : "plain", GetFileSize (path), dLoad,
+					dScans[0], dScans[1], nScanned);
+		}
+	}
+}
+
+// a heap of records laid out as Record.h does, and one of compact records
+// (RECORD_FORMAT_V2): size on disk, load, and warm scans, plain and with
+// a CNF on ps_availqty, which ComparisonEngine applies to the compact
+// records as they are. Best of 5
+void BenchCompact ()
+{
+	char tbl_path[200], path[200];
+	sprintf (tbl_path, "%spartsupp.tbl", tpch_dir);
+	GetPath (path, "bench_compact", ".bin");
+
+	CNF cnf;
+	Record literal;
+	GetEqualsCnf (2, 500, cnf, literal);
+
+	cout << " records          size        load        scan    cnf scan\n";
+	for (int compact = 0; compact <= 1; compact++)
+	{
+		DBFile dbfile;
+		double dStart = Now ();
+		dbfile.Create (path, heap, NULL);
+		if (compact)
+		{
+			// as CREATE TABLE does it
+			dbfile.Close ();
+			RecordLayout layout;
+			layout.SetTypes (*schema);
+			layout.Write (path);
+			dbfile.Open (path);
+		}
+		dbfile.Load (*schema, tbl_path);
+		dbfile.Close ();
+		double dLoad = Now () - dStart;
+
+		dbfile.Open (path, READ_ONLY);
+		double dScans[2] = {0, 0};
+		long nScanned = 0, nFound = 0;
+		for (int t = 0; t < 2; t++)
+		{
+			for (int i = 0; i < 5; i++)
+			{
+				dStart = Now ();
+				Record temp;
+				long n = 0;
+				dbfile.MoveFirst ();
+				if (t == 0)
+					while (dbfile.GetNext (temp) == 1)
+						n++;
+				else
+					while (dbfile.GetNext (temp, cnf, literal) == 1)
+						n++;
+				double dSeconds = Now () - dStart;
+				if (i == 0 || dSeconds < dScans[t])
+					dScans[t] = dSeconds;
+				if (t == 0)
+					nScanned = n;
+				else
+					nFound = n;
+			}
+		}
+		dbfile.Close ();
+
+		printf (" %-8s %12ldB %10.3fs %10.3fs %10.3fs   (%ld recs, %ld found)\n",
+				compact ? "compact" : "plain", GetFileSize (path), dLoad, dScans[0], dScans[1],
+				nScanned, nFound);
+	}
+	remove (path);
+	strcat (path, ".meta.data");
+	remove (path);
+}
+
+// warm scans of a heap, plain and with a CNF that few records pass. Pages
+// hand out views into their buffer; the copies are what the scans cost
+// when pages made a heap Record of every tuple. Best of 5
+void BenchScan ()
+{
+	char tbl_path[200], path[200];
+	sprintf (tbl_path, "%spartsupp.tbl", tpch_dir);
+	GetPath (path, "bench_scan", ".bin");
+
+	DBFile dbfile;
+	dbfile.Create (path, heap, NULL);
+	dbfile.Load (*schema, tbl_path);
+	dbfile.Close ();
+	dbfile.Open (path, READ_ONLY);
+
+	CNF cnf;
+	Record literal;
+	GetEqualsCnf (2, 500, cnf, literal);	// ps_availqty, on every page
+	ComparisonEngine comp;
+
+	cout << " scan                best          recs/s\n";
+	long nRecords = 0;
+	for (int t = 0; t < 4; t++)
+	{
+		bool bCnf = (t >= 2), bCopy = (t % 2 == 1);
+		double dBest = 0;
+		long nFound = 0;
+		for (int i = 0; i < 5; i++)
+		{
+			double dStart = Now ();
+			Record temp;
+			nFound = 0;
+			dbfile.MoveFirst ();
+			if (bCnf && !bCopy)
+			{
+				while (dbfile.GetNext (temp, cnf, literal) == 1)
+					nFound++;
+			}
+			else
+			{
+				while (dbfile.GetNext (temp) == 1)
+				{
+					if (bCopy)
+					{
+						Record *pCopy = new Record ();
+						pCopy->Copy (&temp);
+						if (bCnf && comp.Compare (pCopy, &literal, &cnf))
+							nFound++;
+						delete pCopy;
+					}
+					if (!bCnf)
+						nFound++;
+				}
+			}
+			double dSeconds = Now () - dStart;
+			if (i == 0 || dSeconds < dBest)
+				dBest = dSeconds;
+		}
+		if (t == 0)
+			nRecords = nFound;
+
+		printf (" %-3s %-11s %9.3fs %14.0f   (%ld recs)\n", bCnf ? "cnf" : "all",
+				bCopy ? "copies" : "views", dBest, nRecords / dBest, nFound);
+	}
+	dbfile.Close ();
+	remove (path);
+	strcat (path, ".meta.data");
+	remove (path);
+}
+
+// the records of partsupp.tbl, held in memory so that the pipe into a
+// BigQ is not held up by a scan
+vector<Record*> records;
+
+void ReadRecords ()
+{
+	char tbl_path[200];
+	sprintf (tbl_path, "%spartsupp.tbl", tpch_dir);
+	FILE *tableFile = fopen (tbl_path, "r");
+	if (tableFile == NULL)
+	{
+		cerr << "BAD: can't open " << tbl_path << "\n";
+		exit (1);
+	}
+	Record temp;
+	while (temp.SuckNextRecord (schema, tableFile) == 1)
+	{
+		Record *pRec = new Record ();
+		pRec->Consume (&temp);
+		records.push_back (pRec);
+	}
+	fclose (tableFile);
+}
+
+struct FeedArgs
+{
+	Pipe *pPipe;
+};
+
+void* FeedRecords (void *arg)
+{
+	Pipe *pPipe = ((FeedArgs *) arg)->pPipe;
+	Record temp;
+	for (int i = 0; i < records.size (); i++)
+	{
+		temp.Copy (records[i]);
+		pPipe->Insert (&temp);
+	}
+	pPipe->ShutDown ();
+	return NULL;
+}
+
+// sorts the records with a BigQ, checks the order and the count, and
+// returns the seconds it took, the run stats in stats
+double Sort (OrderMaker &sortOrder, int runlen, int pageSize, RunGeneration runGen,
+			 int nSortThreads, RunStats &stats)
+{
+	Pipe in (100), out (100);
+	FeedArgs args = {&in};
+	pthread_t feedThread;
+	double dStart = Now ();
+	pthread_create (&feedThread, NULL, FeedRecords, (void *) &args);
+	BigQ bigQ (in, out, sortOrder, runlen, pageSize, COMPRESS_NONE, runGen, nSortThreads, "bench");
+
+	ComparisonEngine ce;
+	Record temp, last;
+	long nSorted = 0;
+	bool bOrdered = true;
+	while (out.Remove (&temp))
+	{
+		if (nSorted > 0 && ce.Compare (&last, &temp, &sortOrder) > 0)
+			bOrdered = false;
+		last.Consume (&temp);
+		nSorted++;
+	}
+	pthread_join (feedThread, NULL);
+	double dSeconds = Now () - dStart;
+	bigQ.GetRunStats (stats);
+
+	if (nSorted != records.size () || !bOrdered)
+	{
+		cerr << "BAD: sorted " << nSorted << " of " << records.size () << " recs"
+			 << (bOrdered ? "" : ", out of order") << "\n";
+		exit (1);
+	}
+	return dSeconds;
+}
+
+// run generation on sorter threads and by replacement selection, on
+// ps_comment then ps_partkey, with 16MB of memory
+void BenchSort ()
+{
+	ReadRecords ();
+	OrderMaker byComment;
+	byComment.numAtts = 2;
+	byComment.whichAtts[0] = 4;
+	byComment.whichTypes[0] = String;
+	byComment.whichAtts[1] = 0;
+	byComment.whichTypes[1] = Int;
+	const int runlen = (16 << 20) / PAGE_SIZE;
+
+	int threads[] = {0, 1, 2, 4, -1};
+	cout << " run generation            runs     making runs       merging      total\n";
+	for (int t = 0; t <= 5; t++)
+	{
+		RunStats stats;
+		double dSeconds;
+		if (t < 5)
+			dSeconds = Sort (byComment, runlen, PAGE_SIZE, SORTED_RUNS, threads[t], stats);
+		else
+			dSeconds = Sort (byComment, runlen, PAGE_SIZE, REPLACEMENT_SELECTION, 0, stats);
+		char sName[40];
+		if (t < 5)
+			sprintf (sName, "%d sorter thread%s%s", stats.nSortThreads,
+					 stats.nSortThreads != 1 ? "s" : "", threads[t] < 0 ? " (-1)" : "");
+		else
+			sprintf (sName, "replacement selection");
+		printf (" %-22s %7d %10.3fs %12.3fs %9.3fs   (%.0f recs/s making runs)\n", sName,
+				stats.nRuns, stats.dRunSeconds, stats.dMergeSeconds, dSeconds,
+				stats.nRecords / stats.dRunSeconds);
+	}
+}
+
+// the merge phase of a BigQ over 8 to 512 runs of small pages, on
+// ps_partkey; the memory is a run, so the more runs the lower the
+// fan-in, and past it the merge takes intermediate merges. Best of 3
+void BenchMerge ()
+{
+	ReadRecords ();
+	OrderMaker byPartKey;
+	byPartKey.numAtts = 1;
+	byPartKey.whichAtts[0] = 0;
+	byPartKey.whichTypes[0] = Int;
+
+	// the pages of the records, from a sort in a single run
+	RunStats stats;
+	Sort (byPartKey, 1 << 30, MIN_PAGE_SIZE, SORTED_RUNS, 0, stats);
+	long nPages = stats.nPages;
+
+	cout << "   runs   run pages   fan-in   intermediate merges      merging\n";
+	for (int nRuns = 8; nRuns <= 512; nRuns *= 2)
+	{
+		int runlen = (int) ((nPages + nRuns - 1) / nRuns);
+		double dBest = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			Sort (byPartKey, runlen, MIN_PAGE_SIZE, SORTED_RUNS, 0, stats);
+			if (i == 0 || stats.dMergeSeconds < dBest)
+				dBest = stats.dMergeSeconds;
+		}
+		printf (" %6d %11d %8d %21d %11.3fs   (%.0f recs/s)\n", stats.nRuns, runlen,
+				stats.nFanIn, stats.nMergeSteps, dBest, stats.nRecords / dBest);
+	}
+}
+
+int main (int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		cerr << "usage: bench.out <psize|compress|sort|merge|compact|scan> [tpch dir/] [dbfile dir/]\n";
+		return 1;
+	}
+	if (argc > 2)
+		strncpy (tpch_dir, argv[2], sizeof (tpch_dir) - 1);
+	if (argc > 3)
+		strncpy (dbfile_dir, argv[3], sizeof (dbfile_dir) - 1);
+
+	schema = new Schema (catalog_path, partsupp);
+	if (strcmp (argv[1], "psize") == 0)
+		BenchPageSizes ();
+	else if (strcmp (argv[1], "compress") == 0)
+		BenchCompression ();
+	else if (strcmp (argv[1], "sort") == 0)
+		BenchSort ();
+	else if (strcmp (argv[1], "merge") == 0)
+		BenchMerge ();
+	else if (strcmp (argv[1], "compact") == 0)
+		BenchCompact ();
+	else if (strcmp (argv[1], "scan") == 0)
+		BenchScan ();
+	else
+	{
+		cerr << "BAD: no benchmark " << argv[1] << "\n";
+		return 1;
+	}
+	delete schema;
+	return 0;
+}
@@ -31,8 +31,19 @@ extern struct NameList *file_name;     	// input file to load into table
 extern struct AttsList *col_atts;		// Column name and type in create table
 extern int selectFromTable;				// 1 if the SQL is select from table
 extern int createTable;    				// 1 if the SQL is create table
-extern int sortedTable;    				// 0 = create table as heap, 1 = create table as sorted (use sortingAtts)
+extern int sortedTable;    				// 0 = create table as heap, 1 = as sorted, 2 = as B+-tree (use sortingAtts), 3 = as PAX
+extern int tablePageSize;				// page size given with PAGESIZE in create table, 0 if none
+extern int tableCompressed;				// 1 if COMPRESSED is given in create table
+extern int tableCompact;				// 1 if COMPACT is given in create table (heap only)
 extern int insertTable;    				// 1 if the command is Insert into table
+extern int exportTable;					// 1 if the command is Export table, to file_name
+extern int importTable;					// 1 if the command is Import table, from file_name
+extern int createTableAs;				// 1 if the SQL is create table as select, into table_name
+extern int createIndex;    				// 1 if the command is Create index
+extern char *indexColumn;  				// column of the table to index
+extern int createBloomFilter;			// 1 if the command is Create bloom filter, on indexColumn
+extern double bloomFpRate;				// false positive rate given with FPRATE, 0 if none
+extern int createDictionary;			// 1 if the command is Create dictionary, on indexColumn
 extern int dropTable;      				// 1 is the command is Drop table
 extern int printPlanOnScreen;  			// 1 if true
 extern int executePlan;        			// 1 if true
@@ -70,14 +81,37 @@ int main ()
 		Optimizer Oz(StatsObj, finalFunction, tables, boolean, groupingAtts, 
 					 	attsToSelect, distinctAtts, distinctFunc, 
 						cs.nOnScreen, cs.sFileName);
+
+		// CREATE TABLE AS SELECT: the output goes to an export file,
+		// whose pages the new table takes
+		DDL_DML ddObj;
+		string sTableName, sExportFile;
+		if (createTableAs == 1)
+		{
+			sTableName = table_name->name;
+			if (ddObj.check_existing_table(sTableName))
+			{
+				cerr << "Table " << sTableName.c_str() << " already exists in the database!\n";
+				return 1;
+			}
+			sExportFile = sTableName + ".export";
+			Oz.SetExportOutput(sExportFile);
+		}
 						
 		//Oz.PrintFuncOperator();
 		//Oz.PrintTableList();
 		Oz.MakeQueryPlan();
 	
 		// Execute the query according to the plan only if asked
-		if (cs.nExecute == 1)
+		if (cs.nExecute == 1 || createTableAs == 1)
 	    	Oz.ExecuteQuery();
+
+		if (createTableAs == 1)
+		{
+			int ret = ddObj.CreateTableAsSelect(sTableName, sExportFile);
+			if (ret == RET_COULDNT_OPEN_FILE_TO_LOAD)
+				cerr << "\nERROR! The query wrote no output for table " << sTableName.c_str() << endl;
+		}
 	
 		return 0;
 	}
@@ -117,10 +151,17 @@ int main ()
 			temp = temp->next;
 		}
 
-		// SORTED table
-		if (sortedTable == 1)
+		// PAGESIZE clause, otherwise the default page size
+		int nPageSize = (tablePageSize == 0) ? PAGE_SIZE : tablePageSize;
+		int nCompression = (tableCompressed == 1) ? COMPRESS_LZ : COMPRESS_NONE;
+		if (nCompression != COMPRESS_NONE)
+			cout << "\tPages are compressed\n";
+
+		// SORTED or B+-tree table
+		if (sortedTable == 1 || sortedTable == 2)
 		{
-			cout << "\tCreate table as sorted\n";
+			fType eType = (sortedTable == 1) ? sorted : tree;
+			cout << "\tCreate table as " << ((eType == sorted) ? "sorted" : "B+-tree") << "\n";
 			if (sortingAtts == NULL)
 			{
 				cerr << "\nERROR! Sorted table needs columns on which it is sorted!\n";
@@ -135,19 +176,38 @@ int main ()
 					sort_cols_vec.push_back(temp->name);
 					temp = temp->next;
 				}
-				int ret = ddObj.CreateTable(sTableName, ColAttsVec, true, &sort_cols_vec);
+				int ret = ddObj.CreateTable(sTableName, ColAttsVec, eType, &sort_cols_vec, nPageSize,
+											nCompression);
 				if (ret == RET_TABLE_ALREADY_EXISTS)
 					cerr << "Table " << sTableName.c_str() << " already exists in the database!\n";
 				else if (ret == RET_CREATE_TABLE_SORTED_COLS_DONOT_MATCH)
 					cerr << "\nERROR! Sorted column doesn't match table column\n";
+				else if (ret == RET_INVALID_PAGE_SIZE)
+					cerr << "\nERROR! PAGESIZE must be a power of 2 between " << MIN_PAGE_SIZE
+						 << " and " << PAGE_SIZE << "\n";
 				
 			}
 		}
-		else	// HEAP table
+		else	// HEAP or PAX table
 		{
-			int ret = ddObj.CreateTable(sTableName, ColAttsVec);
+			fType eType = (sortedTable == 3) ? pax : heap;
+			if (eType == pax)
+				cout << "\tCreate table as PAX\n";
+			// the PAX rule leaves COMPACT of a previous command behind
+			int nRecordFormat = RECORD_FORMAT_V1;
+			if (eType == heap && tableCompact == 1)
+			{
+				nRecordFormat = RECORD_FORMAT_V2;
+				cout << "\tRecords are compact\n";
+			}
+			tableCompact = 0;
+			int ret = ddObj.CreateTable(sTableName, ColAttsVec, eType, NULL, nPageSize, nCompression,
+										nRecordFormat);
 			if (ret == RET_TABLE_ALREADY_EXISTS)
                     cerr << "Table " << sTableName.c_str() << " already exists in the database!\n";
+			else if (ret == RET_INVALID_PAGE_SIZE)
+				cerr << "\nERROR! PAGESIZE must be a power of 2 between " << MIN_PAGE_SIZE
+					 << " and " << PAGE_SIZE << "\n";
 		}
 	}
 
@@ -172,6 +232,53 @@ int main ()
 		}
 	}
 
+    // --------- EXPORT TABLE command -------------
+	else if (exportTable == 1)
+	{
+		DDL_DML ddObj;
+		cout << "\nExecuting... Export table command\n";
+		if (table_name == NULL || file_name == NULL)
+		{
+			cerr << "\nERROR! No table-name or file-name specified to export!\n";
+			return 1;
+		}
+		else
+		{
+			string sTableName = table_name->name;
+			int ret = ddObj.ExportTable(sTableName, file_name->name);
+			if (ret == RET_TABLE_NOT_IN_DATABASE)
+				cerr << "\nTable " << sTableName.c_str() << " not found in the database!\n";
+			else if (ret == RET_FILE_NOT_FOUND)
+				cerr << "\nERROR! Could not open the file of table " << sTableName.c_str() << endl;
+			else if (ret == RET_COULDNT_WRITE_EXPORT_FILE)
+				cerr << "\nERROR! Could not write " << file_name->name << endl;
+		}
+	}
+
+    // --------- IMPORT TABLE command -------------
+	else if (importTable == 1)
+	{
+		DDL_DML ddObj;
+		cout << "\nExecuting... Import table command\n";
+		if (table_name == NULL || file_name == NULL)
+		{
+			cerr << "\nERROR! No table-name or file-name specified to import!\n";
+			return 1;
+		}
+		else
+		{
+			string sTableName = table_name->name;
+			int ret = ddObj.ImportTable(sTableName, file_name->name);
+			if (ret == RET_TABLE_NOT_IN_DATABASE)
+				cerr << "\nTable " << sTableName.c_str() << " not found in the database!\n";
+			else if (ret == RET_COULDNT_OPEN_FILE_TO_LOAD)
+				cerr << "\nERROR! " << file_name->name << " is not an export file\n";
+			else if (ret == RET_IMPORT_SCHEMA_MISMATCH)
+				cerr << "\nERROR! The records of " << file_name->name
+					 << " do not have the attributes of table " << sTableName.c_str() << endl;
+		}
+	}
+
     // --------- DROP TABLE query -------------
 	else if (dropTable == 1)
     {
@@ -190,6 +297,93 @@ int main ()
 		}
     }
 	
+    // --------- CREATE INDEX query -------------
+	else if (createIndex == 1)
+	{
+		DDL_DML ddObj;
+		cout << "\nExecuting... Create index command\n";
+		if (table_name == NULL || indexColumn == NULL)
+		{
+			cerr << "\nERROR! No table-name or column specified to index!\n";
+			return 1;
+		}
+		else
+		{
+			string sTableName = table_name->name;
+			int ret = ddObj.CreateIndex(sTableName, indexColumn);
+			if (ret == RET_TABLE_NOT_IN_DATABASE)
+				cerr << "\nTable " << sTableName.c_str() << " not found in the database!\n";
+			else if (ret == RET_INDEX_COLUMN_NOT_FOUND)
+				cerr << "\nERROR! Column " << indexColumn << " not found in table "
+					 << sTableName.c_str() << "\n";
+			else if (ret == RET_UNSUPPORTED_FILE_TYPE)
+				cerr << "\nERROR! Only heap and sorted tables can be indexed\n";
+			else if (ret == RET_INDEX_ALREADY_EXISTS)
+				cerr << "\nERROR! Column " << indexColumn << " is already indexed\n";
+		}
+	}
+
+    // --------- CREATE BLOOM FILTER query -------------
+	else if (createBloomFilter == 1)
+	{
+		DDL_DML ddObj;
+		cout << "\nExecuting... Create bloom filter command\n";
+		if (table_name == NULL || indexColumn == NULL)
+		{
+			cerr << "\nERROR! No table-name or column specified to filter!\n";
+			return 1;
+		}
+		else
+		{
+			// FPRATE clause, otherwise the default rate
+			double dFpRate = (bloomFpRate == 0) ? BLOOM_FP_RATE : bloomFpRate;
+			string sTableName = table_name->name;
+			int ret = ddObj.CreateBloomFilter(sTableName, indexColumn, dFpRate);
+			if (ret == RET_TABLE_NOT_IN_DATABASE)
+				cerr << "\nTable " << sTableName.c_str() << " not found in the database!\n";
+			else if (ret == RET_INDEX_COLUMN_NOT_FOUND)
+				cerr << "\nERROR! Column " << indexColumn << " not found in table "
+					 << sTableName.c_str() << "\n";
+			else if (ret == RET_UNSUPPORTED_FILE_TYPE)
+				cerr << "\nERROR! Only heap tables can have Bloom filters\n";
+			else if (ret == RET_BLOOM_ALREADY_EXISTS)
+				cerr << "\nERROR! Column " << indexColumn << " already has a Bloom filter\n";
+			else if (ret == RET_INVALID_FP_RATE)
+				cerr << "\nERROR! FPRATE must be between 0 and 1\n";
+		}
+	}
+
+    // --------- CREATE DICTIONARY query -------------
+	else if (createDictionary == 1)
+	{
+		DDL_DML ddObj;
+		cout << "\nExecuting... Create dictionary command\n";
+		if (table_name == NULL || indexColumn == NULL)
+		{
+			cerr << "\nERROR! No table-name or column specified to encode!\n";
+			return 1;
+		}
+		else
+		{
+			string sTableName = table_name->name;
+			int ret = ddObj.CreateDictionary(sTableName, indexColumn);
+			if (ret == RET_TABLE_NOT_IN_DATABASE)
+				cerr << "\nTable " << sTableName.c_str() << " not found in the database!\n";
+			else if (ret == RET_INDEX_COLUMN_NOT_FOUND)
+				cerr << "\nERROR! Column " << indexColumn << " not found in table "
+					 << sTableName.c_str() << "\n";
+			else if (ret == RET_UNSUPPORTED_FILE_TYPE)
+				cerr << "\nERROR! Only heap tables can have dictionaries\n";
+			else if (ret == RET_DICT_COLUMN_NOT_STRING)
+				cerr << "\nERROR! Column " << indexColumn << " is not a String\n";
+			else if (ret == RET_DICT_ALREADY_EXISTS)
+				cerr << "\nERROR! Column " << indexColumn << " already has a dictionary\n";
+			else if (ret == RET_DICT_COMPACT_TABLE)
+				cerr << "\nERROR! Table " << sTableName.c_str() << " has compact records,"
+					 << " which can not have dictionaries\n";
+		}
+	}
+
 	// ----------- session variable --------------
 	else
 	{
@@ -0,0 +1,900 @@
+#include <iostream>
+#include <vector>
+#include <sstream>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "DBFile.h"
+#include "ExportFile.h"
+#include "DDL_DML.h"
+#include "RecordLayout.h"
+
+// make sure that the file path/dir information below is correct
+char dbfile_dir[100] = ""; // dir where the test files are created
+char tpch_dir[100] = "/cise/tmp/dbi_sp11/DATA/1G/"; // dir where dbgen tpch files (extension *.tbl) can be found
+char catalog_path[100] = "catalog"; // full path of the catalog file
+char partsupp[] = "partsupp";
+
+using namespace std;
+
+// Regression tests of the file types: the records GetNext(CNF) gives
+// are checked against a brute force scan of the same records, on
+// partsupp, for every access path a file type has. No parser is
+// needed, the CNFs are made from parse trees built here.
+//
+// usage: regress.out [tpch dir/] [dbfile dir/]
+
+// the Int attributes of partsupp the predicates are on
+enum { PARTKEY, SUPPKEY, AVAILQTY, NUM_KEYS };
+
+struct PartSupp
+{
+	int nKeys[NUM_KEYS];
+};
+
+// att op value, the value being nPermille of the largest value the
+// attribute has (and 0 for 0)
+struct Condition
+{
+	int nAtt;
+	int nOp;
+	int nPermille;
+};
+
+#define MAX_CONDS 3
+
+// the conjunction of its conditions
+struct Query
+{
+	int nConds;
+	Condition conds[MAX_CONDS];
+};
+
+// equalities and ranges on the sort key of the sorted files and the
+// tree, on the other attributes, and on both, some that match nothing
+Query queries[] = {
+	{1, {{PARTKEY, EQUALS, 1}}},
+	{1, {{PARTKEY, EQUALS, 777}}},
+	{1, {{PARTKEY, EQUALS, 0}}},
+	{2, {{PARTKEY, GREATER_THAN, 500}, {PARTKEY, LESS_THAN, 510}}},
+	{1, {{PARTKEY, GREATER_THAN, 990}}},
+	{1, {{PARTKEY, LESS_THAN, 5}}},
+	{1, {{PARTKEY, GREATER_THAN, 1000}}},
+	{1, {{SUPPKEY, EQUALS, 250}}},
+	{2, {{SUPPKEY, EQUALS, 250}, {PARTKEY, LESS_THAN, 500}}},
+	{3, {{SUPPKEY, EQUALS, 600}, {PARTKEY, GREATER_THAN, 200}, {PARTKEY, LESS_THAN, 700}}},
+	{1, {{AVAILQTY, LESS_THAN, 10}}},
+	{1, {{AVAILQTY, EQUALS, 500}}},
+	{2, {{AVAILQTY, GREATER_THAN, 990}, {PARTKEY, LESS_THAN, 300}}}
+};
+int numQueries = sizeof (queries) / sizeof (Query);
+
+Schema *schema;
+vector<PartSupp> records;	// of partsupp.tbl, in the order of the file
+int maxKeys[NUM_KEYS];
+
+// the String attribute of partsupp, and its value in every one of records
+int commentAtt;
+vector<string> comments;
+
+// comment op value, or value op comment with bLiteralFirst, the value
+// being the comment of the record at nPermille of the file followed by
+// suffix: with one, it is most likely in no record
+struct CommentCondition
+{
+	int nOp;
+	int nPermille;
+	const char *suffix;
+	bool bLiteralFirst;
+};
+
+struct CommentQuery
+{
+	int nConds;
+	CommentCondition conds[2];
+};
+
+// equalities and ranges on ps_comment, with values that are in the
+// table and values that are not
+CommentQuery commentQueries[] = {
+	{1, {{EQUALS, 100, "", false}}},
+	{1, {{EQUALS, 100, "~", false}}},
+	{1, {{EQUALS, 900, "", true}}},
+	{1, {{LESS_THAN, 300, "", false}}},
+	{1, {{GREATER_THAN, 700, "", false}}},
+	{1, {{LESS_THAN, 500, "~", false}}},
+	{1, {{GREATER_THAN, 500, "~", false}}},
+	{1, {{LESS_THAN, 600, "", true}}},
+	{2, {{GREATER_THAN, 200, "", false}, {LESS_THAN, 210, "~", false}}}
+};
+int numCommentQueries = sizeof (commentQueries) / sizeof (CommentQuery);
+
+// DDL_DML works on the tables of the catalog of the current directory:
+// the tests that go through it make their tables in ddl_dir, whose
+// catalog lists every one of them with the attributes of partsupp
+char ddl_dir[200];
+char start_dir[200];
+
+int GetInt (Record &rec, int whichAtt)
+{
+	char *bits = rec.bits;
+	return *((int *) &(bits[((int *) bits)[whichAtt + 1]]));
+}
+
+int GetValue (Condition &cond)
+{
+	return (int) ((long) maxKeys[cond.nAtt] * cond.nPermille / 1000);
+}
+
+bool Matches (PartSupp &ps, Query &query)
+{
+	for (int i = 0; i < query.nConds; i++)
+	{
+		int nKey = ps.nKeys[query.conds[i].nAtt];
+		int nValue = GetValue (query.conds[i]);
+		switch (query.conds[i].nOp)
+		{
+			case LESS_THAN: if (!(nKey < nValue)) return false; break;
+			case GREATER_THAN: if (!(nKey > nValue)) return false; break;
+			default: if (nKey != nValue) return false; break;
+		}
+	}
+	return true;
+}
+
+// the CNF of the query, from the parse tree the parser would make
+void GetCnf (Query &query, CNF &cnf, Record &literal)
+{
+	Operand names[MAX_CONDS], values[MAX_CONDS];
+	ComparisonOp ops[MAX_CONDS];
+	OrList ors[MAX_CONDS];
+	AndList ands[MAX_CONDS];
+	char sValues[MAX_CONDS][16];
+
+	for (int i = 0; i < query.nConds; i++)
+	{
+		sprintf (sValues[i], "%d", GetValue (query.conds[i]));
+		names[i].code = NAME;
+		names[i].value = schema->GetAtts ()[query.conds[i].nAtt].name;
+		values[i].code = INT;
+		values[i].value = sValues[i];
+		ops[i].code = query.conds[i].nOp;
+		ops[i].left = &names[i];
+		ops[i].right = &values[i];
+		ors[i].left = &ops[i];
+		ors[i].rightOr = NULL;
+		ands[i].left = &ors[i];
+		ands[i].rightAnd = (i + 1 < query.nConds) ? &ands[i + 1] : NULL;
+	}
+	cnf.GrowFromParseTree (&ands[0], schema, literal);
+}
+
+void GetPath (char *path, const char *name, const char *ext)
+{
+	sprintf (path, "%s%s%s", dbfile_dir, name, ext);
+}
+
+// adds table name to the catalog of ddl_dir, and moves there
+void EnterDdlDir (const char *name)
+{
+	mkdir (ddl_dir, 0755);
+	if (chdir (ddl_dir) != 0)
+	{
+		cerr << "BAD: can't move to " << ddl_dir << "\n";
+		exit (1);
+	}
+
+	FILE *out = fopen ("catalog", "a");
+	fprintf (out, "\nBEGIN\n%s\n%s.tbl", name, name);
+	for (int i = 0; i < schema->GetNumAtts (); i++)
+		fprintf (out, "\n%s %s", schema->GetAtts ()[i].name, TypeToString (schema->GetAtts ()[i].myType));
+	fprintf (out, "\nEND\n");
+	fclose (out);
+}
+
+void LeaveDdlDir ()
+{
+	if (chdir (start_dir) != 0)
+	{
+		cerr << "BAD: can't move back to " << start_dir << "\n";
+		exit (1);
+	}
+}
+
+// reads partsupp.tbl into records
+void ReadRecords ()
+{
+	char tbl_path[200];
+	sprintf (tbl_path, "%spartsupp.tbl", tpch_dir);
+	FILE *tableFile = fopen (tbl_path, "r");
+	if (tableFile == NULL)
+	{
+		cerr << "BAD: can't open " << tbl_path << "\n";
+		exit (1);
+	}
+
+	Record temp;
+	while (temp.SuckNextRecord (schema, tableFile) == 1)
+	{
+		PartSupp ps;
+		for (int i = 0; i < NUM_KEYS; i++)
+		{
+			ps.nKeys[i] = GetInt (temp, i);
+			if (ps.nKeys[i] > maxKeys[i])
+				maxKeys[i] = ps.nKeys[i];
+		}
+		records.push_back (ps);
+		comments.push_back (temp.bits + ((int *) temp.bits)[commentAtt + 1]);
+	}
+	fclose (tableFile);
+	cout << " " << records.size () << " records in " << tbl_path << "\n";
+}
+
+// checks the file holds the records, in order of nSortAtt if it is
+// not -1, and that every query gets the records it matches, with and
+// without the hints that make a file use its indexes; returns the
+// number of failures
+int CheckFile (DBFile &dbfile, const char *name, vector<PartSupp> &expected, int nSortAtt)
+{
+	int nFailures = 0;
+	Record temp;
+
+	long nScanned = 0;
+	int nPrev = -1;
+	bool bOrdered = true;
+	dbfile.MoveFirst ();
+	while (dbfile.GetNext (temp) == 1)
+	{
+		if (nSortAtt != -1)
+		{
+			int nKey = GetInt (temp, nSortAtt);
+			if (nKey < nPrev)
+				bOrdered = false;
+			nPrev = nKey;
+		}
+		nScanned++;
+	}
+	if (nScanned != expected.size () || !bOrdered)
+	{
+		cout << " " << name << ": scanned " << nScanned << " of " << expected.size () << " recs"
+			 << (bOrdered ? "" : ", out of order") << "\n";
+		nFailures++;
+	}
+
+	for (int i = 0; i < numQueries; i++)
+	{
+		long nExpected = 0;
+		for (int j = 0; j < expected.size (); j++)
+			if (Matches (expected[j], queries[i]))
+				nExpected++;
+
+		AccessPattern patterns[] = {RANDOM_ACCESS, SEQUENTIAL_ACCESS};
+		for (int p = 0; p < 2; p++)
+		{
+			CNF cnf;
+			Record literal;
+			GetCnf (queries[i], cnf, literal);
+
+			long nSelected = 0;
+			dbfile.MoveFirst ();
+			dbfile.SetAccessPattern (patterns[p]);
+			while (dbfile.GetNext (temp, cnf, literal) == 1)
+			{
+				PartSupp ps;
+				for (int k = 0; k < NUM_KEYS; k++)
+					ps.nKeys[k] = GetInt (temp, k);
+				if (!Matches (ps, queries[i]))
+					nFailures++;
+				nSelected++;
+			}
+			if (nSelected != nExpected)
+			{
+				cout << " " << name << ": query " << i << (p ? " (sequential)" : "") << " selected "
+					 << nSelected << " recs, " << nExpected << " expected\n";
+				nFailures++;
+			}
+		}
+	}
+	dbfile.SetAccessPattern (RANDOM_ACCESS);
+
+	cout << " " << name << ": " << nScanned << " recs, " << numQueries << " queries, "
+		 << (nFailures == 0 ? "ok" : "FAILED") << "\n";
+	return nFailures;
+}
+
+// adds nCount records of partsupp.tbl, from record nFirst on, to the
+// file and to expected
+void AddRecords (DBFile &dbfile, int nFirst, int nCount, vector<PartSupp> &expected)
+{
+	char tbl_path[200];
+	sprintf (tbl_path, "%spartsupp.tbl", tpch_dir);
+	FILE *tableFile = fopen (tbl_path, "r");
+
+	Record temp;
+	for (int i = 0; i < nFirst + nCount && temp.SuckNextRecord (schema, tableFile) == 1; i++)
+	{
+		if (i < nFirst)
+			continue;
+		PartSupp ps;
+		for (int k = 0; k < NUM_KEYS; k++)
+			ps.nKeys[k] = GetInt (temp, k);
+		expected.push_back (ps);
+		dbfile.Add (temp);
+	}
+	fclose (tableFile);
+}
+
+// gives table name hash indexes on SUPPKEY and AVAILQTY, and checks the
+// queries they serve after CREATE INDEX, after a second load and after
+// records are added one by one
+int CheckIndexes (const char *name, int nSortAtt)
+{
+	char path[200], tbl_path[200], label[100];
+	sprintf (path, "%s.bin", name);
+	sprintf (tbl_path, "%spartsupp.tbl", tpch_dir);
+
+	DDL_DML ddl;
+	if (ddl.CreateIndex (name, schema->GetAtts ()[SUPPKEY].name) != RET_SUCCESS ||
+		ddl.CreateIndex (name, schema->GetAtts ()[AVAILQTY].name) != RET_SUCCESS)
+	{
+		cout << " " << name << ": CREATE INDEX failed\n";
+		return 1;
+	}
+
+	int nFailures = 0;
+	vector<PartSupp> expected (records);
+	DBFile dbfile;
+	dbfile.Open (path, READ_ONLY);
+	sprintf (label, "%s indexed", name);
+	nFailures += CheckFile (dbfile, label, expected, nSortAtt);
+	dbfile.Close ();
+
+	dbfile.Open (path);
+	dbfile.Load (*schema, tbl_path);
+	expected.insert (expected.end (), records.begin (), records.end ());
+	dbfile.Close ();
+	dbfile.Open (path, READ_ONLY);
+	sprintf (label, "%s indexed, loaded twice", name);
+	nFailures += CheckFile (dbfile, label, expected, nSortAtt);
+	dbfile.Close ();
+
+	dbfile.Open (path);
+	AddRecords (dbfile, 2000, 5000, expected);
+	sprintf (label, "%s indexed, with added recs", name);
+	nFailures += CheckFile (dbfile, label, expected, nSortAtt);
+	dbfile.Close ();
+	return nFailures;
+}
+
+// adds a record whose compact form is too long for RECORD_FORMAT_V2, so
+// that it is stored as it is, with keys some queries select; returns the
+// length of its comment
+int AddLongRecord (DBFile &dbfile, vector<PartSupp> &expected)
+{
+	PartSupp ps;
+	ps.nKeys[PARTKEY] = (int) ((long) maxKeys[PARTKEY] * 777 / 1000);
+	ps.nKeys[SUPPKEY] = (int) ((long) maxKeys[SUPPKEY] * 250 / 1000);
+	ps.nKeys[AVAILQTY] = (int) ((long) maxKeys[AVAILQTY] * 500 / 1000);
+
+	char sKeys[100];
+	sprintf (sKeys, "%d|%d|%d|1.25|", ps.nKeys[PARTKEY], ps.nKeys[SUPPKEY], ps.nKeys[AVAILQTY]);
+	string sComment (RECORD_V2_MAX_LENGTH + 1000, 'x');
+	string sText = sKeys + sComment + "|";
+
+	Record temp;
+	temp.ComposeRecord (schema, sText.c_str ());
+	dbfile.Add (temp);
+	expected.push_back (ps);
+	return sComment.size ();
+}
+
+// checks the file of compact records, with the long one AddLongRecord
+// gave it, as CheckFile does, and that the long one reads back whole
+int CheckLongRecord (DBFile &dbfile, const char *name, vector<PartSupp> &expected, int nLength)
+{
+	char label[100];
+	sprintf (label, "%s with a long rec", name);
+	int nFailures = CheckFile (dbfile, label, expected, -1);
+
+	int nFound = 0;
+	Record temp;
+	dbfile.MoveFirst ();
+	while (dbfile.GetNext (temp) == 1)
+		if (strlen (temp.bits + ((int *) temp.bits)[commentAtt + 1]) == nLength)
+			nFound++;
+	if (nFound != 1)
+	{
+		cout << " " << label << ": read back " << nFound << " long recs\n";
+		nFailures++;
+	}
+	return nFailures;
+}
+
+// loads partsupp.tbl into a new file of the type and checks it; with
+// bIndexes the file is a table of ddl_dir, which then gets indexes.
+// A heap of RECORD_FORMAT_V2 gets a long record after the load
+int TestFileType (const char *name, fType type, void *startup, int pageSize, bool bIndexes = false,
+				  int recordFormat = RECORD_FORMAT_V1)
+{
+	char path[200], tbl_path[200];
+	if (bIndexes)
+	{
+		EnterDdlDir (name);
+		sprintf (path, "%s.bin", name);
+	}
+	else
+		GetPath (path, name, ".bin");
+	sprintf (tbl_path, "%spartsupp.tbl", tpch_dir);
+
+	DBFile dbfile;
+	dbfile.Create (path, type, startup, pageSize);
+	if (recordFormat == RECORD_FORMAT_V2)
+	{
+		// as CREATE TABLE does it
+		dbfile.Close ();
+		RecordLayout layout;
+		layout.SetTypes (*schema);
+		layout.Write (path);
+		dbfile.Open (path);
+	}
+	dbfile.Load (*schema, tbl_path);
+	dbfile.Close ();
+
+	dbfile.Open (path, READ_ONLY);
+	OrderMaker *pOrder = (startup != NULL) ? ((SortInfo *) startup)->myOrder : NULL;
+	int nSortAtt = (pOrder != NULL) ? pOrder->whichAtts[0] : -1;
+	int nFailures = CheckFile (dbfile, name, records, nSortAtt);
+	dbfile.Close ();
+
+	if (recordFormat == RECORD_FORMAT_V2)
+	{
+		vector<PartSupp> expected (records);
+		dbfile.Open (path);
+		int nLength = AddLongRecord (dbfile, expected);
+		dbfile.Close ();
+		dbfile.Open (path, READ_ONLY);
+		nFailures += CheckLongRecord (dbfile, name, expected, nLength);
+		dbfile.Close ();
+	}
+
+	if (bIndexes)
+	{
+		nFailures += CheckIndexes (name, nSortAtt);
+		LeaveDdlDir ();
+	}
+	return nFailures;
+}
+
+// pages the Bloom filters skipped so far, from their statistics
+long GetBloomSkipped ()
+{
+	stringstream ss;
+	BloomFilterSet::PrintStats (ss);
+	string sWord;
+	long nSkipped = 0;
+	ss >> sWord >> sWord >> nSkipped;
+	return nSkipped;
+}
+
+// a heap with Bloom filters on PARTKEY and SUPPKEY: the queries they
+// prune the pages of get the records they match, and pages are skipped,
+// after CREATE BLOOM FILTER and after records are added one by one
+int TestBloomFilters (const char *name)
+{
+	char path[200], tbl_path[200], label[100];
+	EnterDdlDir (name);
+	sprintf (path, "%s.bin", name);
+	sprintf (tbl_path, "%spartsupp.tbl", tpch_dir);
+
+	DBFile dbfile;
+	dbfile.Create (path, heap, NULL, 8192);
+	dbfile.Load (*schema, tbl_path);
+	dbfile.Close ();
+
+	int nFailures = 0;
+	DDL_DML ddl;
+	if (ddl.CreateBloomFilter (name, schema->GetAtts ()[PARTKEY].name, 0.01) != RET_SUCCESS ||
+		ddl.CreateBloomFilter (name, schema->GetAtts ()[SUPPKEY].name, 0.01) != RET_SUCCESS)
+	{
+		cout << " " << name << ": CREATE BLOOM FILTER failed\n";
+		LeaveDdlDir ();
+		return 1;
+	}
+
+	vector<PartSupp> expected (records);
+	for (int i = 0; i < 2; i++)
+	{
+		if (i == 0)
+		{
+			dbfile.Open (path, READ_ONLY);
+			sprintf (label, "%s", name);
+		}
+		else
+		{
+			dbfile.Open (path);
+			AddRecords (dbfile, 2000, 5000, expected);
+			sprintf (label, "%s with added recs", name);
+		}
+		long nSkipped = GetBloomSkipped ();
+		nFailures += CheckFile (dbfile, label, expected, -1);
+		nSkipped = GetBloomSkipped () - nSkipped;
+		cout << " " << label << ": " << nSkipped << " pages skipped by the Bloom filters\n";
+		if (nSkipped == 0)
+			nFailures++;
+		dbfile.Close ();
+	}
+	LeaveDdlDir ();
+	return nFailures;
+}
+
+string GetCommentValue (CommentCondition &cond)
+{
+	return comments[(long) (comments.size () - 1) * cond.nPermille / 1000] + cond.suffix;
+}
+
+bool MatchesComment (const char *comment, CommentQuery &query)
+{
+	for (int i = 0; i < query.nConds; i++)
+	{
+		CommentCondition &cond = query.conds[i];
+		string sValue = GetCommentValue (cond);
+		int nCmp = strcmp (comment, sValue.c_str ());
+		if (cond.bLiteralFirst)
+			nCmp = -nCmp;
+		switch (cond.nOp)
+		{
+			case LESS_THAN: if (!(nCmp < 0)) return false; break;
+			case GREATER_THAN: if (!(nCmp > 0)) return false; break;
+			default: if (nCmp != 0) return false; break;
+		}
+	}
+	return true;
+}
+
+// the CNF of a query on ps_comment, as GetCnf
+void GetCommentCnf (CommentQuery &query, CNF &cnf, Record &literal)
+{
+	Operand names[2], values[2];
+	ComparisonOp ops[2];
+	OrList ors[2];
+	AndList ands[2];
+	string sValues[2];
+
+	for (int i = 0; i < query.nConds; i++)
+	{
+		sValues[i] = GetCommentValue (query.conds[i]);
+		names[i].code = NAME;
+		names[i].value = schema->GetAtts ()[commentAtt].name;
+		values[i].code = STRING;
+		values[i].value = (char *) sValues[i].c_str ();
+		ops[i].code = query.conds[i].nOp;
+		ops[i].left = query.conds[i].bLiteralFirst ? &values[i] : &names[i];
+		ops[i].right = query.conds[i].bLiteralFirst ? &names[i] : &values[i];
+		ors[i].left = &ops[i];
+		ors[i].rightOr = NULL;
+		ands[i].left = &ors[i];
+		ands[i].rightAnd = (i + 1 < query.nConds) ? &ands[i + 1] : NULL;
+	}
+	cnf.GrowFromParseTree (&ands[0], schema, literal);
+}
+
+// a heap with a hash index on SUPPKEY and a Bloom filter on PARTKEY gets
+// a dictionary on ps_comment, which writes every record again: the
+// records read back the same, the index, the Bloom filter and the zone
+// maps point at their new pages, and the queries on ps_comment, which
+// go through the codes, get the records they match
+int TestDictionary (const char *name)
+{
+	char path[200], tbl_path[200];
+	EnterDdlDir (name);
+	sprintf (path, "%s.bin", name);
+	sprintf (tbl_path, "%spartsupp.tbl", tpch_dir);
+
+	DBFile dbfile;
+	dbfile.Create (path, heap, NULL, 8192);
+	dbfile.Load (*schema, tbl_path);
+	dbfile.Close ();
+
+	DDL_DML ddl;
+	if (ddl.CreateIndex (name, schema->GetAtts ()[SUPPKEY].name) != RET_SUCCESS ||
+		ddl.CreateBloomFilter (name, schema->GetAtts ()[PARTKEY].name, 0.01) != RET_SUCCESS ||
+		ddl.CreateDictionary (name, schema->GetAtts ()[commentAtt].name) != RET_SUCCESS)
+	{
+		cout << " " << name << ": CREATE INDEX, BLOOM FILTER or DICTIONARY failed\n";
+		LeaveDdlDir ();
+		return 1;
+	}
+
+	int nFailures = 0;
+	dbfile.Open (path, READ_ONLY);
+	nFailures += CheckFile (dbfile, name, records, -1);
+
+	long nRecs = 0, nWrong = 0;
+	Record temp;
+	dbfile.MoveFirst ();
+	while (dbfile.GetNext (temp) == 1)
+	{
+		if (nRecs >= comments.size () ||
+			comments[nRecs].compare (temp.bits + ((int *) temp.bits)[commentAtt + 1]) != 0)
+			nWrong++;
+		nRecs++;
+	}
+	if (nWrong > 0)
+	{
+		cout << " " << name << ": " << nWrong << " comments read back wrong\n";
+		nFailures++;
+	}
+
+	for (int i = 0; i < numCommentQueries; i++)
+	{
+		long nExpected = 0;
+		for (int j = 0; j < comments.size (); j++)
+			if (MatchesComment (comments[j].c_str (), commentQueries[i]))
+				nExpected++;
+
+		AccessPattern patterns[] = {RANDOM_ACCESS, SEQUENTIAL_ACCESS};
+		for (int p = 0; p < 2; p++)
+		{
+			CNF cnf;
+			Record literal;
+			GetCommentCnf (commentQueries[i], cnf, literal);
+
+			long nSelected = 0;
+			dbfile.MoveFirst ();
+			dbfile.SetAccessPattern (patterns[p]);
+			while (dbfile.GetNext (temp, cnf, literal) == 1)
+			{
+				if (!MatchesComment (temp.bits + ((int *) temp.bits)[commentAtt + 1], commentQueries[i]))
+					nFailures++;
+				nSelected++;
+			}
+			if (nSelected != nExpected)
+			{
+				cout << " " << name << ": comment query " << i << (p ? " (sequential)" : "")
+					 << " selected " << nSelected << " recs, " << nExpected << " expected\n";
+				nFailures++;
+			}
+		}
+	}
+	dbfile.SetAccessPattern (RANDOM_ACCESS);
+	dbfile.Close ();
+
+	cout << " " << name << ": " << numCommentQueries << " queries on ps_comment, "
+		 << (nFailures == 0 ? "ok" : "FAILED") << "\n";
+	LeaveDdlDir ();
+	return nFailures;
+}
+
+// every file type, on the sort key and on others, with small pages
+// that make the loads and the sorts go over many of them
+int test1 ()
+{
+	OrderMaker byPartKey;
+	byPartKey.numAtts = 1;
+	byPartKey.whichAtts[0] = PARTKEY;
+	byPartKey.whichTypes[0] = Int;
+	SortInfo partKeyInfo = {&byPartKey, 8};
+
+	OrderMaker bySuppKey;
+	bySuppKey.numAtts = 2;
+	bySuppKey.whichAtts[0] = SUPPKEY;
+	bySuppKey.whichTypes[0] = Int;
+	bySuppKey.whichAtts[1] = PARTKEY;
+	bySuppKey.whichTypes[1] = Int;
+	SortInfo suppKeyInfo = {&bySuppKey, 8};
+
+	int nFailures = 0;
+	nFailures += TestFileType ("rt_heap", heap, NULL, PAGE_SIZE);
+	nFailures += TestFileType ("rt_heap8k", heap, NULL, 8192);
+	nFailures += TestFileType ("rt_compact", heap, NULL, PAGE_SIZE, false, RECORD_FORMAT_V2);
+	nFailures += TestFileType ("rt_sorted", sorted, &partKeyInfo, 8192);
+	nFailures += TestFileType ("rt_sorted2", sorted, &suppKeyInfo, 8192);
+	nFailures += TestFileType ("rt_pax", pax, NULL, 8192);
+	nFailures += TestFileType ("rt_tree", tree, &partKeyInfo, 8192);
+	nFailures += TestFileType ("rt_heap_idx", heap, NULL, 8192, true);
+	nFailures += TestFileType ("rt_sorted_idx", sorted, &partKeyInfo, 8192, true);
+	nFailures += TestBloomFilters ("rt_heap_bloom");
+	nFailures += TestDictionary ("rt_heap_dict");
+	return nFailures;
+}
+
+// records added to a sorted file in batches, read between them: every
+// batch becomes a delta run, and the runs get merged into the file by
+// compactions while it is read, then by a batch as large as the file
+int test2 ()
+{
+	OrderMaker byPartKey;
+	byPartKey.numAtts = 1;
+	byPartKey.whichAtts[0] = PARTKEY;
+	byPartKey.whichTypes[0] = Int;
+	SortInfo partKeyInfo = {&byPartKey, 8};
+
+	char path[200], tbl_path[200];
+	GetPath (path, "rt_delta", ".bin");
+	sprintf (tbl_path, "%spartsupp.tbl", tpch_dir);
+
+	DBFile dbfile;
+	dbfile.Create (path, sorted, &partKeyInfo, 8192);
+	dbfile.Load (*schema, tbl_path);
+	vector<PartSupp> expected (records);
+
+	int batches[] = {1000, 10, 3000, 500, 1, 2000, 100, 700, 50, 4000, 300, 20};
+	int numBatches = sizeof (batches) / sizeof (int);
+	int nFailures = 0;
+	char name[50];
+	for (int i = 0; i < numBatches; i++)
+	{
+		AddRecords (dbfile, i * 997, batches[i], expected);
+		Record temp;
+		dbfile.MoveFirst ();
+		dbfile.GetNext (temp);
+		if (i % 4 == 3)
+		{
+			sprintf (name, "rt_delta after %d batches", i + 1);
+			nFailures += CheckFile (dbfile, name, expected, PARTKEY);
+		}
+	}
+
+	AddRecords (dbfile, 0, records.size (), expected);
+	nFailures += CheckFile (dbfile, "rt_delta after a large batch", expected, PARTKEY);
+	AddRecords (dbfile, 5000, 200, expected);
+	dbfile.Close ();
+
+	dbfile.Open (path, READ_ONLY);
+	nFailures += CheckFile (dbfile, "rt_delta reopened", expected, PARTKEY);
+	dbfile.Close ();
+	return nFailures;
+}
+
+// writes the records of the file in an export file of pages of nPageSize
+// bytes; returns the number of records written
+long ExportRecords (const char *fromPath, const char *toPath, int nPageSize)
+{
+	DBFile dbfile;
+	dbfile.Open ((char *) fromPath, READ_ONLY);
+	dbfile.MoveFirst ();
+	ExportFile exportFile;
+	exportFile.Create (toPath, *schema, nPageSize);
+
+	long nRecords = 0;
+	Record temp;
+	while (dbfile.GetNext (temp) == 1)
+	{
+		exportFile.Add (temp);
+		nRecords++;
+	}
+	exportFile.Close ();
+	dbfile.Close ();
+	return nRecords;
+}
+
+// imports the export file in a new file of the type and checks it
+int TestImport (const char *name, const char *exportPath, fType type, void *startup,
+				int pageSize, int compression)
+{
+	char path[200];
+	GetPath (path, name, ".bin");
+
+	DBFile dbfile;
+	dbfile.Create (path, type, startup, pageSize, compression);
+	dbfile.Load (*schema, (char *) exportPath);
+	dbfile.Close ();
+
+	dbfile.Open (path, READ_ONLY);
+	OrderMaker *pOrder = (startup != NULL) ? ((SortInfo *) startup)->myOrder : NULL;
+	int nFailures = CheckFile (dbfile, name, records, pOrder != NULL ? pOrder->whichAtts[0] : -1);
+	dbfile.Close ();
+	return nFailures;
+}
+
+// true if the two files have the same records, bit for bit, in order
+bool SameRecords (const char *path1, const char *path2)
+{
+	DBFile dbfile1, dbfile2;
+	dbfile1.Open ((char *) path1, READ_ONLY);
+	dbfile2.Open ((char *) path2, READ_ONLY);
+	dbfile1.MoveFirst ();
+	dbfile2.MoveFirst ();
+
+	bool bSame = true;
+	Record temp1, temp2;
+	while (bSame && dbfile1.GetNext (temp1) == 1)
+	{
+		int nLen = ((int *) temp1.bits)[0];
+		bSame = dbfile2.GetNext (temp2) == 1 && ((int *) temp2.bits)[0] == nLen &&
+				memcmp (temp1.bits, temp2.bits, nLen) == 0;
+	}
+	if (bSame && dbfile2.GetNext (temp2) == 1)
+		bSame = false;
+	dbfile1.Close ();
+	dbfile2.Close ();
+	return bSame;
+}
+
+// a heap exported and imported back, into every file type, into other
+// page sizes and into compressed pages; test1 made the heaps
+int test3 ()
+{
+	OrderMaker byPartKey;
+	byPartKey.numAtts = 1;
+	byPartKey.whichAtts[0] = PARTKEY;
+	byPartKey.whichTypes[0] = Int;
+	SortInfo partKeyInfo = {&byPartKey, 8};
+
+	char heapPath[200], heap8kPath[200], exportPath[200], export8kPath[200], importPath[200];
+	GetPath (heapPath, "rt_heap", ".bin");
+	GetPath (heap8kPath, "rt_heap8k", ".bin");
+	GetPath (exportPath, "rt_export", ".export");
+	GetPath (export8kPath, "rt_export8k", ".export");
+	GetPath (importPath, "rt_import", ".bin");
+
+	int nFailures = 0;
+	long nExported = ExportRecords (heapPath, exportPath, PAGE_SIZE);
+	long nExported8k = ExportRecords (heap8kPath, export8kPath, 8192);
+	ExportFile exportFile;
+	if (nExported != records.size () || nExported8k != records.size () ||
+		!exportFile.Open (exportPath) || exportFile.GetNumRecords () != records.size ())
+	{
+		cout << " rt_export: exported " << nExported << " and " << nExported8k << " of "
+			 << records.size () << " recs\n";
+		nFailures++;
+	}
+	exportFile.Close ();
+
+	nFailures += TestImport ("rt_import", exportPath, heap, NULL, PAGE_SIZE, COMPRESS_NONE);
+	if (!SameRecords (heapPath, importPath))
+	{
+		cout << " rt_import: records differ from those exported\n";
+		nFailures++;
+	}
+	nFailures += TestImport ("rt_import8k", exportPath, heap, NULL, 8192, COMPRESS_LZ);
+	nFailures += TestImport ("rt_import_from8k", export8kPath, heap, NULL, PAGE_SIZE, COMPRESS_NONE);
+	nFailures += TestImport ("rt_import_sorted", exportPath, sorted, &partKeyInfo, 8192, COMPRESS_NONE);
+	nFailures += TestImport ("rt_import_pax", export8kPath, pax, NULL, 8192, COMPRESS_NONE);
+	return nFailures;
+}
+
+int main (int argc, char *argv[])
+{
+	if (argc > 1)
+		strncpy (tpch_dir, argv[1], sizeof (tpch_dir) - 1);
+	if (argc > 2)
+		strncpy (dbfile_dir, argv[2], sizeof (dbfile_dir) - 1);
+
+	// the tests in ddl_dir read partsupp.tbl from there
+	if (getcwd (start_dir, sizeof (start_dir)) == NULL)
+	{
+		cerr << "BAD: can't get the current directory\n";
+		exit (1);
+	}
+	if (tpch_dir[0] != '/')
+	{
+		char rel_dir[100];
+		strcpy (rel_dir, tpch_dir);
+		snprintf (tpch_dir, sizeof (tpch_dir), "%s/%s", start_dir, rel_dir);
+	}
+	sprintf (ddl_dir, "%srt_ddl", dbfile_dir);
+	mkdir (ddl_dir, 0755);
+	char ddl_catalog[220];
+	sprintf (ddl_catalog, "%s/catalog", ddl_dir);
+	remove (ddl_catalog);
+
+	schema = new Schema (catalog_path, partsupp);
+	commentAtt = schema->Find ((char *) "ps_comment");
+	ReadRecords ();
+
+	int nFailures = 0;
+	cout << "\n test1: file types\n";
+	nFailures += test1 ();
+	cout << "\n test2: delta runs of sorted files\n";
+	nFailures += test2 ();
+	cout << "\n test3: export and import\n";
+	nFailures += test3 ();
+
+	cout << "\n " << (nFailures == 0 ? "all tests passed" : "TESTS FAILED") << "\n";
+	delete schema;
+	return nFailures == 0 ? 0 : 1;
+}